@@ -0,0 +1,85 @@
+//
+//  ApplyPolicyBenchmark.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Times parallel-for batches of cheap and expensive iterations, i.e. reusing cached nodes and allocating new ones, with
+// the previous fixed-width ASDispatchApply and with the adaptive ASApplyPolicy.
+// Usage: ApplyPolicyBenchmark [iterations]
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "ApplyPolicyFixture.h"
+#include "Harness.h"
+
+using namespace AS;
+using namespace AS::Fixture;
+
+/** The previous ASDispatchApply(): a fixed number of threads claiming one iteration at a time while the caller waits. */
+static void legacyApply(size_t iterations, unsigned threadCount, const Work &work)
+{
+  std::atomic<size_t> counter(0);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < threadCount; t++) {
+    threads.emplace_back([&] {
+      size_t i;
+      while ((i = counter.fetch_add(1)) < iterations) {
+        work(i);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+/** Stands in for allocating a node; rounds is roughly proportional to the cost. */
+static size_t work(size_t seed, int rounds)
+{
+  size_t hash = seed;
+  for (int i = 0; i < rounds; i++) {
+    hash = hash * 31 + i;
+  }
+  return hash;
+}
+
+static void run(const char *label, const size_t items, const int rounds, const unsigned cores, const long iterations)
+{
+  char name[64];
+  std::atomic<size_t> sum(0);
+  const Work body = [&](size_t i) { sum.fetch_add(work(i, rounds) & 1, std::memory_order_relaxed); };
+
+  std::snprintf(name, sizeof(name), "%zu %s items legacy", items, label);
+  AS::Harness::time(name, "item", iterations, items, [&] {
+    // ASDispatchApply defaulted to twice the core count.
+    legacyApply(items, cores * 2, body);
+    return sum.load();
+  });
+
+  std::snprintf(name, sizeof(name), "%zu %s items adaptive", items, label);
+  // One policy per call site, which lives as long as the process.
+  ApplyPolicy policy;
+  AS::Harness::time(name, "item", iterations, items, [&] {
+    adaptiveApply(policy, items, cores, body);
+    return sum.load();
+  });
+}
+
+int main(int argc, char *argv[])
+{
+  const long iterations = AS::Harness::iterations(argc, argv, 50);
+  const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+  run("cheap", 8, 100, cores, iterations * 10);
+  run("cheap", 1000, 100, cores, iterations);
+  run("expensive", 8, 100000, cores, iterations);
+  run("expensive", 200, 100000, cores, std::max(1L, iterations / 10));
+  return 0;
+}
@@ -0,0 +1,50 @@
+//
+//  ApplyPolicyFixture.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+// Shared by the host tests and the benchmark: the adaptive parallel-for of ASDispatch.mm, with threads standing in for
+// blocks dispatched to a global queue.
+
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "ASApplyPolicy.h"
+
+namespace AS {
+namespace Fixture {
+
+typedef std::function<void(size_t)> Work;
+
+inline void invoke(void *context, size_t index)
+{
+  (*static_cast<const Work *>(context))(index);
+}
+
+/** Mirrors ASDispatchApplyWithPolicy(): plan, run on the planned threads including the caller, then learn. */
+inline ApplyPolicy::Report adaptiveApply(ApplyPolicy &policy, size_t iterations, unsigned maxThreads, const Work &work)
+{
+  const ApplyPolicy::Plan plan = policy.plan(iterations, maxThreads);
+  ApplyBatch batch(iterations, plan);
+  void *context = const_cast<Work *>(&work);
+  std::vector<std::thread> threads;
+  for (unsigned t = 1; t < plan.threads; t++) {
+    threads.emplace_back([&batch, context] { batch.run(invoke, context); });
+  }
+  batch.run(invoke, context);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  const ApplyPolicy::Report report = batch.finish();
+  policy.record(report);
+  return report;
+}
+
+} // namespace Fixture
+} // namespace AS
@@ -0,0 +1,111 @@
+//
+//  ApplyPolicyTests.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Host-side checks for the policy behind ASDispatchApply. The Objective-C surface is covered by Tests/ASDispatchTests.mm.
+
+#include <cstdio>
+
+#include "ApplyPolicyFixture.h"
+#include "Harness.h"
+
+using namespace AS;
+using namespace AS::Fixture;
+
+/** Teaches a policy an iteration cost by recording batches that took exactly that long. */
+static void train(ApplyPolicy &policy, uint64_t cost)
+{
+  for (int i = 0; i < 64; i++) {
+    policy.record({100, 1, 100, cost * 100, cost * 100});
+  }
+}
+
+static void testExpensiveIterationsAreSpreadOneByOne()
+{
+  ApplyPolicy policy;
+  // Unmeasured call sites are assumed expensive, like node allocation.
+  ApplyPolicy::Plan plan = policy.plan(40, 8);
+  EXPECT_EQ(plan.threads, 8u);
+  EXPECT_EQ(plan.chunkSize, 1u);
+
+  // Never more threads than iterations.
+  plan = policy.plan(3, 8);
+  EXPECT_EQ(plan.threads, 3u);
+}
+
+static void testCheapIterationsAreChunked()
+{
+  ApplyPolicy policy;
+  train(policy, 1000);
+  EXPECT_TRUE(policy.iterationCost() > 900 && policy.iterationCost() < 1100);
+
+  // 10ms of work: every thread is worth waking, and chunks last about kTargetChunkDuration.
+  ApplyPolicy::Plan plan = policy.plan(10000, 8);
+  EXPECT_EQ(plan.threads, 8u);
+  EXPECT_EQ(plan.chunkSize, (size_t)(ApplyPolicy::kTargetChunkDuration / policy.iterationCost()));
+
+  // 100µs of work: one extra thread pays off, chunks shrink so that both threads get several.
+  plan = policy.plan(100, 8);
+  EXPECT_EQ(plan.threads, 3u);
+  EXPECT_EQ(plan.chunkSize, 8u);
+
+  // 30µs of work is not worth waking anybody.
+  plan = policy.plan(30, 8);
+  EXPECT_EQ(plan.threads, 1u);
+  EXPECT_EQ(plan.chunkSize, 30u);
+}
+
+static void testMaxThreadsIsRespected()
+{
+  ApplyPolicy policy;
+  EXPECT_EQ(policy.plan(1000, 1).threads, 1u);
+  EXPECT_EQ(policy.plan(1000, 2).threads, 2u);
+  // A maximum of zero still runs on the calling thread.
+  EXPECT_EQ(policy.plan(1000, 0).threads, 1u);
+}
+
+static void testCostAdapts()
+{
+  ApplyPolicy policy;
+  train(policy, 1000);
+  // One slow batch moves the estimate, but only by a quarter of the difference.
+  policy.record({10, 1, 10, 10 * 101000, 10 * 101000});
+  EXPECT_TRUE(policy.iterationCost() > 20000 && policy.iterationCost() < 30000);
+  train(policy, 1000);
+  EXPECT_TRUE(policy.iterationCost() < 1100);
+}
+
+static void testEveryIterationRunsOnce()
+{
+  ApplyPolicy policy;
+  for (const size_t count : {0, 1, 7, 100, 5000}) {
+    std::vector<std::atomic<int>> counts(count);
+    for (auto &c : counts) {
+      c.store(0);
+    }
+    const ApplyPolicy::Report report = adaptiveApply(policy, count, 4, [&](size_t i) {
+      counts[i].fetch_add(1);
+    });
+    size_t wrong = 0;
+    for (auto &c : counts) {
+      wrong += (c.load() != 1);
+    }
+    EXPECT_EQ(wrong, 0u);
+    EXPECT_EQ(report.iterations, count);
+    EXPECT_TRUE(report.utilization() >= 0 && report.utilization() <= 1);
+  }
+}
+
+int main()
+{
+  testExpensiveIterationsAreSpreadOneByOne();
+  testCheapIterationsAreChunked();
+  testMaxThreadsIsRespected();
+  testCostAdapts();
+  testEveryIterationRunsOnce();
+  return AS::Harness::finish("apply policy");
+}
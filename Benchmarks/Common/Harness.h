@@ -0,0 +1,106 @@
+//
+//  Harness.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+// Shared by the host tests and benchmarks of every core. Expectations count failures instead of aborting, so that one
+// run reports all of them; benchmarks time a body over batches and report the fastest.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace AS {
+namespace Harness {
+
+inline int &failures()
+{
+  static int failures = 0;
+  return failures;
+}
+
+/** Reports the expectations of a test run and returns main()'s exit code. */
+inline int finish(const char *suite)
+{
+  if (failures() > 0) {
+    std::fprintf(stderr, "%d failure(s)\n", failures());
+    return 1;
+  }
+  std::printf("All %s tests passed.\n", suite);
+  return 0;
+}
+
+/** The iteration count passed as the first argument, or defaultIterations. */
+inline long iterations(int argc, char *argv[], long defaultIterations)
+{
+  return argc > 1 ? std::max(1L, std::atol(argv[1])) : defaultIterations;
+}
+
+inline std::string checksumString(size_t checksum)
+{
+  return std::to_string(checksum);
+}
+
+inline std::string checksumString(double checksum)
+{
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.1f", checksum);
+  return buffer;
+}
+
+/**
+ * Times body over several batches and reports the fastest batch, which filters out scheduling noise. Each call of body
+ * performs operations of unit, e.g. 1000 "lookup"s, and returns a checksum that keeps its work from being optimized
+ * away.
+ */
+template <typename Body>
+void time(const char *name, const char *unit, long iterations, size_t operations, const Body &body)
+{
+  // Warm up caches and the allocator before timing.
+  auto checksum = body();
+
+  double bestNs = INFINITY;
+  for (int batch = 0; batch < 5; batch++) {
+    const auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+      checksum += body();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    bestNs = std::min(bestNs, std::chrono::duration<double, std::nano>(end - start).count() / (iterations * operations));
+  }
+  std::printf("%-36s %12.1f ns/%-10s (%ld iterations, checksum %s)\n", name, bestNs, unit, iterations,
+              checksumString(checksum).c_str());
+}
+
+} // namespace Harness
+} // namespace AS
+
+#define EXPECT_TRUE(condition) do { \
+  if (!(condition)) { \
+    std::fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+    AS::Harness::failures()++; \
+  } \
+} while (0)
+
+#define EXPECT_EQ(actual, expected) do { \
+  if (!((actual) == (expected))) { \
+    std::fprintf(stderr, "%s:%d: expected %s == %s\n", __FILE__, __LINE__, #actual, #expected); \
+    AS::Harness::failures()++; \
+  } \
+} while (0)
+
+#define EXPECT_NEAR(actual, expected) do { \
+  const double a = (actual), e = (expected); \
+  if (std::fabs(a - e) > 0.001) { \
+    std::fprintf(stderr, "%s:%d: expected %s == %g, got %g\n", __FILE__, __LINE__, #actual, e, a); \
+    AS::Harness::failures()++; \
+  } \
+} while (0)
@@ -0,0 +1,60 @@
+//
+//  DiffingCoreBenchmark.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Times the diffing engines on large, mostly similar feeds, i.e. the shape of a data controller update.
+// Usage: DiffingCoreBenchmark [iterations]
+
+#include <cstdio>
+
+#include "DiffingFixture.h"
+#include "Harness.h"
+
+using namespace AS::Diffing;
+using namespace AS::Diffing::Fixture;
+
+static void run(const size_t count, const size_t edits, const long iterations, const bool legacy)
+{
+  std::mt19937 random(1);
+  const Symbols oldSymbols = feed(count);
+  size_t symbolCount = count;
+  const Symbols newSymbols = edit(oldSymbols, edits, symbolCount, random);
+  const SymbolComparator comparator(oldSymbols, newSymbols);
+
+  char name[64];
+  std::snprintf(name, sizeof(name), "%zu/%zu myers", count, edits);
+  AS::Harness::time(name, "diff", iterations, 1, [&] {
+    const Changes result = changes(oldSymbols.size(), newSymbols.size(), comparator);
+    return result.insertions.size() + result.deletions.size();
+  });
+
+  std::snprintf(name, sizeof(name), "%zu/%zu heckel", count, edits);
+  AS::Harness::time(name, "diff", iterations, 1, [&] {
+    const Changes result = changesWithMoves(oldSymbols, newSymbols, symbolCount);
+    return result.insertions.size() + result.deletions.size() + result.moves.size();
+  });
+
+  if (legacy) {
+    // Quadratic in time and memory; a 5000 item feed would need a 200 MB length matrix.
+    std::snprintf(name, sizeof(name), "%zu/%zu legacy lcs", count, edits);
+    AS::Harness::time(name, "diff", std::max(1L, iterations / 100), 1, [&] {
+      return legacyCommonIndexes(oldSymbols, newSymbols).size();
+    });
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  const long iterations = AS::Harness::iterations(argc, argv, 200);
+
+  run(100, 5, iterations * 10, true);
+  run(1000, 10, iterations, true);
+  run(2000, 20, iterations, true);
+  run(5000, 20, iterations, false);
+  run(5000, 200, std::max(1L, iterations / 4), false);
+  return 0;
+}
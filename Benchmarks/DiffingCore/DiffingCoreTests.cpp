@@ -0,0 +1,198 @@
+//
+//  DiffingCoreTests.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Host-side checks for the diffing engine. The Objective-C surface is covered by Tests/ArrayDiffingTests.mm; the
+// examples below mirror the ones there so that the engine's choice among equally long subsequences is pinned down.
+
+#include <cstdio>
+#include <map>
+#include <string>
+
+#include "DiffingFixture.h"
+#include "Harness.h"
+
+using namespace AS::Diffing;
+using namespace AS::Diffing::Fixture;
+
+typedef std::vector<size_t> Indexes;
+
+struct Example {
+  Symbols oldSymbols;
+  Symbols newSymbols;
+  size_t symbolCount;
+};
+
+static Example example(const std::vector<std::string> &oldStrings, const std::vector<std::string> &newStrings)
+{
+  std::map<std::string, size_t> table;
+  auto symbolize = [&](const std::vector<std::string> &strings) {
+    Symbols symbols;
+    for (const auto &string : strings) {
+      symbols.push_back(table.emplace(string, table.size()).first->second);
+    }
+    return symbols;
+  };
+  Example result;
+  result.oldSymbols = symbolize(oldStrings);
+  result.newSymbols = symbolize(newStrings);
+  result.symbolCount = table.size();
+  return result;
+}
+
+static Changes diff(const Example &e)
+{
+  return changes(e.oldSymbols.size(), e.newSymbols.size(), SymbolComparator(e.oldSymbols, e.newSymbols));
+}
+
+static Changes diffWithMoves(const Example &e)
+{
+  return changesWithMoves(e.oldSymbols, e.newSymbols, e.symbolCount);
+}
+
+namespace AS {
+namespace Diffing {
+static bool operator==(const Move &lhs, const Move &rhs)
+{
+  return lhs.from == rhs.from && lhs.to == rhs.to;
+}
+} // namespace Diffing
+} // namespace AS
+
+static void testInsertionsAndDeletions()
+{
+  struct {
+    Example e;
+    Indexes insertions;
+    Indexes deletions;
+  } tests[] = {
+    {example({"bob", "alice", "dave"}, {"bob", "alice", "dave", "gary"}), {3}, {}},
+    {example({"a", "b", "c", "d"}, {"d", "c", "b", "a"}), {1, 2, 3}, {0, 1, 2}},
+    {example({"bob", "alice", "dave"}, {"bob", "gary", "alice", "dave"}), {1}, {}},
+    {example({"bob", "alice", "dave"}, {"bob", "alice"}), {}, {2}},
+    {example({"bob", "alice", "dave"}, {}), {}, {0, 1, 2}},
+    {example({"bob", "alice", "dave"}, {"gary", "alice", "dave", "jack"}), {0, 3}, {0}},
+    {example({"bob", "alice", "dave", "judy", "lynda", "tony"}, {"gary", "bob", "suzy", "tony"}), {0, 2}, {1, 2, 3, 4}},
+    {example({"bob", "alice", "dave", "judy"}, {"judy", "dave", "alice", "bob"}), {1, 2, 3}, {0, 1, 2}},
+  };
+  for (const auto &test : tests) {
+    const Changes result = diff(test.e);
+    EXPECT_EQ(result.insertions, test.insertions);
+    EXPECT_EQ(result.deletions, test.deletions);
+    EXPECT_EQ(result.moves.size(), 0u);
+  }
+}
+
+static void testInsertionsDeletionsAndMoves()
+{
+  struct {
+    Example e;
+    Indexes insertions;
+    Indexes deletions;
+    std::vector<Move> moves;
+  } tests[] = {
+    {example({"a", "b"}, {"b", "a"}), {}, {}, {{1, 0}, {0, 1}}},
+    {example({"bob", "alice", "dave"}, {"bob", "alice", "dave", "gary"}), {3}, {}, {}},
+    {example({"a", "b", "c", "d"}, {"d", "c", "b", "a"}), {}, {}, {{3, 0}, {2, 1}, {1, 2}, {0, 3}}},
+    {example({"bob", "alice", "dave"}, {"bob", "gary", "dave", "alice"}), {1}, {}, {{1, 3}}},
+    {example({"bob", "alice", "dave"}, {"bob", "alice"}), {}, {2}, {}},
+    {example({"bob", "alice", "dave"}, {}), {}, {0, 1, 2}, {}},
+    {example({"bob", "alice", "dave"}, {"gary", "alice", "dave", "jack"}), {0, 3}, {0}, {}},
+    {example({"bob", "alice", "dave", "judy", "lynda", "tony"}, {"gary", "bob", "suzy", "tony"}), {0, 2}, {1, 2, 3, 4}, {{0, 1}, {5, 3}}},
+  };
+  for (const auto &test : tests) {
+    const Changes result = diffWithMoves(test.e);
+    EXPECT_EQ(result.insertions, test.insertions);
+    EXPECT_EQ(result.deletions, test.deletions);
+    EXPECT_EQ(result.moves, test.moves);
+  }
+}
+
+static void testCommonIndexesAreALongestCommonSubsequence()
+{
+  std::mt19937 random(7);
+  for (int iteration = 0; iteration < 2000; iteration++) {
+    // Few distinct symbols make for many duplicates and many equally long subsequences.
+    const size_t alphabet = 1 + random() % 8;
+    Symbols oldSymbols(random() % 40), newSymbols(random() % 40);
+    for (auto &symbol : oldSymbols) {
+      symbol = random() % alphabet;
+    }
+    for (auto &symbol : newSymbols) {
+      symbol = random() % alphabet;
+    }
+
+    const Indexes common = commonIndexes(oldSymbols.size(), newSymbols.size(), SymbolComparator(oldSymbols, newSymbols));
+    EXPECT_EQ(common.size(), legacyCommonIndexes(oldSymbols, newSymbols).size());
+
+    // Ascending and embeddable in the new sequence.
+    size_t j = 0;
+    for (size_t c = 0; c < common.size(); c++) {
+      EXPECT_EQ(c == 0 || common[c - 1] < common[c], true);
+      while (j < newSymbols.size() && newSymbols[j] != oldSymbols[common[c]]) {
+        j++;
+      }
+      EXPECT_EQ(j < newSymbols.size(), true);
+      j++;
+    }
+  }
+}
+
+static void testMovesRebuildTheNewSequence()
+{
+  // Mirrors -testArrayDiffingRebuildingWithRandomElements: apply the changes without shifting any element.
+  std::mt19937 random(11);
+  for (int iteration = 0; iteration < 2000; iteration++) {
+    const size_t alphabet = 1 + random() % 25;
+    Symbols oldSymbols(random() % 20), newSymbols(random() % 20);
+    for (auto &symbol : oldSymbols) {
+      symbol = random() % alphabet;
+    }
+    for (auto &symbol : newSymbols) {
+      symbol = random() % alphabet;
+    }
+
+    const Changes result = changesWithMoves(oldSymbols, newSymbols, alphabet);
+    Symbols rebuilt;
+    size_t i = 0, m = 0;
+    for (size_t j = 0; j < newSymbols.size(); j++) {
+      if (i < result.insertions.size() && result.insertions[i] == j) {
+        rebuilt.push_back(newSymbols[j]);
+        i++;
+      } else if (m < result.moves.size() && result.moves[m].to == j) {
+        rebuilt.push_back(oldSymbols[result.moves[m].from]);
+        m++;
+      } else {
+        rebuilt.push_back(j < oldSymbols.size() ? oldSymbols[j] : alphabet);
+      }
+    }
+    EXPECT_EQ(rebuilt, newSymbols);
+    // Every old index is deleted, moved, or kept at its own index.
+    EXPECT_EQ(result.deletions.size() + result.moves.size() + (newSymbols.size() - result.insertions.size() - result.moves.size()),
+              oldSymbols.size());
+  }
+}
+
+static void testLargeMostlySimilarFeeds()
+{
+  std::mt19937 random(3);
+  const Symbols oldSymbols = feed(5000);
+  size_t symbolCount = oldSymbols.size();
+  const Symbols newSymbols = edit(oldSymbols, 30, symbolCount, random);
+  const Indexes common = commonIndexes(oldSymbols.size(), newSymbols.size(), SymbolComparator(oldSymbols, newSymbols));
+  EXPECT_EQ(common.size(), legacyCommonIndexes(oldSymbols, newSymbols).size());
+}
+
+int main()
+{
+  testInsertionsAndDeletions();
+  testInsertionsDeletionsAndMoves();
+  testCommonIndexesAreALongestCommonSubsequence();
+  testMovesRebuildTheNewSequence();
+  testLargeMostlySimilarFeeds();
+  return AS::Harness::finish("diffing core");
+}
@@ -0,0 +1,107 @@
+//
+//  DiffingFixture.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+// Shared by the host tests and the benchmark: sequences of symbols standing in for arrays of objects, and a port of the
+// quadratic LCS that NSArray+Diffing used before ASDiffingCore, as a reference for both correctness and speed.
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "ASDiffingCore.h"
+
+namespace AS {
+namespace Diffing {
+namespace Fixture {
+
+typedef std::vector<size_t> Symbols;
+
+/**
+ * The previous -_asdk_commonIndexesWithArray:compareBlock:. Calls the comparison through a std::function for every cell
+ * of the (n+1)×(m+1) length matrix, the way the Objective-C version called a block.
+ */
+inline std::vector<size_t> legacyCommonIndexes(const Symbols &oldSymbols, const Symbols &newSymbols)
+{
+  const std::function<bool(size_t, size_t)> equal = [&](size_t i, size_t j) {
+    return oldSymbols[i] == newSymbols[j];
+  };
+  const size_t n = oldSymbols.size();
+  const size_t m = newSymbols.size();
+  std::vector<std::vector<size_t>> lengths(n + 1, std::vector<size_t>(m + 1, 0));
+  for (size_t i = 1; i <= n; i++) {
+    for (size_t j = 1; j <= m; j++) {
+      if (equal(i - 1, j - 1)) {
+        lengths[i][j] = 1 + lengths[i - 1][j - 1];
+      } else {
+        lengths[i][j] = std::max(lengths[i - 1][j], lengths[i][j - 1]);
+      }
+    }
+  }
+  std::vector<size_t> common;
+  size_t i = n, j = m;
+  while (i > 0 && j > 0) {
+    if (equal(i - 1, j - 1)) {
+      common.push_back(i - 1);
+      i--;
+      j--;
+    } else if (lengths[i - 1][j] > lengths[i][j - 1]) {
+      i--;
+    } else {
+      j--;
+    }
+  }
+  return std::vector<size_t>(common.rbegin(), common.rend());
+}
+
+/** A feed of count unique items. */
+inline Symbols feed(size_t count)
+{
+  Symbols symbols(count);
+  for (size_t i = 0; i < count; i++) {
+    symbols[i] = i;
+  }
+  return symbols;
+}
+
+/**
+ * Applies editCount random edits to a feed of symbols from [0, symbolCount): a third each are deletions, insertions of
+ * fresh symbols and moves of an existing item to another index.
+ */
+inline Symbols edit(Symbols symbols, size_t editCount, size_t &symbolCount, std::mt19937 &random)
+{
+  for (size_t e = 0; e < editCount; e++) {
+    const size_t count = symbols.size();
+    switch (e % 3) {
+      case 0:
+        if (count > 0) {
+          symbols.erase(symbols.begin() + random() % count);
+        }
+        break;
+      case 1:
+        symbols.insert(symbols.begin() + random() % (count + 1), symbolCount++);
+        break;
+      case 2:
+        if (count > 1) {
+          const size_t from = random() % count;
+          const size_t symbol = symbols[from];
+          symbols.erase(symbols.begin() + from);
+          symbols.insert(symbols.begin() + random() % count, symbol);
+        }
+        break;
+    }
+  }
+  return symbols;
+}
+
+} // namespace Fixture
+} // namespace Diffing
+} // namespace AS
@@ -0,0 +1,89 @@
+//
+//  LRUCacheBenchmark.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Times lookups of text layouts, i.e. many threads measuring a feed whose strings repeat, behind one global lock (as
+// ASTextNode2 did) and with the sharded ASLRUCache.
+// Usage: LRUCacheBenchmark [iterations]
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ASLRUCache.h"
+#include "Harness.h"
+
+using namespace AS;
+
+typedef LRUCache<std::string, std::shared_ptr<std::string>> StringCache;
+
+/** Looks every key up and stores a "layout" on a miss. Keys are skewed so that a few strings are measured often. */
+static size_t measure(StringCache &cache, const std::vector<std::string> &keys, unsigned threadCount, size_t lookups)
+{
+  std::vector<size_t> hits(threadCount);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < threadCount; t++) {
+    threads.emplace_back([&, t] {
+      std::shared_ptr<std::string> layout;
+      uint32_t random = 2463534242u + t;
+      for (size_t i = 0; i < lookups; i++) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        // Squaring a uniform number favors small indices.
+        const double uniform = (random % 10000) / 10000.0;
+        const std::string &key = keys[(size_t)(uniform * uniform * keys.size())];
+        if (cache.find(key, layout)) {
+          hits[t]++;
+        } else {
+          cache.insert(key, std::make_shared<std::string>(key), key.size() * 40);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  size_t total = 0;
+  for (size_t h : hits) {
+    total += h;
+  }
+  return total;
+}
+
+static void run(const size_t keyCount, const unsigned threadCount, const long iterations)
+{
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < keyCount; i++) {
+    keys.push_back("Feed item " + std::to_string(i) + " with a caption of realistic length, liked by many people");
+  }
+  // Room for about half of the strings.
+  const size_t costLimit = keyCount * keys[0].size() * 20;
+  const size_t lookups = 20000;
+  char name[64];
+
+  std::snprintf(name, sizeof(name), "%zu keys/%u threads global lock", keyCount, threadCount);
+  StringCache global(costLimit, 1);
+  AS::Harness::time(name, "lookup", iterations, lookups * threadCount, [&] { return measure(global, keys, threadCount, lookups); });
+
+  std::snprintf(name, sizeof(name), "%zu keys/%u threads sharded", keyCount, threadCount);
+  StringCache sharded(costLimit);
+  AS::Harness::time(name, "lookup", iterations, lookups * threadCount, [&] { return measure(sharded, keys, threadCount, lookups); });
+}
+
+int main(int argc, char *argv[])
+{
+  const long iterations = AS::Harness::iterations(argc, argv, 10);
+  const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+  run(500, 1, iterations);
+  run(500, std::max(2u, cores), iterations);
+  run(5000, std::max(2u, cores), iterations);
+  return 0;
+}
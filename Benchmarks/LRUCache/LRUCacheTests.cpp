@@ -0,0 +1,199 @@
+//
+//  LRUCacheTests.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Host-side checks for the cache behind ASTextNode2's layout cache. The Objective-C surface is covered by
+// Tests/ASTextLayoutCacheTests.mm.
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ASLRUCache.h"
+#include "Harness.h"
+
+using namespace AS;
+
+typedef LRUCache<int, int> IntCache;
+
+static bool contains(IntCache &cache, int key)
+{
+  int value;
+  return cache.find(key, value);
+}
+
+/** With a single shard, the least recently used entry goes first, and lookups count as use. */
+static void testEvictsLeastRecentlyUsed()
+{
+  IntCache cache(3, 1);
+  cache.insert(1, 10, 1);
+  cache.insert(2, 20, 1);
+  cache.insert(3, 30, 1);
+  EXPECT_TRUE(contains(cache, 1));
+  cache.insert(4, 40, 1);
+
+  EXPECT_TRUE(!contains(cache, 2));
+  EXPECT_TRUE(contains(cache, 1));
+  EXPECT_TRUE(contains(cache, 3));
+  EXPECT_TRUE(contains(cache, 4));
+  EXPECT_EQ(cache.statistics().evictions, 1u);
+  EXPECT_EQ(cache.statistics().count, 3u);
+}
+
+static void testCostAccounting()
+{
+  IntCache cache(100, 1);
+  cache.insert(1, 10, 40);
+  cache.insert(2, 20, 40);
+  EXPECT_EQ(cache.statistics().cost, 80u);
+
+  // Replacing a value replaces its cost.
+  cache.insert(1, 11, 10);
+  EXPECT_EQ(cache.statistics().cost, 50u);
+  int value = 0;
+  EXPECT_TRUE(cache.find(1, value));
+  EXPECT_EQ(value, 11);
+
+  // Growing an entry evicts others, least recently used first, but keeps its own recency.
+  cache.insert(3, 30, 10);
+  EXPECT_TRUE(cache.setCost(1, 60));
+  EXPECT_TRUE(!contains(cache, 2));
+  EXPECT_EQ(cache.statistics().cost, 70u);
+
+  // An entry larger than the whole cache does not stay.
+  cache.insert(4, 40, 1000);
+  EXPECT_TRUE(!contains(cache, 4));
+  EXPECT_TRUE(!cache.setCost(4, 1));
+
+  // Lowering the limit evicts right away.
+  cache.setCostLimit(10);
+  EXPECT_TRUE(cache.statistics().cost <= 10);
+
+  EXPECT_TRUE(cache.erase(3) || !contains(cache, 3));
+  cache.clear();
+  EXPECT_EQ(cache.statistics().count, 0u);
+  EXPECT_EQ(cache.statistics().cost, 0u);
+}
+
+static void testStatistics()
+{
+  IntCache cache(1000);
+  int value;
+  cache.insert(1, 10, 1);
+  cache.find(1, value);
+  cache.find(2, value);
+  cache.findOrInsert(2, 1, [] { return 20; });
+  cache.findOrInsert(2, 1, [] { return 21; });
+
+  IntCache::Statistics statistics = cache.statistics();
+  EXPECT_EQ(statistics.hits, 2u);
+  EXPECT_EQ(statistics.misses, 2u);
+  EXPECT_EQ(statistics.count, 2u);
+  EXPECT_EQ(statistics.cost, 2u);
+  EXPECT_TRUE(cache.find(2, value) && value == 20);
+
+  cache.resetStatistics();
+  statistics = cache.statistics();
+  EXPECT_EQ(statistics.hits, 0u);
+  EXPECT_EQ(statistics.misses, 0u);
+  EXPECT_EQ(statistics.count, 2u);
+}
+
+/** Values are destroyed after the shard is unlocked, so their destructors may use the cache. */
+static void testEvictedValuesAreDestroyedOutsideTheLock()
+{
+  struct Reentrant;
+  typedef LRUCache<int, std::shared_ptr<Reentrant>> ReentrantCache;
+  struct Reentrant {
+    Reentrant(ReentrantCache *cache, std::atomic<int> *destroyed) : cache(cache), destroyed(destroyed) {}
+    ReentrantCache *cache;
+    std::atomic<int> *destroyed;
+    ~Reentrant()
+    {
+      cache->statistics();
+      destroyed->fetch_add(1);
+    }
+  };
+
+  std::atomic<int> destroyed(0);
+  ReentrantCache cache(2, 1);
+  for (int i = 0; i < 5; i++) {
+    cache.insert(i, std::make_shared<Reentrant>(&cache, &destroyed), 1);
+  }
+  EXPECT_EQ(destroyed.load(), 3);
+  cache.erase(3);
+  cache.clear();
+  EXPECT_EQ(destroyed.load(), 5);
+}
+
+/** Concurrent callers of findOrInsert for one key all get the value that was stored first. */
+static void testConcurrentFindOrInsert()
+{
+  LRUCache<std::string, int> cache(1 << 20);
+  const int threadCount = 4;
+  const int keyCount = 2000;
+  std::atomic<int> made(0);
+  std::vector<std::vector<int>> seen(threadCount, std::vector<int>(keyCount));
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; t++) {
+    threads.emplace_back([&, t] {
+      for (int k = 0; k < keyCount; k++) {
+        seen[t][k] = cache.findOrInsert(std::to_string(k), 1, [&] { return made.fetch_add(1); });
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(made.load(), keyCount);
+  size_t mismatches = 0;
+  for (int t = 1; t < threadCount; t++) {
+    mismatches += (seen[t] != seen[0]);
+  }
+  EXPECT_EQ(mismatches, 0u);
+  LRUCache<std::string, int>::Statistics statistics = cache.statistics();
+  EXPECT_EQ(statistics.count, (size_t)keyCount);
+  EXPECT_EQ(statistics.hits + statistics.misses, (size_t)(threadCount * keyCount));
+}
+
+/** The cost limit holds across shards while threads insert concurrently. */
+static void testConcurrentInsertStaysWithinLimit()
+{
+  IntCache cache(800);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t] {
+      int value;
+      for (int i = 0; i < 20000; i++) {
+        const int key = (i * 7 + t) % 3000;
+        if (!cache.find(key, value)) {
+          cache.insert(key, i, 1 + key % 3);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  IntCache::Statistics statistics = cache.statistics();
+  EXPECT_TRUE(statistics.cost <= 800);
+  EXPECT_TRUE(statistics.evictions > 0);
+}
+
+int main()
+{
+  testEvictsLeastRecentlyUsed();
+  testCostAccounting();
+  testStatistics();
+  testEvictedValuesAreDestroyedOutsideTheLock();
+  testConcurrentFindOrInsert();
+  testConcurrentInsertStaysWithinLimit();
+  return AS::Harness::finish("LRU cache");
+}
@@ -0,0 +1,98 @@
+//
+//  RunLoopQueueStorageBenchmark.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Times a burst of exclusive enqueues followed by batched draining, i.e. a scroll that schedules many nodes for
+// display, with a model of the NSPointerArray storage ASRunLoopQueue used (a linear membership scan per enqueue and a
+// compaction of the whole array per batch) and with the ring buffer and pointer map.
+// Usage: RunLoopQueueStorageBenchmark [iterations]
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "ASPointerMap.h"
+#include "ASRingBuffer.h"
+#include "Harness.h"
+
+using namespace AS;
+
+/** Enqueues every key twice, as nodes are often scheduled more than once, then drains batchSize at a time. */
+static size_t runPointerArrayModel(const std::vector<const void *> &keys, size_t batchSize)
+{
+  std::vector<const void *> queue;
+  for (int pass = 0; pass < 2; pass++) {
+    for (const void *key : keys) {
+      if (std::find(queue.begin(), queue.end(), key) == queue.end()) {
+        queue.push_back(key);
+      }
+    }
+  }
+  size_t checksum = 0;
+  while (!queue.empty()) {
+    size_t found = 0;
+    for (size_t i = 0; i < queue.size() && found < batchSize; i++) {
+      if (queue[i] != nullptr) {
+        checksum += (uintptr_t)queue[i] >> 4;
+        queue[i] = nullptr;
+        found++;
+      }
+    }
+    queue.erase(std::remove(queue.begin(), queue.end(), nullptr), queue.end());
+  }
+  return checksum;
+}
+
+static size_t runRingBuffer(const std::vector<const void *> &keys, size_t batchSize)
+{
+  RingBuffer<const void *> queue;
+  PointerMap members;
+  for (int pass = 0; pass < 2; pass++) {
+    for (const void *key : keys) {
+      uint64_t sequence;
+      if (!(members.find(key, sequence) && queue.contains(sequence) && queue.at(sequence) == key)) {
+        members.set(key, queue.push_back(key));
+      }
+    }
+  }
+  size_t checksum = 0;
+  while (!queue.empty()) {
+    for (size_t found = 0; found < batchSize && !queue.empty(); found++) {
+      const uint64_t sequence = queue.headSequence();
+      const void *key = queue.pop_front();
+      members.eraseIfEqual(key, sequence);
+      checksum += (uintptr_t)key >> 4;
+    }
+  }
+  return checksum;
+}
+
+static void run(const size_t keyCount, const size_t batchSize, const long iterations)
+{
+  std::vector<const void *> keys;
+  for (size_t i = 0; i < keyCount; i++) {
+    keys.push_back((const void *)(0x100000 + i * 48));
+  }
+  char name[64];
+
+  std::snprintf(name, sizeof(name), "%zu items/batch %zu pointer array", keyCount, batchSize);
+  AS::Harness::time(name, "item", iterations, keyCount, [&] { return runPointerArrayModel(keys, batchSize); });
+
+  std::snprintf(name, sizeof(name), "%zu items/batch %zu ring buffer", keyCount, batchSize);
+  AS::Harness::time(name, "item", iterations, keyCount, [&] { return runRingBuffer(keys, batchSize); });
+}
+
+int main(int argc, char *argv[])
+{
+  const long iterations = AS::Harness::iterations(argc, argv, 10);
+
+  run(100, 1, iterations);
+  run(500, 1, iterations);
+  run(500, 10, iterations);
+  run(2000, 10, iterations);
+  return 0;
+}
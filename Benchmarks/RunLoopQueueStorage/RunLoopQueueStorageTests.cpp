@@ -0,0 +1,165 @@
+//
+//  RunLoopQueueStorageTests.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Host-side checks for the containers behind ASRunLoopQueue. The Objective-C surface is covered by
+// Tests/ASRunLoopQueueTests.mm.
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <unordered_map>
+
+#include "ASPointerMap.h"
+#include "ASRingBuffer.h"
+#include "Harness.h"
+
+using namespace AS;
+
+/** Elements come out in push order across wrap-around and growth, and keep their sequence numbers. */
+static void testRingBufferOrderAndSequences()
+{
+  RingBuffer<int> buffer(4);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(buffer.push_back(0), 0u);
+  EXPECT_EQ(buffer.push_back(1), 1u);
+  EXPECT_EQ(buffer.pop_front(), 0);
+
+  // Wrap around the initial capacity, then grow while wrapped.
+  for (int i = 2; i < 20; i++) {
+    EXPECT_EQ(buffer.push_back(i), (uint64_t)i);
+  }
+  EXPECT_EQ(buffer.size(), 19u);
+  EXPECT_EQ(buffer.headSequence(), 1u);
+  EXPECT_EQ(buffer.tailSequence(), 20u);
+  EXPECT_TRUE(!buffer.contains(0));
+  EXPECT_TRUE(buffer.contains(7));
+  EXPECT_EQ(buffer.at(7), 7);
+  EXPECT_TRUE(!buffer.contains(20));
+
+  for (int i = 1; i < 20; i++) {
+    EXPECT_EQ(buffer.front(), i);
+    EXPECT_EQ(buffer.pop_front(), i);
+  }
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(buffer.headSequence(), 20u);
+}
+
+/** Popped and cleared slots let go of what they held right away. */
+static void testRingBufferReleasesPoppedElements()
+{
+  std::shared_ptr<int> value = std::make_shared<int>(1);
+  RingBuffer<std::shared_ptr<int>> buffer(2);
+  buffer.push_back(value);
+  buffer.push_back(value);
+  buffer.push_back(value);
+  EXPECT_EQ(value.use_count(), 4);
+  buffer.pop_front();
+  EXPECT_EQ(value.use_count(), 3);
+  buffer.clear();
+  EXPECT_EQ(value.use_count(), 1);
+  EXPECT_EQ(buffer.headSequence(), 3u);
+}
+
+static const void *pointer(uintptr_t i)
+{
+  // Aligned like object pointers, so the low bits carry no information.
+  return (const void *)(i * 16);
+}
+
+static void testPointerMapBasics()
+{
+  PointerMap map(2);
+  uint64_t value = 0;
+  EXPECT_TRUE(!map.find(pointer(1), value));
+  map.set(pointer(1), 10);
+  map.set(pointer(2), 20);
+  map.set(pointer(1), 11);
+  EXPECT_EQ(map.size(), 2u);
+  EXPECT_TRUE(map.find(pointer(1), value) && value == 11);
+
+  // Only the entry with the given value is removed.
+  EXPECT_TRUE(!map.eraseIfEqual(pointer(1), 10));
+  EXPECT_TRUE(map.eraseIfEqual(pointer(1), 11));
+  EXPECT_TRUE(!map.find(pointer(1), value));
+  EXPECT_TRUE(map.erase(pointer(2)));
+  EXPECT_TRUE(!map.erase(pointer(2)));
+  EXPECT_TRUE(map.empty());
+}
+
+/** Random inserts and removals agree with std::unordered_map, which exercises probing, growth and backward shifts. */
+static void testPointerMapMatchesReference()
+{
+  PointerMap map;
+  std::unordered_map<const void *, uint64_t> reference;
+  std::mt19937 random(42);
+  for (int i = 0; i < 200000; i++) {
+    // Few distinct keys keep the table dense with collisions.
+    const void *key = pointer(1 + random() % 3000);
+    if (random() % 3 == 0) {
+      EXPECT_EQ(map.erase(key), reference.erase(key) == 1);
+    } else {
+      map.set(key, (uint64_t)i);
+      reference[key] = (uint64_t)i;
+    }
+  }
+  EXPECT_EQ(map.size(), reference.size());
+  size_t mismatches = 0;
+  for (uintptr_t k = 1; k <= 3000; k++) {
+    uint64_t value;
+    const bool found = map.find(pointer(k), value);
+    const auto it = reference.find(pointer(k));
+    mismatches += (found != (it != reference.end())) || (found && value != it->second);
+  }
+  EXPECT_EQ(mismatches, 0u);
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  uint64_t value;
+  EXPECT_TRUE(!map.find(pointer(1), value));
+}
+
+/** The way ASRunLoopQueue combines the two: membership by pointer, validated against the entry's sequence. */
+static void testExclusiveQueue()
+{
+  RingBuffer<const void *> queue;
+  PointerMap members;
+  auto enqueue = [&](const void *key) {
+    uint64_t sequence;
+    if (members.find(key, sequence) && queue.contains(sequence) && queue.at(sequence) == key) {
+      return false;
+    }
+    members.set(key, queue.push_back(key));
+    return true;
+  };
+  auto dequeue = [&]() {
+    const uint64_t sequence = queue.headSequence();
+    const void *key = queue.pop_front();
+    members.eraseIfEqual(key, sequence);
+    return key;
+  };
+
+  EXPECT_TRUE(enqueue(pointer(1)));
+  EXPECT_TRUE(enqueue(pointer(2)));
+  EXPECT_TRUE(!enqueue(pointer(1)));
+  EXPECT_EQ(dequeue(), pointer(1));
+  EXPECT_TRUE(enqueue(pointer(1)));
+  EXPECT_EQ(queue.size(), 2u);
+  EXPECT_EQ(dequeue(), pointer(2));
+  EXPECT_EQ(dequeue(), pointer(1));
+  EXPECT_TRUE(members.empty());
+}
+
+int main()
+{
+  testRingBufferOrderAndSequences();
+  testRingBufferReleasesPoppedElements();
+  testPointerMapBasics();
+  testPointerMapMatchesReference();
+  testExclusiveQueue();
+  return AS::Harness::finish("run loop queue storage");
+}
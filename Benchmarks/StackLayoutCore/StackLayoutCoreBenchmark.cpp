@@ -0,0 +1,164 @@
+//
+//  StackLayoutCoreBenchmark.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Times the stack layout engine on synthetic trees shaped like the layouts we care about.
+// Usage: StackLayoutCoreBenchmark [iterations]
+
+#include <cstdio>
+#include <functional>
+#include <string>
+
+#include "Harness.h"
+#include "StackLayoutFixture.h"
+
+using namespace AS::StackLayout;
+using namespace AS::StackLayout::Fixture;
+
+static const SizeRange kPhoneWidth = {{375, 0}, {375, INFINITY}};
+
+/** One row with many children that need to shrink, e.g. a toolbar or a long horizontal list laid out eagerly. */
+static NodeRef wideStack(const int count)
+{
+  std::vector<NodeRef> children;
+  for (int i = 0; i < count; i++) {
+    auto child = leaf(20 + (i % 7) * 3, 44);
+    child->child.flexShrink = 1;
+    child->child.spacingBefore = 2;
+    children.push_back(child);
+  }
+  Style style = defaultStyle(Direction::Horizontal);
+  style.spacing = 4;
+  style.justifyContent = JustifyContent::SpaceBetween;
+  return stack(style, children);
+}
+
+/** One row of equally flexible children that must all grow, or all shrink, to fill the width exactly. */
+static NodeRef flexStack(const int count, const bool grow)
+{
+  std::vector<NodeRef> children;
+  for (int i = 0; i < count; i++) {
+    auto child = leaf(grow ? 2 : 20 + (i % 5), 30);
+    child->child.flexGrow = grow ? 1 + (i % 3) : 0;
+    child->child.flexShrink = grow ? 0 : 1 + (i % 3);
+    children.push_back(child);
+  }
+  return stack(defaultStyle(Direction::Horizontal), children);
+}
+
+/** Alternating vertical/horizontal stacks nested depth levels deep, each with a flexible and a fixed child. */
+static NodeRef deepStack(const int depth)
+{
+  NodeRef node = leaf(40, 40);
+  for (int level = 0; level < depth; level++) {
+    Style style = defaultStyle(level % 2 == 0 ? Direction::Horizontal : Direction::Vertical);
+    style.spacing = 8;
+    style.alignItems = AlignItems::Center;
+    node->child.flexGrow = 1;
+    node->child.flexShrink = 1;
+    node = stack(style, {leaf(24, 24), node, leaf(16, 16)});
+  }
+  return node;
+}
+
+/** A tag cloud: many chips of varying width that wrap into lines. */
+static NodeRef wrappedStack(const int count)
+{
+  std::vector<NodeRef> chips;
+  for (int i = 0; i < count; i++) {
+    chips.push_back(leaf(30 + (i * 37) % 90, 28));
+  }
+  Style style = defaultStyle(Direction::Horizontal);
+  style.flexWrap = FlexWrap::Wrap;
+  style.spacing = 6;
+  style.lineSpacing = 6;
+  style.alignContent = AlignContent::SpaceBetween;
+  return stack(style, chips);
+}
+
+/** A feed cell: a column of rows, each a horizontal stack of avatar, flexible text column and accessory. */
+static NodeRef cellStack(const int rows)
+{
+  std::vector<NodeRef> children;
+  for (int i = 0; i < rows; i++) {
+    auto text = stack(defaultStyle(Direction::Vertical), {leaf(200, 17), leaf(260, 34)});
+    text->child.flexGrow = 1;
+    text->child.flexShrink = 1;
+    Style row = defaultStyle(Direction::Horizontal);
+    row.spacing = 10;
+    row.alignItems = AlignItems::Center;
+    children.push_back(stack(row, {leaf(40, 40), text, leaf(24, 24)}));
+  }
+  Style column = defaultStyle(Direction::Vertical);
+  column.spacing = 12;
+  return stack(column, children);
+}
+
+/** A feed of cells whose leaves are expensive to measure, like text. Used to compare serial and concurrent layout. */
+static NodeRef feedStack(const int cells, const unsigned measurementCost)
+{
+  std::vector<NodeRef> children;
+  for (int i = 0; i < cells; i++) {
+    children.push_back(cellStack(4));
+  }
+  std::function<void(Node &)> setCost = [&](Node &node) {
+    node.measurementCost = measurementCost;
+    for (auto &child : node.children) {
+      setCost(*child);
+    }
+  };
+  Style column = defaultStyle(Direction::Vertical);
+  auto feed = stack(column, children);
+  setCost(*feed);
+  return feed;
+}
+
+static void run(const char *name, const Node &node, const SizeRange &sizeRange, const long iterations,
+                const bool concurrent = false)
+{
+  AS::Harness::time(name, "layout", iterations, 1, [&] {
+    return layout(node, sizeRange, concurrent).size.width;
+  });
+}
+
+/** Times only UnpositionedLayout::compute of the root stack, i.e. measuring, line breaking, flexing and stretching. */
+static void runUnpositioned(const char *name, const Node &node, const SizeRange &sizeRange, const long iterations)
+{
+  std::vector<Child> children;
+  for (const auto &child : node.children) {
+    children.push_back(child->child);
+  }
+  NodeMeasurer measurer(node, false);
+  AS::Harness::time(name, "layout", iterations, 1, [&] {
+    return UnpositionedLayout::compute(children, node.style, sizeRange, false, measurer).stackDimensionSum;
+  });
+}
+
+int main(int argc, char *argv[])
+{
+  const long iterations = AS::Harness::iterations(argc, argv, 2000);
+
+  run("wide/50", *wideStack(50), kPhoneWidth, iterations);
+  run("wide/500", *wideStack(500), kPhoneWidth, std::max(1L, iterations / 10));
+  runUnpositioned("flex/grow/64", *flexStack(64, true), kPhoneWidth, iterations);
+  runUnpositioned("flex/shrink/64", *flexStack(64, false), kPhoneWidth, iterations);
+  runUnpositioned("flex/shrink/256", *flexStack(256, false), kPhoneWidth, std::max(1L, iterations / 4));
+  run("deep/8", *deepStack(8), kPhoneWidth, iterations);
+  run("deep/16", *deepStack(16), kPhoneWidth, std::max(1L, iterations / 10));
+  run("wrapped/100", *wrappedStack(100), kPhoneWidth, iterations);
+  run("wrapped/1000", *wrappedStack(1000), kPhoneWidth, std::max(1L, iterations / 10));
+  run("cell/10", *cellStack(10), kPhoneWidth, iterations);
+
+  // Nested concurrent measurement on the work-stealing scheduler.
+  const auto feed = feedStack(16, 2000);
+  const long feedIterations = std::max(1L, iterations / 20);
+  run("feed/16 serial", *feed, kPhoneWidth, feedIterations);
+  run("feed/16 concurrent", *feed, kPhoneWidth, feedIterations, true);
+  std::printf("(%u workers, %zu steals)\n", AS::WorkStealingScheduler::shared().workerCount(),
+              AS::WorkStealingScheduler::shared().stealCount());
+  return 0;
+}
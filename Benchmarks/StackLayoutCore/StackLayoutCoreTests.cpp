@@ -0,0 +1,272 @@
+//
+//  StackLayoutCoreTests.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Host-side sanity checks for the flex engine. The full behavior of ASStackLayoutSpec is covered by the
+// snapshot tests in Tests/ASStackLayoutSpecSnapshotTests.mm; these only guard the portable core on its own.
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+#include "Harness.h"
+#include "StackLayoutFixture.h"
+
+using namespace AS::StackLayout;
+using namespace AS::StackLayout::Fixture;
+
+static const SizeRange kUnconstrained = {{0, 0}, {INFINITY, INFINITY}};
+
+static SizeRange exactWidth(const Float width)
+{
+  return {{width, 0}, {width, INFINITY}};
+}
+
+static void testFixedChildrenAreStackedAndStretched()
+{
+  Style style = defaultStyle(Direction::Horizontal);
+  style.spacing = 5;
+  const auto node = stack(style, {leaf(10, 10), leaf(20, 20), leaf(30, 10)});
+  const auto result = layout(*node, kUnconstrained);
+  EXPECT_NEAR(result.size.width, 70);
+  EXPECT_NEAR(result.size.height, 20);
+  EXPECT_NEAR(result.items[0].position.x, 0);
+  EXPECT_NEAR(result.items[1].position.x, 15);
+  EXPECT_NEAR(result.items[2].position.x, 40);
+  // alignItems stretch grows the short children to the line's cross size.
+  EXPECT_NEAR(result.items[0].measurement.size.height, 20);
+  EXPECT_NEAR(result.items[2].measurement.size.height, 20);
+}
+
+static void testFlexGrowDistributesPositiveViolation()
+{
+  auto a = leaf(20, 10);
+  auto b = leaf(20, 10);
+  a->child.flexGrow = 1;
+  b->child.flexGrow = 1;
+  const auto node = stack(defaultStyle(Direction::Horizontal), {a, b});
+  const auto result = layout(*node, exactWidth(100));
+  EXPECT_NEAR(result.items[0].measurement.size.width, 50);
+  EXPECT_NEAR(result.items[1].measurement.size.width, 50);
+  EXPECT_NEAR(result.items[1].position.x, 50);
+}
+
+static void testFlexGrowGivesRoundingRemainderToFirstGrowingItem()
+{
+  auto fixed = leaf(10, 10);
+  auto a = leaf(0, 10);
+  auto b = leaf(0, 10);
+  auto c = leaf(0, 10);
+  a->child.flexGrow = 1;
+  b->child.flexGrow = 1;
+  c->child.flexGrow = 1;
+  const auto node = stack(defaultStyle(Direction::Vertical), {fixed, a, b, c});
+  const auto result = layout(*node, {{0, 110}, {INFINITY, 110}});
+  EXPECT_NEAR(result.items[0].measurement.size.height, 10);
+  EXPECT_NEAR(result.items[1].measurement.size.height, 34);
+  EXPECT_NEAR(result.items[2].measurement.size.height, 33);
+  EXPECT_NEAR(result.items[3].measurement.size.height, 33);
+  EXPECT_NEAR(result.size.height, 110);
+}
+
+static void testFlexShrinkIsProportionalToSize()
+{
+  auto a = leaf(80, 10);
+  auto b = leaf(40, 10);
+  a->child.flexShrink = 1;
+  b->child.flexShrink = 1;
+  const auto node = stack(defaultStyle(Direction::Horizontal), {a, b});
+  const auto result = layout(*node, exactWidth(100));
+  EXPECT_NEAR(result.items[0].measurement.size.width, 80 - 20 * 2.0 / 3.0);
+  EXPECT_NEAR(result.items[1].measurement.size.width, 40 - 20 * 1.0 / 3.0);
+  EXPECT_NEAR(result.size.width, 100);
+}
+
+static void testWrapBreaksIntoLines()
+{
+  Style style = defaultStyle(Direction::Horizontal);
+  style.flexWrap = FlexWrap::Wrap;
+  std::vector<NodeRef> chips;
+  for (int i = 0; i < 5; i++) {
+    chips.push_back(leaf(40, 10));
+  }
+  const auto node = stack(style, chips);
+  const auto result = layout(*node, {{0, 0}, {100, INFINITY}});
+  EXPECT_NEAR(result.size.width, 80);
+  EXPECT_NEAR(result.size.height, 30);
+  EXPECT_NEAR(result.items[1].position.y, 0);
+  EXPECT_NEAR(result.items[2].position.x, 0);
+  EXPECT_NEAR(result.items[2].position.y, 10);
+  EXPECT_NEAR(result.items[4].position.y, 20);
+}
+
+static void testJustifyContentCenter()
+{
+  Style style = defaultStyle(Direction::Horizontal);
+  style.justifyContent = JustifyContent::Center;
+  const auto node = stack(style, {leaf(20, 10), leaf(20, 10)});
+  const auto result = layout(*node, exactWidth(100));
+  EXPECT_NEAR(result.items[0].position.x, 30);
+  EXPECT_NEAR(result.items[1].position.x, 50);
+}
+
+static void testBaselineFirstAlignment()
+{
+  Style style = defaultStyle(Direction::Horizontal);
+  style.alignItems = AlignItems::BaselineFirst;
+  auto tall = leaf(10, 20);
+  tall->ascender = 15;
+  auto small = leaf(10, 10);
+  small->ascender = 5;
+  const auto node = stack(style, {tall, small});
+  const auto result = layout(*node, kUnconstrained);
+  EXPECT_NEAR(result.items[0].position.y, 0);
+  EXPECT_NEAR(result.items[1].position.y, 10);
+  EXPECT_NEAR(result.size.height, 20);
+}
+
+static void testNestedStacks()
+{
+  const auto row = stack(defaultStyle(Direction::Horizontal), {leaf(10, 10), leaf(10, 30)});
+  Style column = defaultStyle(Direction::Vertical);
+  column.alignItems = AlignItems::Start;
+  const auto node = stack(column, {row, leaf(50, 5)});
+  const auto result = layout(*node, kUnconstrained);
+  EXPECT_NEAR(result.items[0].measurement.size.width, 20);
+  EXPECT_NEAR(result.items[1].position.y, 30);
+  EXPECT_NEAR(result.size.width, 50);
+  EXPECT_NEAR(result.size.height, 35);
+}
+
+static void testLayoutArenaRecyclesStorage()
+{
+  auto lease = LayoutArena::acquire(300);
+  const LayoutStorage *storage = lease.get();
+  lease->lines.push_back({0, 300, 0, 0, 0});
+  lease.reset();
+
+  auto reused = LayoutArena::acquire(12);
+  EXPECT_NEAR(reused.get() == storage, 1);
+  EXPECT_NEAR(reused->sizes.size(), 12);
+  EXPECT_NEAR(reused->sizes.capacity() >= 300, 1);
+  EXPECT_NEAR(reused->lines.size(), 0);
+}
+
+static void testWorkStealingRunsEveryIndexOnceWhenNested()
+{
+  AS::WorkStealingScheduler scheduler(3);
+  const size_t outer = 37, inner = 23;
+  std::vector<std::atomic<int>> hits(outer * inner);
+  for (auto &hit : hits) {
+    hit.store(0);
+  }
+  scheduler.parallelFor(outer, [&](size_t i) {
+    scheduler.parallelFor(inner, [&](size_t j) {
+      hits[i * inner + j].fetch_add(1);
+    });
+  });
+  int wrong = 0;
+  for (auto &hit : hits) {
+    wrong += hit.load() != 1;
+  }
+  EXPECT_NEAR(wrong, 0);
+}
+
+static void testWorkStealingServesSeveralCallersAtOnce()
+{
+  AS::WorkStealingScheduler scheduler(2);
+  const size_t callers = 4, count = 101;
+  std::vector<std::atomic<int>> hits(callers * count);
+  for (auto &hit : hits) {
+    hit.store(0);
+  }
+  std::vector<std::thread> threads;
+  for (size_t c = 0; c < callers; c++) {
+    threads.emplace_back([&, c] {
+      scheduler.parallelFor(count, [&](size_t i) {
+        hits[c * count + i].fetch_add(1);
+      });
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  int wrong = 0;
+  for (auto &hit : hits) {
+    wrong += hit.load() != 1;
+  }
+  EXPECT_NEAR(wrong, 0);
+}
+
+static void testWorkStealingCallerOnlyRunsItsOwnTasks()
+{
+  AS::WorkStealingScheduler scheduler(1);
+  const size_t callers = 3, count = 24;
+  std::vector<std::thread::id> callerIds(callers);
+  std::vector<std::thread::id> ranOn(callers * count);
+  std::vector<std::thread> threads;
+  for (size_t c = 0; c < callers; c++) {
+    threads.emplace_back([&, c] {
+      callerIds[c] = std::this_thread::get_id();
+      scheduler.parallelFor(count, [&, c](size_t i) {
+        ranOn[c * count + i] = std::this_thread::get_id();
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+      });
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  int foreign = 0;
+  for (size_t c = 0; c < callers; c++) {
+    for (size_t other = 0; other < callers; other++) {
+      for (size_t i = 0; other != c && i < count; i++) {
+        foreign += ranOn[other * count + i] == callerIds[c];
+      }
+    }
+  }
+  EXPECT_NEAR(foreign, 0);
+}
+
+static void testConcurrentLayoutMatchesSerialLayout()
+{
+  std::vector<NodeRef> rows;
+  for (int i = 0; i < 12; i++) {
+    auto text = stack(defaultStyle(Direction::Vertical), {leaf(200 + i, 17), leaf(260, 34)});
+    text->child.flexShrink = 1;
+    rows.push_back(stack(defaultStyle(Direction::Horizontal), {leaf(40, 40), text, leaf(24, 24)}));
+  }
+  const auto node = stack(defaultStyle(Direction::Vertical), rows);
+  const auto serial = layout(*node, exactWidth(320));
+  const auto concurrent = layout(*node, exactWidth(320), true);
+  EXPECT_NEAR(concurrent.size.width, serial.size.width);
+  EXPECT_NEAR(concurrent.size.height, serial.size.height);
+  for (size_t i = 0; i < serial.items.size(); i++) {
+    EXPECT_NEAR(concurrent.items[i].position.y, serial.items[i].position.y);
+    EXPECT_NEAR(concurrent.items[i].measurement.size.width, serial.items[i].measurement.size.width);
+  }
+}
+
+int main()
+{
+  testFixedChildrenAreStackedAndStretched();
+  testFlexGrowDistributesPositiveViolation();
+  testFlexGrowGivesRoundingRemainderToFirstGrowingItem();
+  testFlexShrinkIsProportionalToSize();
+  testWrapBreaksIntoLines();
+  testJustifyContentCenter();
+  testBaselineFirstAlignment();
+  testNestedStacks();
+  testLayoutArenaRecyclesStorage();
+  testWorkStealingRunsEveryIndexOnceWhenNested();
+  testWorkStealingServesSeveralCallersAtOnce();
+  testWorkStealingCallerOnlyRunsItsOwnTasks();
+  testConcurrentLayoutMatchesSerialLayout();
+  return AS::Harness::finish("stack layout core");
+}
@@ -0,0 +1,140 @@
+//
+//  StackLayoutFixture.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "ASStackLayoutCore.h"
+#include "ASWorkStealingScheduler.h"
+
+namespace AS {
+namespace StackLayout {
+namespace Fixture {
+
+/**
+ * A minimal stand-in for a layout element tree: either a leaf with an intrinsic size, or a stack of other nodes.
+ */
+struct Node {
+  Child child;
+  /** Leaves report this size clamped to the range they are measured in. */
+  Size intrinsicSize;
+  /** Stacks only. */
+  Style style;
+  std::vector<std::shared_ptr<Node>> children;
+  Float ascender;
+  Float descender;
+  /** Busy-work performed each time a leaf is measured, standing in for e.g. text shaping. */
+  unsigned measurementCost;
+
+  bool isStack() const { return !children.empty(); }
+};
+
+typedef std::shared_ptr<Node> NodeRef;
+
+inline Child defaultChild()
+{
+  return {0, 0, 0, 0, {Dimension::Unit::Auto, 0}, AlignSelf::Auto,
+          {{0, 0}, {INFINITY, INFINITY}}};
+}
+
+inline Style defaultStyle(const Direction direction)
+{
+  return {direction, 0, JustifyContent::Start, AlignItems::Stretch, FlexWrap::NoWrap, AlignContent::Start, 0};
+}
+
+inline NodeRef leaf(const Float width, const Float height)
+{
+  NodeRef node = std::make_shared<Node>();
+  node->child = defaultChild();
+  node->intrinsicSize = {width, height};
+  node->style = defaultStyle(Direction::Horizontal);
+  node->ascender = 0;
+  node->descender = 0;
+  node->measurementCost = 0;
+  return node;
+}
+
+inline NodeRef stack(const Style &style, const std::vector<NodeRef> &children)
+{
+  NodeRef node = leaf(0, 0);
+  node->style = style;
+  node->children = children;
+  return node;
+}
+
+struct Result {
+  Size size;
+  std::vector<Item> items;
+};
+
+Result layout(const Node &node, const SizeRange &sizeRange, bool concurrent = false);
+
+inline Float simulateMeasurementCost(const unsigned cost)
+{
+  volatile Float sink = 0;
+  for (unsigned i = 0; i < cost; i++) {
+    sink = sink + std::sqrt((Float)i);
+  }
+  return sink;
+}
+
+/**
+ * Measures the children of one stack, recursing into nested stacks. Concurrent layouts run on the shared
+ * work-stealing scheduler, and stacks measured from one of its tasks are laid out concurrently as well.
+ */
+class NodeMeasurer : public Measurer {
+public:
+  NodeMeasurer(const Node &node, bool concurrent) : _node(node), _concurrent(concurrent) {}
+
+  Measurement measure(size_t index, const SizeRange &sizeRange, const Size &parentSize) override
+  {
+    const Node &child = *_node.children[index];
+    if (child.isStack()) {
+      return {layout(child, sizeRange, _concurrent).size, child.ascender, child.descender};
+    }
+    simulateMeasurementCost(child.measurementCost);
+    return {clamp(sizeRange, child.intrinsicSize), child.ascender, child.descender};
+  }
+
+  Measurement measureAtZeroSize(size_t index) override
+  {
+    const Node &child = *_node.children[index];
+    return {{0, 0}, child.ascender, child.descender};
+  }
+
+  void apply(size_t count, const std::function<void(size_t)> &work) override
+  {
+    WorkStealingScheduler::shared().parallelFor(count, work);
+  }
+
+private:
+  const Node &_node;
+  const bool _concurrent;
+};
+
+inline Result layout(const Node &node, const SizeRange &sizeRange, bool concurrent)
+{
+  std::vector<Child> children;
+  children.reserve(node.children.size());
+  for (const auto &child : node.children) {
+    children.push_back(child->child);
+  }
+  concurrent = concurrent || WorkStealingScheduler::isExecutingTask();
+  NodeMeasurer measurer(node, concurrent);
+  const auto unpositioned = UnpositionedLayout::compute(children, node.style, sizeRange, concurrent, measurer);
+  auto positioned = PositionedLayout::compute(unpositioned, children, node.style, sizeRange, 2);
+  return {positioned.size, std::move(positioned.items)};
+}
+
+} // namespace Fixture
+} // namespace StackLayout
+} // namespace AS
@@ -0,0 +1,194 @@
+//
+//  TransactionSchedulerBenchmark.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Times scheduling and running bursts of small operations, i.e. the display operations of a screenful of cells, with
+// the previous single-mutex queue and with ASTransactionScheduler.
+// Usage: TransactionSchedulerBenchmark [iterations]
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Harness.h"
+#include "TransactionSchedulerFixture.h"
+
+using namespace AS;
+using namespace AS::Fixture;
+
+/**
+ * The previous ASAsyncTransactionQueue: a single mutex guarding a list of operations and a map from priority to list
+ * iterators. The first thread takes operations in queue order, all others by priority, and each completed operation
+ * takes the mutex once more to leave its group.
+ */
+class LegacyQueue {
+public:
+  ~LegacyQueue()
+  {
+    join();
+  }
+
+  void schedule(long priority, const std::function<void()> &block, unsigned maxThreads)
+  {
+    std::lock_guard<std::mutex> l(_mutex);
+    _operations.push_back({block, priority});
+    _priorityMap[priority].push_back(--_operations.end());
+    _pending++;
+
+    if (_threadCount < maxThreads) {
+      const bool respectPriority = _threadCount > 0;
+      _threadCount++;
+      _threads.emplace_back([this, respectPriority] { drain(respectPriority); });
+    }
+  }
+
+  /** Waits until every scheduled operation finished. */
+  void wait()
+  {
+    std::unique_lock<std::mutex> l(_mutex);
+    _condition.wait(l, [this] { return _pending == 0; });
+  }
+
+  void join()
+  {
+    wait();
+    std::vector<std::thread> threads;
+    {
+      std::lock_guard<std::mutex> l(_mutex);
+      threads.swap(_threads);
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+private:
+  struct Operation {
+    std::function<void()> block;
+    long priority;
+  };
+  typedef std::list<Operation> OperationQueue;
+
+  void drain(bool respectPriority)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_operations.empty()) {
+      OperationQueue::iterator queueIterator;
+      std::map<long, std::list<OperationQueue::iterator>>::iterator mapIterator;
+      if (respectPriority) {
+        mapIterator = --_priorityMap.end();
+        queueIterator = mapIterator->second.front();
+      } else {
+        queueIterator = _operations.begin();
+        mapIterator = _priorityMap.find(queueIterator->priority);
+      }
+      Operation operation = *queueIterator;
+      _operations.erase(queueIterator);
+      mapIterator->second.pop_front();
+      if (mapIterator->second.empty()) {
+        _priorityMap.erase(mapIterator);
+      }
+      lock.unlock();
+      operation.block();
+      lock.lock();
+      // Leaving the group.
+      if (--_pending == 0) {
+        _condition.notify_all();
+      }
+    }
+    _threadCount--;
+  }
+
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  OperationQueue _operations;
+  std::map<long, std::list<OperationQueue::iterator>> _priorityMap;
+  unsigned _threadCount = 0;
+  size_t _pending = 0;
+  std::vector<std::thread> _threads;
+};
+
+/** Stands in for rendering a small layer. */
+static size_t work(size_t seed)
+{
+  size_t hash = seed;
+  for (int i = 0; i < 200; i++) {
+    hash = hash * 31 + i;
+  }
+  return hash;
+}
+
+static void increment(void *context)
+{
+  std::atomic<size_t> *counter = static_cast<std::atomic<size_t> *>(context);
+  // The comparison keeps the work from being optimized away; it is never true.
+  counter->fetch_add(1 + (work(counter->load(std::memory_order_relaxed)) == 0));
+}
+
+static void run(const size_t operations, const unsigned producers, const unsigned workers, const long iterations)
+{
+  char name[64];
+  const size_t perProducer = operations / producers;
+
+  std::snprintf(name, sizeof(name), "%zu ops/%u producers legacy", operations, producers);
+  // Both queues live as long as the process in the framework, so they are reused across bursts here too.
+  LegacyQueue queue;
+  AS::Harness::time(name, "operation", iterations, operations, [&] {
+    std::atomic<size_t> counter(0);
+    std::vector<std::thread> threads;
+    for (unsigned p = 0; p < producers; p++) {
+      threads.emplace_back([&, p] {
+        for (size_t i = 0; i < perProducer; i++) {
+          queue.schedule((long)(i % 3), [&] { increment(&counter); }, workers);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    queue.join();
+    return counter.load();
+  });
+
+  std::snprintf(name, sizeof(name), "%zu ops/%u producers rings", operations, producers);
+  ThreadSpawner spawner;
+  AS::Harness::time(name, "operation", iterations, operations, [&] {
+    std::atomic<size_t> counter(0);
+    std::vector<std::thread> threads;
+    for (unsigned p = 0; p < producers; p++) {
+      threads.emplace_back([&, p] {
+        for (size_t i = 0; i < perProducer; i++) {
+          spawner.scheduler.schedule((long)(i % 3), {increment, &counter, nullptr, nullptr, 0, 0}, workers);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    spawner.join();
+    return counter.load();
+  });
+}
+
+int main(int argc, char *argv[])
+{
+  const long iterations = AS::Harness::iterations(argc, argv, 50);
+  const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+  run(100, 1, cores, iterations);
+  run(1000, 1, cores, iterations);
+  run(1000, 4, cores, iterations);
+  run(10000, 4, cores, std::max(1L, iterations / 10));
+  return 0;
+}
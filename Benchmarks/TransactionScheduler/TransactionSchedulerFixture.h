@@ -0,0 +1,74 @@
+//
+//  TransactionSchedulerFixture.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+// Shared by the host tests and the benchmark: threads standing in for the dispatch queue that the scheduler's workers
+// run on.
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ASTransactionScheduler.h"
+
+namespace AS {
+namespace Fixture {
+
+/** Runs every worker on a thread of its own, the way a concurrent dispatch queue would. */
+class ThreadSpawner {
+public:
+  ThreadSpawner() : scheduler(&ThreadSpawner::spawn, this) {}
+
+  ~ThreadSpawner()
+  {
+    join();
+  }
+
+  /** Waits for every worker spawned so far, including the ones spawned while waiting. */
+  void join()
+  {
+    while (true) {
+      std::vector<std::thread> threads;
+      {
+        std::lock_guard<std::mutex> l(_mutex);
+        threads.swap(_threads);
+      }
+      if (threads.empty()) {
+        return;
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+    }
+  }
+
+  size_t spawnCount()
+  {
+    std::lock_guard<std::mutex> l(_mutex);
+    return _spawnCount;
+  }
+
+  TransactionScheduler scheduler;
+
+private:
+  static void spawn(TransactionScheduler &scheduler, unsigned worker, void *context)
+  {
+    ThreadSpawner *self = static_cast<ThreadSpawner *>(context);
+    std::lock_guard<std::mutex> l(self->_mutex);
+    self->_spawnCount++;
+    self->_threads.emplace_back([&scheduler, worker] { scheduler.drain(worker); });
+  }
+
+  std::mutex _mutex;
+  std::vector<std::thread> _threads;
+  size_t _spawnCount = 0;
+};
+
+} // namespace Fixture
+} // namespace AS
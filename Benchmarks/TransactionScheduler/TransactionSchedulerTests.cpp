@@ -0,0 +1,309 @@
+//
+//  TransactionSchedulerTests.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+// Host-side checks for the scheduler behind _ASAsyncTransaction. The Objective-C surface is covered by
+// Tests/ASTransactionTests.mm.
+
+#include <atomic>
+#include <cstdio>
+#include <vector>
+
+#include "Harness.h"
+#include "TransactionSchedulerFixture.h"
+
+using namespace AS;
+using namespace AS::Fixture;
+
+struct Recorder {
+  std::mutex mutex;
+  std::vector<long> order;
+};
+
+struct RecordedTask {
+  Recorder *recorder;
+  long priority;
+  long value;
+};
+
+static void record(void *context)
+{
+  RecordedTask *task = static_cast<RecordedTask *>(context);
+  std::lock_guard<std::mutex> l(task->recorder->mutex);
+  task->recorder->order.push_back(task->value);
+}
+
+static void increment(void *context)
+{
+  static_cast<std::atomic<size_t> *>(context)->fetch_add(1);
+}
+
+/** Holds the first worker (the round-robin one) so that tasks can be queued up for a worker that respects priority. */
+struct Gate {
+  Gate()
+  {
+    mutex.lock();
+  }
+
+  void close(TransactionScheduler &scheduler)
+  {
+    scheduler.schedule(0, {block, this, nullptr, nullptr, 0, 0}, 1);
+    while (!entered.load()) {
+      std::this_thread::yield();
+    }
+  }
+
+  /** Starts a second worker, waits until it drained everything and opens the gate. */
+  void open(TransactionScheduler &scheduler)
+  {
+    std::atomic<size_t> sentinel(0);
+    scheduler.schedule(-100, {increment, &sentinel, nullptr, nullptr, 0, 0}, 2);
+    while (scheduler.statistics().depth > 0) {
+      std::this_thread::yield();
+    }
+    mutex.unlock();
+  }
+
+  static void block(void *context)
+  {
+    Gate *gate = static_cast<Gate *>(context);
+    gate->entered.store(true);
+    gate->mutex.lock();
+    gate->mutex.unlock();
+  }
+
+  std::mutex mutex;
+  std::atomic<bool> entered{false};
+};
+
+/** A single worker that respects priority runs the highest priority first and keeps each priority in order. */
+static void testPriorityOrder()
+{
+  Recorder recorder;
+  std::vector<RecordedTask> tasks;
+  const long priorities[] = {0, 5, -3, 5, 0, 10, -3};
+  for (size_t i = 0; i < sizeof(priorities) / sizeof(priorities[0]); i++) {
+    tasks.push_back({&recorder, priorities[i], (long)i});
+  }
+
+  ThreadSpawner spawner;
+  Gate gate;
+  gate.close(spawner.scheduler);
+  for (auto &task : tasks) {
+    // The limit of one keeps a second worker from starting while the first one is stuck at the gate.
+    spawner.scheduler.schedule(task.priority, {record, &task, nullptr, nullptr, 0, 0}, 1);
+  }
+  gate.open(spawner.scheduler);
+  spawner.join();
+
+  const std::vector<long> expected = {5, 1, 3, 0, 4, 2, 6};
+  EXPECT_EQ(recorder.order, expected);
+}
+
+/** Within a priority, tasks that are due soon run before the rest; later priorities still wait. */
+static void testUrgentTasksRunFirst()
+{
+  Recorder recorder;
+  std::vector<RecordedTask> tasks;
+  for (long i = 0; i < 6; i++) {
+    tasks.push_back({&recorder, i < 4 ? 0 : 1, i});
+  }
+
+  ThreadSpawner spawner;
+  Gate gate;
+  gate.close(spawner.scheduler);
+  const uint64_t now = TransactionScheduler::now();
+  const uint64_t soon = now + spawner.scheduler.urgentHorizon() / 2;
+  const uint64_t later = now + spawner.scheduler.urgentHorizon() * 100;
+  spawner.scheduler.schedule(0, {record, &tasks[0], nullptr, nullptr, later, 0}, 1);
+  spawner.scheduler.schedule(0, {record, &tasks[1], nullptr, nullptr, 0, 0}, 1);
+  spawner.scheduler.schedule(0, {record, &tasks[2], nullptr, nullptr, soon, 0}, 1);
+  spawner.scheduler.schedule(0, {record, &tasks[3], nullptr, nullptr, soon, 0}, 1);
+  spawner.scheduler.schedule(1, {record, &tasks[4], nullptr, nullptr, later, 0}, 1);
+  spawner.scheduler.schedule(1, {record, &tasks[5], nullptr, nullptr, soon, 0}, 1);
+  gate.open(spawner.scheduler);
+  spawner.join();
+
+  const std::vector<long> expected = {5, 4, 2, 3, 0, 1};
+  EXPECT_EQ(recorder.order, expected);
+}
+
+/**
+ * On a 120Hz display, the display of a visible node (due next frame) is urgent, but that of a node in the display range
+ * (due in four frames) is not.
+ */
+static void testUrgentHorizonFollowsFrameDuration()
+{
+  Recorder recorder;
+  std::vector<RecordedTask> tasks;
+  for (long i = 0; i < 2; i++) {
+    tasks.push_back({&recorder, 0, i});
+  }
+
+  ThreadSpawner spawner;
+  const uint64_t frameDuration = 1000 * 1000 * 1000 / 120;
+  spawner.scheduler.setFrameDuration(frameDuration);
+  EXPECT_EQ(spawner.scheduler.urgentHorizon(), TransactionScheduler::kUrgentHorizonFrames * frameDuration);
+  Gate gate;
+  gate.close(spawner.scheduler);
+  const uint64_t now = TransactionScheduler::now();
+  spawner.scheduler.schedule(0, {record, &tasks[0], nullptr, nullptr, now + 4 * frameDuration, 0}, 1);
+  spawner.scheduler.schedule(0, {record, &tasks[1], nullptr, nullptr, now + frameDuration, 0}, 1);
+  gate.open(spawner.scheduler);
+  spawner.join();
+
+  const std::vector<long> expected = {1, 0};
+  EXPECT_EQ(recorder.order, expected);
+}
+
+/** Stale tasks are dropped right before they would start, and tasks that start late are counted. */
+static void testStaleTasksAreDropped()
+{
+  struct Context {
+    std::atomic<bool> stale{false};
+    std::atomic<size_t> invoked{0};
+    std::atomic<size_t> dropped{0};
+  } context;
+  auto invoke = [](void *c) { static_cast<Context *>(c)->invoked.fetch_add(1); };
+  auto drop = [](void *c) { static_cast<Context *>(c)->dropped.fetch_add(1); };
+  auto isStale = [](void *c) { return static_cast<Context *>(c)->stale.load(); };
+
+  ThreadSpawner spawner;
+  Gate gate;
+  gate.close(spawner.scheduler);
+  const uint64_t past = TransactionScheduler::now() - 1;
+  for (int i = 0; i < 10; i++) {
+    spawner.scheduler.schedule(0, {invoke, &context, drop, isStale, past, 0}, 1);
+  }
+  // The tasks go stale while they wait, e.g. because their node left the display range.
+  context.stale.store(true);
+  gate.open(spawner.scheduler);
+  spawner.join();
+  EXPECT_EQ(context.invoked.load(), 0u);
+  EXPECT_EQ(context.dropped.load(), 10u);
+  EXPECT_EQ(spawner.scheduler.statistics().dropped, 10u);
+  EXPECT_EQ(spawner.scheduler.statistics().missedDeadlines, 0u);
+
+  context.stale.store(false);
+  for (int i = 0; i < 10; i++) {
+    spawner.scheduler.schedule(0, {invoke, &context, drop, isStale, past, 0}, 1);
+  }
+  spawner.join();
+  EXPECT_EQ(context.invoked.load(), 10u);
+  EXPECT_EQ(spawner.scheduler.statistics().missedDeadlines, 10u);
+}
+
+/** Every task runs exactly once, no matter how many producers race and how far the rings overflow. */
+static void testConcurrentProducers()
+{
+  const size_t producerCount = 4;
+  const size_t tasksPerProducer = 5000;
+  std::vector<std::atomic<size_t>> counts(producerCount * tasksPerProducer);
+  for (auto &count : counts) {
+    count.store(0);
+  }
+
+  ThreadSpawner spawner;
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < producerCount; p++) {
+    producers.emplace_back([&, p] {
+      for (size_t i = 0; i < tasksPerProducer; i++) {
+        const size_t index = p * tasksPerProducer + i;
+        spawner.scheduler.schedule((long)(index % 12) - 6, {increment, &counts[index], nullptr, nullptr, 0, 0}, 3);
+      }
+    });
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  spawner.join();
+
+  size_t wrong = 0;
+  for (auto &count : counts) {
+    wrong += (count.load() != 1);
+  }
+  EXPECT_EQ(wrong, 0u);
+  EXPECT_EQ(spawner.scheduler.statistics().depth, 0u);
+  EXPECT_EQ(spawner.scheduler.statistics().executed, counts.size());
+}
+
+/** A worker limit of one runs everything on one worker at a time. */
+static void testWorkerLimit()
+{
+  std::atomic<int> running(0);
+  std::atomic<int> maxRunning(0);
+  struct Context {
+    std::atomic<int> *running;
+    std::atomic<int> *maxRunning;
+  } context = {&running, &maxRunning};
+  auto body = [](void *c) {
+    Context *context = static_cast<Context *>(c);
+    const int now = context->running->fetch_add(1) + 1;
+    int max = context->maxRunning->load();
+    while (max < now && !context->maxRunning->compare_exchange_weak(max, now)) {}
+    std::this_thread::yield();
+    context->running->fetch_sub(1);
+  };
+
+  ThreadSpawner spawner;
+  for (int i = 0; i < 2000; i++) {
+    spawner.scheduler.schedule(i % 3, {body, &context, nullptr, nullptr, 0, 0}, 1);
+  }
+  spawner.join();
+  EXPECT_EQ(maxRunning.load(), 1);
+}
+
+static void testStatistics()
+{
+  ThreadSpawner spawner;
+  std::atomic<size_t> count(0);
+  for (int i = 0; i < 100; i++) {
+    spawner.scheduler.schedule(0, {increment, &count, nullptr, nullptr, 0, 0}, 2);
+  }
+  spawner.join();
+
+  TransactionScheduler::Statistics statistics = spawner.scheduler.statistics();
+  EXPECT_EQ(count.load(), 100u);
+  EXPECT_EQ(statistics.executed, 100u);
+  EXPECT_EQ(statistics.depth, 0u);
+  EXPECT_TRUE(statistics.maxDepth >= 1 && statistics.maxDepth <= 100);
+  EXPECT_TRUE(statistics.waitSamples >= 100 / TransactionScheduler::kWaitSampleInterval);
+  EXPECT_TRUE(statistics.waitSamples <= 100 / TransactionScheduler::kWaitSampleInterval + 1);
+  EXPECT_TRUE(statistics.maxWaitNanoseconds <= statistics.totalWaitNanoseconds);
+
+  spawner.scheduler.resetStatistics();
+  statistics = spawner.scheduler.statistics();
+  EXPECT_EQ(statistics.executed, 0u);
+  EXPECT_EQ(statistics.maxDepth, 0u);
+  EXPECT_EQ(statistics.waitSamples, 0u);
+  EXPECT_EQ(statistics.totalWaitNanoseconds, 0u);
+}
+
+/** More priorities than queues still run, sharing the queue of the closest priority. */
+static void testManyPriorities()
+{
+  ThreadSpawner spawner;
+  std::atomic<size_t> count(0);
+  for (long i = 0; i < 64; i++) {
+    spawner.scheduler.schedule(i * 7 - 200, {increment, &count, nullptr, nullptr, 0, 0}, 2);
+  }
+  spawner.join();
+  EXPECT_EQ(count.load(), 64u);
+}
+
+int main()
+{
+  testPriorityOrder();
+  testUrgentTasksRunFirst();
+  testUrgentHorizonFollowsFrameDuration();
+  testStaleTasksAreDropped();
+  testConcurrentProducers();
+  testWorkerLimit();
+  testStatistics();
+  testManyPriorities();
+  return AS::Harness::finish("transaction scheduler");
+}
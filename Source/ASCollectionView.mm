@@ -133,6 +133,12 @@ static NSString * const kReuseIdentifier = @"_ASCollectionReuseIdentifier";
    */
   BOOL _superIsPendingDataLoad;
 
+  /**
+   * Whether the last update committed only the leading items of a reload, with the rest still to be inserted. The
+   * pending data load then doesn't check for batch fetching, as the content is not yet complete.
+   */
+  BOOL _lastUpdateHasPendingRemainder;
+
   /**
    * It's important that we always check for batch fetching at least once, but also
    * that we do not check for batch fetching for empty updates (as that may cause an infinite
@@ -1072,7 +1078,9 @@ static NSString * const kReuseIdentifier = @"_ASCollectionReuseIdentifier";
 {
   if (_superIsPendingDataLoad) {
     [_rangeController setNeedsUpdate];
-    [self _scheduleCheckForBatchFetchingForNumberOfChanges:1];
+    if (!_lastUpdateHasPendingRemainder) {
+      [self _scheduleCheckForBatchFetchingForNumberOfChanges:1];
+    }
     _superIsPendingDataLoad = NO;
   }
   return _dataController.visibleMap.numberOfSections;
@@ -1922,6 +1930,14 @@ static NSString * const kReuseIdentifier = @"_ASCollectionReuseIdentifier";
   return ASCellLayoutModeIncludes(ASCellLayoutModeSerializeNodeCreation);
 }
 
+- (CGRect)dataController:(ASDataController *)dataController displayRangeBoundsWithAnchorIndexPath:(NSIndexPath **)anchorIndexPath
+{
+  ASDisplayNodeAssertMainThread();
+  *anchorIndexPath = [self.indexPathsForVisibleItems sortedArrayUsingSelector:@selector(compare:)].firstObject;
+  ASRangeTuningParameters tuningParameters = [_rangeController tuningParametersForRangeMode:ASLayoutRangeModeFull rangeType:ASLayoutRangeTypeDisplay];
+  return CGRectExpandToRangeWithScrollableDirections(self.bounds, tuningParameters, self.scrollableDirections, self.scrollDirection);
+}
+
 - (id)dataController:(ASDataController *)dataController nodeModelForItemAtIndexPath:(NSIndexPath *)indexPath
 {
   if (!_asyncDataSourceFlags.nodeModelForItem) {
@@ -2216,6 +2232,7 @@ static NSString * const kReuseIdentifier = @"_ASCollectionReuseIdentifier";
 - (void)rangeController:(ASRangeController *)rangeController updateWithChangeSet:(_ASHierarchyChangeSet *)changeSet updates:(dispatch_block_t)updates
 {
   ASDisplayNodeAssertMainThread();
+  _lastUpdateHasPendingRemainder = changeSet.hasPendingRemainder;
   if (!self.asyncDataSource || _superIsPendingDataLoad || _updatingInResponseToInteractiveMove) {
     updates();
     [changeSet executeCompletionHandlerWithFinished:NO];
@@ -9,6 +9,7 @@
 
 #import <AsyncDisplayKit/ASAvailability.h>
 #import <AsyncDisplayKit/ASCollections.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASDisplayNodeExtras.h>
 #import <AsyncDisplayKit/ASDisplayNodeInternal.h>
 #import <AsyncDisplayKit/ASDisplayNode+Subclasses.h>
@@ -98,17 +99,39 @@ using AS::MutexLocker;
 
   ASLayout *layout = nil;
   NSUInteger version = _layoutVersion;
-  if (_calculatedDisplayNodeLayout.isValid(constrainedSize, parentSize, version)) {
+  // Subtrees that were not invalidated since they were last measured are reused as is, and positioned by the caller.
+  // With incremental layout that also holds if only the parent size changed but the layout does not depend on it.
+  const BOOL dependsOnParentSize = !ASActivateExperimentalFeature(ASExperimentalIncrementalLayout)
+                                   || [self _locked_layoutDependsOnParentSize];
+  if (_calculatedDisplayNodeLayout.isValid(constrainedSize, parentSize, version, dependsOnParentSize)) {
     ASDisplayNodeAssertNotNil(_calculatedDisplayNodeLayout.layout, @"-[ASDisplayNode layoutThatFits:parentSize:] _calculatedDisplayNodeLayout.layout should not be nil! %@", self);
     layout = _calculatedDisplayNodeLayout.layout;
-  } else if (_pendingDisplayNodeLayout.isValid(constrainedSize, parentSize, version)) {
+  } else if (_pendingDisplayNodeLayout.isValid(constrainedSize, parentSize, version, dependsOnParentSize)) {
     ASDisplayNodeAssertNotNil(_pendingDisplayNodeLayout.layout, @"-[ASDisplayNode layoutThatFits:parentSize:] _pendingDisplayNodeLayout.layout should not be nil! %@", self);
     layout = _pendingDisplayNodeLayout.layout;
   } else {
-    // Create a pending display node layout for the layout pass
-    layout = [self calculateLayoutThatFits:constrainedSize
-                          restrictedToSize:self.style.size
-                      relativeToParentSize:parentSize];
+    // Before calculating, check whether a layout for exactly these inputs was calculated earlier.
+    const BOOL useLayoutMemo = ASActivateExperimentalFeature(ASExperimentalLayoutMemo);
+    ASLayoutMemo::Key memoKey;
+    if (useLayoutMemo) {
+      memoKey = {constrainedSize, dependsOnParentSize ? parentSize : CGSizeZero, [self _locked_style].generation, version, _primitiveTraitCollection};
+      if (_layoutMemo == nullptr) {
+        _layoutMemo.reset(new ASLayoutMemo());
+      }
+      layout = _layoutMemo->lookup(memoKey);
+    }
+
+    if (layout == nil) {
+      // Create a pending display node layout for the layout pass
+      layout = [self calculateLayoutThatFits:constrainedSize
+                            restrictedToSize:self.style.size
+                        relativeToParentSize:parentSize];
+      // Only remember the layout if the style didn't change while calculating it, e.g. text nodes update their
+      // ascender and descender during their first layout.
+      if (useLayoutMemo && [self _locked_style].generation == memoKey.styleGeneration) {
+        _layoutMemo->store(memoKey, layout);
+      }
+    }
     as_log_verbose(ASLayoutLog(), "Established pending layout for %@ in %s", self, sel_getName(_cmd));
     _pendingDisplayNodeLayout = ASDisplayNodeLayout(layout, constrainedSize, parentSize,version);
     ASDisplayNodeAssertNotNil(layout, @"-[ASDisplayNode layoutThatFits:parentSize:] newly calculated layout should not be nil! %@", self);
@@ -117,6 +140,31 @@ using AS::MutexLocker;
   return layout ?: [ASLayout layoutWithLayoutElement:self size:{0, 0}];
 }
 
+/**
+ * Whether layouts of the receiver can differ between parent sizes. The parent size is only used to resolve fractional
+ * dimensions of the style size, unless a subclass takes it into account itself.
+ */
+- (BOOL)_locked_layoutDependsOnParentSize
+{
+  DISABLED_ASAssertLocked(__instanceLock__);
+  if (_methodOverrides & ASDisplayNodeMethodOverrideCalcLayoutRelativeToParentSize) {
+    return YES;
+  }
+#if YOGA
+  if (_yogaParent != nil || _yogaChildren.count > 0) {
+    return YES;
+  }
+#endif
+  const ASLayoutElementSize size = [self _locked_style].size;
+  const ASDimension dimensions[] = {size.width, size.height, size.minWidth, size.maxWidth, size.minHeight, size.maxHeight};
+  for (const ASDimension &dimension : dimensions) {
+    if (dimension.unit == ASDimensionUnitFraction) {
+      return YES;
+    }
+  }
+  return NO;
+}
+
 #pragma mark ASLayoutElementStyleExtensibility
 
 ASLayoutElementStyleExtensibilityForwarding
@@ -438,7 +486,24 @@ ASLayoutElementStyleExtensibilityForwarding
     // particular ASLayout object, and shouldn't loop asking again unless we have a different ASLayout.
     nextLayout.requestedLayoutFromAbove = YES;
 
-    {
+    const BOOL incrementalLayout = ASActivateExperimentalFeature(ASExperimentalIncrementalLayout);
+    if (incrementalLayout) {
+      // nextLayout is up to date, only our ancestors are dirty. Offer it as pending layout under our new version
+      // before asking them for layout, so that their layout pass picks it up rather than measuring this subtree again.
+      __instanceLock__.unlock();
+      [self setNeedsLayout];
+      __instanceLock__.lock();
+      nextLayout.version = _layoutVersion;
+      _pendingDisplayNodeLayout = nextLayout;
+      ASDisplayNode *supernode = _supernode;
+      __instanceLock__.unlock();
+      if (supernode) {
+        [supernode _u_setNeedsLayoutFromAbove];
+      } else {
+        [self _rootNodeDidInvalidateSize];
+      }
+      __instanceLock__.lock();
+    } else {
       __instanceLock__.unlock();
       [self _u_setNeedsLayoutFromAbove];
       __instanceLock__.lock();
@@ -452,7 +517,10 @@ ASLayoutElementStyleExtensibilityForwarding
     // when the pending layout transition which will be created later in this method is applied.
     // We will use _calculatedLayout the next time around, so requestedLayoutFromAbove will be set to YES and we
     // will break out of this layout loop.
-    _pendingDisplayNodeLayout.layout = nil;
+    // With incremental layout the pending layout is nextLayout, which has requestedLayoutFromAbove set, so keep it.
+    if (!incrementalLayout) {
+      _pendingDisplayNodeLayout.layout = nil;
+    }
     
     // Update the layout's version here because _u_setNeedsLayoutFromAbove calls __setNeedsLayout which in turn increases _layoutVersion
     // Failing to do this will cause the layout to be invalid immediately
@@ -167,6 +167,11 @@ static ASDisplayNodeMethodOverrides GetASDisplayNodeMethodOverrides(Class c)
                                                           relativeToParentSize:))) {
     overrides |= ASDisplayNodeMethodOverrideCalcLayoutThatFits;
   }
+  if (ASDisplayNodeSubclassOverridesSelector(c, @selector(calculateLayoutThatFits:
+                                                          restrictedToSize:
+                                                          relativeToParentSize:))) {
+    overrides |= ASDisplayNodeMethodOverrideCalcLayoutRelativeToParentSize;
+  }
   if (ASDisplayNodeSubclassOverridesSelector(c, @selector(calculateSizeThatFits:))) {
     overrides |= ASDisplayNodeMethodOverrideCalcSizeThatFits;
   }
@@ -802,6 +807,20 @@ ASSynthesizeLockingMethodsWithMutex(__instanceLock__);
   _threadSafeBounds = newBounds;
 }
 
+- (CGRect)_visibleBoundsInWindow
+{
+  ASDisplayNodeAssertMainThread();
+  if (!self.isNodeLoaded) {
+    return CGRectNull;
+  }
+  CALayer *layer = self.layer;
+  UIWindow *window = ASFindWindowOfLayer(layer);
+  if (window == nil) {
+    return CGRectNull;
+  }
+  return CGRectIntersection(layer.bounds, [layer convertRect:window.layer.bounds fromLayer:window.layer]);
+}
+
 - (void)nodeViewDidAddGestureRecognizer
 {
   MutexLocker l(__instanceLock__);
@@ -1297,6 +1316,7 @@ NSString * const ASRenderingEngineDidDisplayNodesScheduledBeforeTimestamp = @"AS
                                                           userInfo:@{ASRenderingEngineDidDisplayNodesScheduledBeforeTimestamp: @(timestamp)}];
       }
     }];
+    renderQueue.drainsWithinFrameBudget = ASActivateExperimentalFeature(ASExperimentalFrameBudgetedRunLoopQueues);
   });
 
   as_log_verbose(ASDisplayLog(), "%s %@", sel_getName(_cmd), node);
@@ -8,6 +8,7 @@
 //
 
 #import <AsyncDisplayKit/ASDisplayNodeExtras.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASDisplayNodeInternal.h>
 #import <AsyncDisplayKit/ASDisplayNode+Ancestry.h>
 
@@ -24,6 +25,7 @@ void ASPerformMainThreadDeallocation(id _Nullable __strong * _Nonnull objectPtr)
   dispatch_once(&onceToken, ^{
     queue = [[ASRunLoopQueue alloc] initWithRunLoop:CFRunLoopGetMain() retainObjects:YES handler:nil];
     queue.batchSize = 10;
+    queue.drainsWithinFrameBudget = ASActivateExperimentalFeature(ASExperimentalFrameBudgetedRunLoopQueues);
   });
 
   if (objectPtr != NULL && *objectPtr != nil) {
@@ -29,6 +29,20 @@ typedef NS_OPTIONS(NSUInteger, ASExperimentalFeatures) {
   ASExperimentalDrawingGlobal = 1 << 8,                                     // exp_drawing_global
   ASExperimentalOptimizeDataControllerPipeline = 1 << 9,                    // exp_optimize_data_controller_pipeline
   ASExperimentalDoNotCacheAccessibilityElements = 1 << 10,                  // exp_do_not_cache_accessibility_elements
+  ASExperimentalWorkStealingLayout = 1 << 11,                               // exp_work_stealing_layout
+  ASExperimentalLayoutMemo = 1 << 12,                                       // exp_layout_memo
+  ASExperimentalIncrementalLayout = 1 << 13,                                // exp_incremental_layout
+  ASExperimentalTransactionScheduler = 1 << 14,                             // exp_transaction_scheduler
+  ASExperimentalDisplayDeadlines = 1 << 15,                                 // exp_display_deadlines
+  ASExperimentalAdaptiveDispatchApply = 1 << 16,                            // exp_adaptive_dispatch_apply
+  ASExperimentalTextLayoutCache = 1 << 17,                                  // exp_text_layout_cache
+  ASExperimentalTextWidthRangeReuse = 1 << 18,                              // exp_text_width_range_reuse
+  ASExperimentalTextPrefetch = 1 << 19,                                     // exp_text_prefetch
+  ASExperimentalImageContentsCoalescing = 1 << 20,                          // exp_image_contents_coalescing
+  ASExperimentalTiledRasterization = 1 << 21,                               // exp_tiled_rasterization
+  ASExperimentalFrameBudgetedRunLoopQueues = 1 << 22,                       // exp_frame_budgeted_run_loop_queues
+  ASExperimentalPipelinedDataController = 1 << 23,                          // exp_pipelined_data_controller
+  ASExperimentalVisibleFirstAllocation = 1 << 24,                           // exp_visible_first_allocation
   ASExperimentalFeatureAll = 0xFFFFFFFF
 };
 
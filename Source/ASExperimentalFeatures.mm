@@ -22,7 +22,21 @@ NSArray<NSString *> *ASExperimentalFeaturesGetNames(ASExperimentalFeatures flags
                                       @"exp_dispatch_apply",
                                       @"exp_drawing_global",
                                       @"exp_optimize_data_controller_pipeline",
-                                      @"exp_do_not_cache_accessibility_elements"]));
+                                      @"exp_do_not_cache_accessibility_elements",
+                                      @"exp_work_stealing_layout",
+                                      @"exp_layout_memo",
+                                      @"exp_incremental_layout",
+                                      @"exp_transaction_scheduler",
+                                      @"exp_display_deadlines",
+                                      @"exp_adaptive_dispatch_apply",
+                                      @"exp_text_layout_cache",
+                                      @"exp_text_width_range_reuse",
+                                      @"exp_text_prefetch",
+                                      @"exp_image_contents_coalescing",
+                                      @"exp_tiled_rasterization",
+                                      @"exp_frame_budgeted_run_loop_queues",
+                                      @"exp_pipelined_data_controller",
+                                      @"exp_visible_first_allocation"]));
   if (flags == ASExperimentalFeatureAll) {
     return allNames;
   }
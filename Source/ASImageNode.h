@@ -121,6 +121,16 @@ typedef UIImage * _Nullable (^asimagenode_modification_block_t)(UIImage *image,
  */
 - (void)setNeedsDisplayWithCompletion:(nullable void (^)(BOOL canceled))displayCompletionBlock;
 
+/**
+ * @abstract The number of bytes of rendered contents kept after no node displays them any more, so that nodes that
+ * display the same image again, e.g. when scrolling back through a gallery, do not redraw it.
+ *
+ * @discussion Defaults to 0, which keeps contents only while nodes display them. Contents are released in
+ * least-recently-used order beyond the limit, and all of them on memory warnings. Requires
+ * exp_image_contents_coalescing.
+ */
+@property (class) NSUInteger retainedContentsByteLimit;
+
 #if TARGET_OS_TV
 /** 
  * A bool to track if the current appearance of the node
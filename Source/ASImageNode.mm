@@ -25,6 +25,8 @@
 #import <AsyncDisplayKit/ASEqualityHelpers.h>
 #import <AsyncDisplayKit/ASHashing.h>
 #import <AsyncDisplayKit/ASWeakMap.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+#import <AsyncDisplayKit/ASContentsCache.h>
 #import <AsyncDisplayKit/CoreGraphics+ASConvenience.h>
 
 // TODO: It would be nice to remove this dependency; it's the only subclass using more than +FrameworkSubclasses.h
@@ -51,6 +53,7 @@ typedef void (^ASImageNodeDrawParametersBlock)(ASWeakMapEntry *entry);
   ASDisplayNodeContextModifier _didDisplayNodeContentWithRenderingContext;
   ASImageNodeDrawParametersBlock _didDrawBlock;
   ASPrimitiveTraitCollection _traitCollection;
+  CGRect _visibleBounds;
 }
 
 @end
@@ -331,6 +334,7 @@ typedef void (^ASImageNodeDrawParametersBlock)(ASWeakMapEntry *entry);
   drawParameters->_backgroundColor = self.backgroundColor;
   drawParameters->_contentMode = self.contentMode;
   drawParameters->_tintColor = self.tintColor;
+  drawParameters->_visibleBounds = ASActivateExperimentalFeature(ASExperimentalTiledRasterization) ? [self _visibleBoundsInWindow] : CGRectNull;
 
   return drawParameters;
 }
@@ -452,8 +456,43 @@ typedef void (^ASImageNodeDrawParametersBlock)(ASWeakMapEntry *entry);
 
 static ASWeakMap<ASImageNodeContentsKey *, UIImage *> *cache = nil;
 
+static ASContentsCache<ASImageNodeContentsKey *, UIImage *> *ASImageNodeContentsCache()
+{
+  static ASContentsCache<ASImageNodeContentsKey *, UIImage *> *contentsCache;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    contentsCache = [[ASContentsCache alloc] initWithShardCount:8 costOfValue:^NSUInteger(UIImage *contents) {
+      CGImageRef image = contents.CGImage;
+      return image ? CGImageGetBytesPerRow(image) * CGImageGetHeight(image) : 0;
+    }];
+  });
+  return contentsCache;
+}
+
++ (NSUInteger)retainedContentsByteLimit
+{
+  return ASImageNodeContentsCache().retainedCostLimit;
+}
+
++ (void)setRetainedContentsByteLimit:(NSUInteger)retainedContentsByteLimit
+{
+  ASImageNodeContentsCache().retainedCostLimit = retainedContentsByteLimit;
+}
+
++ (void)_removeAllRetainedContents
+{
+  [ASImageNodeContentsCache() removeAllRetainedEntries];
+}
+
 + (ASWeakMapEntry *)contentsForkey:(ASImageNodeContentsKey *)key drawParameters:(id)drawParameters isCancelled:(asdisplaynode_iscancelled_block_t)isCancelled
 {
+  if (ASActivateExperimentalFeature(ASExperimentalImageContentsCoalescing)) {
+    // Grids of identical avatars or thumbnails render each image once, and only lock the shard of their key.
+    return [ASImageNodeContentsCache() entryForKey:key isCancelled:isCancelled createValue:^UIImage *{
+      return [self createContentsForkey:key drawParameters:drawParameters isCancelled:isCancelled];
+    }];
+  }
+
   static dispatch_once_t onceToken;
   static AS::Mutex *cacheLock = nil;
   dispatch_once(&onceToken, ^{
@@ -494,9 +533,12 @@ static ASWeakMap<ASImageNodeContentsKey *, UIImage *> *cache = nil;
   
   ASImageNodeDrawParameters *drawParameters = (ASImageNodeDrawParameters *)parameter;
 
-  // Use contentsScale of 1.0 and do the contentsScale handling in boundsSizeInPixels so ASCroppedImageBackingSizeAndDrawRectInBounds
-  // will do its rounding on pixel instead of point boundaries
-  UIImage *result = ASGraphicsCreateImage(drawParameters->_traitCollection, key.backingSize, key.isOpaque, 1.0, key.image, isCancelled, ^{
+  // Large backings are drawn in tiles, which runs this block once per tile. That is only the same as drawing once if the
+  // context blocks, which may not expect it, are not set.
+  const BOOL drawsInTiles = (ASActivateExperimentalFeature(ASExperimentalTiledRasterization)
+                             && key.willDisplayNodeContentWithRenderingContext == nil
+                             && key.didDisplayNodeContentWithRenderingContext == nil);
+  void (^work)() = ^{
     BOOL contextIsClean = YES;
 
     CGContextRef context = UIGraphicsGetCurrentContext();
@@ -532,14 +574,36 @@ static ASWeakMap<ASImageNodeContentsKey *, UIImage *> *cache = nil;
       [key.tintColor setFill];
     }
 
-    @synchronized(image) {
-      [image drawInRect:key.imageDrawRect blendMode:blendMode alpha:1];
+    // A tile that the image does not reach has nothing more to draw.
+    if (context == NULL || CGRectIntersectsRect(key.imageDrawRect, CGContextGetClipBoundingBox(context))) {
+      @synchronized(image) {
+        [image drawInRect:key.imageDrawRect blendMode:blendMode alpha:1];
+      }
     }
 
     if (context && key.didDisplayNodeContentWithRenderingContext) {
       key.didDisplayNodeContentWithRenderingContext(context, drawParameters);
     }
-  });
+  };
+
+  // Use contentsScale of 1.0 and do the contentsScale handling in boundsSizeInPixels so ASCroppedImageBackingSizeAndDrawRectInBounds
+  // will do its rounding on pixel instead of point boundaries
+  UIImage *result;
+  if (drawsInTiles) {
+    // Draw the part on screen first: the backing covers the bounds, scaled.
+    CGRect priorityRect = drawParameters->_visibleBounds;
+    const CGRect bounds = drawParameters->_bounds;
+    if (!CGRectIsNull(priorityRect) && bounds.size.width > 0 && bounds.size.height > 0) {
+      const CGFloat sx = key.backingSize.width / bounds.size.width;
+      const CGFloat sy = key.backingSize.height / bounds.size.height;
+      priorityRect = CGRectMake((priorityRect.origin.x - bounds.origin.x) * sx, (priorityRect.origin.y - bounds.origin.y) * sy,
+                                priorityRect.size.width * sx, priorityRect.size.height * sy);
+    }
+    // Drawing the image holds its lock (see above), so tiles would only wait for each other on several threads.
+    result = ASGraphicsCreateTiledImage(drawParameters->_traitCollection, key.backingSize, key.isOpaque, 1.0, key.image, priorityRect, NO, isCancelled, work);
+  } else {
+    result = ASGraphicsCreateImage(drawParameters->_traitCollection, key.backingSize, key.isOpaque, 1.0, key.image, isCancelled, work);
+  }
 
   // if the original image was stretchy, keep it stretchy
   UIImage *originalImage = key.image;
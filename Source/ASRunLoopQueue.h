@@ -20,6 +20,25 @@ NS_ASSUME_NONNULL_BEGIN
 @interface ASAbstractRunLoopQueue : NSObject
 @end
 
+/** Number of buckets in ASRunLoopQueueStatistics.itemCostHistogram. */
+#define ASRunLoopQueueItemCostHistogramBucketCount 8
+
+typedef struct {
+  /** Items handed to the handler, or released if there is none. */
+  NSUInteger processedItems;
+  /** Run loop turns that processed at least one item. */
+  NSUInteger turns;
+  /** Turns that stopped because the frame budget was spent while items were left. */
+  NSUInteger exhaustedBudgets;
+  /** Items the last turn dequeued at once. Adapted to the recent cost per item while drainsWithinFrameBudget is YES. */
+  NSUInteger lastBatchSize;
+  /**
+   * Items by how long they took to process: under 16µs, 32µs, 64µs, 128µs, 256µs, 512µs, 1024µs, and longer.
+   * Only recorded while drainsWithinFrameBudget is YES.
+   */
+  NSUInteger itemCostHistogram[ASRunLoopQueueItemCostHistogramBucketCount];
+} ASRunLoopQueueStatistics;
+
 AS_SUBCLASSING_RESTRICTED
 @interface ASRunLoopQueue<ObjectType> : ASAbstractRunLoopQueue <ASLocking>
 
@@ -46,6 +65,20 @@ AS_SUBCLASSING_RESTRICTED
 @property (nonatomic) NSUInteger batchSize;           // Default == 1.
 @property (nonatomic) BOOL ensureExclusiveMembership; // Default == YES.  Set-like behavior.
 
+/**
+ * Whether each run loop turn processes items until a share of a frame at the main display's refresh rate has passed,
+ * rather than a fixed batchSize. Default == NO.
+ *
+ * @discussion Items are dequeued in batches sized from the recent cost per item, starting at batchSize, so cheap
+ * items drain in one turn and expensive ones spread over several frames. At least one item is processed per turn.
+ */
+@property (nonatomic) BOOL drainsWithinFrameBudget;
+
+/** Counted since the queue was created or the last call to -resetStatistics. */
+@property (readonly) ASRunLoopQueueStatistics statistics;
+
+- (void)resetStatistics;
+
 @end
 
 
@@ -82,10 +115,30 @@ NS_INLINE ASCATransactionQueue *ASCATransactionQueueGet(void) {
 
 + (ASDeallocQueue *)sharedDeallocationQueue NS_RETURNS_RETAINED;
 
+/**
+ * Releases everything queued right away, on the calling thread.
+ */
 - (void)drain;
 
+/**
+ * Takes the caller's reference and releases it on a utility-QoS background queue.
+ *
+ * @discussion Objects are collected for coalescingInterval, then released in chunks of at most chunkTimeBudget each,
+ * so tearing down a large hierarchy does not contend with foreground work in one long burst.
+ */
 - (void)releaseObjectInBackground:(id __strong _Nullable * _Nonnull)objectPtr;
 
+/**
+ * How long objects are collected before background releasing starts. Default == 0.1 seconds.
+ */
+@property NSTimeInterval coalescingInterval;
+
+/**
+ * How long one background chunk may spend releasing before it yields the thread. Default == 0.005 seconds.
+ * At least one object is released per chunk.
+ */
+@property NSTimeInterval chunkTimeBudget;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -10,9 +10,13 @@
 #import <AsyncDisplayKit/ASAvailability.h>
 #import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASLog.h>
+#import <AsyncDisplayKit/ASPointerMap.h>
+#import <AsyncDisplayKit/ASRingBuffer.h>
 #import <AsyncDisplayKit/ASRunLoopQueue.h>
 #import <AsyncDisplayKit/ASThread.h>
 #import <AsyncDisplayKit/ASSignpost.h>
+#import <QuartzCore/QuartzCore.h>
+#import <UIKit/UIKit.h>
 #import <vector>
 
 #define ASRunLoopQueueLoggingEnabled 0
@@ -30,8 +34,18 @@ static void runLoopSourceCallback(void *info) {
 #pragma mark - ASDeallocQueue
 
 @implementation ASDeallocQueue {
+  // Objects waiting for the next chunk. Guarded by _lock.
   std::vector<CFTypeRef> _queue;
+  BOOL _drainScheduled;
+  NSTimeInterval _coalescingInterval;
+  NSTimeInterval _chunkTimeBudget;
   AS::Mutex _lock;
+
+  // Objects taken from _queue by the chunk in progress, released from _drainIndex on. Guarded by _drainLock, which
+  // chunks hold while releasing, so releasing never blocks threads that enqueue.
+  std::vector<CFTypeRef> _drainBuffer;
+  size_t _drainIndex;
+  AS::Mutex _drainLock;
 }
 
 + (ASDeallocQueue *)sharedDeallocationQueue NS_RETURNS_RETAINED
@@ -44,11 +58,44 @@ static void runLoopSourceCallback(void *info) {
   return deallocQueue;
 }
 
+- (instancetype)init
+{
+  if (self = [super init]) {
+    _coalescingInterval = 0.100;
+    _chunkTimeBudget = 0.005;
+  }
+  return self;
+}
+
 - (void)dealloc
 {
   ASDisplayNodeFailAssert(@"Singleton should not dealloc.");
 }
 
+- (NSTimeInterval)coalescingInterval
+{
+  MutexLocker l(_lock);
+  return _coalescingInterval;
+}
+
+- (void)setCoalescingInterval:(NSTimeInterval)coalescingInterval
+{
+  MutexLocker l(_lock);
+  _coalescingInterval = coalescingInterval;
+}
+
+- (NSTimeInterval)chunkTimeBudget
+{
+  MutexLocker l(_lock);
+  return _chunkTimeBudget;
+}
+
+- (void)setChunkTimeBudget:(NSTimeInterval)chunkTimeBudget
+{
+  MutexLocker l(_lock);
+  _chunkTimeBudget = chunkTimeBudget;
+}
+
 - (void)releaseObjectInBackground:(id  _Nullable __strong *)objectPtr
 {
   NSParameterAssert(objectPtr != NULL);
@@ -60,7 +107,9 @@ static void runLoopSourceCallback(void *info) {
   }
   
   _lock.lock();
-  const auto isFirstEntry = _queue.empty();
+  const auto shouldScheduleDrain = !_drainScheduled;
+  _drainScheduled = YES;
+  const auto coalescingInterval = _coalescingInterval;
   // Push the pointer into our queue and clear their pointer.
   // This "steals" the +1 from ARC and nils their pointer so they can't
   // access or release the object.
@@ -68,18 +117,66 @@ static void runLoopSourceCallback(void *info) {
   *cfPtr = NULL;
   _lock.unlock();
   
-  if (isFirstEntry) {
-    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.100 * NSEC_PER_SEC)), dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
-      [self drain];
+  if (shouldScheduleDrain) {
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(coalescingInterval * NSEC_PER_SEC)), dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+      [self _drainChunk];
+    });
+  }
+}
+
+/**
+ * Releases objects until the chunk's time budget is spent, then queues the next chunk behind whatever other work the
+ * utility queue has, until nothing is left.
+ */
+- (void)_drainChunk
+{
+  MutexLocker dl(_drainLock);
+  NSTimeInterval chunkTimeBudget;
+  {
+    MutexLocker l(_lock);
+    chunkTimeBudget = _chunkTimeBudget;
+    if (_drainIndex == _drainBuffer.size()) {
+      _drainBuffer.clear();
+      _drainIndex = 0;
+      _drainBuffer.swap(_queue);
+    }
+  }
+
+  ASSignpostStart(DeallocQueueDrain, self, "");
+  const size_t start = _drainIndex;
+  const CFTimeInterval deadline = CACurrentMediaTime() + chunkTimeBudget;
+  while (_drainIndex < _drainBuffer.size()) {
+    // NOTE: Could check that retain count is 1 and retry later if not.
+    CFRelease(_drainBuffer[_drainIndex++]);
+    if (CACurrentMediaTime() >= deadline) {
+      break;
+    }
+  }
+  ASSignpostEnd(DeallocQueueDrain, self, "count: %d", (int)(_drainIndex - start));
+
+  BOOL hasMore = (_drainIndex < _drainBuffer.size());
+  if (!hasMore) {
+    MutexLocker l(_lock);
+    hasMore = !_queue.empty();
+    _drainScheduled = hasMore;
+  }
+  if (hasMore) {
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+      [self _drainChunk];
     });
   }
 }
 
 - (void)drain
 {
+  MutexLocker dl(_drainLock);
   _lock.lock();
   const auto q = std::move(_queue);
+  _queue.clear();
   _lock.unlock();
+  while (_drainIndex < _drainBuffer.size()) {
+    CFRelease(_drainBuffer[_drainIndex++]);
+  }
   for (CFTypeRef ref : q) {
     // NOTE: Could check that retain count is 1 and retry later if not.
     CFRelease(ref);
@@ -104,13 +201,64 @@ static void runLoopSourceCallback(void *info) {
 
 #pragma mark - ASRunLoopQueue
 
+// The share of a frame that a queue draining within the frame budget may take per run loop turn. The rest is left to
+// layout, Core Animation's commit and the app's own work.
+static const CFTimeInterval kASRunLoopQueueFrameBudgetFraction = 0.25;
+
+// Upper bound on items dequeued at once, so one mis-estimated batch cannot blow many frames.
+static const NSInteger kASRunLoopQueueMaximumAdaptedBatchSize = 1024;
+
+/**
+ * The time a frame-budgeted queue may spend per turn. Reads the refresh rate of the main screen, which may be 120Hz,
+ * when called on the main thread, and assumes 60Hz elsewhere.
+ */
+static CFTimeInterval ASRunLoopQueueFrameTimeBudget()
+{
+  NSInteger framesPerSecond = 60;
+  if (ASDisplayNodeThreadIsMain()) {
+    if (AS_AVAILABLE_IOS_TVOS(10.3, 10.3)) {
+      framesPerSecond = MAX(framesPerSecond, [UIScreen mainScreen].maximumFramesPerSecond);
+    }
+  }
+  return kASRunLoopQueueFrameBudgetFraction / framesPerSecond;
+}
+
+static inline NSUInteger ASRunLoopQueueItemCostBucket(CFTimeInterval cost)
+{
+  NSUInteger bucket = 0;
+  for (CFTimeInterval limit = 16e-6; bucket < ASRunLoopQueueItemCostHistogramBucketCount - 1 && cost >= limit; limit *= 2) {
+    bucket++;
+  }
+  return bucket;
+}
+
+/**
+ * One enqueued object. Only one of the references is set, depending on whether the queue retains its objects. The key
+ * outlives a weak reference, so the membership map can still be cleaned up after the object deallocates.
+ */
+struct ASRunLoopQueueEntry {
+  const void *key = nullptr;
+  id strongObject;
+  __weak id weakObject;
+};
+
 @interface ASRunLoopQueue () {
   CFRunLoopRef _runLoop;
   CFRunLoopSourceRef _runLoopSource;
   CFRunLoopObserverRef _runLoopObserver;
-  NSPointerArray *_internalQueue; // Use NSPointerArray so we can decide __strong or __weak per-instance.
+  AS::RingBuffer<ASRunLoopQueueEntry> _internalQueue;
+  // While ensureExclusiveMembership is YES, maps each queued object to the sequence number of its entry.
+  AS::PointerMap _internalQueueMembers;
+  BOOL _retainsObjects;
   AS::RecursiveMutex _internalQueueLock;
 
+  // Only accessed from the run loop's thread.
+  CFTimeInterval _timeBudget;
+  CFTimeInterval _averageItemCost;
+
+  // Guarded by _internalQueueLock.
+  ASRunLoopQueueStatistics _statistics;
+
   // In order to not pollute the top-level activities, each queue has 1 root activity.
   os_activity_t _rootActivity;
 
@@ -129,8 +277,7 @@ static void runLoopSourceCallback(void *info) {
 {
   if (self = [super init]) {
     _runLoop = runloop;
-    NSPointerFunctionsOptions options = retainsObjects ? NSPointerFunctionsStrongMemory : NSPointerFunctionsWeakMemory;
-    _internalQueue = [[NSPointerArray alloc] initWithOptions:options];
+    _retainsObjects = retainsObjects;
     _queueConsumer = handlerBlock;
     _batchSize = 1;
     _ensureExclusiveMembership = YES;
@@ -189,12 +336,43 @@ static void runLoopSourceCallback(void *info) {
 #if ASRunLoopQueueLoggingEnabled
 - (void)checkRunLoop
 {
-    NSLog(@"<%@> - Jobs: %ld", self, _internalQueue.count);
+    NSLog(@"<%@> - Jobs: %ld", self, _internalQueue.size());
 }
 #endif
 
+/**
+ * Removes up to maxCount items from the head of the queue, skipping deallocated ones, and appends them to items if it
+ * is non-NULL. Returns the number of items removed and sets isQueueDrained if none are left.
+ */
+- (NSInteger)_locked_dequeueItems:(std::vector<id> *)items maxCount:(NSInteger)maxCountToProcess isQueueDrained:(BOOL *)isQueueDrained
+{
+  NSInteger foundItemCount = 0;
+  while (foundItemCount < maxCountToProcess && !_internalQueue.empty()) {
+    const uint64_t sequence = _internalQueue.headSequence();
+    ASRunLoopQueueEntry entry = _internalQueue.pop_front();
+    // A newer entry for an object at the same address, if any, keeps its membership.
+    _internalQueueMembers.eraseIfEqual(entry.key, sequence);
+
+    id object = entry.strongObject ?: entry.weakObject;
+    if (object != nil) {
+      foundItemCount++;
+      if (items) {
+        items->push_back(object);
+      }
+    }
+  }
+
+  *isQueueDrained = _internalQueue.empty();
+  return foundItemCount;
+}
+
 - (void)processQueue
 {
+  if (_drainsWithinFrameBudget) {
+    [self _processQueueWithinFrameBudget];
+    return;
+  }
+
   BOOL hasExecutionBlock = (_queueConsumer != nil);
 
   // If we have an execution block, this vector will be populated, otherwise remains empty.
@@ -205,7 +383,7 @@ static void runLoopSourceCallback(void *info) {
   {
     MutexLocker l(_internalQueueLock);
 
-    NSInteger internalQueueCount = _internalQueue.count;
+    NSInteger internalQueueCount = _internalQueue.size();
     // Early-exit if the queue is empty.
     if (internalQueueCount == 0) {
       return;
@@ -215,42 +393,12 @@ static void runLoopSourceCallback(void *info) {
 
     // Snatch the next batch of items.
     NSInteger maxCountToProcess = MIN(internalQueueCount, self.batchSize);
-
-    /**
-     * For each item in the next batch, if it's non-nil then NULL it out
-     * and if we have an execution block then add it in.
-     * This could be written a bunch of different ways but
-     * this particular one nicely balances readability, safety, and efficiency.
-     */
-    NSInteger foundItemCount = 0;
-    for (NSInteger i = 0; i < internalQueueCount && foundItemCount < maxCountToProcess; i++) {
-      /**
-       * It is safe to use unsafe_unretained here. If the queue is weak, the
-       * object will be added to the autorelease pool. If the queue is strong,
-       * it will retain the object until we transfer it (retain it) in itemsToProcess.
-       */
-      unowned id ptr = (__bridge id)[_internalQueue pointerAtIndex:i];
-      if (ptr != nil) {
-        foundItemCount++;
-        if (hasExecutionBlock) {
-          itemsToProcess.push_back(ptr);
-        }
-        [_internalQueue replacePointerAtIndex:i withPointer:NULL];
-      }
-    }
-
-    if (foundItemCount == 0) {
-      // If _internalQueue holds weak references, and all of them just become NULL, then the array
-      // is never marked as needsCompletion, and compact will return early, not removing the NULL's.
-      // Inserting a NULL here ensures the compaction will take place.
-      // See http://www.openradar.me/15396578 and https://stackoverflow.com/a/40274426/1136669
-      [_internalQueue addPointer:NULL];
-    }
-
-    [_internalQueue compact];
-    if (_internalQueue.count == 0) {
-      isQueueDrained = YES;
+    const NSInteger foundItemCount = [self _locked_dequeueItems:(hasExecutionBlock ? &itemsToProcess : NULL) maxCount:maxCountToProcess isQueueDrained:&isQueueDrained];
+    if (foundItemCount > 0) {
+      _statistics.processedItems += foundItemCount;
+      _statistics.turns++;
     }
+    _statistics.lastBatchSize = maxCountToProcess;
   }
 
   // itemsToProcess will be empty if _queueConsumer == nil so no need to check again.
@@ -277,6 +425,91 @@ static void runLoopSourceCallback(void *info) {
   ASSignpostEnd(RunLoopQueueBatch, self, "count: %d", (int)count);
 }
 
+/**
+ * Processes batches of items until the queue is empty or the time budget is spent. Each batch is as large as the rest
+ * of the budget fits at the average cost of recent items. Without a handler, items are released here, outside the
+ * lock, since releasing is the work.
+ */
+- (void)_processQueueWithinFrameBudget
+{
+  {
+    MutexLocker l(_internalQueueLock);
+    // Early-exit if the queue is empty.
+    if (_internalQueue.empty()) {
+      return;
+    }
+  }
+
+  ASSignpostStart(RunLoopQueueBatch, self, "%s", object_getClassName(self));
+  as_activity_scope_verbose(as_activity_create("Process run loop queue batch", _rootActivity, OS_ACTIVITY_FLAG_DEFAULT));
+
+  if (_timeBudget == 0) {
+    _timeBudget = ASRunLoopQueueFrameTimeBudget();
+  }
+  CFTimeInterval now = CACurrentMediaTime();
+  const CFTimeInterval deadline = now + _timeBudget;
+
+  std::vector<id> itemsToProcess;
+  NSUInteger histogram[ASRunLoopQueueItemCostHistogramBucketCount] = {};
+  NSUInteger count = 0;
+  NSInteger batchSize = MAX(self.batchSize, 1);
+  BOOL isQueueDrained = NO;
+  do {
+    if (_averageItemCost > 0) {
+      batchSize = (NSInteger)MIN((CFTimeInterval)kASRunLoopQueueMaximumAdaptedBatchSize, MAX(1.0, (deadline - now) / _averageItemCost));
+    }
+    {
+      MutexLocker l(_internalQueueLock);
+      [self _locked_dequeueItems:&itemsToProcess maxCount:batchSize isQueueDrained:&isQueueDrained];
+    }
+
+    const auto itemsEnd = itemsToProcess.end();
+    for (auto iterator = itemsToProcess.begin(); iterator < itemsEnd; iterator++) {
+      if (_queueConsumer) {
+        unowned id value = *iterator;
+        _queueConsumer(value, isQueueDrained && iterator == itemsEnd - 1);
+        as_log_verbose(ASDisplayLog(), "processed %@", value);
+      } else {
+        *iterator = nil;
+      }
+      const CFTimeInterval end = CACurrentMediaTime();
+      const CFTimeInterval cost = end - now;
+      now = end;
+      histogram[ASRunLoopQueueItemCostBucket(cost)]++;
+      // An exponential moving average follows shifts in cost, e.g. from cheap to expensive nodes, within a few items.
+      _averageItemCost = (_averageItemCost > 0 ? _averageItemCost * 0.875 + cost * 0.125 : cost);
+    }
+    count += itemsToProcess.size();
+    itemsToProcess.clear();
+  } while (!isQueueDrained && now < deadline);
+
+  {
+    MutexLocker l(_internalQueueLock);
+    if (count > 0) {
+      _statistics.processedItems += count;
+      _statistics.turns++;
+    }
+    if (!isQueueDrained) {
+      _statistics.exhaustedBudgets++;
+    }
+    _statistics.lastBatchSize = batchSize;
+    for (NSUInteger i = 0; i < ASRunLoopQueueItemCostHistogramBucketCount; i++) {
+      _statistics.itemCostHistogram[i] += histogram[i];
+    }
+  }
+  if (count > 1) {
+    as_log_verbose(ASDisplayLog(), "processed %lu items", (unsigned long)count);
+  }
+
+  // If the queue is not fully drained yet force another run loop to process the rest in the next frame
+  if (!isQueueDrained) {
+    CFRunLoopSourceSignal(_runLoopSource);
+    CFRunLoopWakeUp(_runLoop);
+  }
+
+  ASSignpostEnd(RunLoopQueueBatch, self, "count: %d", (int)count);
+}
+
 - (void)enqueue:(id)object
 {
   if (!object) {
@@ -285,31 +518,52 @@ static void runLoopSourceCallback(void *info) {
   
   MutexLocker l(_internalQueueLock);
 
-  // Check if the object exists.
-  BOOL foundObject = NO;
-    
+  const void *key = (__bridge const void *)object;
   if (_ensureExclusiveMembership) {
-    for (id currentObject in _internalQueue) {
-      if (currentObject == object) {
-        foundObject = YES;
-        break;
+    // The entry the map points at may hold a deallocated object that shared this address, so compare the objects.
+    uint64_t sequence;
+    if (_internalQueueMembers.find(key, sequence) && _internalQueue.contains(sequence)) {
+      const ASRunLoopQueueEntry &entry = _internalQueue.at(sequence);
+      if ((entry.strongObject ?: entry.weakObject) == object) {
+        return;
       }
     }
   }
 
-  if (!foundObject) {
-    [_internalQueue addPointer:(__bridge void *)object];
-    if (_internalQueue.count == 1) {
-      CFRunLoopSourceSignal(_runLoopSource);
-      CFRunLoopWakeUp(_runLoop);
-    }
+  ASRunLoopQueueEntry entry;
+  entry.key = key;
+  if (_retainsObjects) {
+    entry.strongObject = object;
+  } else {
+    entry.weakObject = object;
+  }
+  const uint64_t sequence = _internalQueue.push_back(std::move(entry));
+  if (_ensureExclusiveMembership) {
+    _internalQueueMembers.set(key, sequence);
+  }
+
+  if (_internalQueue.size() == 1) {
+    CFRunLoopSourceSignal(_runLoopSource);
+    CFRunLoopWakeUp(_runLoop);
   }
 }
 
 - (BOOL)isEmpty
 {
   MutexLocker l(_internalQueueLock);
-  return _internalQueue.count == 0;
+  return _internalQueue.empty();
+}
+
+- (ASRunLoopQueueStatistics)statistics
+{
+  MutexLocker l(_internalQueueLock);
+  return _statistics;
+}
+
+- (void)resetStatistics
+{
+  MutexLocker l(_internalQueueLock);
+  _statistics = {};
 }
 
 ASSynthesizeLockingMethodsWithMutex(_internalQueueLock)
@@ -1561,7 +1561,10 @@ static NSString * const kCellReuseIdentifier = @"_ASTableViewCell";
       [super reloadData];
       // Flush any range changes that happened as part of submitting the reload.
       [self->_rangeController updateIfNeeded];
-      [self _scheduleCheckForBatchFetchingForNumberOfChanges:1];
+      // If only the leading rows are in, check once the rest have been inserted.
+      if (!changeSet.hasPendingRemainder) {
+        [self _scheduleCheckForBatchFetchingForNumberOfChanges:1];
+      }
       [changeSet executeCompletionHandlerWithFinished:YES];
     });
     return;
@@ -1699,6 +1702,14 @@ static NSString * const kCellReuseIdentifier = @"_ASTableViewCell";
   return NO;
 }
 
+- (CGRect)dataController:(ASDataController *)dataController displayRangeBoundsWithAnchorIndexPath:(NSIndexPath **)anchorIndexPath
+{
+  ASDisplayNodeAssertMainThread();
+  *anchorIndexPath = [self.indexPathsForVisibleRows sortedArrayUsingSelector:@selector(compare:)].firstObject;
+  ASRangeTuningParameters tuningParameters = [_rangeController tuningParametersForRangeMode:ASLayoutRangeModeFull rangeType:ASLayoutRangeTypeDisplay];
+  return CGRectExpandToRangeWithScrollableDirections(self.bounds, tuningParameters, self.scrollableDirections, self.scrollDirection);
+}
+
 - (BOOL)dataController:(ASDataController *)dataController shouldSynchronouslyProcessChangeSet:(_ASHierarchyChangeSet *)changeSet
 {
   // Reload data is expensive, don't block main while doing so.
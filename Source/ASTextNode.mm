@@ -19,6 +19,7 @@
 #import <tgmath.h>
 
 #import <AsyncDisplayKit/_ASDisplayLayer.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASDisplayNode+FrameworkPrivate.h>
 #import <AsyncDisplayKit/ASDisplayNode+Subclasses.h>
 #import <AsyncDisplayKit/ASDisplayNodeExtras.h>
@@ -29,6 +30,7 @@
 #import <AsyncDisplayKit/ASTextKitCoreTextAdditions.h>
 #import <AsyncDisplayKit/ASTextKitRenderer+Positioning.h>
 #import <AsyncDisplayKit/ASTextKitShadower.h>
+#import <AsyncDisplayKit/NSAttributedString+ASText.h>
 
 #import <AsyncDisplayKit/CoreGraphics+ASConvenience.h>
 #import <AsyncDisplayKit/ASHashing.h>
@@ -109,10 +111,48 @@ static NSCache *sharedRendererCache()
  return __rendererCache;
 }
 
+static NSCache *sharedNaturalWidthRendererCache()
+{
+  static dispatch_once_t onceToken;
+  static NSCache *__rendererCache = nil;
+  dispatch_once(&onceToken, ^{
+    __rendererCache = [[NSCache alloc] init];
+    __rendererCache.countLimit = 500;
+  });
+  return __rendererCache;
+}
+
+/**
+ Whether the renderer's text took its natural width: no line wrapped or was cut off, and the line origins do not depend
+ on the container's width. Such a renderer is exactly what any constrained size at least as large as its size would
+ produce.
+ */
+static BOOL rendererHasNaturalWidth(ASTextKitRenderer *renderer)
+{
+  const ASTextKitAttributes &attributes = renderer.attributes;
+  // Scale factors and exclusion paths depend on the constrained size.
+  if (attributes.pointSizeScaleFactors.count > 0 || attributes.exclusionPaths.count > 0) {
+    return NO;
+  }
+  if (renderer.isTruncated || ![attributes.attributedString as_isLeftAligned]) {
+    return NO;
+  }
+  // Without wrapping, there is one line per paragraph.
+  NSString *string = attributes.attributedString.string;
+  __block NSUInteger paragraphCount = 0;
+  [string enumerateSubstringsInRange:NSMakeRange(0, string.length) options:NSStringEnumerationByParagraphs | NSStringEnumerationSubstringNotRequired usingBlock:^(NSString *substring, NSRange substringRange, NSRange enclosingRange, BOOL *stop) {
+    paragraphCount++;
+  }];
+  return renderer.lineCount == paragraphCount;
+}
+
 /**
  The concept here is that neither the node nor layout should ever have a strong reference to the renderer object.
  This is to reduce memory load when loading thousands and thousands of text nodes into memory at once. Instead
  we maintain a LRU renderer cache that is queried via a unique key based on text kit attributes and constrained size. 
+
+ With exp_text_width_range_reuse, a renderer whose text took its natural width is also kept under the attributes
+ alone, and used for any constrained size that fits it, e.g. after rotating or resizing a split view.
  */
 
 static ASTextKitRenderer *rendererForAttributes(ASTextKitAttributes attributes, CGSize constrainedSize)
@@ -122,9 +162,25 @@ static ASTextKitRenderer *rendererForAttributes(ASTextKitAttributes attributes,
   ASTextNodeRendererKey *key = [[ASTextNodeRendererKey alloc] initWithTextKitAttributes:attributes constrainedSize:constrainedSize];
 
   ASTextKitRenderer *renderer = [cache objectForKey:key];
-  if (renderer == nil) {
-    renderer = [[ASTextKitRenderer alloc] initWithTextKitAttributes:attributes constrainedSize:constrainedSize];
-    [cache setObject:renderer forKey:key];
+  if (renderer != nil) {
+    return renderer;
+  }
+
+  const BOOL reuseWidths = ASActivateExperimentalFeature(ASExperimentalTextWidthRangeReuse);
+  ASTextNodeRendererKey *naturalWidthKey = nil;
+  if (reuseWidths) {
+    naturalWidthKey = [[ASTextNodeRendererKey alloc] initWithTextKitAttributes:attributes constrainedSize:CGSizeZero];
+    renderer = [sharedNaturalWidthRendererCache() objectForKey:naturalWidthKey];
+    if (renderer != nil && constrainedSize.width >= renderer.size.width && constrainedSize.height >= renderer.size.height) {
+      [cache setObject:renderer forKey:key];
+      return renderer;
+    }
+  }
+
+  renderer = [[ASTextKitRenderer alloc] initWithTextKitAttributes:attributes constrainedSize:constrainedSize];
+  [cache setObject:renderer forKey:key];
+  if (reuseWidths && rendererHasNaturalWidth(renderer)) {
+    [sharedNaturalWidthRendererCache() setObject:renderer forKey:naturalWidthKey];
   }
   
   return renderer;
@@ -232,6 +232,14 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nullable, nonatomic) id<ASTextLinePositionModifier> textContainerLinePositionModifier;
 
+/**
+ @abstract Lays the text out for the given constrained size on a low-priority background queue, so that measuring or
+ drawing the node at that size later finds the layout ready.
+ @discussion Requires exp_text_layout_cache, and does nothing without it. With exp_text_prefetch, the node calls this
+ on its own for its bounds when it enters the preload range.
+ */
+- (void)prefetchLayoutForConstrainedSize:(CGSize)constrainedSize;
+
 @end
 
 #if AS_ENABLE_TEXTNODE
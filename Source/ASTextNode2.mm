@@ -13,6 +13,7 @@
 #import <deque>
 
 #import <AsyncDisplayKit/_ASDisplayLayer.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASDisplayNode+FrameworkPrivate.h>
 #import <AsyncDisplayKit/ASDisplayNode+Subclasses.h>
 #import <AsyncDisplayKit/ASDisplayNodeExtras.h>
@@ -23,6 +24,7 @@
 #import <AsyncDisplayKit/ASEqualityHelpers.h>
 
 #import <AsyncDisplayKit/ASTextLayout.h>
+#import <AsyncDisplayKit/ASTextLayoutCache.h>
 
 @interface ASTextCacheValue : NSObject {
   @package
@@ -48,6 +50,10 @@
  * NOTE: Be careful to copy `text` if needed.
  */
 static NS_RETURNS_RETAINED ASTextLayout *ASTextNodeCompatibleLayoutWithContainerAndText(ASTextContainer *container, NSAttributedString *text)  {
+  if (ASActivateExperimentalFeature(ASExperimentalTextLayoutCache)) {
+    return ASTextLayoutCacheGetLayout(container, text);
+  }
+
   static dispatch_once_t onceToken;
   static AS::Mutex *layoutCacheLock;
   static NSCache<NSAttributedString *, ASTextCacheValue *> *textLayoutCache;
@@ -68,50 +74,10 @@ static NS_RETURNS_RETAINED ASTextLayout *ASTextNodeCompatibleLayoutWithContainer
   AS::MutexLocker lock(cacheValue->_m);
   layoutCacheLock->unlock();
 
-  CGRect containerBounds = (CGRect){ .size = container.size };
-  {
-    for (const auto &t : cacheValue->_layouts) {
-      CGSize constrainedSize = std::get<0>(t);
-      ASTextLayout *layout = std::get<1>(t);
-
-      CGSize layoutSize = layout.textBoundingSize;
-      // 1. CoreText can return frames that are narrower than the constrained width, for obvious reasons.
-      // 2. CoreText can return frames that are slightly wider than the constrained width, for some reason.
-      //    We have to trust that somehow it's OK to try and draw within our size constraint, despite the return value.
-      // 3. Thus, those two values (constrained width & returned width) form a range, where
-      //    intermediate values in that range will be snapped. Thus, we can use a given layout as long as our
-      //    width is in that range, between the min and max of those two values.
-      CGRect minRect = CGRectMake(0, 0, MIN(layoutSize.width, constrainedSize.width), MIN(layoutSize.height, constrainedSize.height));
-      if (!CGRectContainsRect(containerBounds, minRect)) {
-        continue;
-      }
-      CGRect maxRect = CGRectMake(0, 0, MAX(layoutSize.width, constrainedSize.width), MAX(layoutSize.height, constrainedSize.height));
-      if (!CGRectContainsRect(maxRect, containerBounds)) {
-        continue;
-      }
-      if (!CGSizeEqualToSize(container.size, constrainedSize)) {
-        continue;
-      }
-
-      // Now check container params.
-      ASTextContainer *otherContainer = layout.container;
-      if (!UIEdgeInsetsEqualToEdgeInsets(container.insets, otherContainer.insets)) {
-        continue;
-      }
-      if (!ASObjectIsEqual(container.exclusionPaths, otherContainer.exclusionPaths)) {
-        continue;
-      }
-      if (container.maximumNumberOfRows != otherContainer.maximumNumberOfRows) {
-        continue;
-      }
-      if (container.truncationType != otherContainer.truncationType) {
-        continue;
-      }
-      if (!ASObjectIsEqual(container.truncationToken, otherContainer.truncationToken)) {
-        continue;
-      }
+  for (const auto &t : cacheValue->_layouts) {
+    if (ASTextLayoutIsCompatibleWithContainer(std::get<1>(t), std::get<0>(t), container)) {
       // TODO: When we get a cache hit, move this entry to the front (LRU).
-      return layout;
+      return std::get<1>(t);
     }
   }
 
@@ -362,6 +328,32 @@ static NSArray *DefaultLinkAttributeNames() {
   return layout.textBoundingSize;
 }
 
+- (void)prefetchLayoutForConstrainedSize:(CGSize)constrainedSize
+{
+  if (!ASActivateExperimentalFeature(ASExperimentalTextLayoutCache)) {
+    return;
+  }
+
+  ASTextContainer *copiedContainer;
+  NSMutableAttributedString *mutableText;
+  {
+    ASLockScopeSelf();
+    if (_attributedText.length == 0) {
+      return;
+    }
+    [self _ensureTruncationText];
+
+    // Prepare the text exactly as -calculateSizeThatFits: and drawing would, or the layout would not be found.
+    copiedContainer = [_textContainer copy];
+    copiedContainer.size = constrainedSize;
+    [copiedContainer makeImmutable];
+    BOOL isCalculatingIntrinsicSize = (constrainedSize.width >= ASTextContainerMaxSize.width) || (constrainedSize.height >= ASTextContainerMaxSize.height);
+    mutableText = [_attributedText mutableCopy];
+    [self prepareAttributedString:mutableText isForIntrinsicSize:isCalculatingIntrinsicSize];
+  }
+  ASTextLayoutCachePrefetchLayout(copiedContainer, mutableText);
+}
+
 #pragma mark - Modifying User Text
 
 // Returns the ascender of the first character in attributedString by also including the line height if specified in paragraph style.
@@ -620,6 +612,24 @@ static NSArray *DefaultLinkAttributeNames() {
   [self _setNeedsDisplayOnTintedTextColor];
 }
 
+- (void)didEnterPreloadState
+{
+  [super didEnterPreloadState];
+
+  if (!ASActivateExperimentalFeature(ASExperimentalTextPrefetch)) {
+    return;
+  }
+  // The node has been measured by now. Lay it out for drawing, which uses the bounds, before the display range asks.
+  // Text that follows the tint color is only known once drawing reads the tint color.
+  CGSize size = self.bounds.size;
+  if (CGSizeEqualToSize(size, CGSizeZero)) {
+    size = self.calculatedSize;
+  }
+  if (size.width > 0 && size.height > 0 && !self.textColorFollowsTintColor) {
+    [self prefetchLayoutForConstrainedSize:size];
+  }
+}
+
 #pragma mark - Attributes
 
 - (id)linkAttributeValueAtPoint:(CGPoint)point
@@ -29,6 +29,7 @@
 #import <AsyncDisplayKit/ASVideoPlayerNode.h>
 
 #import <AsyncDisplayKit/ASImageProtocols.h>
+#import <AsyncDisplayKit/ASBasicImageDiskCache.h>
 #import <AsyncDisplayKit/ASBasicImageDownloader.h>
 #import <AsyncDisplayKit/ASPINRemoteImageDownloader.h>
 #import <AsyncDisplayKit/ASMultiplexImageNode.h>
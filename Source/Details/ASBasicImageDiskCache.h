@@ -0,0 +1,58 @@
+//
+//  ASBasicImageDiskCache.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASImageProtocols.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * @abstract An on-disk cache of decoded, display-ready bitmaps, for use with @c ASBasicImageDownloader.
+ *
+ * @discussion Images are stored already decoded and scaled down to fit maximumPixelDimension, in the pixel format
+ * Core Animation displays directly. Reading one back memory-maps the file into a @c CGImage, so cached images are
+ * neither decoded nor copied again, e.g. when a feed of thumbnails is shown right after launch.
+ *
+ * Images are keyed by URL and maximumPixelDimension, so caches with different dimensions can share a directory. Files
+ * are removed oldest first once they take more than byteLimit.
+ *
+ * To use it, set it as the @c diskCache of the downloader and pass both to
+ * -[ASNetworkImageNode initWithCache:downloader:].
+ */
+@interface ASBasicImageDiskCache : NSObject <ASImageCacheProtocol>
+
+/**
+ * @param directoryURL A directory for the cache's files only. It is created if needed.
+ * @param maximumPixelDimension The longest side, in pixels, images are stored at. Larger images are scaled down.
+ */
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL maximumPixelDimension:(NSUInteger)maximumPixelDimension NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (readonly) NSURL *directoryURL;
+@property (readonly) NSUInteger maximumPixelDimension;
+
+/**
+ * @abstract The number of bytes the cache's files may take. Defaults to 100 MB.
+ */
+@property NSUInteger byteLimit;
+
+/**
+ * @abstract Decodes and scales down image, and stores it for URL.
+ * @discussion Writing happens in the background. Safe to call from any thread.
+ * @return The decoded and scaled image, which is what the cache will return for URL, or nil if image could not be drawn.
+ */
+- (nullable UIImage *)storeImage:(UIImage *)image forURL:(NSURL *)URL;
+
+/**
+ * @abstract Removes every image of this cache's maximumPixelDimension, waiting until they are gone.
+ */
+- (void)removeAllImages;
+
+@end
+
+NS_ASSUME_NONNULL_END
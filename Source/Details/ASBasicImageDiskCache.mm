@@ -0,0 +1,274 @@
+//
+//  ASBasicImageDiskCache.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASBasicImageDiskCache.h>
+
+#import <AsyncDisplayKit/ASImageContainerProtocolCategories.h>
+#import <AsyncDisplayKit/ASThread.h>
+
+static const uint32_t kASDecodedImageMagic = 'ASDI';
+static const uint32_t kASDecodedImageVersion = 2;
+/** Rows and the pixels after the header start at multiples of this, which Core Animation can display without copying. */
+static const size_t kASDecodedImageAlignment = 64;
+static const NSUInteger kASBasicImageDiskCacheDefaultByteLimit = 100 * 1024 * 1024;
+
+/**
+ * A file is this header, the URL it was stored for (to tell apart URLs whose names collide), and the pixels at
+ * pixelOffset. The pixels are as the source image stored them; orientation is the UIImageOrientation to show them with.
+ */
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  uint32_t bytesPerRow;
+  uint32_t bitmapInfo;
+  uint32_t URLLength;
+  uint32_t pixelOffset;
+  uint32_t orientation;
+} ASDecodedImageHeader;
+
+static size_t ASDecodedImageAlign(size_t value)
+{
+  return (value + kASDecodedImageAlignment - 1) / kASDecodedImageAlignment * kASDecodedImageAlignment;
+}
+
+static void ASDecodedImageReleaseData(void *info, const void *data, size_t size)
+{
+  CFRelease(info);
+}
+
+@implementation ASBasicImageDiskCache {
+  dispatch_queue_t _ioQueue;
+  AS::Mutex _byteCountLock;
+  NSUInteger _byteCount;  // Of all files in the directory, known once _ioQueue ran the first trim.
+}
+
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL maximumPixelDimension:(NSUInteger)maximumPixelDimension
+{
+  if (self = [super init]) {
+    _directoryURL = [directoryURL copy];
+    _maximumPixelDimension = MAX(1, maximumPixelDimension);
+    _byteLimit = kASBasicImageDiskCacheDefaultByteLimit;
+    _ioQueue = dispatch_queue_create("org.TextureGroup.Texture.basicImageDiskCache", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+    dispatch_async(_ioQueue, ^{
+      [[NSFileManager defaultManager] createDirectoryAtURL:self->_directoryURL withIntermediateDirectories:YES attributes:nil error:NULL];
+      [self _trim];
+    });
+  }
+  return self;
+}
+
+#pragma mark Files
+
+- (NSURL *)_fileURLForURL:(NSURL *)URL
+{
+  // FNV-1a, to name files without depending on a crypto library; the URL in the file settles collisions.
+  NSData *bytes = [URL.absoluteString dataUsingEncoding:NSUTF8StringEncoding];
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  const uint8_t *b = (const uint8_t *)bytes.bytes;
+  for (NSUInteger i = 0; i < bytes.length; i++) {
+    hash = (hash ^ b[i]) * 0x100000001b3ULL;
+  }
+  NSString *name = [NSString stringWithFormat:@"%016llx-%lu.bitmap", hash, (unsigned long)_maximumPixelDimension];
+  return [_directoryURL URLByAppendingPathComponent:name isDirectory:NO];
+}
+
+/** Memory-maps the file of URL into an image, or returns nil if there is none or it is not the image of URL. */
+- (UIImage *)_imageFromFileForURL:(NSURL *)URL
+{
+  NSData *data = [NSData dataWithContentsOfURL:[self _fileURLForURL:URL] options:NSDataReadingMappedAlways error:NULL];
+  if (data.length < sizeof(ASDecodedImageHeader)) {
+    return nil;
+  }
+  ASDecodedImageHeader header;
+  memcpy(&header, data.bytes, sizeof(header));
+  NSData *URLBytes = [URL.absoluteString dataUsingEncoding:NSUTF8StringEncoding];
+  if (header.magic != kASDecodedImageMagic || header.version != kASDecodedImageVersion
+      || header.orientation > UIImageOrientationRightMirrored || header.URLLength != URLBytes.length || sizeof(header) + header.URLLength > header.pixelOffset
+      || (uint64_t)header.pixelOffset + (uint64_t)header.bytesPerRow * header.height > data.length
+      || memcmp((const uint8_t *)data.bytes + sizeof(header), URLBytes.bytes, URLBytes.length) != 0) {
+    return nil;
+  }
+
+  // The provider keeps the mapping alive for as long as the image needs its pixels.
+  CGDataProviderRef provider = CGDataProviderCreateWithData((__bridge_retained void *)data, (const uint8_t *)data.bytes + header.pixelOffset,
+                                                            (size_t)header.bytesPerRow * header.height, ASDecodedImageReleaseData);
+  if (provider == NULL) {
+    CFRelease((__bridge CFTypeRef)data);
+    return nil;
+  }
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGImageRef imageRef = CGImageCreate(header.width, header.height, 8, 32, header.bytesPerRow, colorSpace, header.bitmapInfo, provider, NULL, false, kCGRenderingIntentDefault);
+  CGColorSpaceRelease(colorSpace);
+  CGDataProviderRelease(provider);
+  if (imageRef == NULL) {
+    return nil;
+  }
+  UIImage *image = [UIImage imageWithCGImage:imageRef scale:1 orientation:(UIImageOrientation)header.orientation];
+  CGImageRelease(imageRef);
+  return image;
+}
+
+/** Removes the oldest files until they fit the byte limit. Runs on _ioQueue. */
+- (void)_trim
+{
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  NSArray<NSURLResourceKey> *keys = @[ NSURLContentModificationDateKey, NSURLTotalFileAllocatedSizeKey ];
+  NSArray<NSURL *> *files = [fileManager contentsOfDirectoryAtURL:_directoryURL includingPropertiesForKeys:keys options:NSDirectoryEnumerationSkipsHiddenFiles error:NULL];
+  NSMutableArray<NSDictionary *> *fileInfos = [NSMutableArray arrayWithCapacity:files.count];
+  NSUInteger byteCount = 0;
+  for (NSURL *file in files) {
+    NSDictionary *values = [file resourceValuesForKeys:keys error:NULL];
+    byteCount += [values[NSURLTotalFileAllocatedSizeKey] unsignedIntegerValue];
+    [fileInfos addObject:@{ @"url" : file, @"values" : values ?: @{} }];
+  }
+
+  const NSUInteger byteLimit = self.byteLimit;
+  if (byteCount > byteLimit) {
+    [fileInfos sortUsingComparator:^NSComparisonResult(NSDictionary *a, NSDictionary *b) {
+      return [a[@"values"][NSURLContentModificationDateKey] compare:b[@"values"][NSURLContentModificationDateKey]];
+    }];
+    // Trim to three quarters, so that a full cache is not trimmed again on every store.
+    for (NSDictionary *info in fileInfos) {
+      if (byteCount <= byteLimit / 4 * 3) {
+        break;
+      }
+      if ([fileManager removeItemAtURL:info[@"url"] error:NULL]) {
+        byteCount -= MIN(byteCount, [info[@"values"][NSURLTotalFileAllocatedSizeKey] unsignedIntegerValue]);
+      }
+    }
+  }
+
+  AS::MutexLocker l(_byteCountLock);
+  _byteCount = byteCount;
+}
+
+#pragma mark Storing
+
+- (UIImage *)storeImage:(UIImage *)image forURL:(NSURL *)URL
+{
+  CGImageRef sourceImage = image.CGImage;
+  if (sourceImage == NULL || URL == nil) {
+    return nil;
+  }
+  size_t width = CGImageGetWidth(sourceImage);
+  size_t height = CGImageGetHeight(sourceImage);
+  const size_t longestSide = MAX(width, height);
+  if (longestSide == 0) {
+    return nil;
+  }
+  if (longestSide > _maximumPixelDimension) {
+    width = MAX(1, (size_t)round((double)width * _maximumPixelDimension / longestSide));
+    height = MAX(1, (size_t)round((double)height * _maximumPixelDimension / longestSide));
+  }
+
+  const CGImageAlphaInfo alphaInfo = CGImageGetAlphaInfo(sourceImage);
+  const BOOL opaque = (alphaInfo == kCGImageAlphaNone || alphaInfo == kCGImageAlphaNoneSkipFirst || alphaInfo == kCGImageAlphaNoneSkipLast);
+  const uint32_t bitmapInfo = kCGBitmapByteOrder32Little | (opaque ? kCGImageAlphaNoneSkipFirst : kCGImageAlphaPremultipliedFirst);
+  const size_t bytesPerRow = ASDecodedImageAlign(width * 4);
+
+  NSData *URLBytes = [URL.absoluteString dataUsingEncoding:NSUTF8StringEncoding];
+  const size_t pixelOffset = ASDecodedImageAlign(sizeof(ASDecodedImageHeader) + URLBytes.length);
+  NSMutableData *file = [NSMutableData dataWithLength:pixelOffset + bytesPerRow * height];
+  uint8_t *bytes = (uint8_t *)file.mutableBytes;
+  if (bytes == NULL) {
+    return nil;
+  }
+
+  // Decode and scale in one pass, straight into the file's pixels. CGImage ignores the orientation, which the header
+  // keeps so that it can be restored, e.g. for camera photos stored sideways.
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef context = CGBitmapContextCreate(bytes + pixelOffset, width, height, 8, bytesPerRow, colorSpace, bitmapInfo);
+  CGColorSpaceRelease(colorSpace);
+  if (context == NULL) {
+    return nil;
+  }
+  CGContextSetInterpolationQuality(context, kCGInterpolationHigh);
+  CGContextDrawImage(context, CGRectMake(0, 0, width, height), sourceImage);
+  CGContextRelease(context);
+
+  const ASDecodedImageHeader header = {
+    .magic = kASDecodedImageMagic,
+    .version = kASDecodedImageVersion,
+    .width = (uint32_t)width,
+    .height = (uint32_t)height,
+    .bytesPerRow = (uint32_t)bytesPerRow,
+    .bitmapInfo = bitmapInfo,
+    .URLLength = (uint32_t)URLBytes.length,
+    .pixelOffset = (uint32_t)pixelOffset,
+    .orientation = (uint32_t)image.imageOrientation,
+  };
+  memcpy(bytes, &header, sizeof(header));
+  memcpy(bytes + sizeof(header), URLBytes.bytes, URLBytes.length);
+
+  NSURL *fileURL = [self _fileURLForURL:URL];
+  dispatch_async(_ioQueue, ^{
+    if (![file writeToURL:fileURL options:NSDataWritingAtomic error:NULL]) {
+      return;
+    }
+    BOOL needsTrim;
+    {
+      AS::MutexLocker l(self->_byteCountLock);
+      self->_byteCount += file.length;
+      needsTrim = self->_byteCount > self.byteLimit;
+    }
+    if (needsTrim) {
+      [self _trim];
+    }
+  });
+
+  // Hand out the same pixels the file has, so that the image looks the same whether it came from the cache or not.
+  CGDataProviderRef provider = CGDataProviderCreateWithData((__bridge_retained void *)file, bytes + pixelOffset, bytesPerRow * height, ASDecodedImageReleaseData);
+  if (provider == NULL) {
+    CFRelease((__bridge CFTypeRef)file);
+    return nil;
+  }
+  colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGImageRef imageRef = CGImageCreate(width, height, 8, 32, bytesPerRow, colorSpace, bitmapInfo, provider, NULL, false, kCGRenderingIntentDefault);
+  CGColorSpaceRelease(colorSpace);
+  CGDataProviderRelease(provider);
+  UIImage *result = imageRef ? [UIImage imageWithCGImage:imageRef scale:1 orientation:image.imageOrientation] : nil;
+  CGImageRelease(imageRef);
+  return result;
+}
+
+- (void)removeAllImages
+{
+  dispatch_sync(_ioQueue, ^{
+    NSString *suffix = [NSString stringWithFormat:@"-%lu.bitmap", (unsigned long)self->_maximumPixelDimension];
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    for (NSURL *file in [fileManager contentsOfDirectoryAtURL:self->_directoryURL includingPropertiesForKeys:nil options:0 error:NULL]) {
+      if ([file.lastPathComponent hasSuffix:suffix]) {
+        [fileManager removeItemAtURL:file error:NULL];
+      }
+    }
+    [self _trim];
+  });
+}
+
+#pragma mark ASImageCacheProtocol
+
+- (void)cachedImageWithURL:(NSURL *)URL
+             callbackQueue:(dispatch_queue_t)callbackQueue
+                completion:(ASImageCacherCompletion)completion
+{
+  if (URL == nil) {
+    completion(nil, ASImageCacheTypeAsynchronous);
+    return;
+  }
+  // Mapping a file is cheap, but opening it is still file I/O, which does not belong on the main thread.
+  dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+    UIImage *image = [self _imageFromFileForURL:URL];
+    dispatch_async(callbackQueue ?: dispatch_get_main_queue(), ^{
+      completion(image, ASImageCacheTypeAsynchronous);
+    });
+  });
+}
+
+@end
@@ -11,6 +11,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class ASBasicImageDiskCache;
+
 /**
  * @abstract Simple NSURLSession-based image downloader.
  */
@@ -20,14 +22,29 @@ NS_ASSUME_NONNULL_BEGIN
  * A shared image downloader which can be used by @c ASNetworkImageNodes and @c ASMultiplexImageNodes.
  * The userInfo provided by this downloader is `nil`.
  *
- * This is a very basic image downloader. It does not support caching, progressive downloading and likely
- * isn't something you should use in production. If you'd like something production ready, see @c ASPINRemoteImageDownloader
+ * This is a very basic image downloader. It renders progress images from the bytes received so far, for downloads
+ * whose progress image block is set before their transfer starts; other downloads go to a file. It does not
+ * cache images unless given a disk cache, and likely isn't something you should use in production. If you'd like something production ready, see @c ASPINRemoteImageDownloader
  *
  * @note It is strongly recommended you include PINRemoteImage and use @c ASPINRemoteImageDownloader instead.
  */
 @property (class, readonly) ASBasicImageDownloader *sharedImageDownloader;
 + (ASBasicImageDownloader *)sharedImageDownloader NS_RETURNS_RETAINED;
 
+/**
+ * @abstract If set, downloaded images are decoded into this cache, and completions get the cached bitmap.
+ * @discussion Defaults to nil. Use the same cache as the image nodes' cache.
+ */
+@property (nullable) ASBasicImageDiskCache *diskCache;
+
+/**
+ * @abstract The number of downloads that may transfer at once. Defaults to 6; 0 means no limit.
+ * @discussion Further requests wait, highest priority first and in request order within a priority, and are
+ * re-prioritized by -setPriority:withDownloadIdentifier: as their nodes move between ranges. Requests cancelled while
+ * waiting never reach the network.
+ */
+@property NSUInteger maximumConcurrentDownloads;
+
 + (instancetype)new __attribute__((unavailable("+[ASBasicImageDownloader sharedImageDownloader] must be used.")));
 - (instancetype)init __attribute__((unavailable("+[ASBasicImageDownloader sharedImageDownloader] must be used.")));
 
@@ -9,8 +9,11 @@
 
 #import <AsyncDisplayKit/ASBasicImageDownloader.h>
 
+#import <ImageIO/ImageIO.h>
+#import <QuartzCore/QuartzCore.h>
 #import <objc/runtime.h>
 
+#import <AsyncDisplayKit/ASBasicImageDiskCache.h>
 #import <AsyncDisplayKit/ASBasicImageDownloaderInternal.h>
 #import <AsyncDisplayKit/ASImageContainerProtocolCategories.h>
 #import <AsyncDisplayKit/ASThread.h>
@@ -39,10 +42,48 @@ static inline float NSURLSessionTaskPriorityWithImageDownloaderPriority(ASImageD
   }
 }
 
+/**
+ * Progress images are handed out at most this often, since each one decodes all bytes received so far.
+ */
+static const CFTimeInterval kASBasicImageDownloaderProgressImageInterval = 0.1;
+
+/**
+ * The most a transfer's buffer is sized up front from the response's expected length, which is the server's word. Larger
+ * bodies grow the buffer as they arrive.
+ */
+static const NSUInteger kASBasicImageDownloaderMaxPreallocatedLength = 4 * 1024 * 1024;
+
+static UIImageOrientation UIImageOrientationWithCGImagePropertyOrientation(NSNumber *orientation) {
+  switch (orientation.integerValue) {
+    case 2: return UIImageOrientationUpMirrored;
+    case 3: return UIImageOrientationDown;
+    case 4: return UIImageOrientationDownMirrored;
+    case 5: return UIImageOrientationLeftMirrored;
+    case 6: return UIImageOrientationRight;
+    case 7: return UIImageOrientationRightMirrored;
+    case 8: return UIImageOrientationLeft;
+    default: return UIImageOrientationUp;
+  }
+}
+
 @interface ASBasicImageDownloaderContext ()
 {
   BOOL _invalid;
   AS::RecursiveMutex __instanceLock__;
+
+  // The body of the current transfer so far: the first _receivedLength bytes of _receivedBuffer for a data task, or
+  // _downloadedData once a download task has finished.
+  NSMutableData *_receivedBuffer;
+  NSUInteger _receivedLength;
+  NSData *_downloadedData;
+  int64_t _expectedLength;
+
+  // While a progress image block is set, received bytes are fed to an incremental image source.
+  ASImageDownloaderProgressImage _progressImageBlock;
+  dispatch_queue_t _progressImageQueue;
+  CGImageSourceRef _incrementalSource;
+  UIImageOrientation _progressImageOrientation;
+  CFTimeInterval _lastProgressImageTime;
 }
 
 @property (nonatomic) NSMutableArray *callbackDatas;
@@ -94,6 +135,13 @@ static NSMutableDictionary *currentRequests = nil;
   return self;
 }
 
+- (void)dealloc
+{
+  if (_incrementalSource) {
+    CFRelease(_incrementalSource);
+  }
+}
+
 - (void)cancel
 {
   MutexLocker l(__instanceLock__);
@@ -120,6 +168,12 @@ static NSMutableDictionary *currentRequests = nil;
   [self.callbackDatas addObject:callbackData];
 }
 
+- (BOOL)hasCallbackDatas
+{
+  MutexLocker l(__instanceLock__);
+  return self.callbackDatas.count > 0;
+}
+
 - (void)performProgressBlocks:(CGFloat)progress
 {
   MutexLocker l(__instanceLock__);
@@ -135,6 +189,143 @@ static NSMutableDictionary *currentRequests = nil;
   }
 }
 
+- (void)setProgressImageBlock:(ASImageDownloaderProgressImage)progressImageBlock callbackQueue:(dispatch_queue_t)callbackQueue
+{
+  MutexLocker l(__instanceLock__);
+  _progressImageBlock = [progressImageBlock copy];
+  _progressImageQueue = callbackQueue ?: dispatch_get_main_queue();
+}
+
+- (BOOL)wantsProgressImages
+{
+  MutexLocker l(__instanceLock__);
+  return _progressImageBlock != nil;
+}
+
+- (void)didReceiveResponse:(NSURLResponse *)response
+{
+  MutexLocker l(__instanceLock__);
+  _expectedLength = response.expectedContentLength;
+  _receivedBuffer = _expectedLength > 0 ? [[NSMutableData alloc] initWithLength:(NSUInteger)MIN(_expectedLength, (int64_t)kASBasicImageDownloaderMaxPreallocatedLength)] : nil;
+  _receivedLength = 0;
+  [self _locked_resetIncrementalSource];
+}
+
+- (void)didReceiveData:(NSData *)data
+{
+  MutexLocker l(__instanceLock__);
+  [self _locked_appendData:data];
+  if (_expectedLength <= 0) {
+    return;
+  }
+
+  const CGFloat progress = (CGFloat)_receivedLength / (CGFloat)_expectedLength;
+  [self performProgressBlocks:progress];
+  if (progress < 1) {
+    [self _locked_performProgressImageBlockWithProgress:progress];
+  }
+}
+
+- (void)didFinishDownloadingToURL:(NSURL *)location
+{
+  // The file is deleted once this returns, which leaves a mapping of it intact.
+  NSData *data = [NSData dataWithContentsOfURL:location options:NSDataReadingMappedIfSafe error:NULL];
+  MutexLocker l(__instanceLock__);
+  _downloadedData = data;
+}
+
+- (NSData *)takeReceivedData
+{
+  MutexLocker l(__instanceLock__);
+  NSData *data = _downloadedData ?: [self _locked_receivedDataWithoutCopying];
+  _receivedBuffer = nil;
+  _receivedLength = 0;
+  _downloadedData = nil;
+  _expectedLength = 0;
+  [self _locked_resetIncrementalSource];
+  return data;
+}
+
+- (void)_locked_appendData:(NSData *)data
+{
+  const NSUInteger length = _receivedLength + data.length;
+  if (length > _receivedBuffer.length) {
+    // Data handed out may still point into the old buffer, so move to a new one rather than resize it.
+    NSMutableData *buffer = [[NSMutableData alloc] initWithLength:MAX(length, _receivedBuffer.length * 2)];
+    if (_receivedLength > 0) {
+      memcpy(buffer.mutableBytes, _receivedBuffer.mutableBytes, _receivedLength);
+    }
+    _receivedBuffer = buffer;
+  }
+  [data getBytes:(uint8_t *)_receivedBuffer.mutableBytes + _receivedLength length:data.length];
+  _receivedLength = length;
+}
+
+/**
+ * The bytes received so far. Bytes below _receivedLength are never written again, so the data can share the buffer,
+ * which it keeps alive.
+ */
+- (NSData *)_locked_receivedDataWithoutCopying
+{
+  NSMutableData *buffer = _receivedBuffer;
+  if (buffer == nil) {
+    return nil;
+  }
+  return [[NSData alloc] initWithBytesNoCopy:buffer.mutableBytes length:_receivedLength deallocator:^(void *bytes, NSUInteger length) {
+    (void)buffer;
+  }];
+}
+
+- (void)_locked_resetIncrementalSource
+{
+  if (_incrementalSource) {
+    CFRelease(_incrementalSource);
+    _incrementalSource = NULL;
+  }
+  _lastProgressImageTime = 0;
+}
+
+/**
+ * Decodes whatever the received bytes hold of the image, i.e. a coarser pass of a progressive JPEG or the top rows of
+ * a baseline one, and hands it to the progress image block.
+ */
+- (void)_locked_performProgressImageBlockWithProgress:(CGFloat)progress
+{
+  if (_progressImageBlock == nil) {
+    return;
+  }
+  const CFTimeInterval now = CACurrentMediaTime();
+  if (now - _lastProgressImageTime < kASBasicImageDownloaderProgressImageInterval) {
+    return;
+  }
+
+  if (_incrementalSource == NULL) {
+    _incrementalSource = CGImageSourceCreateIncremental(NULL);
+    _progressImageOrientation = UIImageOrientationUp;
+  }
+  // The source keeps the data it is given, and only ever gets more of the same bytes.
+  CGImageSourceUpdateData(_incrementalSource, (__bridge CFDataRef)[self _locked_receivedDataWithoutCopying], false);
+  if (CGImageSourceGetStatusAtIndex(_incrementalSource, 0) != kCGImageStatusIncomplete) {
+    return;
+  }
+  if (_progressImageOrientation == UIImageOrientationUp) {
+    NSDictionary *properties = (__bridge_transfer NSDictionary *)CGImageSourceCopyPropertiesAtIndex(_incrementalSource, 0, NULL);
+    _progressImageOrientation = UIImageOrientationWithCGImagePropertyOrientation(properties[(__bridge NSString *)kCGImagePropertyOrientation]);
+  }
+  CGImageRef imageRef = CGImageSourceCreateImageAtIndex(_incrementalSource, 0, NULL);
+  if (imageRef == NULL) {
+    return;
+  }
+  UIImage *image = [UIImage imageWithCGImage:imageRef scale:1 orientation:_progressImageOrientation];
+  CGImageRelease(imageRef);
+  _lastProgressImageTime = now;
+
+  ASImageDownloaderProgressImage progressImageBlock = _progressImageBlock;
+  dispatch_async(_progressImageQueue, ^{
+    progressImageBlock(image, progress, self);
+  });
+}
+
 - (void)completeWithImage:(UIImage *)image error:(NSError *)error
 {
   MutexLocker l(__instanceLock__);
@@ -190,7 +381,7 @@ static NSMutableDictionary *currentRequests = nil;
 
 #pragma mark -
 /**
- * NSURLSessionDownloadTask lacks a `userInfo` property, so add this association ourselves.
+ * NSURLSessionTask lacks a `userInfo` property, so add this association ourselves.
  */
 @interface NSURLRequest (ASBasicImageDownloader)
 @property (nonatomic) ASBasicImageDownloaderContext *asyncdisplaykit_context;
@@ -214,10 +405,18 @@ static const void *ContextKey() {
 
 
 #pragma mark -
-@interface ASBasicImageDownloader () <NSURLSessionDownloadDelegate>
+@interface ASBasicImageDownloader () <NSURLSessionDataDelegate, NSURLSessionDownloadDelegate>
 {
   NSOperationQueue *_sessionDelegateQueue;
   NSURLSession *_session;
+
+  // Guards the scheduler state below and the priority of every context in it.
+  AS::Mutex _schedulerLock;
+  // Contexts waiting for a slot, one FIFO per ASImageDownloaderPriority.
+  NSMutableOrderedSet<ASBasicImageDownloaderContext *> *_pendingContexts[ASImageDownloaderPriorityVisible + 1];
+  // Contexts that hold a slot, from the time they are dequeued until their task completes.
+  NSMutableSet<ASBasicImageDownloaderContext *> *_runningContexts;
+  NSUInteger _maximumConcurrentDownloads;
 }
 
 @end
@@ -237,18 +436,144 @@ static const void *ContextKey() {
 #pragma mark Lifecycle.
 
 - (instancetype)_init
+{
+  return [self _initWithSessionConfiguration:[NSURLSessionConfiguration defaultSessionConfiguration]];
+}
+
+- (instancetype)_initWithSessionConfiguration:(NSURLSessionConfiguration *)configuration
 {
   if (!(self = [super init]))
     return nil;
 
   _sessionDelegateQueue = [[NSOperationQueue alloc] init];
-  _session = [NSURLSession sessionWithConfiguration:[NSURLSessionConfiguration defaultSessionConfiguration]
+  _session = [NSURLSession sessionWithConfiguration:configuration
                                            delegate:self
                                       delegateQueue:_sessionDelegateQueue];
 
+  for (auto &pendingContexts : _pendingContexts) {
+    pendingContexts = [[NSMutableOrderedSet alloc] init];
+  }
+  _runningContexts = [[NSMutableSet alloc] init];
+  _maximumConcurrentDownloads = 6;
+
   return self;
 }
 
+#pragma mark Scheduling.
+
+/**
+ * Queues context at priority unless it is already queued or running, in which case it moves up to priority if that is
+ * higher. Callers must start pending downloads afterwards.
+ */
+- (void)_locked_enqueueContext:(ASBasicImageDownloaderContext *)context priority:(ASImageDownloaderPriority)priority
+{
+  if ([_runningContexts containsObject:context]) {
+    if (priority > context.priority) {
+      context.priority = priority;
+      context.sessionTask.priority = NSURLSessionTaskPriorityWithImageDownloaderPriority(priority);
+    }
+    return;
+  }
+
+  if ([_pendingContexts[context.priority] containsObject:context]) {
+    if (priority <= context.priority) {
+      return;
+    }
+    [_pendingContexts[context.priority] removeObject:context];
+  }
+  context.priority = priority;
+  [_pendingContexts[priority] addObject:context];
+}
+
+/** Removes the highest priority pending context, or returns nil if none is waiting or every slot is taken. */
+- (ASBasicImageDownloaderContext *)_locked_dequeueContextIfPossible
+{
+  if (_maximumConcurrentDownloads > 0 && _runningContexts.count >= _maximumConcurrentDownloads) {
+    return nil;
+  }
+  for (NSInteger priority = ASImageDownloaderPriorityVisible; priority >= 0; priority--) {
+    ASBasicImageDownloaderContext *context = _pendingContexts[priority].firstObject;
+    if (context != nil) {
+      [_pendingContexts[priority] removeObjectAtIndex:0];
+      [_runningContexts addObject:context];
+      return context;
+    }
+  }
+  return nil;
+}
+
+/** Fills the free slots with pending contexts. */
+- (void)_startPendingDownloads
+{
+  while (true) {
+    ASBasicImageDownloaderContext *context;
+    {
+      MutexLocker l(_schedulerLock);
+      context = [self _locked_dequeueContextIfPossible];
+    }
+    if (context == nil) {
+      return;
+    }
+
+    // Creating and resuming tasks contends on the session's locks. Callers are often on the main thread, so stay off it.
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+      NSURLSessionTask *task = [context createSessionTaskIfNecessaryWithBlock:^(){
+        // Progress images need the bytes as they arrive. Otherwise the body goes to a file rather than into memory.
+        NSURLSessionTask *newTask;
+        if ([context wantsProgressImages]) {
+          newTask = [self->_session dataTaskWithURL:context.URL];
+        } else {
+          newTask = [self->_session downloadTaskWithURL:context.URL];
+        }
+        // Associate the context before anyone can cancel the task, so its completion always frees the slot.
+        newTask.originalRequest.asyncdisplaykit_context = context;
+        return newTask;
+      }];
+      if (task == nil) {
+        // Cancelled in the meantime, or already transferring for another downloader: give the slot back.
+        [self _didFinishContext:context requeue:NO];
+        return;
+      }
+
+      {
+        MutexLocker l(self->_schedulerLock);
+        task.priority = NSURLSessionTaskPriorityWithImageDownloaderPriority(context.priority);
+      }
+
+      // start downloading
+      [task resume];
+    });
+  }
+}
+
+/** Frees context's slot, and with requeue, queues it again if callers arrived after its image was delivered. */
+- (void)_didFinishContext:(ASBasicImageDownloaderContext *)context requeue:(BOOL)requeue
+{
+  {
+    MutexLocker l(_schedulerLock);
+    [_runningContexts removeObject:context];
+    if (requeue && ![context isCancelled] && [context hasCallbackDatas]) {
+      [self _locked_enqueueContext:context priority:context.priority];
+    }
+  }
+  [self _startPendingDownloads];
+}
+
+- (NSUInteger)maximumConcurrentDownloads
+{
+  MutexLocker l(_schedulerLock);
+  return _maximumConcurrentDownloads;
+}
+
+- (void)setMaximumConcurrentDownloads:(NSUInteger)maximumConcurrentDownloads
+{
+  {
+    MutexLocker l(_schedulerLock);
+    _maximumConcurrentDownloads = maximumConcurrentDownloads;
+  }
+  [self _startPendingDownloads];
+}
+
 
 #pragma mark ASImageDownloaderProtocol.
 
@@ -272,34 +597,25 @@ static const void *ContextKey() {
 {
   ASBasicImageDownloaderContext *context = [ASBasicImageDownloaderContext contextForURL:URL];
 
-  // NSURLSessionDownloadTask will do file I/O to create a temp directory. If called on the main thread this will
-  // cause significant performance issues.
-  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-    // associate metadata with it
-    const auto callbackData = [[NSMutableDictionary alloc] init];
-    callbackData[kASBasicImageDownloaderContextCallbackQueue] = callbackQueue ? : dispatch_get_main_queue();
-
-    if (downloadProgress) {
-      callbackData[kASBasicImageDownloaderContextProgressBlock] = [downloadProgress copy];
-    }
-
-    if (completion) {
-      callbackData[kASBasicImageDownloaderContextCompletionBlock] = [completion copy];
-    }
+  // associate metadata with it
+  const auto callbackData = [[NSMutableDictionary alloc] init];
+  callbackData[kASBasicImageDownloaderContextCallbackQueue] = callbackQueue ? : dispatch_get_main_queue();
 
-    [context addCallbackData:[[NSDictionary alloc] initWithDictionary:callbackData]];
+  if (downloadProgress) {
+    callbackData[kASBasicImageDownloaderContextProgressBlock] = [downloadProgress copy];
+  }
 
-    // Create new task if necessary
-    NSURLSessionDownloadTask *task = (NSURLSessionDownloadTask *)[context createSessionTaskIfNecessaryWithBlock:^(){return [self->_session downloadTaskWithURL:URL];}];
+  if (completion) {
+    callbackData[kASBasicImageDownloaderContextCompletionBlock] = [completion copy];
+  }
 
-    if (task) {
-      task.priority = NSURLSessionTaskPriorityWithImageDownloaderPriority(priority);
-      task.originalRequest.asyncdisplaykit_context = context;
+  [context addCallbackData:[[NSDictionary alloc] initWithDictionary:callbackData]];
 
-      // start downloading
-      [task resume];
-    }
-  });
+  {
+    MutexLocker l(_schedulerLock);
+    [self _locked_enqueueContext:context priority:priority];
+  }
+  [self _startPendingDownloads];
 
   return context;
 }
@@ -309,9 +625,62 @@ static const void *ContextKey() {
   ASDisplayNodeAssert([downloadIdentifier isKindOfClass:ASBasicImageDownloaderContext.class], @"unexpected downloadIdentifier");
   ASBasicImageDownloaderContext *context = (ASBasicImageDownloaderContext *)downloadIdentifier;
 
+  {
+    // A context that never got a slot just leaves the queue. A running one frees its slot once its task completes.
+    MutexLocker l(_schedulerLock);
+    [_pendingContexts[context.priority] removeObject:context];
+  }
   [context cancel];
 }
 
+- (void)setProgressImageBlock:(ASImageDownloaderProgressImage)progressBlock
+                callbackQueue:(dispatch_queue_t)callbackQueue
+       withDownloadIdentifier:(id)downloadIdentifier
+{
+  ASDisplayNodeAssert([downloadIdentifier isKindOfClass:ASBasicImageDownloaderContext.class], @"unexpected downloadIdentifier");
+  ASBasicImageDownloaderContext *context = (ASBasicImageDownloaderContext *)downloadIdentifier;
+
+  [context setProgressImageBlock:progressBlock callbackQueue:callbackQueue];
+}
+
+- (void)setPriority:(ASImageDownloaderPriority)priority withDownloadIdentifier:(id)downloadIdentifier
+{
+  ASDisplayNodeAssert([downloadIdentifier isKindOfClass:ASBasicImageDownloaderContext.class], @"unexpected downloadIdentifier");
+  ASBasicImageDownloaderContext *context = (ASBasicImageDownloaderContext *)downloadIdentifier;
+
+  MutexLocker l(_schedulerLock);
+  if (priority == context.priority) {
+    return;
+  }
+  if ([_pendingContexts[context.priority] containsObject:context]) {
+    [_pendingContexts[context.priority] removeObject:context];
+    [_pendingContexts[priority] addObject:context];
+  } else if ([_runningContexts containsObject:context]) {
+    context.sessionTask.priority = NSURLSessionTaskPriorityWithImageDownloaderPriority(priority);
+  }
+  context.priority = priority;
+}
+
+
+#pragma mark NSURLSessionDataDelegate.
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask
+                                 didReceiveResponse:(NSURLResponse *)response
+                                  completionHandler:(void (^)(NSURLSessionResponseDisposition))completionHandler
+{
+  ASBasicImageDownloaderContext *context = dataTask.originalRequest.asyncdisplaykit_context;
+  [context didReceiveResponse:response];
+  completionHandler(NSURLSessionResponseAllow);
+}
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask
+                                     didReceiveData:(NSData *)data
+{
+  ASBasicImageDownloaderContext *context = dataTask.originalRequest.asyncdisplaykit_context;
+  if (![context isCancelled]) {
+    [context didReceiveData:data];
+  }
+}
 
 #pragma mark NSURLSessionDownloadDelegate.
 
@@ -321,32 +690,43 @@ static const void *ContextKey() {
                               totalBytesExpectedToWrite:(int64_t)totalBytesExpectedToWrite
 {
   ASBasicImageDownloaderContext *context = downloadTask.originalRequest.asyncdisplaykit_context;
-  [context performProgressBlocks:(CGFloat)totalBytesWritten / (CGFloat)totalBytesExpectedToWrite];
+  if (totalBytesExpectedToWrite > 0 && ![context isCancelled]) {
+    [context performProgressBlocks:(CGFloat)totalBytesWritten / (CGFloat)totalBytesExpectedToWrite];
+  }
 }
 
-// invoked if the download succeeded with no error
 - (void)URLSession:(NSURLSession *)session downloadTask:(NSURLSessionDownloadTask *)downloadTask
                               didFinishDownloadingToURL:(NSURL *)location
 {
   ASBasicImageDownloaderContext *context = downloadTask.originalRequest.asyncdisplaykit_context;
-  if ([context isCancelled]) {
-    return;
-  }
-
-  if (context) {
-    UIImage *image = [UIImage imageWithData:[NSData dataWithContentsOfURL:location]];
-    [context completeWithImage:image error:nil];
+  if (![context isCancelled]) {
+    [context didFinishDownloadingToURL:location];
   }
 }
 
+#pragma mark NSURLSessionTaskDelegate.
+
 // invoked unconditionally
-- (void)URLSession:(NSURLSession *)session task:(NSURLSessionDownloadTask *)task
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task
                            didCompleteWithError:(NSError *)error
 {
   ASBasicImageDownloaderContext *context = task.originalRequest.asyncdisplaykit_context;
-  if (context && error) {
+  if (context == nil) {
+    return;
+  }
+
+  NSData *data = [context takeReceivedData];
+  if (error) {
     [context completeWithImage:nil error:error];
+  } else if (![context isCancelled]) {
+    UIImage *image = [UIImage imageWithData:data];
+    ASBasicImageDiskCache *diskCache = self.diskCache;
+    if (image != nil && diskCache != nil) {
+      image = [diskCache storeImage:image forURL:context.URL] ?: image;
+    }
+    [context completeWithImage:image error:nil];
   }
+  [self _didFinishContext:context requeue:YES];
 }
 
 @end
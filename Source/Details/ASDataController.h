@@ -97,6 +97,13 @@ AS_EXTERN NSString * const ASCollectionInvalidUpdateException;
 
 - (nullable id<ASSectionContext>)dataController:(ASDataController *)dataController contextForSection:(NSInteger)section;
 
+/**
+ * The rect, in the view's coordinates, that the display range covers, and the index path of the first item on screen
+ * if there is one. Lets the data controller allocate and lay out the nodes that will be on screen before the rest.
+ * Called on the main thread, only with ASExperimentalVisibleFirstAllocation.
+ */
+- (CGRect)dataController:(ASDataController *)dataController displayRangeBoundsWithAnchorIndexPath:(NSIndexPath * _Nullable * _Nonnull)anchorIndexPath;
+
 @end
 
 /**
@@ -14,6 +14,7 @@
 #import <AsyncDisplayKit/ASCellNode.h>
 #import <AsyncDisplayKit/ASCollectionElement.h>
 #import <AsyncDisplayKit/ASCollectionLayoutContext.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASDispatch.h>
 #import <AsyncDisplayKit/ASDisplayNodeExtras.h>
 #import <AsyncDisplayKit/ASElementMap.h>
@@ -30,6 +31,8 @@
 #import <AsyncDisplayKit/ASDisplayNode+Subclasses.h>
 #import <AsyncDisplayKit/NSIndexSet+ASHelpers.h>
 
+#import <algorithm>
+
 //#define LOG(...) NSLog(__VA_ARGS__)
 #define LOG(...)
 
@@ -45,6 +48,12 @@ typedef dispatch_block_t ASDataControllerCompletionBlock;
 
 typedef void (^ASDataControllerSynchronizationBlock)();
 
+/**
+ * With ASExperimentalPipelinedDataController, how many change sets may be allocating or laying out at once. One per
+ * stage keeps each stage busy; beyond that, -updateWithChangeSet: waits for the oldest to reach the commit stage.
+ */
+static const long kASDataControllerMaximumPipelinedChangeSets = 3;
+
 @interface ASDataController () {
   id<ASDataControllerLayoutDelegate> _layoutDelegate;
 
@@ -58,6 +67,9 @@ typedef void (^ASDataControllerSynchronizationBlock)();
   dispatch_queue_t _editingTransactionQueue;  // Serial background queue.  Dispatches concurrent layout and manages _editingNodes.
   dispatch_group_t _editingTransactionGroup;  // Group of all edit transaction blocks. Useful for waiting.
   std::atomic<int> _editingTransactionGroupCount;
+
+  dispatch_queue_t _layoutTransactionQueue;   // Serial background queue. Lays out nodes allocated on _editingTransactionQueue when pipelined.
+  dispatch_semaphore_t _pipelineSemaphore;    // Limits change sets between -updateWithChangeSet: and commit when pipelined.
   
   BOOL _initialReloadDataHasBeenCalled;
 
@@ -71,6 +83,7 @@ typedef void (^ASDataControllerSynchronizationBlock)();
     unsigned int constrainedSizeForNodeAtIndexPath:1;
     unsigned int constrainedSizeForSupplementaryNodeOfKindAtIndexPath:1;
     unsigned int contextForSection:1;
+    unsigned int displayRangeBoundsWithAnchorIndexPath:1;
   } _dataSourceFlags;
 }
 
@@ -97,6 +110,7 @@ typedef void (^ASDataControllerSynchronizationBlock)();
   _dataSourceFlags.constrainedSizeForNodeAtIndexPath = [_dataSource respondsToSelector:@selector(dataController:constrainedSizeForNodeAtIndexPath:)];
   _dataSourceFlags.constrainedSizeForSupplementaryNodeOfKindAtIndexPath = [_dataSource respondsToSelector:@selector(dataController:constrainedSizeForSupplementaryNodeOfKind:atIndexPath:)];
   _dataSourceFlags.contextForSection = [_dataSource respondsToSelector:@selector(dataController:contextForSection:)];
+  _dataSourceFlags.displayRangeBoundsWithAnchorIndexPath = [_dataSource respondsToSelector:@selector(dataController:displayRangeBoundsWithAnchorIndexPath:)];
 
   self.visibleMap = self.pendingMap = [[ASElementMap alloc] init];
   
@@ -111,6 +125,10 @@ typedef void (^ASDataControllerSynchronizationBlock)();
   _editingTransactionQueue = dispatch_queue_create(queueName, DISPATCH_QUEUE_SERIAL);
   dispatch_queue_set_specific(_editingTransactionQueue, &kASDataControllerEditingQueueKey, &kASDataControllerEditingQueueContext, NULL);
   _editingTransactionGroup = dispatch_group_create();
+
+  const char *layoutQueueName = [[NSString stringWithFormat:@"org.AsyncDisplayKit.ASDataController.layoutTransactionQueue:%p", self] cStringUsingEncoding:NSASCIIStringEncoding];
+  _layoutTransactionQueue = dispatch_queue_create(layoutQueueName, DISPATCH_QUEUE_SERIAL);
+  _pipelineSemaphore = dispatch_semaphore_create(kASDataControllerMaximumPipelinedChangeSets);
   
   return self;
 }
@@ -134,7 +152,15 @@ typedef void (^ASDataControllerSynchronizationBlock)();
 - (void)_allocateNodesFromElements:(NSArray<ASCollectionElement *> *)elements
 {
   ASSERT_ON_EDITING_QUEUE;
-  
+  [self _prepareNodesFromElements:elements layoutNodes:YES];
+}
+
+/**
+ * Allocates the nodes of the given elements concurrently and, if layoutNodes is YES, lays each one out as soon as it
+ * is allocated. Nodes that are already allocated are only laid out.
+ */
+- (void)_prepareNodesFromElements:(NSArray<ASCollectionElement *> *)elements layoutNodes:(BOOL)layoutNodes
+{
   NSUInteger nodeCount = elements.count;
   __weak id<ASDataControllerSource> weakDataSource = _dataSource;
   if (nodeCount == 0 || weakDataSource == nil) {
@@ -151,7 +177,7 @@ typedef void (^ASDataControllerSynchronizationBlock)();
     if ([_dataSource dataControllerShouldSerializeNodeCreation:self]) {
       threadCount = 1;
     }
-    ASDispatchApply(nodeCount, queue, threadCount, ^(size_t i) {
+    void (^allocateNode)(size_t) = ^(size_t i) {
       __strong id<ASDataControllerSource> strongDataSource = weakDataSource;
       if (strongDataSource == nil) {
         return;
@@ -167,10 +193,18 @@ typedef void (^ASDataControllerSynchronizationBlock)();
 
       // Layout the node if the size range is valid.
       ASSizeRange sizeRange = element.constrainedSize;
-      if (ASSizeRangeHasSignificantArea(sizeRange)) {
+      if (layoutNodes && ASSizeRangeHasSignificantArea(sizeRange)) {
         [self _layoutNode:node withConstrainedSize:sizeRange];
       }
-    });
+    };
+
+    if (threadCount == 0 && ASActivateExperimentalFeature(ASExperimentalAdaptiveDispatchApply)) {
+      ASDispatchApplyReport report;
+      ASDispatchApplyAdaptive(nodeCount, queue, &report, allocateNode);
+      as_log_verbose(ASCollectionLog(), "Allocated %zu nodes on %lu threads in %.2fms, %.0f%% utilization", report.iterationCount, (unsigned long)report.threadCount, report.duration * 1000, report.utilization * 100);
+    } else {
+      ASDispatchApply(nodeCount, queue, threadCount, allocateNode);
+    }
   }
 
   ASSignpostEnd(DataControllerBatch, self, "count: %lu", (unsigned long)nodeCount);
@@ -555,7 +589,10 @@ typedef void (^ASDataControllerSynchronizationBlock)();
     os_log_debug(ASCollectionLog(), "performBatchUpdates %@ %@", ASViewToDisplayNode(ASDynamicCast(self.dataSource, UIView)), changeSet);
   }
 
-  if (!ASActivateExperimentalFeature(ASExperimentalOptimizeDataControllerPipeline)) {
+  // When pipelined, change sets overlap and are kept in order by the stage queues, so there is nothing to wait for here.
+  // Back-pressure is applied below, once the new map is latched.
+  BOOL pipelined = ASActivateExperimentalFeature(ASExperimentalPipelinedDataController);
+  if (!pipelined && !ASActivateExperimentalFeature(ASExperimentalOptimizeDataControllerPipeline)) {
     NSTimeInterval transactionQueueFlushDuration = 0.0f;
     {
       AS::ScopeTimer t(transactionQueueFlushDuration);
@@ -622,45 +659,102 @@ typedef void (^ASDataControllerSynchronizationBlock)();
   os_log_debug(ASCollectionLog(), "New content: %@", newMap.smallDescription);
 
   Class<ASDataControllerLayoutDelegate> layoutDelegateClass = [self.layoutDelegate class];
+
+  // With visible-first allocation, nodes nearest the viewport are prepared first, and the display range's worth of
+  // them before any others.
+  BOOL visibleFirst = NO;
+  NSIndexPath *anchorIndexPath = nil;
+  CGFloat displayRangeArea = 0;
+  if (!canDelegate && _dataSourceFlags.displayRangeBoundsWithAnchorIndexPath && ASActivateExperimentalFeature(ASExperimentalVisibleFirstAllocation)) {
+    visibleFirst = YES;
+    CGRect displayRangeBounds = [_dataSource dataController:self displayRangeBoundsWithAnchorIndexPath:&anchorIndexPath];
+    displayRangeArea = CGRectGetWidth(displayRangeBounds) * CGRectGetHeight(displayRangeBounds);
+  }
+  // A reload shown from the top can commit the leading items as soon as they fill the display range, and insert the
+  // rest once they are ready. Scrolled elsewhere, the content offset could land past the committed items.
+  BOOL commitsDisplayRangeEarly = visibleFirst && changeSet.includesReloadData
+      && (anchorIndexPath == nil || (anchorIndexPath.section == 0 && anchorIndexPath.item == 0));
+
+  if (pipelined) {
+    // Back-pressure: if every stage is busy, wait for the oldest change set to reach the commit stage rather than
+    // queueing up unbounded work (and maps) behind it.
+    NSTimeInterval pipelineWaitDuration = 0.0f;
+    {
+      AS::ScopeTimer t(pipelineWaitDuration);
+      dispatch_semaphore_wait(_pipelineSemaphore, DISPATCH_TIME_FOREVER);
+    }
+    if (pipelineWaitDuration > 0.001) {
+      as_log_verbose(ASCollectionLog(), "%@ waited %.2fms for the update pipeline", ASObjectDescriptionMakeTiny(_dataSource), pipelineWaitDuration * 1000);
+    }
+  }
+
   ++_editingTransactionGroupCount;
-  dispatch_group_async(_editingTransactionGroup, _editingTransactionQueue, ^{
+  dispatch_group_enter(_editingTransactionGroup);
+  dispatch_block_t prepareAndCommit = ^{
     __block __unused os_activity_scope_state_s preparationScope = {}; // unused if deployment target < iOS10
     as_activity_scope_enter(as_activity_create("Prepare nodes for collection update", AS_ACTIVITY_CURRENT, OS_ACTIVITY_FLAG_DEFAULT), &preparationScope);
 
     // Step 3: Call the layout delegate if possible. Otherwise, allocate and layout all elements
+    ASElementMap *displayRangeMap = nil;
+    __block _ASHierarchyChangeSet *remainingItems = nil;
     if (canDelegate) {
       [layoutDelegateClass calculateLayoutWithContext:layoutContext];
-    } else {
-      const auto elementsToProcess = [[NSMutableArray<ASCollectionElement *> alloc] init];
-      for (ASCollectionElement *element in newMap) {
-        ASCellNode *nodeIfAllocated = element.nodeIfAllocated;
-        if (nodeIfAllocated.shouldUseUIKitCell) {
-          // If the node exists and we know it is a passthrough cell, we know it will never have a .calculatedLayout.
-          continue;
-        } else if (nodeIfAllocated.calculatedLayout == nil) {
-          // If the node hasn't been allocated, or it doesn't have a valid layout, let's process it.
-          [elementsToProcess addObject:element];
-        }
+    } else if (visibleFirst) {
+      NSArray<ASCollectionElement *> *elements = [self _elementsToPrepareInMap:newMap nearestIndexPath:anchorIndexPath];
+      NSUInteger preparedCount = [self _prepareNodesFromElements:elements coveringArea:displayRangeArea];
+      if (commitsDisplayRangeEarly && preparedCount < elements.count) {
+        displayRangeMap = [self _mapWithReadyLeadingItemsOfMap:newMap];
       }
-      [self _allocateNodesFromElements:elementsToProcess];
+      if (displayRangeMap != nil) {
+        [self->_mainSerialQueue performBlockOnMainThread:^{
+          // Completion handlers expect every item of the reload, so they run with the change set inserting the rest.
+          remainingItems = [self _changeSetInsertingItemsOfMap:newMap
+                                                missingFromMap:displayRangeMap
+                                             completionHandler:[changeSet takeCompletionHandler]];
+          changeSet.hasPendingRemainder = YES;
+          [self _commitChangeSet:changeSet map:displayRangeMap];
+        }];
+      }
+      [self _prepareNodesFromElements:[elements subarrayWithRange:NSMakeRange(preparedCount, elements.count - preparedCount)] layoutNodes:YES];
+    } else if (pipelined) {
+      // Nodes were allocated in the previous stage. Lay out those that still need it; a later change set may have
+      // allocated the same elements before this one got here, and nodes laid out since then are skipped.
+      [self _prepareNodesFromElements:[self _elementsToPrepareInMap:newMap] layoutNodes:YES];
+    } else {
+      [self _allocateNodesFromElements:[self _elementsToPrepareInMap:newMap]];
     }
 
     // Step 4: Inform the delegate on main thread
     [self->_mainSerialQueue performBlockOnMainThread:^{
       as_activity_scope_leave(&preparationScope);
-      [self->_delegate dataController:self updateWithChangeSet:changeSet updates:^{
-        // Step 5: Deploy the new data as "completed"
-        //
-        // Note that since the backing collection view might be busy responding to user events (e.g scrolling),
-        // it will not consume the batch update blocks immediately.
-        // As a result, in a short intermidate time, the view will still be relying on the old data source state.
-        // Thus, we can't just swap the new map immediately before step 4, but until this update block is executed.
-        // (https://github.com/TextureGroup/Texture/issues/378)
-        self.visibleMap = newMap;
-      }];
+      if (displayRangeMap != nil) {
+        [self _commitChangeSet:remainingItems map:newMap];
+      } else {
+        [self _commitChangeSet:changeSet map:newMap];
+      }
     }];
     --self->_editingTransactionGroupCount;
-  });
+    if (pipelined) {
+      dispatch_semaphore_signal(self->_pipelineSemaphore);
+    }
+    dispatch_group_leave(self->_editingTransactionGroup);
+  };
+
+  if (pipelined) {
+    // Stage 1 allocates nodes on the editing queue, stage 2 lays them out on the layout queue and stage 3 commits on
+    // the main serial queue. Each stage is a serial queue fed by the previous one, so change sets leave every stage in
+    // the order they entered it, while change set N+1 allocates as N lays out and N-1 commits.
+    dispatch_async(_editingTransactionQueue, ^{
+      if (visibleFirst) {
+        [self _prepareNodesFromElements:[self _elementsToPrepareInMap:newMap nearestIndexPath:anchorIndexPath] layoutNodes:NO];
+      } else if (!canDelegate) {
+        [self _prepareNodesFromElements:[self _elementsToPrepareInMap:newMap] layoutNodes:NO];
+      }
+      dispatch_async(self->_layoutTransactionQueue, prepareAndCommit);
+    });
+  } else {
+    dispatch_async(_editingTransactionQueue, prepareAndCommit);
+  }
 
   // We've now dispatched node allocation and layout to a concurrent background queue.
   // In some cases, it's advantageous to prevent the main thread from returning, to ensure the next
@@ -674,6 +768,176 @@ typedef void (^ASDataControllerSynchronizationBlock)();
   }
 }
 
+/**
+ * The elements of the given map whose nodes still need to be allocated or laid out.
+ */
+- (NSArray<ASCollectionElement *> *)_elementsToPrepareInMap:(ASElementMap *)map
+{
+  const auto elements = [[NSMutableArray<ASCollectionElement *> alloc] init];
+  for (ASCollectionElement *element in map) {
+    ASCellNode *nodeIfAllocated = element.nodeIfAllocated;
+    if (nodeIfAllocated.shouldUseUIKitCell) {
+      // If the node exists and we know it is a passthrough cell, we know it will never have a .calculatedLayout.
+      continue;
+    } else if (nodeIfAllocated.calculatedLayout == nil) {
+      // If the node hasn't been allocated, or it doesn't have a valid layout, let's process it.
+      [elements addObject:element];
+    }
+  }
+  return elements;
+}
+
+/**
+ * The elements of the given map that still need preparing, nearest the viewport first: supplementary elements, then
+ * items by their distance from anchorIndexPath (or the first item) in index order. Items before the anchor count as
+ * twice as far, since the screen extends forward from its first item and only the trailing buffer lies behind it.
+ */
+- (NSArray<ASCollectionElement *> *)_elementsToPrepareInMap:(ASElementMap *)map nearestIndexPath:(nullable NSIndexPath *)anchorIndexPath
+{
+  NSArray<ASCollectionElement *> *elementsToPrepare = [self _elementsToPrepareInMap:map];
+  const auto orderedElements = [[NSMutableArray<ASCollectionElement *> alloc] initWithCapacity:elementsToPrepare.count];
+  const auto itemsToPrepare = [[NSMutableSet<ASCollectionElement *> alloc] initWithCapacity:elementsToPrepare.count];
+  for (ASCollectionElement *element in elementsToPrepare) {
+    if (element.supplementaryElementKind != nil) {
+      [orderedElements addObject:element];
+    } else {
+      [itemsToPrepare addObject:element];
+    }
+  }
+
+  NSArray<ASCollectionElement *> *items = map.itemElements;
+  NSUInteger anchor = 0;
+  if (anchorIndexPath != nil && items.count > 0) {
+    for (NSInteger section = 0; section < MIN(anchorIndexPath.section, map.numberOfSections); section++) {
+      anchor += [map numberOfItemsInSection:section];
+    }
+    if (anchorIndexPath.section < map.numberOfSections) {
+      anchor += MIN(anchorIndexPath.item, [map numberOfItemsInSection:anchorIndexPath.section]);
+    }
+    anchor = MIN(anchor, items.count - 1);
+  }
+
+  // (distance, index) pairs sort by distance, then in index order.
+  std::vector<std::pair<NSUInteger, NSUInteger>> order;
+  order.reserve(itemsToPrepare.count);
+  NSUInteger i = 0;
+  for (ASCollectionElement *item in items) {
+    if ([itemsToPrepare containsObject:item]) {
+      order.emplace_back(i >= anchor ? i - anchor : 2 * (anchor - i), i);
+    }
+    i++;
+  }
+  std::sort(order.begin(), order.end());
+  for (const auto &entry : order) {
+    [orderedElements addObject:items[entry.second]];
+  }
+  return orderedElements;
+}
+
+/**
+ * Prepares the given elements in order, a few at a time, until the nodes laid out so far cover the given area.
+ * Returns how many elements were prepared.
+ */
+- (NSUInteger)_prepareNodesFromElements:(NSArray<ASCollectionElement *> *)elements coveringArea:(CGFloat)area
+{
+  // Small enough to stop soon after the area is covered, large enough to keep every core busy.
+  const NSUInteger chunkSize = MAX((NSUInteger)4, NSProcessInfo.processInfo.activeProcessorCount * 2);
+  NSUInteger preparedCount = 0;
+  CGFloat coveredArea = 0;
+  while (preparedCount < elements.count && coveredArea < area) {
+    NSArray<ASCollectionElement *> *chunk = [elements subarrayWithRange:NSMakeRange(preparedCount, MIN(chunkSize, elements.count - preparedCount))];
+    [self _prepareNodesFromElements:chunk layoutNodes:YES];
+    for (ASCollectionElement *element in chunk) {
+      CGSize size = element.nodeIfAllocated.calculatedSize;
+      coveredArea += size.width * size.height;
+    }
+    preparedCount += chunk.count;
+  }
+  return preparedCount;
+}
+
+/**
+ * A copy of the given map with only the leading items whose nodes are ready, in index order. Returns nil if that is
+ * none or all of them, or if the map has supplementary elements that belong to items rather than to sections.
+ */
+- (nullable ASElementMap *)_mapWithReadyLeadingItemsOfMap:(ASElementMap *)map
+{
+  for (ASCollectionElement *element in map) {
+    if (element.supplementaryElementKind != nil && [map indexPathForElement:element].item != 0) {
+      return nil;
+    }
+  }
+
+  NSArray<ASCollectionElement *> *items = map.itemElements;
+  NSUInteger readyCount = 0;
+  for (ASCollectionElement *item in items) {
+    ASCellNode *node = item.nodeIfAllocated;
+    if (!node.shouldUseUIKitCell && node.calculatedLayout == nil) {
+      break;
+    }
+    readyCount++;
+  }
+  if (readyCount == 0 || readyCount == items.count) {
+    return nil;
+  }
+
+  NSArray<NSIndexPath *> *indexPaths = map.itemIndexPaths;
+  NSArray<NSIndexPath *> *remainingIndexPaths = [indexPaths subarrayWithRange:NSMakeRange(readyCount, indexPaths.count - readyCount)];
+  ASMutableElementMap *leadingMap = [map mutableCopy];
+  // Items are removed in descending order.
+  [leadingMap removeItemsAtIndexPaths:remainingIndexPaths.reverseObjectEnumerator.allObjects];
+  return [leadingMap copy];
+}
+
+/**
+ * A completed change set that inserts the items of map that the smaller leadingMap, which has the same sections, lacks,
+ * and runs the given completion handler.
+ */
+- (_ASHierarchyChangeSet *)_changeSetInsertingItemsOfMap:(ASElementMap *)map
+                                          missingFromMap:(ASElementMap *)leadingMap
+                                       completionHandler:(nullable void (^)(BOOL finished))completionHandler
+{
+  ASDisplayNodeAssertMainThread();
+  std::vector<NSInteger> oldItemCounts;
+  std::vector<NSInteger> newItemCounts;
+  const auto indexPaths = [[NSMutableArray<NSIndexPath *> alloc] init];
+  for (NSInteger section = 0; section < map.numberOfSections; section++) {
+    NSInteger leadingCount = [leadingMap numberOfItemsInSection:section];
+    NSInteger count = [map numberOfItemsInSection:section];
+    oldItemCounts.push_back(leadingCount);
+    newItemCounts.push_back(count);
+    for (NSInteger item = leadingCount; item < count; item++) {
+      [indexPaths addObject:[NSIndexPath indexPathForItem:item inSection:section]];
+    }
+  }
+
+  _ASHierarchyChangeSet *changeSet = [[_ASHierarchyChangeSet alloc] initWithOldData:oldItemCounts];
+  changeSet.animated = NO;
+  // Table views read the options as a UITableViewRowAnimation; collection views go by `animated`.
+  [changeSet insertItems:indexPaths animationOptions:UITableViewRowAnimationNone];
+  [changeSet addCompletionHandler:completionHandler];
+  [changeSet markCompletedWithNewItemCounts:newItemCounts];
+  return changeSet;
+}
+
+/**
+ * Hands the change set to the delegate, which deploys the given map as the visible one when the view takes the update.
+ */
+- (void)_commitChangeSet:(_ASHierarchyChangeSet *)changeSet map:(ASElementMap *)map
+{
+  ASDisplayNodeAssertMainThread();
+  [_delegate dataController:self updateWithChangeSet:changeSet updates:^{
+    // Step 5: Deploy the new data as "completed"
+    //
+    // Note that since the backing collection view might be busy responding to user events (e.g scrolling),
+    // it will not consume the batch update blocks immediately.
+    // As a result, in a short intermidate time, the view will still be relying on the old data source state.
+    // Thus, we can't just swap the new map immediately before step 4, but until this update block is executed.
+    // (https://github.com/TextureGroup/Texture/issues/378)
+    self.visibleMap = map;
+  }];
+}
+
 /**
  * Update sections based on the given change set.
  */
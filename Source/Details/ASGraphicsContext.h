@@ -62,4 +62,27 @@ AS_EXTERN UIImage *ASGraphicsCreateImage(ASPrimitiveTraitCollection traitCollect
 */
 AS_EXTERN UIImage *ASGraphicsCreateImageWithTraitCollectionAndOptions(ASPrimitiveTraitCollection traitCollection, CGSize size, BOOL opaque, CGFloat scale, UIImage * _Nullable sourceImage, void (NS_NOESCAPE ^work)(void)) ASDISPLAYNODE_DEPRECATED_MSG("Use ASGraphicsCreateImage instead");
 
+/**
+ * Images with fewer pixels than this are not worth tiling; ASGraphicsCreateTiledImage renders them in one pass.
+ */
+AS_EXTERN const size_t ASGraphicsTiledImageMinimumPixelCount;
+
+/**
+ * Like ASGraphicsCreateImage, but renders a large image in horizontal tiles, so that cancellation takes effect between
+ * tiles and the tiles that matter most are drawn first. Tiles are 8-bit sRGB, so an image that ASGraphicsCreateImage
+ * would render in extended range, e.g. for a wide color sourceImage, is rendered in one pass by it instead.
+ *
+ * @param sourceImage The image that work draws, if any, as for ASGraphicsCreateImage.
+ * @param priorityRect The part of the image to draw first, e.g. the part on screen, in points. CGRectNull draws from the
+ *   top down.
+ * @param concurrent Whether tiles may be drawn on several threads at once. Only takes effect on iOS >= 10, and requires
+ *   work to be safe to run concurrently with itself.
+ * @param work A block, wherein the current UIGraphics context is set to one tile: it is clipped to the tile and its
+ *   transform matches the whole image's. It runs once per tile, so it should only draw what falls within
+ *   CGContextGetClipBoundingBox, and must not depend on what it drew for other tiles.
+ *
+ * @return The rendered image, or nil if cancelled.
+ */
+AS_EXTERN UIImage * _Nullable ASGraphicsCreateTiledImage(ASPrimitiveTraitCollection traitCollection, CGSize size, BOOL opaque, CGFloat scale, UIImage * _Nullable sourceImage, CGRect priorityRect, BOOL concurrent, asdisplaynode_iscancelled_block_t _Nullable NS_NOESCAPE isCancelled, void (NS_NOESCAPE ^work)(void));
+
 NS_ASSUME_NONNULL_END
@@ -12,6 +12,11 @@
 #import <AsyncDisplayKit/ASInternalHelpers.h>
 #import <AsyncDisplayKit/ASAvailability.h>
 
+#import <algorithm>
+#import <atomic>
+#import <cmath>
+#import <vector>
+
 
 #if AS_AT_LEAST_IOS13
 #define ASPerformBlockWithTraitCollection(work, traitCollection) \
@@ -134,3 +139,123 @@ UIImage *ASGraphicsCreateImage(ASPrimitiveTraitCollection traitCollection, CGSiz
 UIImage *ASGraphicsCreateImageWithTraitCollectionAndOptions(ASPrimitiveTraitCollection traitCollection, CGSize size, BOOL opaque, CGFloat scale, UIImage * sourceImage, void (NS_NOESCAPE ^work)()) {
   return ASGraphicsCreateImage(traitCollection, size, opaque, scale, sourceImage, nil, work);
 }
+
+// 1024×1024 pixels take well over a frame to draw on older devices.
+const size_t ASGraphicsTiledImageMinimumPixelCount = 1024 * 1024;
+// Tiles of about 256K pixels keep each tile to a few milliseconds.
+static const size_t kASGraphicsTilePixelCount = 256 * 1024;
+
+/**
+ * Whether ASGraphicsCreateImage would draw into the 8-bit sRGB format that tiles are drawn in, rather than extended
+ * range, e.g. for a Display P3 source image or screen.
+ */
+static BOOL ASGraphicsCreateImageUsesStandardRange(ASPrimitiveTraitCollection traitCollection, UIImage *sourceImage)
+{
+  if (AS_AVAILABLE_IOS_TVOS(10, 10)) {
+    if (ASActivateExperimentalFeature(ASExperimentalDrawingGlobal)) {
+      const BOOL wideColorScreen = (traitCollection.displayGamut == UIDisplayGamutP3);
+      if (sourceImage != nil && sourceImage.renderingMode != UIImageRenderingModeAlwaysTemplate) {
+        UIGraphicsImageRendererFormat *format = sourceImage.imageRendererFormat;
+        if (AS_AVAILABLE_IOS_TVOS(12, 12)) {
+          const UIGraphicsImageRendererFormatRange range = format.preferredRange;
+          return range == UIGraphicsImageRendererFormatRangeStandard || (range == UIGraphicsImageRendererFormatRangeAutomatic && !wideColorScreen);
+        }
+        return !format.prefersExtendedRange;
+      }
+      if (AS_AVAILABLE_IOS_TVOS(12, 12)) {
+        // The preferred formats have automatic range, which is extended on wide color screens.
+        return !wideColorScreen;
+      }
+      // ASConfigureExtendedRange turned it off.
+      return YES;
+    }
+  }
+  // UIGraphicsBeginImageContextWithOptions.
+  return YES;
+}
+
+UIImage *ASGraphicsCreateTiledImage(ASPrimitiveTraitCollection traitCollection, CGSize size, BOOL opaque, CGFloat scale, UIImage *sourceImage, CGRect priorityRect, BOOL concurrent, asdisplaynode_iscancelled_block_t NS_NOESCAPE isCancelled, void (NS_NOESCAPE ^work)()) {
+  if (scale == 0) {
+    scale = ASScreenScale();
+  }
+  const size_t width = (size_t)std::ceil(size.width * scale);
+  const size_t height = (size_t)std::ceil(size.height * scale);
+  if (width * height < ASGraphicsTiledImageMinimumPixelCount || !ASGraphicsCreateImageUsesStandardRange(traitCollection, sourceImage)) {
+    return ASGraphicsCreateImage(traitCollection, size, opaque, scale, sourceImage, isCancelled, work);
+  }
+
+  // The format UIGraphicsBeginImageContextWithOptions uses.
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  const uint32_t bitmapInfo = kCGBitmapByteOrder32Little | (opaque ? kCGImageAlphaNoneSkipFirst : kCGImageAlphaPremultipliedFirst);
+  CGContextRef imageContext = CGBitmapContextCreate(NULL, width, height, 8, 0, colorSpace, bitmapInfo);
+  if (imageContext == NULL) {
+    CGColorSpaceRelease(colorSpace);
+    return ASGraphicsCreateImage(traitCollection, size, opaque, scale, sourceImage, isCancelled, work);
+  }
+  uint8_t *data = (uint8_t *)CGBitmapContextGetData(imageContext);
+  const size_t bytesPerRow = CGBitmapContextGetBytesPerRow(imageContext);
+
+  // Tiles are bands of whole rows, so each one is a bitmap context of its own over its rows of the image's buffer and
+  // tiles never share memory.
+  const size_t rowsPerTile = std::max<size_t>(1, kASGraphicsTilePixelCount / width);
+  const size_t tileCount = (height + rowsPerTile - 1) / rowsPerTile;
+  std::vector<size_t> order(tileCount);
+  for (size_t i = 0; i < tileCount; i++) {
+    order[i] = i;
+  }
+  if (!CGRectIsNull(priorityRect) && !CGRectIsEmpty(priorityRect)) {
+    // Tiles closest to the middle of priorityRect first.
+    const CGFloat priorityRow = CGRectGetMidY(priorityRect) * scale;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return std::fabs((a + 0.5) * rowsPerTile - priorityRow) < std::fabs((b + 0.5) * rowsPerTile - priorityRow);
+    });
+  }
+
+  std::atomic<bool> cancelled(false);
+  auto drawTile = [&](size_t n) {
+    if (cancelled.load(std::memory_order_relaxed)) {
+      return;
+    }
+    if (isCancelled != nil && isCancelled()) {
+      cancelled.store(true, std::memory_order_relaxed);
+      return;
+    }
+    const size_t firstRow = order[n] * rowsPerTile;
+    const size_t rowCount = std::min(rowsPerTile, height - firstRow);
+    CGContextRef tileContext = CGBitmapContextCreate(data + firstRow * bytesPerRow, width, rowCount, 8, bytesPerRow, colorSpace, bitmapInfo);
+    if (tileContext == NULL) {
+      cancelled.store(true, std::memory_order_relaxed);
+      return;
+    }
+    // Flip to UIKit's coordinates and move the tile's rows into place.
+    CGContextTranslateCTM(tileContext, 0, rowCount);
+    CGContextScaleCTM(tileContext, scale, -scale);
+    CGContextTranslateCTM(tileContext, 0, -(CGFloat)firstRow / scale);
+    // Clip explicitly, so that work can find the tile's rect and skip drawing the rest of the image.
+    CGContextClipToRect(tileContext, CGRectMake(0, firstRow / scale, width / scale, rowCount / scale));
+    UIGraphicsPushContext(tileContext);
+    ASPerformBlockWithTraitCollection(work, traitCollection);
+    UIGraphicsPopContext();
+    CGContextRelease(tileContext);
+  };
+
+  if (concurrent && tileCount > 1 && AS_AVAILABLE_IOS_TVOS(10, 10)) {
+    dispatch_apply(tileCount, dispatch_get_global_queue(qos_class_self(), 0), ^(size_t n) {
+      drawTile(n);
+    });
+  } else {
+    for (size_t n = 0; n < tileCount; n++) {
+      drawTile(n);
+    }
+  }
+
+  UIImage *image = nil;
+  if (!cancelled.load() && (isCancelled == nil || !isCancelled())) {
+    CGImageRef cgImage = CGBitmapContextCreateImage(imageContext);
+    image = [UIImage imageWithCGImage:cgImage scale:scale orientation:UIImageOrientationUp];
+    CGImageRelease(cgImage);
+  }
+  CGContextRelease(imageContext);
+  CGColorSpaceRelease(colorSpace);
+  return image;
+}
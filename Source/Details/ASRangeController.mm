@@ -16,6 +16,8 @@
 #import <AsyncDisplayKit/ASDisplayNodeExtras.h>
 #import <AsyncDisplayKit/ASDisplayNodeInternal.h> // Required for interfaceState and hierarchyState setter methods.
 #import <AsyncDisplayKit/ASElementMap.h>
+#import <AsyncDisplayKit/ASImageNode.h>
+#import <AsyncDisplayKit/ASImageNode+Private.h>
 #import <AsyncDisplayKit/ASSignpost.h>
 
 #import <AsyncDisplayKit/ASCellNode+Internal.h>
@@ -574,6 +576,8 @@ static ASLayoutRangeMode __rangeModeForMemoryWarnings = ASLayoutRangeModeLowMemo
     // There's no need to call needs update as updateCurrentRangeWithMode sets this if necessary.
     [rangeController updateIfNeeded];
   }
+  // Shrinking the ranges releases the contents of nodes that left them, but not the contents kept beyond their nodes.
+  [ASImageNode _removeAllRetainedContents];
   
 #if ASRangeControllerLoggingEnabled
   NSLog(@"+[ASRangeController didReceiveMemoryWarning] with controllers: %@", allRangeControllers);
@@ -67,25 +67,26 @@
 
 /**
  * @abstract Compares two arrays, providing the insertion and deletion indexes needed to transform into the target array.
- * @discussion This compares the equality of each object with `isEqual:`.
- * This diffing algorithm uses a bottom-up memoized longest common subsequence solution to identify differences.
- * It runs in O(mn) complexity.
+ * @discussion This compares the equality of each object with `isEqual:` and `hash`.
+ * This diffing algorithm keeps a longest common subsequence in place, found with Myers' algorithm in linear space.
+ * It runs in O((m+n)d) complexity, where d is the number of insertions and deletions.
  */
 - (void)asdk_diffWithArray:(NSArray *)array insertions:(NSIndexSet **)insertions deletions:(NSIndexSet **)deletions;
 
 /**
  * @abstract Compares two arrays, providing the insertion and deletion indexes needed to transform into the target array.
  * @discussion The `compareBlock` is used to identify the equality of the objects within the arrays.
- * This diffing algorithm uses a bottom-up memoized longest common subsequence solution to identify differences.
- * It runs in O(mn) complexity.
+ * This diffing algorithm keeps a longest common subsequence in place, found with Myers' algorithm in linear space.
+ * It runs in O((m+n)d) complexity, where d is the number of insertions and deletions.
  */
 - (void)asdk_diffWithArray:(NSArray *)array insertions:(NSIndexSet **)insertions deletions:(NSIndexSet **)deletions compareBlock:(BOOL (^)(id lhs, id rhs))comparison;
 
 /**
  * @abstract Compares two arrays, providing the insertion, deletion, and move indexes needed to transform into the target array.
- * @discussion This compares the equality of each object with `isEqual:`.
- * This diffing algorithm uses a bottom-up memoized longest common subsequence solution to identify differences.
- * It runs in O(mn) complexity.
+ * @discussion This compares the equality of each object with `isEqual:` and `hash`.
+ * This diffing algorithm pairs equal objects through a hash table (Heckel's algorithm). Objects that keep their index
+ * are left alone, every other pair is a move.
+ * It runs in O(m+n) complexity.
  * The moves are returned in ascending order of their destination index.
  */
 - (void)asdk_diffWithArray:(NSArray *)array insertions:(NSIndexSet **)insertions deletions:(NSIndexSet **)deletions moves:(NSArray<NSIndexPath *> **)moves;
@@ -10,12 +10,87 @@
 #import <AsyncDisplayKit/NSArray+Diffing.h>
 #import <UIKit/NSIndexPath+UIKitAdditions.h>
 #import <AsyncDisplayKit/ASAssert.h>
+#import <AsyncDisplayKit/ASBaseDefines.h>
+#import <AsyncDisplayKit/ASDiffingCore.h>
 #import <unordered_map>
-
-@implementation NSArray (Diffing)
+#import <vector>
 
 typedef BOOL (^compareBlock)(id _Nonnull lhs, id _Nonnull rhs);
 
+namespace {
+
+/** Compares the elements of two arrays with a custom block. */
+class ASBlockComparator : public AS::Diffing::Comparator {
+public:
+  ASBlockComparator(NSArray *oldArray, NSArray *newArray, compareBlock comparison)
+  : _oldObjects(oldArray.count), _newObjects(newArray.count), _comparison(comparison)
+  {
+    [oldArray getObjects:_oldObjects.data() range:NSMakeRange(0, _oldObjects.size())];
+    [newArray getObjects:_newObjects.data() range:NSMakeRange(0, _newObjects.size())];
+  }
+
+  bool equal(size_t oldIndex, size_t newIndex) const override
+  {
+    return _comparison(_oldObjects[oldIndex], _newObjects[newIndex]);
+  }
+
+private:
+  // The arrays retain their elements for the lifetime of the comparator.
+  std::vector<unowned id> _oldObjects;
+  std::vector<unowned id> _newObjects;
+  const compareBlock _comparison;
+};
+
+/**
+ * Replaces every element of both arrays with the index of its equivalence class under -isEqual: and -hash, so that the
+ * engine compares integers instead of sending messages. Returns the number of classes.
+ */
+size_t ASDiffingSymbolize(NSArray *oldArray, NSArray *newArray,
+                          std::vector<size_t> &oldSymbols, std::vector<size_t> &newSymbols)
+{
+  struct NSObjectHash
+  {
+    std::size_t operator()(id <NSObject> k) const { return (std::size_t) [k hash]; };
+  };
+  struct NSObjectCompare
+  {
+    bool operator()(id <NSObject> lhs, id <NSObject> rhs) const { return (bool) [lhs isEqual:rhs]; };
+  };
+  std::unordered_map<unowned id, size_t, NSObjectHash, NSObjectCompare> table;
+  table.reserve(oldArray.count + newArray.count);
+
+  oldSymbols.reserve(oldArray.count);
+  for (id element in oldArray) {
+    const size_t symbol = table.size();
+    oldSymbols.push_back(table.emplace(element, symbol).first->second);
+  }
+  newSymbols.reserve(newArray.count);
+  for (id element in newArray) {
+    const size_t symbol = table.size();
+    newSymbols.push_back(table.emplace(element, symbol).first->second);
+  }
+  return table.size();
+}
+
+NSMutableIndexSet *ASIndexSetWithIndexes(const std::vector<size_t> &indexes)
+{
+  // Indexes are ascending, so coalesce runs into ranges.
+  NSMutableIndexSet *indexSet = [NSMutableIndexSet indexSet];
+  for (size_t i = 0; i < indexes.size();) {
+    size_t j = i + 1;
+    while (j < indexes.size() && indexes[j] == indexes[j - 1] + 1) {
+      j++;
+    }
+    [indexSet addIndexesInRange:NSMakeRange(indexes[i], j - i)];
+    i = j;
+  }
+  return indexSet;
+}
+
+} // namespace
+
+@implementation NSArray (Diffing)
+
 - (void)asdk_diffWithArray:(NSArray *)array insertions:(NSIndexSet **)insertions deletions:(NSIndexSet **)deletions
 {
   [self asdk_diffWithArray:array insertions:insertions deletions:deletions moves:nil compareBlock:[NSArray defaultCompareBlock]];
@@ -37,126 +112,37 @@ typedef BOOL (^compareBlock)(id _Nonnull lhs, id _Nonnull rhs);
 - (void)asdk_diffWithArray:(NSArray *)array insertions:(NSIndexSet **)insertions deletions:(NSIndexSet **)deletions
                      moves:(NSArray<NSIndexPath *> **)moves compareBlock:(compareBlock)comparison
 {
-  struct NSObjectHash
-  {
-    std::size_t operator()(id <NSObject> k) const { return (std::size_t) [k hash]; };
-  };
-  struct NSObjectCompare
-  {
-    bool operator()(id <NSObject> lhs, id <NSObject> rhs) const { return (bool) [lhs isEqual:rhs]; };
-  };
-  std::unordered_multimap<unowned id, NSUInteger, NSObjectHash, NSObjectCompare> potentialMoves;
-
   NSAssert(comparison != nil, @"Comparison block is required");
   NSAssert(moves == nil || comparison == [NSArray defaultCompareBlock], @"move detection requires isEqual: and hash (no custom compare)");
-  NSMutableArray<NSIndexPath *> *moveIndexPaths = nil;
-  NSMutableIndexSet *insertionIndexes = nil, *deletionIndexes = nil;
-  if (moves) {
-    moveIndexPaths = [NSMutableArray new];
-  }
-  NSMutableIndexSet *commonIndexes = [self _asdk_commonIndexesWithArray:array compareBlock:comparison];
-
-  if (deletions || moves) {
-    deletionIndexes = [NSMutableIndexSet indexSet];
-    NSUInteger i = 0;
-    for (id element in self) {
-      if (![commonIndexes containsIndex:i]) {
-        [deletionIndexes addIndex:i];
-      }
-      if (moves) {
-        potentialMoves.insert(std::pair<id, NSUInteger>(element, i));
-      }
-      ++i;
+
+  AS::Diffing::Changes changes;
+  if (comparison == [NSArray defaultCompareBlock]) {
+    std::vector<size_t> oldSymbols, newSymbols;
+    const size_t symbolCount = ASDiffingSymbolize(self, array, oldSymbols, newSymbols);
+    if (moves) {
+      changes = AS::Diffing::changesWithMoves(oldSymbols, newSymbols, symbolCount);
+    } else {
+      changes = AS::Diffing::changes(oldSymbols.size(), newSymbols.size(), AS::Diffing::SymbolComparator(oldSymbols, newSymbols));
     }
+  } else {
+    changes = AS::Diffing::changes(self.count, array.count, ASBlockComparator(self, array, comparison));
   }
 
-  if (insertions || moves) {
-    insertionIndexes = [NSMutableIndexSet indexSet];
-    NSArray *commonObjects = [self objectsAtIndexes:commonIndexes];
-    for (NSUInteger i = 0, j = 0; j < array.count; j++) {
-      auto moveFound = potentialMoves.find(array[j]);
-      NSUInteger movedFrom = NSNotFound;
-      if (moveFound != potentialMoves.end() && moveFound->second != j) {
-        movedFrom = moveFound->second;
-        potentialMoves.erase(moveFound);
-        [moveIndexPaths addObject:[NSIndexPath indexPathForItem:j inSection:movedFrom]];
-      }
-      if (i < commonObjects.count && j < array.count && comparison(commonObjects[i], array[j])) {
-        i++;
-      } else {
-        if (movedFrom != NSNotFound) {
-          // moves will coalesce a delete / insert - the insert is just not done, and here we remove the delete:
-          [deletionIndexes removeIndex:movedFrom];
-          // OR a move will have come from the LCS:
-          if ([commonIndexes containsIndex:movedFrom]) {
-            [commonIndexes removeIndex:movedFrom];
-            commonObjects = [self objectsAtIndexes:commonIndexes];
-          }
-        } else {
-          [insertionIndexes addIndex:j];
-        }
-      }
+  if (moves) {
+    NSMutableArray<NSIndexPath *> *moveIndexPaths = [NSMutableArray arrayWithCapacity:changes.moves.size()];
+    for (const auto &move : changes.moves) {
+      [moveIndexPaths addObject:[NSIndexPath indexPathForItem:(NSInteger)move.to inSection:(NSInteger)move.from]];
     }
+    *moves = moveIndexPaths;
   }
-
-  if (moves) {*moves = moveIndexPaths;}
-  if (deletions) {*deletions = deletionIndexes;}
-  if (insertions) {*insertions = insertionIndexes;}
+  if (deletions) {*deletions = ASIndexSetWithIndexes(changes.deletions);}
+  if (insertions) {*insertions = ASIndexSetWithIndexes(changes.insertions);}
 }
 
-// https://github.com/raywenderlich/swift-algorithm-club/tree/master/Longest%20Common%20Subsequence is not exactly this code (obviously), but
-// is a good commentary on the algorithm.
 - (NSMutableIndexSet *)_asdk_commonIndexesWithArray:(NSArray *)array compareBlock:(BOOL (^)(id lhs, id rhs))comparison
 {
   NSAssert(comparison != nil, @"Comparison block is required");
-
-  NSInteger selfCount = self.count;
-  NSInteger arrayCount = array.count;
-
-  // Allocate the diff map in the heap so we don't blow the stack for large arrays.
-  NSInteger **lengths = NULL;
-  lengths = (NSInteger **)malloc(sizeof(NSInteger*) * (selfCount+1));
-  if (lengths == NULL) {
-    ASDisplayNodeFailAssert(@"Failed to allocate memory for diffing");
-    return nil;
-  }
-  // Fill in a LCS length matrix:
-  for (NSInteger i = 0; i <= selfCount; i++) {
-    lengths[i] = (NSInteger *)malloc(sizeof(NSInteger) * (arrayCount+1));
-    if (lengths[i] == NULL) {
-      ASDisplayNodeFailAssert(@"Failed to allocate memory for diffing");
-      return nil;
-    }
-    id selfObj = i > 0 ? self[i-1] : nil;
-    for (NSInteger j = 0; j <= arrayCount; j++) {
-      if (i == 0 || j == 0) {
-        lengths[i][j] = 0;
-      } else if (comparison(selfObj, array[j-1])) {
-        lengths[i][j] = 1 + lengths[i-1][j-1];
-      } else {
-        lengths[i][j] = MAX(lengths[i-1][j], lengths[i][j-1]);
-      }
-    }
-  }
-  // Backtrack to fill in indices based on length matrix:
-  NSMutableIndexSet *common = [NSMutableIndexSet indexSet];
-  NSInteger i = selfCount, j = arrayCount;
-  while(i > 0 && j > 0) {
-    if (comparison(self[i-1], array[j-1])) {
-      [common addIndex:(i-1)];
-      i--; j--;
-    } else if (lengths[i-1][j] > lengths[i][j-1]) {
-      i--;
-    } else {
-      j--;
-    }
-  }
-
-  for (NSInteger i = 0; i <= selfCount; i++) {
-    free(lengths[i]);
-  }
-  free(lengths);
-  return common;
+  return ASIndexSetWithIndexes(AS::Diffing::commonIndexes(self.count, array.count, ASBlockComparator(self, array, comparison)));
 }
 
 static compareBlock defaultCompare = nil;
@@ -19,6 +19,7 @@ NS_ASSUME_NONNULL_BEGIN
 typedef void(^asyncdisplaykit_async_transaction_completion_block_t)(_ASAsyncTransaction *completedTransaction, BOOL canceled);
 typedef id<NSObject> _Nullable(^asyncdisplaykit_async_transaction_operation_block_t)(void);
 typedef void(^asyncdisplaykit_async_transaction_operation_completion_block_t)(id _Nullable value, BOOL canceled);
+typedef BOOL(^asyncdisplaykit_async_transaction_operation_is_stale_block_t)(void);
 
 /**
  State is initially ASAsyncTransactionStateOpen.
@@ -34,6 +35,32 @@ typedef NS_ENUM(NSUInteger, ASAsyncTransactionState) {
 
 AS_EXTERN NSInteger const ASDefaultTransactionPriority;
 
+/**
+ Instrumentation of the scheduler that runs transaction operations while ASExperimentalTransactionScheduler is enabled,
+ summed over all queues.
+ */
+typedef struct {
+  /// Operations that were scheduled but have not started yet.
+  NSUInteger queueDepth;
+  /// The highest queue depth on any one queue since the last reset.
+  NSUInteger maxQueueDepth;
+  /// Operations started since the last reset.
+  NSUInteger executedOperations;
+  /// Operations whose time between scheduling and starting was measured. Only a fraction of operations is sampled.
+  NSUInteger sampledOperations;
+  /// The time the sampled operations spent waiting, summed.
+  NSTimeInterval totalWaitTime;
+  /// The longest time a sampled operation spent waiting.
+  NSTimeInterval maxWaitTime;
+  /// Operations whose execution block was skipped because they were stale by the time they would have started.
+  NSUInteger droppedOperations;
+  /// Operations with a deadline that only started after it had passed.
+  NSUInteger missedDeadlines;
+} ASAsyncTransactionSchedulerStatistics;
+
+AS_EXTERN ASAsyncTransactionSchedulerStatistics ASAsyncTransactionSchedulerGetStatistics(void);
+AS_EXTERN void ASAsyncTransactionSchedulerResetStatistics(void);
+
 /**
  @summary ASAsyncTransaction provides lightweight transaction semantics for asynchronous operations.
 
@@ -93,6 +120,30 @@ AS_EXTERN NSInteger const ASDefaultTransactionPriority;
                         queue:(dispatch_queue_t)queue
                    completion:(nullable asyncdisplaykit_async_transaction_operation_completion_block_t)completion;
 
+/**
+ @summary Adds an operation that is needed by a certain time and may become obsolete before it starts.
+
+ @desc While ASExperimentalTransactionScheduler is enabled, operations of the same priority that are due within a
+ couple of frames run before the others, and operations that are stale by the time they would start are dropped: their
+ execution block is skipped and their completion block receives nil. Otherwise, this is the same as
+ -addOperationWithBlock:priority:queue:completion:.
+
+ @param block The execution block that will be executed on a background queue.  This is where the expensive work goes.
+ @param priority Execution priority; Tasks with higher priority will be executed sooner
+ @param deadline The CACurrentMediaTime() by which the result is needed, or 0 if there is none.
+ @param isStaleBlock Called on a background queue right before the execution block would start. Return YES if its
+ result is no longer needed.
+ @param queue The dispatch queue on which to execute the block.
+ @param completion The completion block that will be executed with the output of the execution block when all of the
+ operations in the transaction are completed. Executed and released on callbackQueue.
+ */
+- (void)addOperationWithBlock:(asyncdisplaykit_async_transaction_operation_block_t)block
+                     priority:(NSInteger)priority
+                     deadline:(CFTimeInterval)deadline
+                 isStaleBlock:(nullable asyncdisplaykit_async_transaction_operation_is_stale_block_t)isStaleBlock
+                        queue:(dispatch_queue_t)queue
+                   completion:(nullable asyncdisplaykit_async_transaction_operation_completion_block_t)completion;
+
 /**
  @summary Cancels all operations in the transaction.
 
@@ -11,9 +11,15 @@
 #import <AsyncDisplayKit/_ASAsyncTransaction.h>
 #import <AsyncDisplayKit/_ASAsyncTransactionGroup.h>
 #import <AsyncDisplayKit/ASAssert.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+#import <AsyncDisplayKit/ASInternalHelpers.h>
 #import <AsyncDisplayKit/ASThread.h>
+#import <AsyncDisplayKit/ASTransactionScheduler.h>
+#import <QuartzCore/QuartzCore.h>
+#import <atomic>
 #import <list>
 #import <map>
+#import <memory>
 
 #ifndef __STRICT_ANSI__
   #warning "Texture must be compiled with std=c++11 to prevent layout issues. gnu++ is not supported. This is hopefully temporary."
@@ -75,6 +81,15 @@ public:
     
     // schedule block on given queue
     virtual void schedule(NSInteger priority, dispatch_queue_t queue, dispatch_block_t block) = 0;
+
+    // schedule block on given queue, to be done by deadline (a CACurrentMediaTime(), or 0) and to be skipped if isStale
+    // returns YES right before it would start. Both are hints that implementations may ignore.
+    virtual void scheduleWithDeadline(NSInteger priority, CFTimeInterval deadline,
+                                      asyncdisplaykit_async_transaction_operation_is_stale_block_t isStale,
+                                      dispatch_queue_t queue, dispatch_block_t block)
+    {
+      schedule(priority, queue, block);
+    }
     
     // dispatch block on given queue when all previously scheduled blocks finished executing
     virtual void notify(dispatch_queue_t queue, dispatch_block_t block) = 0;
@@ -315,6 +330,300 @@ ASAsyncTransactionQueue & ASAsyncTransactionQueue::instance()
   return *instance;
 }
 
+#pragma mark - Scheduler
+
+// Maps the queues that operations target to the scheduler running operations on them. Transactions only ever target a
+// handful of queues, so this is a short array that is looked up without locking and only grows.
+class ASAsyncTransactionSchedulers
+{
+public:
+  static ASAsyncTransactionSchedulers &instance();
+
+  // Returns NULL if there are too many queues.
+  AS::TransactionScheduler *schedulerForQueue(dispatch_queue_t queue);
+
+  ASAsyncTransactionSchedulerStatistics statistics();
+  void resetStatistics();
+
+private:
+  static const unsigned kMaxQueues = 16;
+
+  struct Entry
+  {
+    void *_queue;
+    AS::TransactionScheduler *_scheduler;
+  };
+
+  static void spawn(AS::TransactionScheduler &scheduler, unsigned worker, void *context);
+
+  Entry _entries[kMaxQueues];
+  std::atomic<unsigned> _count;
+  std::mutex _mutex;
+};
+
+ASAsyncTransactionSchedulers &ASAsyncTransactionSchedulers::instance()
+{
+  static ASAsyncTransactionSchedulers *instance = new ASAsyncTransactionSchedulers();
+  return *instance;
+}
+
+void ASAsyncTransactionSchedulers::spawn(AS::TransactionScheduler &scheduler, unsigned worker, void *context)
+{
+  AS::TransactionScheduler *s = &scheduler;
+  dispatch_async((__bridge dispatch_queue_t)context, ^{
+    s->drain(worker);
+  });
+}
+
+AS::TransactionScheduler *ASAsyncTransactionSchedulers::schedulerForQueue(dispatch_queue_t queue)
+{
+  void *key = (__bridge void *)queue;
+  unsigned count = _count.load(std::memory_order_acquire);
+  for (unsigned i = 0; i < count; i++) {
+    if (_entries[i]._queue == key) {
+      return _entries[i]._scheduler;
+    }
+  }
+
+  std::lock_guard<std::mutex> l(_mutex);
+  count = _count.load(std::memory_order_relaxed);
+  for (unsigned i = 0; i < count; i++) {
+    if (_entries[i]._queue == key) {
+      return _entries[i]._scheduler;
+    }
+  }
+  if (count == kMaxQueues) {
+    return NULL;
+  }
+  // Both the queue and the scheduler live as long as the process, so workers never outlive either.
+  _entries[count]._queue = (__bridge_retained void *)queue;
+  _entries[count]._scheduler = new AS::TransactionScheduler(&ASAsyncTransactionSchedulers::spawn, _entries[count]._queue);
+  // Deadlines are a number of frames away, so what counts as due soon depends on the refresh rate.
+  _entries[count]._scheduler->setFrameDuration((uint64_t)(ASDisplayFrameDuration() * NSEC_PER_SEC));
+  _count.store(count + 1, std::memory_order_release);
+  return _entries[count]._scheduler;
+}
+
+ASAsyncTransactionSchedulerStatistics ASAsyncTransactionSchedulers::statistics()
+{
+  ASAsyncTransactionSchedulerStatistics result = {};
+  const unsigned count = _count.load(std::memory_order_acquire);
+  for (unsigned i = 0; i < count; i++) {
+    const AS::TransactionScheduler::Statistics statistics = _entries[i]._scheduler->statistics();
+    result.queueDepth += statistics.depth;
+    result.maxQueueDepth = MAX(result.maxQueueDepth, statistics.maxDepth);
+    result.executedOperations += statistics.executed;
+    result.sampledOperations += statistics.waitSamples;
+    result.totalWaitTime += statistics.totalWaitNanoseconds / (NSTimeInterval)NSEC_PER_SEC;
+    result.maxWaitTime = MAX(result.maxWaitTime, statistics.maxWaitNanoseconds / (NSTimeInterval)NSEC_PER_SEC);
+    result.droppedOperations += statistics.dropped;
+    result.missedDeadlines += statistics.missedDeadlines;
+  }
+  return result;
+}
+
+void ASAsyncTransactionSchedulers::resetStatistics()
+{
+  const unsigned count = _count.load(std::memory_order_acquire);
+  for (unsigned i = 0; i < count; i++) {
+    _entries[i]._scheduler->resetStatistics();
+  }
+}
+
+ASAsyncTransactionSchedulerStatistics ASAsyncTransactionSchedulerGetStatistics(void)
+{
+  return ASAsyncTransactionSchedulers::instance().statistics();
+}
+
+void ASAsyncTransactionSchedulerResetStatistics(void)
+{
+  ASAsyncTransactionSchedulers::instance().resetStatistics();
+}
+
+
+static unsigned ASAsyncTransactionSchedulerWorkerLimit()
+{
+#if ASDISPLAYNODE_DELAY_DISPLAY
+  return 1;
+#else
+  // Workers never block on each other, so one per core keeps every core busy without oversubscribing.
+  NSUInteger workerLimit = [NSProcessInfo processInfo].activeProcessorCount;
+
+  // Leave the main thread a core of its own while tracking.
+  if (workerLimit > 1 && [[NSRunLoop mainRunLoop].currentMode isEqualToString:UITrackingRunLoopMode]) {
+    --workerLimit;
+  }
+  return (unsigned)workerLimit;
+#endif
+}
+
+// Group whose operations run on AS::TransactionScheduler. Operations are queued without taking any lock shared between
+// transactions; only the group's own bookkeeping is guarded, by a mutex of its own.
+class ASAsyncTransactionSchedulerGroup : public ASAsyncTransactionQueue::Group
+{
+public:
+  ASAsyncTransactionSchedulerGroup()
+    : _pendingOperations(0)
+    , _releaseCalled(false)
+  {
+  }
+
+  virtual void release();
+  virtual void schedule(NSInteger priority, dispatch_queue_t queue, dispatch_block_t block);
+  virtual void scheduleWithDeadline(NSInteger priority, CFTimeInterval deadline,
+                                    asyncdisplaykit_async_transaction_operation_is_stale_block_t isStaleBlock,
+                                    dispatch_queue_t queue, dispatch_block_t block);
+  virtual void notify(dispatch_queue_t queue, dispatch_block_t block);
+  virtual void enter();
+  virtual void leave();
+  virtual void wait();
+
+private:
+  // The context of a scheduler task, owned by the task until it ran or was dropped.
+  struct Operation
+  {
+    dispatch_block_t _block;
+    asyncdisplaykit_async_transaction_operation_is_stale_block_t _isStale;
+    ASAsyncTransactionSchedulerGroup *_group;
+  };
+
+  static void invoke(void *context);
+  static void drop(void *context);
+  static bool isStale(void *context);
+
+  struct Notify
+  {
+    dispatch_block_t _block;
+    dispatch_queue_t _queue;
+  };
+
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  int _pendingOperations;
+  std::list<Notify> _notifyList;
+  BOOL _releaseCalled;
+};
+
+void ASAsyncTransactionSchedulerGroup::release()
+{
+  BOOL shouldDelete;
+  {
+    std::lock_guard<std::mutex> l(_mutex);
+    shouldDelete = (_pendingOperations == 0);
+    _releaseCalled = YES;
+  }
+  if (shouldDelete) {
+    delete this;
+  }
+}
+
+void ASAsyncTransactionSchedulerGroup::invoke(void *context)
+{
+  std::unique_ptr<Operation> operation(static_cast<Operation *>(context));
+  if (operation->_block) {
+    operation->_block();
+  }
+  // Leave before the block is released, as the queue-based group does.
+  operation->_group->leave();
+}
+
+void ASAsyncTransactionSchedulerGroup::drop(void *context)
+{
+  std::unique_ptr<Operation> operation(static_cast<Operation *>(context));
+  operation->_group->leave();
+}
+
+bool ASAsyncTransactionSchedulerGroup::isStale(void *context)
+{
+  return static_cast<Operation *>(context)->_isStale();
+}
+
+void ASAsyncTransactionSchedulerGroup::schedule(NSInteger priority, dispatch_queue_t queue, dispatch_block_t block)
+{
+  scheduleWithDeadline(priority, 0, nil, queue, block);
+}
+
+void ASAsyncTransactionSchedulerGroup::scheduleWithDeadline(NSInteger priority, CFTimeInterval deadline,
+                                                            asyncdisplaykit_async_transaction_operation_is_stale_block_t isStaleBlock,
+                                                            dispatch_queue_t queue, dispatch_block_t block)
+{
+  enter();
+
+  AS::TransactionScheduler *scheduler = ASAsyncTransactionSchedulers::instance().schedulerForQueue(queue);
+  if (scheduler == NULL) {
+    dispatch_async(queue, ^{
+      if (block && !(isStaleBlock && isStaleBlock())) {
+        block();
+      }
+      leave();
+    });
+    return;
+  }
+
+  AS::TransactionScheduler::Task task = {};
+  task.invoke = &ASAsyncTransactionSchedulerGroup::invoke;
+  task.context = new Operation{block, isStaleBlock, this};
+  if (isStaleBlock) {
+    task.drop = &ASAsyncTransactionSchedulerGroup::drop;
+    task.isStale = &ASAsyncTransactionSchedulerGroup::isStale;
+  }
+  if (deadline > 0) {
+    // The scheduler's clock is not the media clock, so carry over the time left rather than the point in time.
+    const CFTimeInterval remaining = MAX(0, deadline - CACurrentMediaTime());
+    task.deadline = AS::TransactionScheduler::now() + (uint64_t)(remaining * NSEC_PER_SEC);
+  }
+  scheduler->schedule(priority, task, ASAsyncTransactionSchedulerWorkerLimit());
+}
+
+void ASAsyncTransactionSchedulerGroup::notify(dispatch_queue_t queue, dispatch_block_t block)
+{
+  std::lock_guard<std::mutex> l(_mutex);
+
+  if (_pendingOperations == 0) {
+    dispatch_async(queue, block);
+  } else {
+    _notifyList.push_back({block, queue});
+  }
+}
+
+void ASAsyncTransactionSchedulerGroup::enter()
+{
+  std::lock_guard<std::mutex> l(_mutex);
+  ++_pendingOperations;
+}
+
+void ASAsyncTransactionSchedulerGroup::leave()
+{
+  std::list<Notify> notifyList;
+  BOOL shouldDelete;
+  {
+    std::lock_guard<std::mutex> l(_mutex);
+    if (--_pendingOperations > 0) {
+      return;
+    }
+    _notifyList.swap(notifyList);
+    _condition.notify_all();
+    shouldDelete = _releaseCalled;
+  }
+
+  for (Notify &notify : notifyList) {
+    dispatch_async(notify._queue, notify._block);
+  }
+
+  // The group may only be deleted once the mutex it owns is unlocked.
+  if (shouldDelete) {
+    delete this;
+  }
+}
+
+void ASAsyncTransactionSchedulerGroup::wait()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (_pendingOperations > 0) {
+    _condition.wait(lock);
+  }
+}
+
 @interface _ASAsyncTransaction ()
 @property ASAsyncTransactionState state;
 @end
@@ -352,6 +661,16 @@ ASAsyncTransactionQueue & ASAsyncTransactionQueue::instance()
                      priority:(NSInteger)priority
                         queue:(dispatch_queue_t)queue
                    completion:(asyncdisplaykit_async_transaction_operation_completion_block_t)completion
+{
+  [self addOperationWithBlock:block priority:priority deadline:0 isStaleBlock:nil queue:queue completion:completion];
+}
+
+- (void)addOperationWithBlock:(asyncdisplaykit_async_transaction_operation_block_t)block
+                     priority:(NSInteger)priority
+                     deadline:(CFTimeInterval)deadline
+                 isStaleBlock:(asyncdisplaykit_async_transaction_operation_is_stale_block_t)isStaleBlock
+                        queue:(dispatch_queue_t)queue
+                   completion:(asyncdisplaykit_async_transaction_operation_completion_block_t)completion
 {
   ASDisplayNodeAssertMainThread();
   NSAssert(self.state == ASAsyncTransactionStateOpen, @"You can only add operations to open transactions");
@@ -360,7 +679,7 @@ ASAsyncTransactionQueue & ASAsyncTransactionQueue::instance()
 
   ASAsyncTransactionOperation *operation = [[ASAsyncTransactionOperation alloc] initWithOperationCompletionBlock:completion];
   [_operations addObject:operation];
-  _group->schedule(priority, queue, ^{
+  _group->scheduleWithDeadline(priority, deadline, isStaleBlock, queue, ^{
     @autoreleasepool {
       if (self.state != ASAsyncTransactionStateCanceled) {
         operation.value = block();
@@ -446,7 +765,11 @@ ASAsyncTransactionQueue & ASAsyncTransactionQueue::instance()
 {
   // Lazily initialize _group and _operations to avoid overhead in the case where no operations are added to the transaction
   if (_group == NULL) {
-    _group = ASAsyncTransactionQueue::instance().createGroup();
+    if (ASActivateExperimentalFeature(ASExperimentalTransactionScheduler)) {
+      _group = new ASAsyncTransactionSchedulerGroup();
+    } else {
+      _group = ASAsyncTransactionQueue::instance().createGroup();
+    }
   }
   if (_operations == nil) {
     _operations = [[NSMutableArray alloc] init];
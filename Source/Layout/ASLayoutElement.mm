@@ -144,6 +144,7 @@ NSString * const ASYogaAspectRatioProperty = @"ASYogaAspectRatioProperty";
     BOOL changed = !ASLayoutElementSizeEqualToLayoutElementSize(oldSize, newSize); \
     if (changed) {                                                                 \
       _size.store(newSize);                                                        \
+      _generation.fetch_add(1);                                                    \
     }                                                                              \
     __instanceLock__.unlock();                                                     \
     changed;                                                                       \
@@ -151,6 +152,7 @@ NSString * const ASYogaAspectRatioProperty = @"ASYogaAspectRatioProperty";
 
 #define ASLayoutElementStyleCallDelegate(propertyName)\
 do {\
+  _generation.fetch_add(1);\
   [self propertyDidChange:propertyName];\
   [_delegate style:self propertyDidChange:propertyName];\
 } while(0)
@@ -169,6 +171,7 @@ do {\
   std::atomic<CGFloat> _ascender;
   std::atomic<CGFloat> _descender;
   std::atomic<CGPoint> _layoutPosition;
+  std::atomic<NSUInteger> _generation;
 
 #if YOGA
   YGNodeRef _yogaNode;
@@ -219,6 +222,11 @@ do {\
 
 ASSynthesizeLockingMethodsWithMutex(__instanceLock__)
 
+- (NSUInteger)generation
+{
+  return _generation.load();
+}
+
 #pragma mark - ASLayoutElementStyleSize
 
 - (ASLayoutElementSize)size
@@ -543,6 +551,7 @@ ASSynthesizeLockingMethodsWithMutex(__instanceLock__)
   
   MutexLocker l(__instanceLock__);
   _extensions.boolExtensions[idx] = value;
+  _generation.fetch_add(1);
 }
 
 - (BOOL)layoutOptionExtensionBoolAtIndex:(int)idx\
@@ -559,6 +568,7 @@ ASSynthesizeLockingMethodsWithMutex(__instanceLock__)
   
   MutexLocker l(__instanceLock__);
   _extensions.integerExtensions[idx] = value;
+  _generation.fetch_add(1);
 }
 
 - (NSInteger)layoutOptionExtensionIntegerAtIndex:(int)idx
@@ -575,6 +585,7 @@ ASSynthesizeLockingMethodsWithMutex(__instanceLock__)
   
   MutexLocker l(__instanceLock__);
   _extensions.edgeInsetsExtensions[idx] = value;
+  _generation.fetch_add(1);
 }
 
 - (UIEdgeInsets)layoutOptionExtensionEdgeInsetsAtIndex:(int)idx
@@ -150,10 +150,10 @@
     self.style.descender = stackChildren.back().style.descender;
   }
 
-  ASLayout *rawSublayouts[positionedLayout.items.size()];
+  ASLayout *rawSublayouts[positionedLayout.sublayouts.size()];
   int i = 0;
-  for (const auto &item : positionedLayout.items) {
-    rawSublayouts[i++] = item.layout;
+  for (ASLayout *sublayout : positionedLayout.sublayouts) {
+    rawSublayouts[i++] = sublayout;
   }
 
   const auto sublayouts = [NSArray<ASLayout *> arrayByTransferring:rawSublayouts count:i];
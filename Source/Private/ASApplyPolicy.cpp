@@ -0,0 +1,94 @@
+//
+//  ASApplyPolicy.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#include "ASApplyPolicy.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace AS {
+
+double ApplyPolicy::Report::utilization() const
+{
+  if (wallNanoseconds == 0 || threads == 0) {
+    return 1;
+  }
+  return std::min(1.0, (double)busyNanoseconds / ((double)wallNanoseconds * threads));
+}
+
+ApplyPolicy::ApplyPolicy() : _iterationCost(kDefaultIterationCost) {}
+
+ApplyPolicy::Plan ApplyPolicy::plan(size_t iterations, unsigned maxThreads) const
+{
+  if (iterations == 0) {
+    return {1, 1};
+  }
+  const uint64_t cost = std::max<uint64_t>(1, iterationCost());
+  const uint64_t work = cost * iterations;
+
+  // The calling thread is free; every other thread has to earn its wake-up.
+  const uint64_t affordable = 1 + work / kMinWorkPerThread;
+  unsigned threads = (unsigned)std::min<uint64_t>(std::max(1u, maxThreads), affordable);
+  threads = (unsigned)std::min<size_t>(threads, iterations);
+
+  size_t chunkSize = (size_t)std::max<uint64_t>(1, kTargetChunkDuration / cost);
+  if (threads > 1) {
+    chunkSize = std::min(chunkSize, std::max<size_t>(1, iterations / (threads * kChunksPerThread)));
+  } else {
+    chunkSize = iterations;
+  }
+  return {threads, chunkSize};
+}
+
+void ApplyPolicy::record(const Report &report)
+{
+  if (report.iterations == 0) {
+    return;
+  }
+  const uint64_t sample = std::max<uint64_t>(1, report.busyNanoseconds / report.iterations);
+  // A quarter of the weight on the newest batch: adapts within a few batches but shrugs off a single outlier.
+  uint64_t cost = _iterationCost.load(std::memory_order_relaxed);
+  uint64_t updated;
+  do {
+    updated = cost - cost / 4 + sample / 4;
+  } while (!_iterationCost.compare_exchange_weak(cost, updated, std::memory_order_relaxed));
+}
+
+ApplyBatch::ApplyBatch(size_t iterations, const ApplyPolicy::Plan &plan)
+: _iterations(iterations), _plan(plan), _start(now()), _next(0), _busy(0) {}
+
+uint64_t ApplyBatch::now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ApplyBatch::run(void (*work)(void *context, size_t index), void *context)
+{
+  const size_t chunkSize = _plan.chunkSize;
+  uint64_t busy = 0;
+  while (true) {
+    const size_t begin = _next.fetch_add(chunkSize, std::memory_order_relaxed);
+    if (begin >= _iterations) {
+      break;
+    }
+    const size_t end = std::min(_iterations, begin + chunkSize);
+    const uint64_t chunkStart = now();
+    for (size_t i = begin; i < end; i++) {
+      work(context, i);
+    }
+    busy += now() - chunkStart;
+  }
+  _busy.fetch_add(busy, std::memory_order_relaxed);
+}
+
+ApplyPolicy::Report ApplyBatch::finish() const
+{
+  return {_iterations, _plan.threads, _plan.chunkSize, now() - _start, _busy.load(std::memory_order_relaxed)};
+}
+
+} // namespace AS
@@ -0,0 +1,97 @@
+//
+//  ASApplyPolicy.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+// Plain C++11 so that the policy behind ASDispatchApply can be built, tested and benchmarked on any host.
+// See Benchmarks/ApplyPolicy.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace AS {
+
+/**
+ * Decides how many threads a parallel-for uses and how many iterations they claim at a time, based on how long
+ * iterations took in earlier batches of the same call site.
+ *
+ * Waking a thread costs tens of microseconds, so a batch only gets as many threads as it has work to amortize that
+ * over; small batches run on the calling thread alone. Iterations are claimed in chunks sized so that claiming stays
+ * cheap relative to the work while every thread still gets several chunks to balance load.
+ */
+class ApplyPolicy {
+public:
+  struct Plan {
+    /** Including the calling thread. */
+    unsigned threads;
+    size_t chunkSize;
+  };
+
+  /** What happened in one batch. */
+  struct Report {
+    size_t iterations;
+    unsigned threads;
+    size_t chunkSize;
+    uint64_t wallNanoseconds;
+    /** Time spent in iterations, summed over all threads. */
+    uint64_t busyNanoseconds;
+
+    /** The fraction of the threads' time spent in iterations, from 0 to 1. */
+    double utilization() const;
+  };
+
+  /** Assumed until the first batch was measured: expensive enough that a batch of a few items is spread out. */
+  static const uint64_t kDefaultIterationCost = 100 * 1000;
+  /** Work an additional thread must be given to be worth waking. */
+  static const uint64_t kMinWorkPerThread = 50 * 1000;
+  /** Chunks shorter than this are enlarged, so that the cost of claiming them stays negligible. */
+  static const uint64_t kTargetChunkDuration = 20 * 1000;
+  /** Chunks are kept small enough for every thread to get at least this many, for load balance. */
+  static const unsigned kChunksPerThread = 4;
+
+  ApplyPolicy();
+
+  /** maxThreads is the number of threads the device can currently afford, including the calling thread. */
+  Plan plan(size_t iterations, unsigned maxThreads) const;
+
+  /** Learns the per-iteration cost from a finished batch. */
+  void record(const Report &report);
+
+  /** Exponentially weighted average of recent batches, in nanoseconds. */
+  uint64_t iterationCost() const { return _iterationCost.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint64_t> _iterationCost;
+};
+
+/**
+ * Hands out the iterations of one batch in chunks and measures the time spent in them. Any number of threads may call
+ * run() concurrently; every iteration is executed exactly once.
+ */
+class ApplyBatch {
+public:
+  ApplyBatch(size_t iterations, const ApplyPolicy::Plan &plan);
+
+  /** Claims and executes chunks until none are left. work is called as work(context, index). */
+  void run(void (*work)(void *context, size_t index), void *context);
+
+  /** Call once every thread returned from run(). */
+  ApplyPolicy::Report finish() const;
+
+  static uint64_t now();
+
+private:
+  const size_t _iterations;
+  const ApplyPolicy::Plan _plan;
+  const uint64_t _start;
+  std::atomic<size_t> _next;
+  std::atomic<uint64_t> _busy;
+};
+
+} // namespace AS
@@ -0,0 +1,96 @@
+//
+//  ASAttributedStringLRUCache.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+#import <UIKit/UIKit.h>
+
+#import <atomic>
+
+#import <AsyncDisplayKit/ASLRUCache.h>
+
+namespace AS {
+
+struct AttributedStringHash {
+  size_t operator()(NSAttributedString *text) const
+  {
+    return text.hash;
+  }
+};
+
+struct AttributedStringEqual {
+  bool operator()(NSAttributedString *lhs, NSAttributedString *rhs) const
+  {
+    return lhs == rhs || [lhs isEqualToAttributedString:rhs];
+  }
+};
+
+/**
+ * The cache behind the text caches of ASTextNode2: entries per attributed string, by equality, that are emptied on
+ * memory warnings. Meant to live as long as the process.
+ *
+ * The cache's own hits and misses count lookups of entries. Users that look for something within an entry, e.g. one of
+ * a string's layouts, count whether they found it with recordHit() and recordMiss() instead, and statistics() reports
+ * those.
+ */
+template <typename Entry>
+class AttributedStringLRUCache : public LRUCache<NSAttributedString *, Entry, AttributedStringHash, AttributedStringEqual> {
+  typedef LRUCache<NSAttributedString *, Entry, AttributedStringHash, AttributedStringEqual> Base;
+
+public:
+  explicit AttributedStringLRUCache(size_t costLimit) : Base(costLimit), _hits(0), _misses(0)
+  {
+    // NSCache used to give the memory back on its own.
+    [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationDidReceiveMemoryWarningNotification object:nil queue:nil usingBlock:^(NSNotification *note) {
+      this->clear();
+    }];
+  }
+
+  /** The entry for text, which is inserted with cost and made by make if there is none. */
+  template <typename Make>
+  Entry entryForText(NSAttributedString *text, size_t cost, const Make &make)
+  {
+    Entry entry;
+    if (!this->find(text, entry)) {
+      // Only copy the string, which may be mutable, if it is going to be stored.
+      entry = this->findOrInsert([text copy], cost, make);
+    }
+    return entry;
+  }
+
+  void recordHit()
+  {
+    _hits.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void recordMiss()
+  {
+    _misses.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  typename Base::Statistics statistics() const
+  {
+    typename Base::Statistics statistics = Base::statistics();
+    statistics.hits = _hits.load(std::memory_order_relaxed);
+    statistics.misses = _misses.load(std::memory_order_relaxed);
+    return statistics;
+  }
+
+  void resetStatistics()
+  {
+    _hits.store(0, std::memory_order_relaxed);
+    _misses.store(0, std::memory_order_relaxed);
+    Base::resetStatistics();
+  }
+
+private:
+  std::atomic<size_t> _hits;
+  std::atomic<size_t> _misses;
+};
+
+} // namespace AS
@@ -7,6 +7,8 @@
 //  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
 //
 
+#import <AsyncDisplayKit/ASBasicImageDownloader.h>
+
 @interface ASBasicImageDownloaderContext : NSObject
 
 + (ASBasicImageDownloaderContext *)contextForURL:(NSURL *)URL;
@@ -14,7 +16,23 @@
 @property (nonatomic, readonly) NSURL *URL;
 @property (nonatomic, weak) NSURLSessionTask *sessionTask;
 
+/**
+ * The highest priority the context was requested at. Only read and written by ASBasicImageDownloader's scheduler,
+ * under its lock.
+ */
+@property (nonatomic) ASImageDownloaderPriority priority;
+
 - (BOOL)isCancelled;
 - (void)cancel;
 
+/** Whether callers added since the last completion are still waiting for the image. */
+- (BOOL)hasCallbackDatas;
+
+@end
+
+@interface ASBasicImageDownloader (Internal)
+
+/** Returns a downloader with its own session, e.g. one that routes requests through a test NSURLProtocol. */
+- (instancetype)_initWithSessionConfiguration:(NSURLSessionConfiguration *)configuration;
+
 @end
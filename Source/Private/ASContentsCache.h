@@ -0,0 +1,66 @@
+//
+//  ASContentsCache.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <Foundation/Foundation.h>
+#import <AsyncDisplayKit/ASBaseDefines.h>
+#import <AsyncDisplayKit/ASBlockTypes.h>
+#import <AsyncDisplayKit/ASWeakMap.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * A weak map, with the same retain-the-entry convention as ASWeakMap, for values that are expensive to create such as
+ * rendered contents.
+ *
+ * Entries are kept for as long as callers retain them, and optionally a recently used few beyond that (see
+ * retainedCostLimit). Keys are spread over independently locked shards, so that lookups of different keys rarely wait
+ * on each other, and a lock is only held to look up or store an entry, never while a value is created. Values are
+ * created once per key: callers asking for a key whose value is being created wait for that value instead of creating
+ * it again.
+ *
+ * The Key type should implement `hash` and `isEqual:`.
+ */
+AS_SUBCLASSING_RESTRICTED
+@interface ASContentsCache<__covariant Key, Value> : NSObject
+
+/**
+ * shardCount is rounded up to a power of two. costOfValue estimates what a value costs to retain, in the unit of
+ * retainedCostLimit; without it every value costs 1.
+ */
+- (instancetype)initWithShardCount:(NSUInteger)shardCount costOfValue:(nullable NSUInteger (^)(Value value))costOfValue NS_DESIGNATED_INITIALIZER;
+
+/** Eight shards, every value costing 1. */
+- (instancetype)init;
+
+/**
+ * The cache also retains the most recently used entries up to this total cost, so that their values outlive the
+ * callers that retained them and are found again later. Entries beyond it are released in least-recently-used order.
+ * Defaults to 0, which leaves entries to their callers alone.
+ */
+@property NSUInteger retainedCostLimit;
+
+/** Releases the entries the cache retains. Entries retained by callers stay. */
+- (void)removeAllRetainedEntries;
+
+/**
+ * Read from the cache, without waiting for a value that is being created.
+ */
+- (nullable ASWeakMapEntry<Value> *)entryForKey:(Key)key AS_WARN_UNUSED_RESULT;
+
+/**
+ * Read from the cache, creating the value with the block if there is none. If another caller is creating the value for
+ * an equal key, waits for it, or returns nil once isCancelled does. If the block returns nil, e.g. because the caller
+ * was cancelled, nothing is stored and nil is returned; a caller that was waiting then creates the value itself.
+ */
+- (nullable ASWeakMapEntry<Value> *)entryForKey:(Key)key
+                                    isCancelled:(nullable NS_NOESCAPE asdisplaynode_iscancelled_block_t)isCancelled
+                                    createValue:(NS_NOESCAPE Value _Nullable (^)(void))createValue AS_WARN_UNUSED_RESULT;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,206 @@
+//
+//  ASContentsCache.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASContentsCache.h>
+
+#import <atomic>
+#import <chrono>
+#import <condition_variable>
+#import <memory>
+
+#import <AsyncDisplayKit/ASLRUCache.h>
+#import <AsyncDisplayKit/ASThread.h>
+
+/** A value being created. Waiters keep it, so they get the value even if its creator drops the entry right away. */
+@interface ASContentsCacheRequest : NSObject {
+  @package
+  BOOL _finished;
+  ASWeakMapEntry *_entry;
+}
+@end
+
+@implementation ASContentsCacheRequest
+@end
+
+namespace {
+
+/** How often a waiter that can be cancelled checks whether it was. */
+const std::chrono::milliseconds kCancellationPollInterval(4);
+
+struct Shard {
+  AS::Mutex mutex;
+  std::condition_variable_any finished;
+  ASWeakMap *map = [[ASWeakMap alloc] init];
+  NSMapTable<id, ASContentsCacheRequest *> *requests = [NSMapTable strongToStrongObjectsMapTable];
+  // Keeps neighbouring shards' locks off this shard's cache lines.
+  char padding[64];
+};
+
+struct KeyHash {
+  size_t operator()(id key) const
+  {
+    return [key hash];
+  }
+};
+
+struct KeyEqual {
+  bool operator()(id lhs, id rhs) const
+  {
+    return lhs == rhs || [lhs isEqual:rhs];
+  }
+};
+
+typedef AS::LRUCache<id, ASWeakMapEntry *, KeyHash, KeyEqual> RetainedEntries;
+
+} // namespace
+
+@implementation ASContentsCache {
+  NSUInteger _shardCount;
+  std::unique_ptr<Shard[]> _shards;
+  NSUInteger (^_costOfValue)(id);
+  std::atomic<NSUInteger> _retainedCostLimit;
+  // The strong tier in front of the weak map: retaining an entry keeps it in its shard's map.
+  std::unique_ptr<RetainedEntries> _retainedEntries;
+}
+
+- (instancetype)init
+{
+  return [self initWithShardCount:8 costOfValue:nil];
+}
+
+- (instancetype)initWithShardCount:(NSUInteger)shardCount costOfValue:(NSUInteger (^)(id))costOfValue
+{
+  if (self = [super init]) {
+    _shardCount = 1;
+    while (_shardCount < shardCount) {
+      _shardCount <<= 1;
+    }
+    _shards.reset(new Shard[_shardCount]);
+    _costOfValue = [costOfValue copy];
+    _retainedCostLimit = 0;
+    // One shard: a shard only gets its share of the limit, and values such as bitmaps are large relative to it. Its
+    // lock is only held to reorder a list, and only taken when a limit is set.
+    _retainedEntries.reset(new RetainedEntries(0, 1));
+  }
+  return self;
+}
+
+- (NSUInteger)retainedCostLimit
+{
+  return _retainedCostLimit.load(std::memory_order_relaxed);
+}
+
+- (void)setRetainedCostLimit:(NSUInteger)retainedCostLimit
+{
+  _retainedCostLimit.store(retainedCostLimit, std::memory_order_relaxed);
+  _retainedEntries->setCostLimit(retainedCostLimit);
+}
+
+- (void)removeAllRetainedEntries
+{
+  _retainedEntries->clear();
+}
+
+/** Marks entry most recently used, retaining it if it is not yet. */
+- (void)retainEntry:(ASWeakMapEntry *)entry forKey:(id)key
+{
+  if (_retainedCostLimit.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  ASWeakMapEntry *retained;
+  if (_retainedEntries->find(key, retained) && retained == entry) {
+    return;
+  }
+  id value = entry.value;
+  _retainedEntries->insert(key, entry, _costOfValue ? _costOfValue(value) : 1);
+}
+
+- (Shard *)shardForKey:(id)key
+{
+  // Mix the high bits in: many hashes (e.g. of pointers) vary little in their low bits.
+  uint64_t hash = [key hash];
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return &_shards[hash & (_shardCount - 1)];
+}
+
+- (ASWeakMapEntry *)entryForKey:(id)key
+{
+  Shard &shard = *[self shardForKey:key];
+  AS::MutexLocker l(shard.mutex);
+  return [shard.map entryForKey:key];
+}
+
+- (ASWeakMapEntry *)entryForKey:(id)key
+                    isCancelled:(NS_NOESCAPE asdisplaynode_iscancelled_block_t)isCancelled
+                    createValue:(NS_NOESCAPE id (^)(void))createValue
+{
+  Shard &shard = *[self shardForKey:key];
+  ASContentsCacheRequest *request;
+  {
+    AS::UniqueLock l(shard.mutex);
+    while (true) {
+      ASWeakMapEntry *entry = [shard.map entryForKey:key];
+      if (entry != nil) {
+        l.unlock();
+        [self retainEntry:entry forKey:key];
+        return entry;
+      }
+      ASContentsCacheRequest *pending = [shard.requests objectForKey:key];
+      if (pending == nil) {
+        break;
+      }
+      const auto finished = [pending] { return pending->_finished; };
+      if (isCancelled == nil) {
+        shard.finished.wait(l, finished);
+      } else {
+        while (!shard.finished.wait_for(l, kCancellationPollInterval, finished)) {
+          // The condition only wakes us for a finished value, so look at our own cancellation between waits, outside
+          // the lock.
+          l.unlock();
+          const BOOL cancelled = isCancelled();
+          l.lock();
+          if (cancelled) {
+            return nil;
+          }
+        }
+      }
+      ASWeakMapEntry *created = pending->_entry;
+      if (created != nil) {
+        // Count the wait as a use of the entry, like finding it in the map.
+        l.unlock();
+        [self retainEntry:created forKey:key];
+        return created;
+      }
+      // Its creator gave up. Try again, which may make us the creator.
+    }
+    request = [[ASContentsCacheRequest alloc] init];
+    [shard.requests setObject:request forKey:key];
+  }
+
+  id value = createValue();
+
+  ASWeakMapEntry *entry = nil;
+  {
+    AS::MutexLocker l(shard.mutex);
+    if (value != nil) {
+      entry = [shard.map setObject:value forKey:key];
+    }
+    request->_entry = entry;
+    request->_finished = YES;
+    [shard.requests removeObjectForKey:key];
+  }
+  shard.finished.notify_all();
+  if (entry != nil) {
+    [self retainEntry:entry forKey:key];
+  }
+  return entry;
+}
+
+@end
@@ -0,0 +1,259 @@
+//
+//  ASDiffingCore.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#include "ASDiffingCore.h"
+
+namespace AS {
+namespace Diffing {
+
+namespace {
+
+/**
+ * Linear space Myers diff. See "An O(ND) Difference Algorithm and Its Variations", E. Myers, 1986, section 4b.
+ *
+ * The forward and the reverse search share two V arrays that are sized once for the whole input, so the recursion on
+ * the halves of a split never allocates.
+ */
+class Engine {
+public:
+  Engine(size_t oldCount, size_t newCount, const Comparator &comparator, std::vector<size_t> &common)
+  : _comparator(comparator),
+    _forward(oldCount + newCount + 4),
+    _reverse(oldCount + newCount + 4),
+    _common(common) {}
+
+  void diff(size_t oldBegin, size_t oldEnd, size_t newBegin, size_t newEnd)
+  {
+    // Matching the common prefix and suffix directly is what makes mostly similar sequences cheap.
+    while (oldBegin < oldEnd && newBegin < newEnd && _comparator.equal(oldBegin, newBegin)) {
+      _common.push_back(oldBegin);
+      oldBegin++;
+      newBegin++;
+    }
+    size_t suffixLength = 0;
+    while (oldBegin < oldEnd && newBegin < newEnd && _comparator.equal(oldEnd - 1, newEnd - 1)) {
+      oldEnd--;
+      newEnd--;
+      suffixLength++;
+    }
+
+    if (oldBegin < oldEnd && newBegin < newEnd) {
+      bisect(oldBegin, oldEnd, newBegin, newEnd);
+    }
+
+    for (size_t i = 0; i < suffixLength; i++) {
+      _common.push_back(oldEnd + i);
+    }
+  }
+
+private:
+  /**
+   * Finds the middle snake of the edit graph by searching forward from the top left and backward from the bottom
+   * right at the same time, then diffs both halves independently.
+   */
+  void bisect(size_t oldBegin, size_t oldEnd, size_t newBegin, size_t newEnd)
+  {
+    const ptrdiff_t oldCount = oldEnd - oldBegin;
+    const ptrdiff_t newCount = newEnd - newBegin;
+    const ptrdiff_t maxD = (oldCount + newCount + 1) / 2;
+    const ptrdiff_t offset = maxD;
+    const ptrdiff_t length = 2 * maxD + 2;
+    // Both V arrays store the furthest x reached on each diagonal k, at index offset + k.
+    ptrdiff_t *forward = _forward.data();
+    ptrdiff_t *reverse = _reverse.data();
+    for (ptrdiff_t i = 0; i < length; i++) {
+      forward[i] = -1;
+      reverse[i] = -1;
+    }
+    forward[offset + 1] = 0;
+    reverse[offset + 1] = 0;
+
+    const ptrdiff_t delta = oldCount - newCount;
+    // If the total number of elements is odd, the forward search will be the one to collide with the reverse search.
+    const bool front = (delta % 2 != 0);
+    // Diagonals that ran off the edit graph are excluded from further rounds.
+    ptrdiff_t forwardStart = 0, forwardEnd = 0, reverseStart = 0, reverseEnd = 0;
+
+    for (ptrdiff_t d = 0; d < maxD; d++) {
+      for (ptrdiff_t k = -d + forwardStart; k <= d - forwardEnd; k += 2) {
+        const ptrdiff_t kOffset = offset + k;
+        ptrdiff_t x;
+        if (k == -d || (k != d && forward[kOffset - 1] < forward[kOffset + 1])) {
+          x = forward[kOffset + 1];
+        } else {
+          x = forward[kOffset - 1] + 1;
+        }
+        ptrdiff_t y = x - k;
+        while (x < oldCount && y < newCount && _comparator.equal(oldBegin + x, newBegin + y)) {
+          x++;
+          y++;
+        }
+        forward[kOffset] = x;
+        if (x > oldCount) {
+          forwardEnd += 2;
+        } else if (y > newCount) {
+          forwardStart += 2;
+        } else if (front) {
+          const ptrdiff_t reverseOffset = offset + delta - k;
+          if (reverseOffset >= 0 && reverseOffset < length && reverse[reverseOffset] != -1) {
+            if (x >= oldCount - reverse[reverseOffset]) {
+              split(oldBegin, oldEnd, newBegin, newEnd, x, y);
+              return;
+            }
+          }
+        }
+      }
+
+      for (ptrdiff_t k = -d + reverseStart; k <= d - reverseEnd; k += 2) {
+        const ptrdiff_t kOffset = offset + k;
+        ptrdiff_t x;
+        if (k == -d || (k != d && reverse[kOffset - 1] < reverse[kOffset + 1])) {
+          x = reverse[kOffset + 1];
+        } else {
+          x = reverse[kOffset - 1] + 1;
+        }
+        ptrdiff_t y = x - k;
+        while (x < oldCount && y < newCount
+               && _comparator.equal(oldBegin + (oldCount - x - 1), newBegin + (newCount - y - 1))) {
+          x++;
+          y++;
+        }
+        reverse[kOffset] = x;
+        if (x > oldCount) {
+          reverseEnd += 2;
+        } else if (y > newCount) {
+          reverseStart += 2;
+        } else if (!front) {
+          const ptrdiff_t forwardOffset = offset + delta - k;
+          if (forwardOffset >= 0 && forwardOffset < length && forward[forwardOffset] != -1) {
+            const ptrdiff_t forwardX = forward[forwardOffset];
+            if (forwardX >= oldCount - x) {
+              split(oldBegin, oldEnd, newBegin, newEnd, forwardX, offset + forwardX - forwardOffset);
+              return;
+            }
+          }
+        }
+      }
+    }
+    // Only reachable if nothing is in common, in which case there is nothing to record.
+  }
+
+  void split(size_t oldBegin, size_t oldEnd, size_t newBegin, size_t newEnd, ptrdiff_t x, ptrdiff_t y)
+  {
+    diff(oldBegin, oldBegin + x, newBegin, newBegin + y);
+    diff(oldBegin + x, oldEnd, newBegin + y, newEnd);
+  }
+
+  const Comparator &_comparator;
+  std::vector<ptrdiff_t> _forward;
+  std::vector<ptrdiff_t> _reverse;
+  std::vector<size_t> &_common;
+};
+
+} // namespace
+
+std::vector<size_t> commonIndexes(size_t oldCount, size_t newCount, const Comparator &comparator)
+{
+  std::vector<size_t> common;
+  if (oldCount == 0 || newCount == 0) {
+    return common;
+  }
+  Engine(oldCount, newCount, comparator, common).diff(0, oldCount, 0, newCount);
+  return common;
+}
+
+Changes changes(size_t oldCount, size_t newCount, const Comparator &comparator)
+{
+  const std::vector<size_t> common = commonIndexes(oldCount, newCount, comparator);
+  Changes result;
+
+  size_t c = 0;
+  for (size_t i = 0; i < oldCount; i++) {
+    if (c < common.size() && common[c] == i) {
+      c++;
+    } else {
+      result.deletions.push_back(i);
+    }
+  }
+
+  // Every new element that does not continue the common subsequence is inserted.
+  c = 0;
+  for (size_t j = 0; j < newCount; j++) {
+    if (c < common.size() && comparator.equal(common[c], j)) {
+      c++;
+    } else {
+      result.insertions.push_back(j);
+    }
+  }
+  return result;
+}
+
+Changes changesWithMoves(const std::vector<size_t> &oldSymbols,
+                         const std::vector<size_t> &newSymbols,
+                         size_t symbolCount)
+{
+  const size_t oldCount = oldSymbols.size();
+  const size_t newCount = newSymbols.size();
+  Changes result;
+
+  // Elements that did not change their index stay in place.
+  std::vector<bool> oldMatched(oldCount, false);
+  std::vector<bool> newMatched(newCount, false);
+  for (size_t i = 0; i < oldCount && i < newCount; i++) {
+    if (oldSymbols[i] == newSymbols[i]) {
+      oldMatched[i] = true;
+      newMatched[i] = true;
+    }
+  }
+
+  // The symbol table: the old indexes of every symbol, ascending and grouped by symbol, plus a cursor per symbol to the
+  // next occurrence that may still be unused.
+  std::vector<size_t> cursors(symbolCount + 1, 0);
+  for (size_t symbol : oldSymbols) {
+    cursors[symbol + 1]++;
+  }
+  for (size_t s = 0; s < symbolCount; s++) {
+    cursors[s + 1] += cursors[s];
+  }
+  std::vector<size_t> ends(cursors.begin() + 1, cursors.end());
+  std::vector<size_t> occurrences(oldCount);
+  {
+    std::vector<size_t> fill(cursors.begin(), cursors.end() - 1);
+    for (size_t i = 0; i < oldCount; i++) {
+      occurrences[fill[oldSymbols[i]]++] = i;
+    }
+  }
+
+  for (size_t j = 0; j < newCount; j++) {
+    if (newMatched[j]) {
+      continue;
+    }
+    const size_t symbol = newSymbols[j];
+    size_t &cursor = cursors[symbol];
+    while (cursor < ends[symbol] && oldMatched[occurrences[cursor]]) {
+      cursor++;
+    }
+    if (cursor < ends[symbol]) {
+      const size_t from = occurrences[cursor++];
+      oldMatched[from] = true;
+      result.moves.push_back({from, j});
+    } else {
+      result.insertions.push_back(j);
+    }
+  }
+
+  for (size_t i = 0; i < oldCount; i++) {
+    if (!oldMatched[i]) {
+      result.deletions.push_back(i);
+    }
+  }
+  return result;
+}
+
+} // namespace Diffing
+} // namespace AS
@@ -0,0 +1,86 @@
+//
+//  ASDiffingCore.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+// This file must stay free of Objective-C so that the diffing engine behind NSArray+Diffing can be built, tested and
+// benchmarked on any host with a C++11 compiler. See Benchmarks/DiffingCore.
+
+#include <cstddef>
+#include <vector>
+
+namespace AS {
+namespace Diffing {
+
+/** Compares elements of the old and the new sequence on behalf of the engine. */
+class Comparator {
+public:
+  virtual ~Comparator() {}
+  virtual bool equal(size_t oldIndex, size_t newIndex) const = 0;
+};
+
+/** Compares sequences of symbols, i.e. elements that were already replaced by an identifier of their equality class. */
+class SymbolComparator : public Comparator {
+public:
+  SymbolComparator(const std::vector<size_t> &oldSymbols, const std::vector<size_t> &newSymbols)
+  : _oldSymbols(oldSymbols), _newSymbols(newSymbols) {}
+
+  bool equal(size_t oldIndex, size_t newIndex) const override
+  {
+    return _oldSymbols[oldIndex] == _newSymbols[newIndex];
+  }
+
+private:
+  const std::vector<size_t> &_oldSymbols;
+  const std::vector<size_t> &_newSymbols;
+};
+
+/** An element that is in both sequences but at a different index. */
+struct Move {
+  size_t from;
+  size_t to;
+};
+
+struct Changes {
+  /** Ascending indexes into the new sequence. */
+  std::vector<size_t> insertions;
+  /** Ascending indexes into the old sequence. */
+  std::vector<size_t> deletions;
+  /** Ordered by ascending destination. */
+  std::vector<Move> moves;
+};
+
+/**
+ * Returns the ascending old indexes of a longest common subsequence of both sequences.
+ *
+ * Uses Myers' O((N+M)D) algorithm in linear space, where D is the number of insertions and deletions: common prefixes
+ * and suffixes are matched directly, and the remainder is split at its middle snake into two independent halves.
+ * Mostly similar sequences are therefore diffed in close to linear time.
+ */
+std::vector<size_t> commonIndexes(size_t oldCount, size_t newCount, const Comparator &comparator);
+
+/**
+ * Returns the insertions and deletions that turn the old sequence into the new one, keeping a longest common
+ * subsequence in place. Moves are never reported.
+ */
+Changes changes(size_t oldCount, size_t newCount, const Comparator &comparator);
+
+/**
+ * Returns the insertions, deletions and moves that turn the old sequence into the new one, in O(N+M).
+ *
+ * Heckel's approach: symbols are the keys of a table recording where they occur in the old sequence, so every element
+ * of the new sequence is paired with an unused equal element of the old sequence in constant time. Elements that are at
+ * the same index in both sequences stay in place; all others are paired with the earliest unused occurrence, which
+ * makes them moves. Symbols must be in [0, symbolCount).
+ */
+Changes changesWithMoves(const std::vector<size_t> &oldSymbols,
+                         const std::vector<size_t> &newSymbols,
+                         size_t symbolCount);
+
+} // namespace Diffing
+} // namespace AS
@@ -11,13 +11,37 @@
 #import <AsyncDisplayKit/ASBaseDefines.h>
 
 /**
- * Like dispatch_apply, but you can set the thread count. 0 means 2*active CPUs.
+ * Like dispatch_apply, but you can set the thread count. 0 means 2*active CPUs, or an adaptive number of threads if
+ * ASExperimentalAdaptiveDispatchApply is enabled (see ASDispatchApplyAdaptive).
  *
  * Note: The actual number of threads may be lower than threadCount, if libdispatch
  * decides the system can't handle it. In reality this rarely happens.
  */
 AS_EXTERN void ASDispatchApply(size_t iterationCount, dispatch_queue_t queue, NSUInteger threadCount, NS_NOESCAPE void(^work)(size_t i));
 
+/**
+ * What happened in one adaptive batch.
+ */
+typedef struct {
+  size_t iterationCount;
+  /// Including the calling thread.
+  NSUInteger threadCount;
+  /// The number of iterations a thread claimed at a time.
+  size_t chunkSize;
+  NSTimeInterval duration;
+  /// The fraction of the threads' time spent in work, from 0 to 1.
+  double utilization;
+} ASDispatchApplyReport;
+
+/**
+ * Like dispatch_apply, but the number of threads and the number of iterations they claim at a time are derived from the
+ * cost of iterations in earlier calls from the same call site. The calling thread does its share of the work, small
+ * batches run on it alone, and fewer threads are used while the device is hot or in low power mode.
+ *
+ * @param report If not NULL, receives what happened in this batch.
+ */
+AS_EXTERN void ASDispatchApplyAdaptive(size_t iterationCount, dispatch_queue_t queue, ASDispatchApplyReport *_Nullable report, NS_NOESCAPE void(^work)(size_t i));
+
 /**
  * Like dispatch_async, but you can set the thread count. 0 means 2*active CPUs.
  *
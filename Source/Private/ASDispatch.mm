@@ -7,12 +7,128 @@
 //
 
 #import <AsyncDisplayKit/ASDispatch.h>
+#import <AsyncDisplayKit/ASApplyPolicy.h>
 #import <AsyncDisplayKit/ASConfigurationInternal.h>
+#import <AsyncDisplayKit/ASThread.h>
 
 
 // Prefer C atomics in this file because ObjC blocks can't capture C++ atomics well.
 #import <stdatomic.h>
 
+// Call sites of ASDispatchApply differ by orders of magnitude in the cost of an iteration, so every call site learns
+// its own. There are only a handful, so they are found by scanning a short array that only grows.
+class ASDispatchApplyPolicies
+{
+public:
+  static AS::ApplyPolicy &policyForCaller(const void *caller)
+  {
+    static ASDispatchApplyPolicies *instance = new ASDispatchApplyPolicies();
+    return instance->policy(caller);
+  }
+
+private:
+  static const unsigned kMaxCallers = 16;
+
+  ASDispatchApplyPolicies() : _count(0) {}
+
+  AS::ApplyPolicy &policy(const void *caller)
+  {
+    unsigned count = _count.load(std::memory_order_acquire);
+    for (unsigned i = 0; i < count; i++) {
+      if (_callers[i] == caller) {
+        return _policies[i];
+      }
+    }
+
+    AS::MutexLocker l(_mutex);
+    count = _count.load(std::memory_order_relaxed);
+    for (unsigned i = 0; i < count; i++) {
+      if (_callers[i] == caller) {
+        return _policies[i];
+      }
+    }
+    if (count == kMaxCallers) {
+      return _sharedPolicy;
+    }
+    _callers[count] = caller;
+    _count.store(count + 1, std::memory_order_release);
+    return _policies[count];
+  }
+
+  const void *_callers[kMaxCallers];
+  AS::ApplyPolicy _policies[kMaxCallers];
+  AS::ApplyPolicy _sharedPolicy;
+  std::atomic<unsigned> _count;
+  AS::Mutex _mutex;
+};
+
+// The number of threads the device can currently afford, including the calling thread.
+static unsigned ASDispatchApplyMaxThreads()
+{
+  NSProcessInfo *processInfo = NSProcessInfo.processInfo;
+  unsigned threads = (unsigned)processInfo.activeProcessorCount;
+  if (@available(iOS 11.0, tvOS 11.0, *)) {
+    switch (processInfo.thermalState) {
+      case NSProcessInfoThermalStateCritical:
+        return 1;
+      case NSProcessInfoThermalStateSerious:
+        threads /= 2;
+        break;
+      default:
+        break;
+    }
+  }
+  if (processInfo.lowPowerModeEnabled) {
+    threads /= 2;
+  }
+  return MAX(1u, threads);
+}
+
+static void ASDispatchApplyInvoke(void *context, size_t i)
+{
+  ((__bridge void(^)(size_t))context)(i);
+}
+
+static void ASDispatchApplyWithPolicy(AS::ApplyPolicy &policy, size_t iterationCount, dispatch_queue_t queue, ASDispatchApplyReport *report, NS_NOESCAPE void(^work)(size_t i))
+{
+  const AS::ApplyPolicy::Plan plan = policy.plan(iterationCount, ASDispatchApplyMaxThreads());
+  AS::ApplyBatch batch(iterationCount, plan);
+  AS::ApplyBatch *batchPointer = &batch;
+  void *context = (__bridge void *)work;
+
+  dispatch_group_t group = nil;
+  if (plan.threads > 1) {
+    group = dispatch_group_create();
+    for (unsigned t = 1; t < plan.threads; t++) {
+      dispatch_group_async(group, queue, ^{
+        batchPointer->run(ASDispatchApplyInvoke, context);
+      });
+    }
+  }
+  // Work instead of waiting idle.
+  batch.run(ASDispatchApplyInvoke, context);
+  if (group) {
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+  }
+
+  const AS::ApplyPolicy::Report batchReport = batch.finish();
+  policy.record(batchReport);
+  if (report) {
+    *report = {
+      .iterationCount = batchReport.iterations,
+      .threadCount = batchReport.threads,
+      .chunkSize = batchReport.chunkSize,
+      .duration = batchReport.wallNanoseconds / (NSTimeInterval)NSEC_PER_SEC,
+      .utilization = batchReport.utilization(),
+    };
+  }
+}
+
+void ASDispatchApplyAdaptive(size_t iterationCount, dispatch_queue_t queue, ASDispatchApplyReport *report, NS_NOESCAPE void(^work)(size_t i)) {
+  AS::ApplyPolicy &policy = ASDispatchApplyPolicies::policyForCaller(__builtin_return_address(0));
+  ASDispatchApplyWithPolicy(policy, iterationCount, queue, report, work);
+}
+
 /**
  * Like dispatch_apply, but you can set the thread count. 0 means 2*active CPUs.
  *
@@ -21,6 +137,11 @@
  */
 void ASDispatchApply(size_t iterationCount, dispatch_queue_t queue, NSUInteger threadCount, NS_NOESCAPE void(^work)(size_t i)) {
   if (threadCount == 0) {
+    if (ASActivateExperimentalFeature(ASExperimentalAdaptiveDispatchApply)) {
+      AS::ApplyPolicy &policy = ASDispatchApplyPolicies::policyForCaller(__builtin_return_address(0));
+      ASDispatchApplyWithPolicy(policy, iterationCount, queue, NULL, work);
+      return;
+    }
     if (ASActivateExperimentalFeature(ASExperimentalDispatchApply)) {
       dispatch_apply(iterationCount, queue, work);
       return;
@@ -10,6 +10,7 @@
 #import <AsyncDisplayKit/_ASCoreAnimationExtras.h>
 #import <AsyncDisplayKit/_ASAsyncTransaction.h>
 #import <AsyncDisplayKit/_ASDisplayLayer.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 #import <AsyncDisplayKit/ASDisplayNodeInternal.h>
 #import <AsyncDisplayKit/ASGraphicsContext.h>
 #import <AsyncDisplayKit/ASInternalHelpers.h>
@@ -17,6 +18,9 @@
 
 using AS::MutexLocker;
 
+// Nodes in the display range are typically a few frames of scrolling away from becoming visible.
+static const CFTimeInterval kASDisplayRangeDeadlineFrames = 4;
+
 @interface ASDisplayNode () <_ASDisplayLayerDelegate>
 @end
 
@@ -378,6 +382,7 @@ using AS::MutexLocker;
   
   CALayer *layer = _layer;
   BOOL rasterizesSubtree = _flags.rasterizesSubtree;
+  ASInterfaceState interfaceState = _interfaceState;
   
   __instanceLock__.unlock();
 
@@ -455,7 +460,20 @@ using AS::MutexLocker;
     
     // Adding this displayBlock operation to the transaction will start it IMMEDIATELY.
     // The only function of the transaction commit is to gate the calling of the completionBlock.
-    [transaction addOperationWithBlock:displayBlock priority:self.drawingPriority queue:[_ASDisplayLayer displayQueue] completion:completionBlock];
+    if (ASActivateExperimentalFeature(ASExperimentalDisplayDeadlines)) {
+      // Visible contents are due by the next frame. Contents in the display range have until the node could have
+      // scrolled into view, and become stale as soon as it leaves the range, which bumps the display sentinel.
+      CFTimeInterval frames = ASInterfaceStateIncludesVisible(interfaceState) ? 1 : kASDisplayRangeDeadlineFrames;
+      CFTimeInterval deadline = CACurrentMediaTime() + frames * ASDisplayFrameDuration();
+      [transaction addOperationWithBlock:displayBlock
+                                priority:self.drawingPriority
+                                deadline:deadline
+                            isStaleBlock:isCancelledBlock
+                                   queue:[_ASDisplayLayer displayQueue]
+                              completion:completionBlock];
+    } else {
+      [transaction addOperationWithBlock:displayBlock priority:self.drawingPriority queue:[_ASDisplayLayer displayQueue] completion:completionBlock];
+    }
   } else {
     UIImage *contents = (UIImage *)displayBlock();
     completionBlock(contents, NO);
@@ -13,10 +13,12 @@
 //
 
 #import <atomic>
+#import <memory>
 #import <AsyncDisplayKit/ASDisplayNode.h>
 #import <AsyncDisplayKit/ASDisplayNode+Beta.h>
 #import <AsyncDisplayKit/ASDisplayNode+FrameworkPrivate.h>
 #import <AsyncDisplayKit/ASLayoutElement.h>
+#import <AsyncDisplayKit/ASLayoutMemo.h>
 #import <AsyncDisplayKit/ASLayoutTransition.h>
 #import <AsyncDisplayKit/ASThread.h>
 #import <AsyncDisplayKit/_ASTransitionContext.h>
@@ -46,6 +48,7 @@ typedef NS_OPTIONS(unsigned short, ASDisplayNodeMethodOverrides)
   ASDisplayNodeMethodOverrideLayoutSpecThatFits     = 1 << 4,
   ASDisplayNodeMethodOverrideCalcLayoutThatFits     = 1 << 5,
   ASDisplayNodeMethodOverrideCalcSizeThatFits       = 1 << 6,
+  ASDisplayNodeMethodOverrideCalcLayoutRelativeToParentSize = 1 << 7,
 };
 
 typedef NS_OPTIONS(uint_least32_t, ASDisplayNodeAtomicFlags)
@@ -203,6 +206,9 @@ static constexpr CACornerMask kASCACornerAllCorners =
   /// Starts at 1.
   std::atomic<NSUInteger> _layoutVersion;
 
+  /// Layouts calculated for previous inputs, see ASLayoutMemo. Created on first use with exp_layout_memo enabled.
+  std::unique_ptr<ASLayoutMemo> _layoutMemo;
+
 
   // Layout Spec performance measurement
   NSTimeInterval _layoutSpecTotalTime;
@@ -55,4 +55,15 @@ struct ASDisplayNodeLayout {
     && CGSizeEqualToSize(parentSize, theParentSize)
     && ASSizeRangeEqualToSizeRange(constrainedSize, theConstrainedSize);
   }
+
+  /**
+   * Returns whether this is valid for a given constrained size and version, comparing the parent size only if the
+   * layout depends on it
+   */
+  BOOL isValid(ASSizeRange theConstrainedSize, CGSize theParentSize, NSUInteger versionArg, BOOL dependsOnParentSize) {
+    if (dependsOnParentSize) {
+      return isValid(theConstrainedSize, theParentSize, versionArg);
+    }
+    return isValid(versionArg) && ASSizeRangeEqualToSizeRange(constrainedSize, theConstrainedSize);
+  }
 };
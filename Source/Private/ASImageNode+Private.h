@@ -14,4 +14,7 @@
 - (void)_locked_setImage:(UIImage *)image;
 - (UIImage *)_locked_Image;
 
+/** Releases the contents kept for retainedContentsByteLimit. */
++ (void)_removeAllRetainedContents;
+
 @end
@@ -39,6 +39,9 @@ AS_EXTERN void ASPerformBackgroundDeallocation(id __strong _Nullable * _Nonnull
 
 AS_EXTERN CGFloat ASScreenScale(void);
 
+/// The duration of a frame of the main screen, which may refresh at 120Hz.
+AS_EXTERN CFTimeInterval ASDisplayFrameDuration(void);
+
 AS_EXTERN CGSize ASFloorSizeValues(CGSize s);
 
 AS_EXTERN CGFloat ASFloorPixelValue(CGFloat f);
@@ -179,6 +179,20 @@ CGFloat ASScreenScale()
   return __scale;
 }
 
+CFTimeInterval ASDisplayFrameDuration()
+{
+  static CFTimeInterval frameDuration;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSInteger framesPerSecond = 60;
+    if (AS_AVAILABLE_IOS_TVOS(10.3, 10.3)) {
+      framesPerSecond = MAX(framesPerSecond, [UIScreen mainScreen].maximumFramesPerSecond);
+    }
+    frameDuration = 1.0 / framesPerSecond;
+  });
+  return frameDuration;
+}
+
 CGSize ASFloorSizeValues(CGSize s)
 {
   return CGSizeMake(ASFloorPixelValue(s.width), ASFloorPixelValue(s.height));
@@ -0,0 +1,277 @@
+//
+//  ASLRUCache.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+// Plain C++11 so that the caches behind ASTextNode2 can be built, stress-tested and benchmarked on any host.
+// See Benchmarks/LRUCache.
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace AS {
+
+/**
+ * A thread-safe cache that evicts the least recently used entries once the summed cost of its entries exceeds a limit.
+ *
+ * Keys are spread over independently locked shards, so threads looking up different keys rarely wait on each other.
+ * Every shard gets an equal part of the cost limit and keeps its own recency order, which makes eviction approximate
+ * LRU across the whole cache but exact within a shard. Evicted values are destroyed after the shard's lock is released,
+ * so destructors may safely call back into the cache.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+class LRUCache {
+public:
+  struct Statistics {
+    size_t hits;
+    size_t misses;
+    /** Entries removed to stay within the cost limit. Explicit removals are not counted. */
+    size_t evictions;
+    size_t count;
+    size_t cost;
+  };
+
+  static const unsigned kDefaultShardCount = 8;
+
+  /** shardCount is rounded up to a power of two. */
+  explicit LRUCache(size_t costLimit, unsigned shardCount = kDefaultShardCount)
+  : _shardCount(roundUpToPowerOfTwo(shardCount)), _shards(new Shard[_shardCount])
+  {
+    setCostLimit(costLimit);
+  }
+
+  LRUCache(const LRUCache &) = delete;
+  LRUCache &operator=(const LRUCache &) = delete;
+
+  /** Copies the value stored for key into value and marks it most recently used. Returns false if there is none. */
+  bool find(const Key &key, Value &value)
+  {
+    Shard &shard = shardForKey(key);
+    std::lock_guard<std::mutex> l(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+      shard.misses++;
+      return false;
+    }
+    shard.promote(it->second);
+    shard.hits++;
+    value = it->second->value;
+    return true;
+  }
+
+  /**
+   * Returns the value stored for key, marking it most recently used. If there is none, stores and returns make() at the
+   * given cost. make is called with the shard locked, so concurrent callers for one key always get the same value; it
+   * must be cheap and must not call into the cache.
+   */
+  template <typename Make>
+  Value findOrInsert(const Key &key, size_t cost, Make make)
+  {
+    Shard &shard = shardForKey(key);
+    EntryList evicted;
+    std::unique_lock<std::mutex> l(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+      shard.promote(it->second);
+      shard.hits++;
+      return it->second->value;
+    }
+    shard.misses++;
+    shard.entries.push_front({key, make(), cost});
+    shard.index.emplace(key, shard.entries.begin());
+    shard.cost += cost;
+    Value value = shard.entries.front().value;
+    shard.evict(evicted);
+    l.unlock();
+    return value;
+  }
+
+  /** Stores value for key at the given cost, replacing any previous value, and marks it most recently used. */
+  void insert(const Key &key, const Value &value, size_t cost)
+  {
+    Shard &shard = shardForKey(key);
+    EntryList evicted;
+    std::unique_lock<std::mutex> l(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+      shard.remove(it, evicted);
+    }
+    shard.entries.push_front({key, value, cost});
+    shard.index.emplace(key, shard.entries.begin());
+    shard.cost += cost;
+    shard.evict(evicted);
+    l.unlock();
+  }
+
+  /**
+   * Updates the cost of the entry for key, e.g. after its value grew, and evicts others if needed. Does not change its
+   * recency. Returns false if there is no entry for key, e.g. because it was evicted in the meantime.
+   */
+  bool setCost(const Key &key, size_t cost)
+  {
+    Shard &shard = shardForKey(key);
+    EntryList evicted;
+    std::unique_lock<std::mutex> l(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+      return false;
+    }
+    shard.cost = shard.cost - it->second->cost + cost;
+    it->second->cost = cost;
+    shard.evict(evicted);
+    l.unlock();
+    return true;
+  }
+
+  /** Returns false if there was no entry for key. */
+  bool erase(const Key &key)
+  {
+    Shard &shard = shardForKey(key);
+    EntryList removed;
+    std::unique_lock<std::mutex> l(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+      return false;
+    }
+    shard.remove(it, removed);
+    l.unlock();
+    return true;
+  }
+
+  void clear()
+  {
+    for (unsigned i = 0; i < _shardCount; i++) {
+      Shard &shard = _shards[i];
+      EntryList removed;
+      std::unique_lock<std::mutex> l(shard.mutex);
+      removed.swap(shard.entries);
+      shard.index.clear();
+      shard.cost = 0;
+      l.unlock();
+    }
+  }
+
+  /** Evicts entries right away if the cache is over the new limit. */
+  void setCostLimit(size_t costLimit)
+  {
+    const size_t shardLimit = costLimit / _shardCount + (costLimit % _shardCount != 0);
+    for (unsigned i = 0; i < _shardCount; i++) {
+      Shard &shard = _shards[i];
+      EntryList evicted;
+      std::unique_lock<std::mutex> l(shard.mutex);
+      shard.costLimit = shardLimit;
+      shard.evict(evicted);
+      l.unlock();
+    }
+  }
+
+  Statistics statistics() const
+  {
+    Statistics statistics = {0, 0, 0, 0, 0};
+    for (unsigned i = 0; i < _shardCount; i++) {
+      Shard &shard = _shards[i];
+      std::lock_guard<std::mutex> l(shard.mutex);
+      statistics.hits += shard.hits;
+      statistics.misses += shard.misses;
+      statistics.evictions += shard.evictions;
+      statistics.count += shard.index.size();
+      statistics.cost += shard.cost;
+    }
+    return statistics;
+  }
+
+  /** Resets hits, misses and evictions. */
+  void resetStatistics()
+  {
+    for (unsigned i = 0; i < _shardCount; i++) {
+      Shard &shard = _shards[i];
+      std::lock_guard<std::mutex> l(shard.mutex);
+      shard.hits = 0;
+      shard.misses = 0;
+      shard.evictions = 0;
+    }
+  }
+
+private:
+  struct Entry {
+    Key key;
+    Value value;
+    size_t cost;
+  };
+  /** Most recently used first. */
+  typedef std::list<Entry> EntryList;
+  typedef std::unordered_map<Key, typename EntryList::iterator, Hash, Equal> Index;
+
+  struct Shard {
+    void promote(typename EntryList::iterator entry)
+    {
+      entries.splice(entries.begin(), entries, entry);
+    }
+
+    /** Moves the entry into removed, so that it is destroyed once the caller released the lock. */
+    void remove(typename Index::iterator it, EntryList &removed)
+    {
+      cost -= it->second->cost;
+      removed.splice(removed.end(), entries, it->second);
+      index.erase(it);
+    }
+
+    /** Removes least recently used entries until the shard is within its limit, even the only entry. */
+    void evict(EntryList &evicted)
+    {
+      while (cost > costLimit && !entries.empty()) {
+        auto last = std::prev(entries.end());
+        remove(index.find(last->key), evicted);
+        evictions++;
+      }
+    }
+
+    mutable std::mutex mutex;
+    EntryList entries;
+    Index index;
+    size_t cost = 0;
+    size_t costLimit = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    // Keeps neighbouring shards' locks off this shard's cache lines.
+    char padding[64];
+  };
+
+  static unsigned roundUpToPowerOfTwo(unsigned value)
+  {
+    unsigned result = 1;
+    while (result < value) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  Shard &shardForKey(const Key &key) const
+  {
+    // Mix the high bits in: many hashes (e.g. of pointers) vary little in their low bits.
+    uint64_t hash = Hash()(key);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return _shards[hash & (_shardCount - 1)];
+  }
+
+  const unsigned _shardCount;
+  const std::unique_ptr<Shard[]> _shards;
+};
+
+template <typename Key, typename Value, typename Hash, typename Equal>
+const unsigned LRUCache<Key, Value, Hash, Equal>::kDefaultShardCount;
+
+} // namespace AS
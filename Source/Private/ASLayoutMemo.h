@@ -0,0 +1,78 @@
+//
+//  ASLayoutMemo.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+#import <AsyncDisplayKit/ASBaseDefines.h>
+#import <AsyncDisplayKit/ASDimension.h>
+#import <AsyncDisplayKit/ASTraitCollection.h>
+
+@class ASLayout;
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef struct {
+  NSUInteger hits;
+  NSUInteger misses;
+} ASLayoutMemoStatistics;
+
+/**
+ * Returns the number of layout memo lookups that were hits and misses, summed over all elements since launch or the
+ * last call to ASLayoutMemoResetStatistics(). Only counts while exp_layout_memo is enabled.
+ */
+AS_EXTERN ASLayoutMemoStatistics ASLayoutMemoGetStatistics(void);
+
+AS_EXTERN void ASLayoutMemoResetStatistics(void);
+
+NS_ASSUME_NONNULL_END
+
+#ifdef __cplusplus
+
+/**
+ * A small cache of layouts previously calculated for one layout element, so that switching back and forth between
+ * constrained sizes (e.g. on rotation, or when a stack measures the same child with several size ranges) does not
+ * recalculate identical layouts.
+ *
+ * Entries are keyed on everything the element's own layout depends on, and hold at most kCapacity layouts evicted in
+ * least-recently-used order. The memo is not synchronized; the owning element must hold its lock while using it.
+ */
+struct ASLayoutMemo {
+  struct Key {
+    ASSizeRange constrainedSize;
+    CGSize parentSize;
+    /** See ASLayoutElementStyle.generation. */
+    NSUInteger styleGeneration;
+    /** See ASDisplayNode's _layoutVersion. */
+    NSUInteger version;
+    ASPrimitiveTraitCollection traitCollection;
+
+    bool operator==(const Key &other) const;
+  };
+
+  static const size_t kCapacity = 4;
+
+  /**
+   * Returns the layout stored for key, or nil. Entries calculated for an older version than key's can never be hit
+   * again and are dropped.
+   */
+  ASLayout *lookup(const Key &key);
+
+  void store(const Key &key, ASLayout *layout);
+
+private:
+  struct Entry {
+    Key key;
+    ASLayout *layout;
+  };
+
+  /** Most recently used first. */
+  Entry _entries[kCapacity];
+  size_t _count = 0;
+};
+
+#endif
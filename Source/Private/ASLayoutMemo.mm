@@ -0,0 +1,88 @@
+//
+//  ASLayoutMemo.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASLayoutMemo.h>
+
+#import <atomic>
+
+#import <AsyncDisplayKit/ASLayout.h>
+
+static std::atomic<NSUInteger> gHits(0);
+static std::atomic<NSUInteger> gMisses(0);
+
+ASLayoutMemoStatistics ASLayoutMemoGetStatistics(void)
+{
+  return {gHits.load(std::memory_order_relaxed), gMisses.load(std::memory_order_relaxed)};
+}
+
+void ASLayoutMemoResetStatistics(void)
+{
+  gHits.store(0, std::memory_order_relaxed);
+  gMisses.store(0, std::memory_order_relaxed);
+}
+
+/** Like CGSizeEqualToSize, except that undefined (NaN) dimensions, which every stack child gets, equal each other. */
+static inline bool ASLayoutMemoParentSizesEqual(CGSize a, CGSize b)
+{
+  const auto dimensionsEqual = [](CGFloat x, CGFloat y) { return x == y || (isnan(x) && isnan(y)); };
+  return dimensionsEqual(a.width, b.width) && dimensionsEqual(a.height, b.height);
+}
+
+bool ASLayoutMemo::Key::operator==(const Key &other) const
+{
+  return version == other.version
+      && styleGeneration == other.styleGeneration
+      && ASSizeRangeEqualToSizeRange(constrainedSize, other.constrainedSize)
+      && ASLayoutMemoParentSizesEqual(parentSize, other.parentSize)
+      && ASPrimitiveTraitCollectionIsEqualToASPrimitiveTraitCollection(traitCollection, other.traitCollection);
+}
+
+ASLayout *ASLayoutMemo::lookup(const Key &key)
+{
+  size_t kept = 0;
+  ASLayout *layout = nil;
+  for (size_t i = 0; i < _count; i++) {
+    if (_entries[i].key.version < key.version) {
+      _entries[i].layout = nil;
+      continue;
+    }
+    if (layout == nil && _entries[i].key == key) {
+      layout = _entries[i].layout;
+      // Move the hit to the front, shifting the entries kept so far back by one.
+      Entry hit = _entries[i];
+      for (size_t j = kept; j > 0; j--) {
+        _entries[j] = _entries[j - 1];
+      }
+      _entries[0] = hit;
+    } else {
+      _entries[kept] = _entries[i];
+    }
+    kept++;
+  }
+  for (size_t i = kept; i < _count; i++) {
+    _entries[i].layout = nil;
+  }
+  _count = kept;
+
+  (layout ? gHits : gMisses).fetch_add(1, std::memory_order_relaxed);
+  return layout;
+}
+
+void ASLayoutMemo::store(const Key &key, ASLayout *layout)
+{
+  if (layout == nil) {
+    return;
+  }
+  // Evict the least recently used entry if full, then insert at the front.
+  const size_t count = MIN(_count + 1, kCapacity);
+  for (size_t i = count - 1; i > 0; i--) {
+    _entries[i] = _entries[i - 1];
+  }
+  _entries[0] = {key, layout};
+  _count = count;
+}
@@ -0,0 +1,167 @@
+//
+//  ASPointerMap.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+// Plain C++11 so that ASRunLoopQueue's storage can be built, tested and benchmarked on any host.
+// See Benchmarks/RunLoopQueueStorage.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace AS {
+
+/**
+ * A map from non-null pointers to 64-bit values, stored inline with open addressing and linear probing.
+ *
+ * Unlike std::unordered_map or an NSHashTable, inserting does not allocate a node, and the table stays at most half
+ * full so that probes are short. Removal shifts later entries of the probe run back instead of leaving tombstones, so
+ * lookups do not slow down as entries come and go. The pointers are only compared, never dereferenced or retained.
+ *
+ * Not thread-safe.
+ */
+class PointerMap {
+public:
+  explicit PointerMap(size_t initialCapacity = 16) : _entries(roundUpToPowerOfTwo(initialCapacity * 2)), _count(0) {}
+
+  size_t size() const { return _count; }
+  bool empty() const { return _count == 0; }
+
+  /** Copies the value stored for key into value. Returns false if there is none. */
+  bool find(const void *key, uint64_t &value) const
+  {
+    for (size_t i = indexForKey(key);; i = (i + 1) & mask()) {
+      const Entry &entry = _entries[i];
+      if (entry.key == key) {
+        value = entry.value;
+        return true;
+      }
+      if (entry.key == nullptr) {
+        return false;
+      }
+    }
+  }
+
+  /** Stores value for key, replacing any value it had. key must not be null. */
+  void set(const void *key, uint64_t value)
+  {
+    if ((_count + 1) * 2 > _entries.size()) {
+      rehash(_entries.size() * 2);
+    }
+    for (size_t i = indexForKey(key);; i = (i + 1) & mask()) {
+      Entry &entry = _entries[i];
+      if (entry.key == key) {
+        entry.value = value;
+        return;
+      }
+      if (entry.key == nullptr) {
+        entry.key = key;
+        entry.value = value;
+        _count++;
+        return;
+      }
+    }
+  }
+
+  /** Removes key. Returns false if it was not in the map. */
+  bool erase(const void *key)
+  {
+    return erase(key, false, 0);
+  }
+
+  /**
+   * Removes key only if its value is value. Lets an owner of an old entry remove it without removing a newer entry that
+   * reused the same key.
+   */
+  bool eraseIfEqual(const void *key, uint64_t value)
+  {
+    return erase(key, true, value);
+  }
+
+  void clear()
+  {
+    for (Entry &entry : _entries) {
+      entry = Entry();
+    }
+    _count = 0;
+  }
+
+private:
+  struct Entry {
+    Entry() : key(nullptr), value(0) {}
+    const void *key;
+    uint64_t value;
+  };
+
+  size_t mask() const { return _entries.size() - 1; }
+
+  size_t indexForKey(const void *key) const
+  {
+    // Fibonacci hashing spreads aligned pointers, whose low bits are always zero, over the whole table.
+    const uint64_t hash = (uint64_t)(uintptr_t)key * 0x9E3779B97F4A7C15ull;
+    return (size_t)(hash >> 32) & mask();
+  }
+
+  bool erase(const void *key, bool matchValue, uint64_t value)
+  {
+    size_t i = indexForKey(key);
+    while (true) {
+      const Entry &entry = _entries[i];
+      if (entry.key == nullptr) {
+        return false;
+      }
+      if (entry.key == key) {
+        if (matchValue && entry.value != value) {
+          return false;
+        }
+        break;
+      }
+      i = (i + 1) & mask();
+    }
+
+    // Backward-shift deletion: move each later entry of the run into the hole if its home slot is not after the hole.
+    size_t hole = i;
+    for (size_t j = (hole + 1) & mask(); _entries[j].key != nullptr; j = (j + 1) & mask()) {
+      const size_t home = indexForKey(_entries[j].key);
+      if (((j - home) & mask()) >= ((j - hole) & mask())) {
+        _entries[hole] = _entries[j];
+        hole = j;
+      }
+    }
+    _entries[hole] = Entry();
+    _count--;
+    return true;
+  }
+
+  void rehash(size_t capacity)
+  {
+    std::vector<Entry> entries(capacity);
+    entries.swap(_entries);
+    _count = 0;
+    for (const Entry &entry : entries) {
+      if (entry.key != nullptr) {
+        set(entry.key, entry.value);
+      }
+    }
+  }
+
+  static size_t roundUpToPowerOfTwo(size_t n)
+  {
+    size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  std::vector<Entry> _entries;
+  size_t _count;
+};
+
+} // namespace AS
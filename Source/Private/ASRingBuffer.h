@@ -0,0 +1,107 @@
+//
+//  ASRingBuffer.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+// Plain C++11 so that ASRunLoopQueue's storage can be built, tested and benchmarked on any host.
+// See Benchmarks/RunLoopQueueStorage.
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace AS {
+
+/**
+ * A FIFO queue over a growable power-of-two array. Pushing and popping are O(1) and never shift other elements.
+ *
+ * Every element gets a sequence number when it is pushed, counting up from zero over the life of the buffer, so
+ * callers can refer back to an element that is still queued without holding an index that popping would invalidate.
+ *
+ * Not thread-safe. T must be default constructible; popped slots are reset to T() so that they release what they hold.
+ */
+template <typename T>
+class RingBuffer {
+public:
+  explicit RingBuffer(size_t initialCapacity = 16) : _slots(roundUpToPowerOfTwo(initialCapacity)), _head(0), _count(0), _headSequence(0) {}
+
+  size_t size() const { return _count; }
+  bool empty() const { return _count == 0; }
+
+  /** The sequence number of the front element, or of the next element pushed if the buffer is empty. */
+  uint64_t headSequence() const { return _headSequence; }
+  /** The sequence number the next element pushed will get. */
+  uint64_t tailSequence() const { return _headSequence + _count; }
+
+  /** Appends value and returns its sequence number. */
+  uint64_t push_back(T value)
+  {
+    if (_count == _slots.size()) {
+      grow();
+    }
+    _slots[(_head + _count) & mask()] = std::move(value);
+    return _headSequence + _count++;
+  }
+
+  T &front() { return _slots[_head]; }
+
+  /** Moves the front element out. The buffer must not be empty. */
+  T pop_front()
+  {
+    T value = std::move(_slots[_head]);
+    _slots[_head] = T();
+    _head = (_head + 1) & mask();
+    _count--;
+    _headSequence++;
+    return value;
+  }
+
+  /** Whether sequence refers to an element that is still queued. */
+  bool contains(uint64_t sequence) const { return sequence >= _headSequence && sequence < tailSequence(); }
+
+  /** The element pushed with sequence, which must still be queued. */
+  T &at(uint64_t sequence) { return _slots[(_head + (size_t)(sequence - _headSequence)) & mask()]; }
+
+  /** Pops every element. Capacity is kept. */
+  void clear()
+  {
+    while (_count > 0) {
+      pop_front();
+    }
+  }
+
+private:
+  size_t mask() const { return _slots.size() - 1; }
+
+  void grow()
+  {
+    std::vector<T> slots(_slots.size() * 2);
+    for (size_t i = 0; i < _count; i++) {
+      slots[i] = std::move(_slots[(_head + i) & mask()]);
+    }
+    _slots.swap(slots);
+    _head = 0;
+  }
+
+  static size_t roundUpToPowerOfTwo(size_t n)
+  {
+    size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  std::vector<T> _slots;
+  size_t _head;
+  size_t _count;
+  uint64_t _headSequence;
+};
+
+} // namespace AS
@@ -0,0 +1,51 @@
+//
+//  ASTextFramesetterPool.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <CoreText/CoreText.h>
+
+#import <AsyncDisplayKit/ASBaseDefines.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef struct {
+  /** Check-outs that got an idle framesetter from the pool. */
+  NSUInteger hits;
+  /** Check-outs that had to create a framesetter. */
+  NSUInteger misses;
+  /** Strings whose framesetters were dropped to stay within the cost limit. */
+  NSUInteger evictions;
+  /** Strings that currently have an entry in the pool. */
+  NSUInteger count;
+} ASTextFramesetterPoolStatistics;
+
+/**
+ * Returns a framesetter for text, which ASTextLayout uses while exp_framesetter_cache is enabled.
+ *
+ * A framesetter keeps the typesetting of its whole string, so frames of any size are cheap once it exists. The pool
+ * keeps framesetters per attributed string (by equality), so that layouts of one string for different container sizes
+ * share a single shaping pass. Framesetters can only be used by one thread at a time: the one returned belongs to the
+ * caller until it is handed back with ASTextFramesetterPoolCheckIn(), and concurrent callers for the same string get
+ * framesetters of their own. Strings are evicted in least-recently-used order beyond the cost limit, and the pool is
+ * emptied on memory warnings.
+ */
+AS_EXTERN CTFramesetterRef _Nullable ASTextFramesetterPoolCheckOut(NSAttributedString *text) CF_RETURNS_RETAINED;
+
+/** Returns a framesetter checked out for text, which must not have been mutated since. Consumes framesetter. */
+AS_EXTERN void ASTextFramesetterPoolCheckIn(NSAttributedString *text, CTFramesetterRef CF_CONSUMED framesetter);
+
+/** Counted since launch or the last call to ASTextFramesetterPoolResetStatistics(). */
+AS_EXTERN ASTextFramesetterPoolStatistics ASTextFramesetterPoolGetStatistics(void);
+
+AS_EXTERN void ASTextFramesetterPoolResetStatistics(void);
+
+/** In bytes. Defaults to 4 MB. */
+AS_EXTERN void ASTextFramesetterPoolSetCostLimit(NSUInteger costLimit);
+
+AS_EXTERN void ASTextFramesetterPoolRemoveAllFramesetters(void);
+
+NS_ASSUME_NONNULL_END
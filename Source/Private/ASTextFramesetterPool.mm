@@ -0,0 +1,122 @@
+//
+//  ASTextFramesetterPool.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASTextFramesetterPool.h>
+
+#import <vector>
+
+#import <AsyncDisplayKit/ASAttributedStringLRUCache.h>
+#import <AsyncDisplayKit/ASThread.h>
+
+/**
+ * Framesetters kept idle per string. One serves the usual case of a string laid out by one thread at a time; the second
+ * covers measurement and drawing of the same string overlapping. More concurrent users create and drop their own.
+ */
+static const size_t kASTextFramesetterPoolIdlePerString = 2;
+static const NSUInteger kASTextFramesetterPoolDefaultCostLimit = 4 * 1024 * 1024;
+
+@interface ASTextFramesetterPoolEntry : NSObject {
+  @package
+  AS::Mutex _m;
+  std::vector<CTFramesetterRef> _idle;
+}
+@end
+
+@implementation ASTextFramesetterPoolEntry
+
+- (void)dealloc
+{
+  for (CTFramesetterRef framesetter : _idle) {
+    CFRelease(framesetter);
+  }
+}
+
+@end
+
+typedef AS::AttributedStringLRUCache<ASTextFramesetterPoolEntry *> ASTextFramesetterLRUCache;
+
+static ASTextFramesetterLRUCache &ASTextFramesetterPoolShared()
+{
+  static ASTextFramesetterLRUCache *cache;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    cache = new ASTextFramesetterLRUCache(kASTextFramesetterPoolDefaultCostLimit);
+  });
+  return *cache;
+}
+
+/**
+ * A framesetter holds the typeset lines of its string: glyphs, advances, positions and string indices for every
+ * character, and a run per attribute change.
+ */
+static size_t ASTextFramesetterPoolCost(NSAttributedString *text)
+{
+  return 512 + text.length * 48 * kASTextFramesetterPoolIdlePerString;
+}
+
+CTFramesetterRef ASTextFramesetterPoolCheckOut(NSAttributedString *text)
+{
+  ASTextFramesetterLRUCache &cache = ASTextFramesetterPoolShared();
+  ASTextFramesetterPoolEntry *entry = cache.entryForText(text, ASTextFramesetterPoolCost(text), [] {
+    return [[ASTextFramesetterPoolEntry alloc] init];
+  });
+
+  {
+    AS::MutexLocker l(entry->_m);
+    if (!entry->_idle.empty()) {
+      CTFramesetterRef framesetter = entry->_idle.back();
+      entry->_idle.pop_back();
+      cache.recordHit();
+      return framesetter;
+    }
+  }
+
+  // Typesetting is the expensive part, so do it without holding the entry.
+  cache.recordMiss();
+  return CTFramesetterCreateWithAttributedString((CFAttributedStringRef)text);
+}
+
+void ASTextFramesetterPoolCheckIn(NSAttributedString *text, CTFramesetterRef framesetter)
+{
+  ASTextFramesetterPoolEntry *entry = nil;
+  // If the string was evicted while the framesetter was out, it is simply released.
+  if (ASTextFramesetterPoolShared().find(text, entry)) {
+    AS::MutexLocker l(entry->_m);
+    if (entry->_idle.size() < kASTextFramesetterPoolIdlePerString) {
+      entry->_idle.push_back(framesetter);
+      return;
+    }
+  }
+  CFRelease(framesetter);
+}
+
+ASTextFramesetterPoolStatistics ASTextFramesetterPoolGetStatistics(void)
+{
+  const ASTextFramesetterLRUCache::Statistics statistics = ASTextFramesetterPoolShared().statistics();
+  return {
+    .hits = statistics.hits,
+    .misses = statistics.misses,
+    .evictions = statistics.evictions,
+    .count = statistics.count,
+  };
+}
+
+void ASTextFramesetterPoolResetStatistics(void)
+{
+  ASTextFramesetterPoolShared().resetStatistics();
+}
+
+void ASTextFramesetterPoolSetCostLimit(NSUInteger costLimit)
+{
+  ASTextFramesetterPoolShared().setCostLimit(costLimit);
+}
+
+void ASTextFramesetterPoolRemoveAllFramesetters(void)
+{
+  ASTextFramesetterPoolShared().clear();
+}
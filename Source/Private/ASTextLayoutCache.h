@@ -0,0 +1,69 @@
+//
+//  ASTextLayoutCache.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASBaseDefines.h>
+
+@class ASTextContainer;
+@class ASTextLayout;
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef struct {
+  /** Layouts that were found in the cache. */
+  NSUInteger hits;
+  /** Layouts that had to be calculated. */
+  NSUInteger misses;
+  /** Strings whose layouts were dropped to stay within the cost limit. */
+  NSUInteger evictions;
+  /** Strings that currently have layouts in the cache. */
+  NSUInteger count;
+  /** Estimated bytes held by the cached layouts. */
+  NSUInteger cost;
+  /** Layouts calculated ahead of time by ASTextLayoutCachePrefetchLayout(). */
+  NSUInteger prefetches;
+  /** Prefetch requests dropped because the workers fell behind. */
+  NSUInteger droppedPrefetches;
+} ASTextLayoutCacheStatistics;
+
+/**
+ * Returns a layout of text in a container equivalent to container from the cache ASTextNode2 uses while
+ * exp_text_layout_cache is enabled, calculating and caching it if needed.
+ *
+ * Layouts are kept per attributed string, a few container sizes each, and strings are evicted in least-recently-used
+ * order once the estimated size of their layouts exceeds the cost limit. Strings are spread over independently locked
+ * shards, so measuring on several threads at once does not serialize on one lock. Concurrent requests for the same
+ * string wait for each other, so a layout is only calculated once. The cache is emptied on memory warnings.
+ *
+ * With exp_text_width_range_reuse, a layout in which the text took its natural width (nothing wrapped or was cut off,
+ * and every line is left aligned) is also returned for any container at least that wide and tall.
+ */
+AS_EXTERN ASTextLayout *ASTextLayoutCacheGetLayout(ASTextContainer *container, NSAttributedString *text);
+
+/**
+ * Calculates the layout on a low-priority background queue and stores it in the cache, unless it is there already, so
+ * that a later call to ASTextLayoutCacheGetLayout() with an equivalent container and equal text finds it. container and
+ * text must not be mutated afterwards.
+ */
+AS_EXTERN void ASTextLayoutCachePrefetchLayout(ASTextContainer *container, NSAttributedString *text);
+
+/** Counted since launch or the last call to ASTextLayoutCacheResetStatistics(). */
+AS_EXTERN ASTextLayoutCacheStatistics ASTextLayoutCacheGetStatistics(void);
+
+AS_EXTERN void ASTextLayoutCacheResetStatistics(void);
+
+/** In bytes. Defaults to 8 MB. */
+AS_EXTERN void ASTextLayoutCacheSetCostLimit(NSUInteger costLimit);
+
+AS_EXTERN void ASTextLayoutCacheRemoveAllLayouts(void);
+
+/**
+ * Whether layout, calculated for a container of constrainedSize, can be used for container.
+ */
+AS_EXTERN BOOL ASTextLayoutIsCompatibleWithContainer(ASTextLayout *layout, CGSize constrainedSize, ASTextContainer *container);
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,321 @@
+//
+//  ASTextLayoutCache.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <AsyncDisplayKit/ASTextLayoutCache.h>
+
+#import <atomic>
+#import <deque>
+
+#import <AsyncDisplayKit/ASAttributedStringLRUCache.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+#import <AsyncDisplayKit/ASEqualityHelpers.h>
+#import <AsyncDisplayKit/ASTextLayout.h>
+#import <AsyncDisplayKit/ASThread.h>
+#import <AsyncDisplayKit/NSAttributedString+ASText.h>
+
+/** A string's layouts are replaced in least-recently-used order beyond this many container sizes. */
+static const size_t kASTextLayoutCacheLayoutsPerString = 4;
+static const NSUInteger kASTextLayoutCacheDefaultCostLimit = 8 * 1024 * 1024;
+/** The string, the entry and the cache's bookkeeping. */
+static const size_t kASTextLayoutCacheEntryCost = 256;
+
+struct ASTextCachedLayout {
+  CGSize constrainedSize;
+  ASTextLayout *layout;
+  /** See ASTextLayoutNaturalWidth(). */
+  CGFloat naturalWidth;
+};
+
+@interface ASTextLayoutCacheEntry : NSObject {
+  @package
+  AS::Mutex _m;
+  /** Most recently used first. */
+  std::deque<ASTextCachedLayout> _layouts;
+}
+@end
+@implementation ASTextLayoutCacheEntry
+@end
+
+typedef AS::AttributedStringLRUCache<ASTextLayoutCacheEntry *> ASTextLayoutLRUCache;
+
+static std::atomic<NSUInteger> gPrefetches(0);
+static std::atomic<NSUInteger> gPrefetchesDropped(0);
+
+static ASTextLayoutLRUCache &ASTextLayoutCacheShared()
+{
+  static ASTextLayoutLRUCache *cache;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    cache = new ASTextLayoutLRUCache(kASTextLayoutCacheDefaultCostLimit);
+  });
+  return *cache;
+}
+
+/**
+ * CoreText keeps glyphs, advances, positions and string indices for every laid out character, and the line and run
+ * objects on top of that. This estimates them from what ASTextLayout exposes cheaply.
+ */
+static size_t ASTextLayoutCacheCost(ASTextLayout *layout)
+{
+  return 512 + layout.lines.count * 256 + layout.visibleRange.length * 40;
+}
+
+/** Everything but the size. */
+static BOOL ASTextContainerHasEqualParameters(ASTextContainer *container, ASTextContainer *otherContainer)
+{
+  if (!UIEdgeInsetsEqualToEdgeInsets(container.insets, otherContainer.insets)) {
+    return NO;
+  }
+  if (!ASObjectIsEqual(container.exclusionPaths, otherContainer.exclusionPaths)) {
+    return NO;
+  }
+  if (container.maximumNumberOfRows != otherContainer.maximumNumberOfRows) {
+    return NO;
+  }
+  if (container.truncationType != otherContainer.truncationType) {
+    return NO;
+  }
+  if (!ASObjectIsEqual(container.truncationToken, otherContainer.truncationToken)) {
+    return NO;
+  }
+  return YES;
+}
+
+BOOL ASTextLayoutIsCompatibleWithContainer(ASTextLayout *layout, CGSize constrainedSize, ASTextContainer *container)
+{
+  CGRect containerBounds = (CGRect){ .size = container.size };
+  CGSize layoutSize = layout.textBoundingSize;
+  // 1. CoreText can return frames that are narrower than the constrained width, for obvious reasons.
+  // 2. CoreText can return frames that are slightly wider than the constrained width, for some reason.
+  //    We have to trust that somehow it's OK to try and draw within our size constraint, despite the return value.
+  // 3. Thus, those two values (constrained width & returned width) form a range, where
+  //    intermediate values in that range will be snapped. Thus, we can use a given layout as long as our
+  //    width is in that range, between the min and max of those two values.
+  CGRect minRect = CGRectMake(0, 0, MIN(layoutSize.width, constrainedSize.width), MIN(layoutSize.height, constrainedSize.height));
+  if (!CGRectContainsRect(containerBounds, minRect)) {
+    return NO;
+  }
+  CGRect maxRect = CGRectMake(0, 0, MAX(layoutSize.width, constrainedSize.width), MAX(layoutSize.height, constrainedSize.height));
+  if (!CGRectContainsRect(maxRect, containerBounds)) {
+    return NO;
+  }
+  if (!CGSizeEqualToSize(container.size, constrainedSize)) {
+    return NO;
+  }
+
+  // Now check container params.
+  return ASTextContainerHasEqualParameters(container, layout.container);
+}
+
+/**
+ * The width the text takes when nothing limits it, if the layout shows it: no line wrapped or was cut off, and the line
+ * origins do not depend on the container's width. Such a layout is exactly what any container at least that wide and
+ * tall would produce. Otherwise NAN.
+ */
+static CGFloat ASTextLayoutNaturalWidth(ASTextLayout *layout)
+{
+  ASTextContainer *container = layout.container;
+  if (container.path != nil || container.exclusionPaths.count > 0 || container.verticalForm || container.linePositionModifier != nil) {
+    return NAN;
+  }
+  if (layout.truncatedLine != nil || NSMaxRange(layout.visibleRange) < NSMaxRange(layout.range)) {
+    return NAN;
+  }
+  // Every line but the last has to end in a hard break; a line that wrapped would wrap elsewhere at another width.
+  NSString *string = layout.text.string;
+  NSCharacterSet *newlines = [NSCharacterSet newlineCharacterSet];
+  NSArray<ASTextLine *> *lines = layout.lines;
+  for (NSUInteger i = 0; i + 1 < lines.count; i++) {
+    const NSRange range = lines[i].range;
+    if (range.length == 0 || ![newlines characterIsMember:[string characterAtIndex:NSMaxRange(range) - 1]]) {
+      return NAN;
+    }
+  }
+  if (![layout.text as_isLeftAligned]) {
+    return NAN;
+  }
+  return layout.textBoundingSize.width;
+}
+
+static BOOL ASTextCachedLayoutIsCompatibleWithContainer(const ASTextCachedLayout &cached, ASTextContainer *container, BOOL reuseWidths)
+{
+  if (ASTextLayoutIsCompatibleWithContainer(cached.layout, cached.constrainedSize, container)) {
+    return YES;
+  }
+  if (!reuseWidths || isnan(cached.naturalWidth)) {
+    return NO;
+  }
+  const CGSize size = container.size;
+  if (size.width < cached.naturalWidth || size.height < cached.layout.textBoundingSize.height) {
+    return NO;
+  }
+  if (container.path != nil || container.verticalForm || !ASObjectIsEqual(container.linePositionModifier, cached.layout.container.linePositionModifier)) {
+    return NO;
+  }
+  return ASTextContainerHasEqualParameters(container, cached.layout.container);
+}
+
+/**
+ * Prefetches do not count as hits or misses: they are not measurements, and would hide whether measurements found
+ * their layouts.
+ */
+static ASTextLayout *ASTextLayoutCacheLayout(ASTextContainer *container, NSAttributedString *text, BOOL prefetch)
+{
+  ASTextLayoutLRUCache &cache = ASTextLayoutCacheShared();
+  ASTextLayoutCacheEntry *entry = cache.entryForText(text, kASTextLayoutCacheEntryCost, [] {
+    return [[ASTextLayoutCacheEntry alloc] init];
+  });
+
+  // Hold the entry's lock while calculating, so that threads measuring the same string wait for one calculation
+  // instead of racing. Other strings are unaffected.
+  const BOOL reuseWidths = ASActivateExperimentalFeature(ASExperimentalTextWidthRangeReuse);
+  AS::MutexLocker lock(entry->_m);
+  auto &layouts = entry->_layouts;
+  for (auto it = layouts.begin(); it != layouts.end(); ++it) {
+    if (ASTextCachedLayoutIsCompatibleWithContainer(*it, container, reuseWidths)) {
+      ASTextLayout *layout = it->layout;
+      if (it != layouts.begin()) {
+        auto hit = *it;
+        layouts.erase(it);
+        layouts.push_front(hit);
+      }
+      if (!prefetch) {
+        cache.recordHit();
+      }
+      return layout;
+    }
+  }
+
+  if (prefetch) {
+    gPrefetches.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    cache.recordMiss();
+  }
+  ASTextLayout *layout = [ASTextLayout layoutWithContainer:container text:text];
+  if (layout == nil) {
+    return nil;
+  }
+  layouts.push_front({container.size, layout, reuseWidths ? ASTextLayoutNaturalWidth(layout) : NAN});
+  if (layouts.size() > kASTextLayoutCacheLayoutsPerString) {
+    layouts.pop_back();
+  }
+
+  size_t cost = kASTextLayoutCacheEntryCost;
+  for (const auto &t : layouts) {
+    cost += ASTextLayoutCacheCost(t.layout);
+  }
+  // If the entry was evicted while we calculated, the layout is still returned, just not kept.
+  cache.setCost(text, cost);
+  return layout;
+}
+
+ASTextLayout *ASTextLayoutCacheGetLayout(ASTextContainer *container, NSAttributedString *text)
+{
+  return ASTextLayoutCacheLayout(container, text, NO);
+}
+
+#pragma mark - Prefetching
+
+/**
+ * A small pool of low-priority workers that lay out texts ahead of time. Requests are served in the order they were
+ * made, which is the order cells approach the viewport. If scrolling outpaces the workers, the oldest requests, whose
+ * cells are the most likely to have scrolled past already, are dropped.
+ */
+class ASTextLayoutPrefetcher
+{
+public:
+  static ASTextLayoutPrefetcher &shared()
+  {
+    static ASTextLayoutPrefetcher *instance = new ASTextLayoutPrefetcher();
+    return *instance;
+  }
+
+  void enqueue(ASTextContainer *container, NSAttributedString *text)
+  {
+    AS::MutexLocker l(_mutex);
+    if (_pending.size() == kMaxPending) {
+      _pending.pop_front();
+      gPrefetchesDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    _pending.push_back({container, text});
+    if (_workerCount < _maxWorkerCount && _workerCount < _pending.size()) {
+      _workerCount++;
+      dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+        drain();
+      });
+    }
+  }
+
+private:
+  static const size_t kMaxPending = 256;
+
+  // Leave a core to the main thread and the measurements that are actually waited for.
+  ASTextLayoutPrefetcher() : _workerCount(0), _maxWorkerCount((unsigned)MAX(1, MIN(2, NSProcessInfo.processInfo.activeProcessorCount - 1))) {}
+
+  void drain()
+  {
+    while (true) {
+      ASTextContainer *container;
+      NSAttributedString *text;
+      {
+        AS::MutexLocker l(_mutex);
+        if (_pending.empty()) {
+          _workerCount--;
+          return;
+        }
+        container = _pending.front().first;
+        text = _pending.front().second;
+        _pending.pop_front();
+      }
+      @autoreleasepool {
+        ASTextLayoutCacheLayout(container, text, YES);
+      }
+    }
+  }
+
+  AS::Mutex _mutex;
+  std::deque<std::pair<ASTextContainer *, NSAttributedString *>> _pending;
+  unsigned _workerCount;
+  const unsigned _maxWorkerCount;
+};
+
+void ASTextLayoutCachePrefetchLayout(ASTextContainer *container, NSAttributedString *text)
+{
+  ASTextLayoutPrefetcher::shared().enqueue(container, text);
+}
+
+ASTextLayoutCacheStatistics ASTextLayoutCacheGetStatistics(void)
+{
+  const ASTextLayoutLRUCache::Statistics statistics = ASTextLayoutCacheShared().statistics();
+  return {
+    .hits = statistics.hits,
+    .misses = statistics.misses,
+    .evictions = statistics.evictions,
+    .count = statistics.count,
+    .cost = statistics.cost,
+    .prefetches = gPrefetches.load(std::memory_order_relaxed),
+    .droppedPrefetches = gPrefetchesDropped.load(std::memory_order_relaxed),
+  };
+}
+
+void ASTextLayoutCacheResetStatistics(void)
+{
+  gPrefetches.store(0, std::memory_order_relaxed);
+  gPrefetchesDropped.store(0, std::memory_order_relaxed);
+  ASTextLayoutCacheShared().resetStatistics();
+}
+
+void ASTextLayoutCacheSetCostLimit(NSUInteger costLimit)
+{
+  ASTextLayoutCacheShared().setCostLimit(costLimit);
+}
+
+void ASTextLayoutCacheRemoveAllLayouts(void)
+{
+  ASTextLayoutCacheShared().clear();
+}
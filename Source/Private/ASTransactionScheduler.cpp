@@ -0,0 +1,275 @@
+//
+//  ASTransactionScheduler.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#include "ASTransactionScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+namespace AS {
+
+static thread_local unsigned tScheduleCount = 0;
+
+namespace {
+
+const unsigned kLevelCountBits = 4;
+const unsigned kLevelIndexBits = 4;
+
+unsigned levelCount(uint64_t order)
+{
+  return order & ((1u << kLevelCountBits) - 1);
+}
+
+unsigned levelAt(uint64_t order, unsigned position)
+{
+  return (order >> (kLevelCountBits + position * kLevelIndexBits)) & ((1u << kLevelIndexBits) - 1);
+}
+
+template <typename T>
+void storeMax(std::atomic<T> &target, T value)
+{
+  T current = target.load(std::memory_order_relaxed);
+  while (current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+} // namespace
+
+static_assert(TransactionScheduler::kMaxLevels <= (1u << kLevelIndexBits), "Level indexes must fit the order word");
+static_assert(TransactionScheduler::kMaxLevels < (1u << kLevelCountBits), "Level count must fit the order word");
+static_assert(kLevelCountBits + TransactionScheduler::kMaxLevels * kLevelIndexBits <= 64, "Order word overflows");
+
+const unsigned TransactionScheduler::kMaxWorkers;
+
+TransactionScheduler::TransactionScheduler(SpawnFunction spawn, void *spawnContext)
+: _spawn(spawn), _spawnContext(spawnContext), _urgentHorizon(kUrgentHorizonFrames * kDefaultFrameDuration),
+  _levelOrder(0), _workers(0), _rotation(0), _depth(0), _maxDepth(0), _executed(0), _waitSamples(0), _totalWait(0),
+  _maxWait(0), _dropped(0), _missedDeadlines(0) {}
+
+TransactionScheduler::~TransactionScheduler() {}
+
+void TransactionScheduler::setFrameDuration(uint64_t frameDuration)
+{
+  _urgentHorizon.store(kUrgentHorizonFrames * frameDuration, std::memory_order_relaxed);
+}
+
+uint64_t TransactionScheduler::now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TransactionScheduler::Level &TransactionScheduler::levelFor(long priority, Lane lane)
+{
+  // Fast path: the handful of priorities in use are registered early on, after which this never locks.
+  uint64_t order = _levelOrder.load(std::memory_order_acquire);
+  for (unsigned i = 0, count = levelCount(order); i < count; i++) {
+    Level &level = *_levels[levelAt(order, i)];
+    if (level.priority == priority && level.lane == lane) {
+      return level;
+    }
+  }
+
+  std::lock_guard<std::mutex> l(_levelMutex);
+  order = _levelOrder.load(std::memory_order_relaxed);
+  const unsigned count = levelCount(order);
+  for (unsigned i = 0; i < count; i++) {
+    Level &level = *_levels[levelAt(order, i)];
+    if (level.priority == priority && level.lane == lane) {
+      return level;
+    }
+  }
+
+  if (count == kMaxLevels) {
+    // Out of queues: share the one with the closest priority, in the same lane if there is one.
+    Level *closest = _levels[0].get();
+    for (unsigned i = 1; i < count; i++) {
+      Level *level = _levels[i].get();
+      if ((level->lane == lane) != (closest->lane == lane)) {
+        if (level->lane == lane) {
+          closest = level;
+        }
+      } else if (std::labs(level->priority - priority) < std::labs(closest->priority - priority)) {
+        closest = level;
+      }
+    }
+    return *closest;
+  }
+
+  _levels[count].reset(new Level(priority, lane));
+
+  unsigned indexes[kMaxLevels];
+  for (unsigned i = 0; i <= count; i++) {
+    indexes[i] = i;
+  }
+  std::stable_sort(indexes, indexes + count + 1, [this](unsigned a, unsigned b) {
+    const Level &first = *_levels[a];
+    const Level &second = *_levels[b];
+    return first.priority > second.priority || (first.priority == second.priority && first.lane < second.lane);
+  });
+  uint64_t newOrder = count + 1;
+  for (unsigned i = 0; i <= count; i++) {
+    newOrder |= (uint64_t)indexes[i] << (kLevelCountBits + i * kLevelIndexBits);
+  }
+  // Publishing the order also publishes the new level to readers on the fast path.
+  _levelOrder.store(newOrder, std::memory_order_release);
+  return *_levels[count];
+}
+
+void TransactionScheduler::schedule(long priority, Task task, unsigned workerLimit)
+{
+  // Counting per thread keeps producers from contending on yet another shared counter.
+  const bool sampled = (tScheduleCount++ % kWaitSampleInterval == 0);
+  const uint64_t time = (sampled || task.deadline != 0) ? now() : 0;
+  task.enqueueTime = sampled ? time : 0;
+  const Lane lane = (task.deadline != 0 && task.deadline <= time + urgentHorizon()) ? Urgent : Regular;
+
+  // Count the task before it becomes visible so that depth never drops below zero, and so that a retiring worker that
+  // sees a depth of zero can be sure the next schedule() call sees its slot as free.
+  const size_t depth = _depth.fetch_add(1) + 1;
+  storeMax(_maxDepth, depth);
+
+  Level &level = levelFor(priority, lane);
+  // Once a ring overflowed, newer tasks queue up behind the overflow until it drained, to keep the order of the level.
+  if (level.overflowCount.load(std::memory_order_acquire) > 0 || !level.ring.tryPush(task)) {
+    std::lock_guard<std::mutex> l(level.overflowMutex);
+    level.overflow.push_back(task);
+    level.overflowCount.fetch_add(1, std::memory_order_release);
+  }
+
+  workerLimit = std::max(1u, std::min(workerLimit, kMaxWorkers));
+  uint32_t workers = _workers.load();
+  while (true) {
+    if ((unsigned)__builtin_popcount(workers) >= workerLimit) {
+      return;
+    }
+    const unsigned worker = (unsigned)__builtin_ctz(~workers);
+    if (_workers.compare_exchange_weak(workers, workers | (1u << worker))) {
+      _spawn(*this, worker, _spawnContext);
+      return;
+    }
+  }
+}
+
+bool TransactionScheduler::popLevel(Level &level, Task &task)
+{
+  if (level.ring.tryPop(task)) {
+    if (level.overflowCount.load(std::memory_order_acquire) > 0) {
+      // Refill the ring from the overflow so that it drains in order.
+      std::lock_guard<std::mutex> l(level.overflowMutex);
+      while (!level.overflow.empty() && level.ring.tryPush(level.overflow.front())) {
+        level.overflow.pop_front();
+        level.overflowCount.fetch_sub(1, std::memory_order_release);
+      }
+    }
+    return true;
+  }
+  if (level.overflowCount.load(std::memory_order_acquire) > 0) {
+    std::lock_guard<std::mutex> l(level.overflowMutex);
+    if (!level.overflow.empty()) {
+      task = level.overflow.front();
+      level.overflow.pop_front();
+      level.overflowCount.fetch_sub(1, std::memory_order_release);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TransactionScheduler::pop(bool roundRobin, Task &task)
+{
+  const uint64_t order = _levelOrder.load(std::memory_order_acquire);
+  const unsigned count = levelCount(order);
+  if (count == 0) {
+    return false;
+  }
+  const unsigned start = roundRobin ? _rotation.fetch_add(1, std::memory_order_relaxed) % count : 0;
+  for (unsigned i = 0; i < count; i++) {
+    if (popLevel(*_levels[levelAt(order, (start + i) % count)], task)) {
+      _depth.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void TransactionScheduler::run(const Task &task)
+{
+  if (task.isStale != nullptr && task.isStale(task.context)) {
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+    task.drop(task.context);
+    return;
+  }
+
+  const uint64_t time = (task.enqueueTime != 0 || task.deadline != 0) ? now() : 0;
+  if (task.enqueueTime != 0) {
+    const uint64_t wait = time - task.enqueueTime;
+    _waitSamples.fetch_add(1, std::memory_order_relaxed);
+    _totalWait.fetch_add(wait, std::memory_order_relaxed);
+    storeMax(_maxWait, wait);
+  }
+  if (task.deadline != 0 && time > task.deadline) {
+    _missedDeadlines.fetch_add(1, std::memory_order_relaxed);
+  }
+  // Counted before running, so that whoever waits for the task to finish also sees it counted.
+  _executed.fetch_add(1, std::memory_order_relaxed);
+  task.invoke(task.context);
+}
+
+void TransactionScheduler::drain(unsigned worker)
+{
+  // The first worker visits every priority in turn, the same way the first thread used to take operations in queue
+  // order, so that a steady stream of high priority work cannot starve the rest. All others go by priority.
+  const bool roundRobin = (worker == 0);
+  const uint32_t bit = 1u << worker;
+  while (true) {
+    Task task;
+    while (pop(roundRobin, task)) {
+      run(task);
+    }
+
+    // Retire, then check once more: a task scheduled before our slot became free may not have spawned a worker.
+    _workers.fetch_and(~bit);
+    if (_depth.load() == 0) {
+      return;
+    }
+    uint32_t workers = _workers.load();
+    do {
+      if (workers & bit) {
+        // schedule() already handed our slot to a new worker.
+        return;
+      }
+    } while (!_workers.compare_exchange_weak(workers, workers | bit));
+  }
+}
+
+TransactionScheduler::Statistics TransactionScheduler::statistics() const
+{
+  return {
+    _depth.load(std::memory_order_relaxed),
+    _maxDepth.load(std::memory_order_relaxed),
+    _executed.load(std::memory_order_relaxed),
+    _waitSamples.load(std::memory_order_relaxed),
+    _totalWait.load(std::memory_order_relaxed),
+    _maxWait.load(std::memory_order_relaxed),
+    _dropped.load(std::memory_order_relaxed),
+    _missedDeadlines.load(std::memory_order_relaxed),
+  };
+}
+
+void TransactionScheduler::resetStatistics()
+{
+  _maxDepth.store(_depth.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  _executed.store(0, std::memory_order_relaxed);
+  _waitSamples.store(0, std::memory_order_relaxed);
+  _totalWait.store(0, std::memory_order_relaxed);
+  _maxWait.store(0, std::memory_order_relaxed);
+  _dropped.store(0, std::memory_order_relaxed);
+  _missedDeadlines.store(0, std::memory_order_relaxed);
+}
+
+} // namespace AS
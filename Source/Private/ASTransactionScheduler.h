@@ -0,0 +1,240 @@
+//
+//  ASTransactionScheduler.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+// Plain C++11 so that the scheduler behind _ASAsyncTransaction can be built, stress-tested and benchmarked on any host.
+// See Benchmarks/TransactionScheduler.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace AS {
+
+/**
+ * A bounded lock-free multi-producer multi-consumer queue (D. Vyukov's ring buffer). Every slot carries a sequence
+ * number that tells producers and consumers whether it is free or filled for the current lap, so both sides only
+ * contend on one atomic counter each.
+ */
+template <typename T>
+class MPMCRingQueue {
+public:
+  /** capacity must be a power of two. */
+  explicit MPMCRingQueue(size_t capacity) : _cells(new Cell[capacity]), _mask(capacity - 1), _enqueuePosition(0), _dequeuePosition(0)
+  {
+    for (size_t i = 0; i < capacity; i++) {
+      _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MPMCRingQueue(const MPMCRingQueue &) = delete;
+  MPMCRingQueue &operator=(const MPMCRingQueue &) = delete;
+
+  /** Returns false if the queue is full. */
+  bool tryPush(const T &value)
+  {
+    Cell *cell;
+    size_t position = _enqueuePosition.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &_cells[position & _mask];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+      if (difference == 0) {
+        if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = _enqueuePosition.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = value;
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  /** Returns false if the queue is empty. */
+  bool tryPop(T &value)
+  {
+    Cell *cell;
+    size_t position = _dequeuePosition.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &_cells[position & _mask];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+      if (difference == 0) {
+        if (_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = _dequeuePosition.load(std::memory_order_relaxed);
+      }
+    }
+    value = cell->value;
+    cell->sequence.store(position + _mask + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  // Padding keeps the producer and the consumer counter on separate cache lines.
+  std::unique_ptr<Cell[]> _cells;
+  const size_t _mask;
+  char _padding0[64];
+  std::atomic<size_t> _enqueuePosition;
+  char _padding1[64];
+  std::atomic<size_t> _dequeuePosition;
+  char _padding2[64];
+};
+
+/**
+ * Runs the operations of async transactions on a pool of workers, highest priority first.
+ *
+ * Every distinct priority gets its own lock-free ring queue, so scheduling and dequeuing never take a lock unless a ring
+ * overflows. Workers are spawned on demand up to a limit and retire when there is nothing left to do; the first worker
+ * visits the priorities round-robin so that low priority work cannot starve.
+ *
+ * Tasks may carry a deadline. Within a priority, tasks due within kUrgentHorizonFrames display frames of being
+ * scheduled, e.g. the display of a node that is already visible, get a queue of their own that is drained before the
+ * rest. Tasks may also carry a
+ * staleness check, which is evaluated right before the task would start; stale tasks are dropped instead of run.
+ */
+class TransactionScheduler {
+public:
+  struct Task {
+    void (*invoke)(void *context);
+    void *context;
+    /** Called instead of invoke if the task is stale by the time it would start. Required if isStale is set. */
+    void (*drop)(void *context);
+    /** Optional. */
+    bool (*isStale)(void *context);
+    /** The now() by which the task should have finished, or 0 if it has no deadline. */
+    uint64_t deadline;
+    /** Set by schedule(): the time the task was scheduled if its wait is sampled, 0 otherwise. */
+    uint64_t enqueueTime;
+  };
+
+  struct Statistics {
+    /** Tasks scheduled but not started. */
+    size_t depth;
+    size_t maxDepth;
+    /** Tasks started. */
+    size_t executed;
+    /**
+     * Reading the clock costs about as much as scheduling a task, so the time between scheduling and starting a task is
+     * only measured for one in kWaitSampleInterval tasks. Both wait times cover those samples only.
+     */
+    size_t waitSamples;
+    uint64_t totalWaitNanoseconds;
+    uint64_t maxWaitNanoseconds;
+    /** Tasks that were stale when they were about to start. */
+    size_t dropped;
+    /** Tasks with a deadline that only started after it had passed. */
+    size_t missedDeadlines;
+  };
+
+  /**
+   * Starts a thread of execution that calls drain(worker) on the scheduler, e.g. by dispatching onto the queue the
+   * scheduler's tasks must run on.
+   */
+  typedef void (*SpawnFunction)(TransactionScheduler &scheduler, unsigned worker, void *context);
+
+  static const unsigned kMaxWorkers = 32;
+  /**
+   * Queues for distinct priorities and lanes. Further priorities share the queue of the closest priority in the same
+   * lane.
+   */
+  static const unsigned kMaxLevels = 12;
+  static const size_t kRingCapacity = 1024;
+  static const unsigned kWaitSampleInterval = 8;
+  /** Tasks due within this many frames of being scheduled go ahead of other tasks of their priority. */
+  static const uint64_t kUrgentHorizonFrames = 2;
+  /** The frame duration in nanoseconds until setFrameDuration() is called, that of a 60Hz display. */
+  static const uint64_t kDefaultFrameDuration = 1000 * 1000 * 1000 / 60;
+
+  TransactionScheduler(SpawnFunction spawn, void *spawnContext);
+  ~TransactionScheduler();
+
+  TransactionScheduler(const TransactionScheduler &) = delete;
+  TransactionScheduler &operator=(const TransactionScheduler &) = delete;
+
+  /** Enqueues task and spawns a worker if fewer than workerLimit are running. */
+  void schedule(long priority, Task task, unsigned workerLimit);
+
+  /** Runs tasks until none are left, then retires worker. Only called from the spawn function's thread of execution. */
+  void drain(unsigned worker);
+
+  /** Sets the duration of a frame of the display, in nanoseconds, which tasks due soon are measured in. */
+  void setFrameDuration(uint64_t frameDuration);
+
+  /** Tasks due within this many nanoseconds of being scheduled go ahead of other tasks of their priority. */
+  uint64_t urgentHorizon() const { return _urgentHorizon.load(std::memory_order_relaxed); }
+
+  Statistics statistics() const;
+  void resetStatistics();
+
+  /** Monotonic clock used for wait times and deadlines. */
+  static uint64_t now();
+
+private:
+  enum Lane : unsigned { Urgent, Regular };
+
+  struct Level {
+    Level(long priority, Lane lane) : priority(priority), lane(lane), ring(kRingCapacity) {}
+    const long priority;
+    const Lane lane;
+    MPMCRingQueue<Task> ring;
+    /** Used only while the ring is full. */
+    std::mutex overflowMutex;
+    std::deque<Task> overflow;
+    std::atomic<size_t> overflowCount{0};
+  };
+
+  Level &levelFor(long priority, Lane lane);
+  bool pop(bool roundRobin, Task &task);
+  bool popLevel(Level &level, Task &task);
+  void run(const Task &task);
+
+  SpawnFunction _spawn;
+  void *_spawnContext;
+  std::atomic<uint64_t> _urgentHorizon;
+
+  std::unique_ptr<Level> _levels[kMaxLevels];
+  /**
+   * The number of levels in the lowest four bits, followed by their indexes in the order they are drained, four bits
+   * each. Republished whenever a level is added so that readers can walk the levels in order without a lock.
+   */
+  std::atomic<uint64_t> _levelOrder;
+  std::mutex _levelMutex;
+
+  /** Bit i is set while worker i is running. */
+  std::atomic<uint32_t> _workers;
+  std::atomic<unsigned> _rotation;
+
+  std::atomic<size_t> _depth;
+  std::atomic<size_t> _maxDepth;
+  std::atomic<size_t> _executed;
+  std::atomic<size_t> _waitSamples;
+  std::atomic<uint64_t> _totalWait;
+  std::atomic<uint64_t> _maxWait;
+  std::atomic<size_t> _dropped;
+  std::atomic<size_t> _missedDeadlines;
+};
+
+} // namespace AS
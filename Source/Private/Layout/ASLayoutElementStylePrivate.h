@@ -26,6 +26,12 @@
  */
 @property (nonatomic, readonly) ASLayoutElementSize size;
 
+/**
+ * @abstract Incremented whenever any property of the style changes. Used to tell whether a layout that was calculated
+ * with this style is still valid.
+ */
+@property (nonatomic, readonly) NSUInteger generation;
+
 @property (nonatomic, assign) ASStackLayoutAlignItems parentAlignStyle;
 
 @end
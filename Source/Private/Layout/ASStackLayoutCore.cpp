@@ -0,0 +1,1084 @@
+//
+//  ASStackLayoutCore.cpp
+//  Texture
+//
+//  Copyright (c) Facebook, Inc. and its affiliates.  All rights reserved.
+//  Changes after 4/13/2017 are: Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#include "ASStackLayoutCore.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+namespace AS {
+namespace StackLayout {
+
+const Float kViolationEpsilon = 0.01;
+
+const Float kParentDimensionUndefined = NAN;
+
+Size clamp(const SizeRange &sizeRange, const Size &size)
+{
+  return {std::max(sizeRange.min.width, std::min(sizeRange.max.width, size.width)),
+          std::max(sizeRange.min.height, std::min(sizeRange.max.height, size.height))};
+}
+
+void LayoutStorage::reset(const size_t count)
+{
+  sizes.resize(count);
+  ascenders.resize(count);
+  descenders.resize(count);
+  flexGrow.resize(count);
+  flexShrink.resize(count);
+  stackSizes.resize(count);
+  adjustments.resize(count);
+  lines.clear();
+}
+
+/** Storages beyond this many per thread are freed rather than kept for reuse. */
+static const size_t kLayoutArenaMaxFreeStorages = 8;
+/** Storages that have grown beyond this many items are freed so that one huge stack does not pin its memory. */
+static const size_t kLayoutArenaMaxRetainedItems = 4096;
+
+namespace {
+struct LayoutStorageFreeList {
+  std::vector<LayoutStorage *> storages;
+
+  ~LayoutStorageFreeList()
+  {
+    for (LayoutStorage *storage : storages) {
+      delete storage;
+    }
+  }
+};
+}
+
+static LayoutStorageFreeList &currentFreeList()
+{
+  static thread_local LayoutStorageFreeList freeList;
+  return freeList;
+}
+
+LayoutArena::Lease LayoutArena::acquire(const size_t count)
+{
+  auto &storages = currentFreeList().storages;
+  LayoutStorage *storage;
+  if (storages.empty()) {
+    storage = new LayoutStorage();
+  } else {
+    storage = storages.back();
+    storages.pop_back();
+  }
+  storage->reset(count);
+  return Lease(storage);
+}
+
+void LayoutArena::Recycler::operator()(LayoutStorage *storage) const
+{
+  auto &storages = currentFreeList().storages;
+  if (storages.size() < kLayoutArenaMaxFreeStorages && storage->sizes.capacity() <= kLayoutArenaMaxRetainedItems) {
+    storages.push_back(storage);
+  } else {
+    delete storage;
+  }
+}
+
+static Float floorPixelValue(const Float f, const Float scale)
+{
+  // Matches ASFloorPixelValue, see ASInternalHelpers.mm for the FLT_EPSILON rationale.
+  return std::floor((f + FLT_EPSILON) * scale) / scale;
+}
+
+static Float resolveCrossDimensionMaxForStretchChild(const Style &style,
+                                                     const Child &child,
+                                                     const Float crossMax)
+{
+  // stretched children may have a cross direction max that is smaller than the minimum size constraint of the parent.
+  const Float computedMax = crossDimension(style.direction, child.resolvedSize.max);
+  return computedMax == INFINITY ? crossMax : computedMax;
+}
+
+static Float resolveCrossDimensionMinForStretchChild(const Style &style,
+                                                     const Child &child,
+                                                     const Float crossMin)
+{
+  // stretched children will have a cross dimension of at least crossMin, unless they explicitly define a child size
+  // that is smaller than the constraint of the parent.
+  const Float computedMin = crossDimension(style.direction, child.resolvedSize.min);
+  return computedMin != 0 ? computedMin : crossMin;
+}
+
+/**
+ Sizes the child given the parameters specified, and returns the computed measurement.
+ */
+static Measurement crossChildMeasurement(Measurer &measurer,
+                                         const size_t index,
+                                         const Child &child,
+                                         const Style &style,
+                                         const Float stackMin,
+                                         const Float stackMax,
+                                         const Float crossMin,
+                                         const Float crossMax,
+                                         const Size &parentSize)
+{
+  const AlignItems alignItems = alignment(child.alignSelf, style.alignItems);
+  // stretched children will have a cross dimension of at least crossMin
+  const Float childCrossMin = (alignItems == AlignItems::Stretch ?
+                               resolveCrossDimensionMinForStretchChild(style, child, crossMin) :
+                               0);
+  const Float childCrossMax = (alignItems == AlignItems::Stretch ?
+                               resolveCrossDimensionMaxForStretchChild(style, child, crossMax) :
+                               crossMax);
+  const SizeRange childSizeRange = directionSizeRange(style.direction, stackMin, stackMax, childCrossMin, childCrossMax);
+  return measurer.measure(index, childSizeRange, parentSize);
+}
+
+template <typename Work>
+static void applyIfNeeded(Measurer &measurer, const size_t iterationCount, const bool concurrent, const Work &work)
+{
+  if (iterationCount == 0) {
+    return;
+  }
+
+  if (iterationCount == 1) {
+    work(0);
+    return;
+  }
+
+  // TODO Once the locking situation in ASDisplayNode has improved, always dispatch if on main
+  if (!concurrent) {
+    for (size_t i = 0; i < iterationCount; i++) {
+      work(i);
+    }
+    return;
+  }
+
+  measurer.apply(iterationCount, work);
+}
+
+/**
+ Computes the consumed cross dimension length for the given vector of lines and stacking style.
+ 
+          Cross Dimension
+          +--------------------->
+          +--------+ +--------+ +--------+ +---------+
+ Vertical |Vertical| |Vertical| |Vertical| |Vertical |
+ Stack    | Line 1 | | Line 2 | | Line 3 | | Line 4  |
+          |        | |        | |        | |         |
+          +--------+ +--------+ +--------+ +---------+
+                      crossDimensionSum
+          |------------------------------------------|
+
+ @param lines unpositioned lines
+ */
+static Float computeLinesCrossDimensionSum(const std::vector<Line> &lines, const Style &style)
+{
+  return std::accumulate(lines.begin(), lines.end(),
+                         // Start from default spacing between each line:
+                         lines.empty() ? 0 : style.lineSpacing * (lines.size() - 1),
+                         [&](Float x, const Line &l) {
+                           return x + l.crossSize;
+                         });
+}
+
+/**
+ Computes the violation by comparing a cross dimension sum with the overall allowable size range for the stack.
+ 
+ Violation is the distance you would have to add to the unbounded cross-direction length of the stack spec's
+ lines in order to bring the stack within its allowed sizeRange.  The diagram below shows 3 vertical stacks, each contains 3-5 vertical lines,
+ with the different types of violation.
+ 
+          Cross Dimension
+          +--------------------->
+                                              cross size range
+                                              |------------|
+          +--------+ +--------+ +--------+ +---------+  -  -  -  -  -  -  -  -
+ Vertical |Vertical| |Vertical| |Vertical| |Vertical |     |                 ^
+ Stack 1  | Line 1 | | Line 2 | | Line 3 | | Line 4  | (zero violation)      | stack size range
+          |        | |        | |        | |  |      |     |                 v
+          +--------+ +--------+ +--------+ +---------+  -  -  -  -  -  -  -  -
+                                              |            |
+          +--------+ +--------+ +--------+  -  -  -  -  -  -  -  -  -  -  -  -
+ Vertical |        | |        | |        |    |            |                 ^
+ Stack 2  |        | |        | |        |<--> (positive violation)          | stack size range
+          |        | |        | |        |    |            |                 v
+          +--------+ +--------+ +--------+  -  -  -  -  -  -  -  -  -  -  -  -
+                                              |            |<------> (negative violation)
+          +--------+ +--------+ +--------+ +---------+ +-----------+  -  -   -
+ Vertical |        | |        | |        | |  |      | |   |       |         ^
+ Stack 3  |        | |        | |        | |         | |           |         |  stack size range
+          |        | |        | |        | |  |      | |   |       |         v
+          +--------+ +--------+ +--------+ +---------+ +-----------+  -  -   -
+ 
+ @param crossDimensionSum the consumed length of the lines in the stack along the cross dimension
+ @param style layout style to be applied to all children
+ @param sizeRange the range of allowable sizes for the stack layout spec
+ */
+Float UnpositionedLayout::computeCrossViolation(const Float crossDimensionSum,
+                                                const Style &style,
+                                                const SizeRange &sizeRange)
+{
+  const Float minCrossDimension = crossDimension(style.direction, sizeRange.min);
+  const Float maxCrossDimension = crossDimension(style.direction, sizeRange.max);
+  if (crossDimensionSum < minCrossDimension) {
+    return minCrossDimension - crossDimensionSum;
+  } else if (crossDimensionSum > maxCrossDimension) {
+    return maxCrossDimension - crossDimensionSum;
+  }
+  return 0;
+}
+
+/**
+ Stretches children to lay out along the cross axis according to the alignment stretch settings of the children
+ (child.alignSelf), and the stack layout's alignment settings (style.alignItems).  This does not do the actual alignment
+ of the items once stretched though; PositionedLayout will do centering etc.
+
+ Finds the maximum cross dimension among child layouts.  If that dimension exceeds the minimum cross layout size then
+ we must stretch any children whose alignItems specify ASStackLayoutAlignItemsStretch.
+
+ The diagram below shows 3 children in a horizontal stack.  The second child is larger than the minCrossDimension, so
+ its height is used as the childCrossMax.  Any children that are stretchable (which may be all children if
+ style.alignItems specifies stretch) like the first child must be stretched to match that maximum.  All children must be
+ at least minCrossDimension in cross dimension size, which is shown by the sizing of the third child.
+
+                 Stack Dimension
+                 +--------------------->
+              +  +-+-------------+-+-------------+--+---------------+  + + +
+              |    | child.      | |             |  |               |  | | |
+              |    | alignSelf   | |             |  |               |  | | |
+ Cross        |    | = stretch   | |             |  +-------+-------+  | | |
+ Dimension    |    +-----+-------+ |             |  |       |       |  | | |
+              |    |     |       | |             |          |          | | |
+              |          |         |             |  |       v       |  | | |
+              v  +-+- - - - - - -+-+ - - - - - - +--+- - - - - - - -+  | | + minCrossDimension
+                         |         |             |                     | |
+                   |     v       | |             |                     | |
+                   +- - - - - - -+ +-------------+                     | + childCrossMax
+                                                                       |
+                 +--------------------------------------------------+  + crossMax
+
+ @param storage measurements of the items; modified in-place as needed
+ @param line the line whose items to stretch
+ @param style the layout style of the overall stack layout
+ */
+static void stretchItemsAlongCrossDimension(LayoutStorage &storage,
+                                            const Line &line,
+                                            const std::vector<Child> &children,
+                                            const Style &style,
+                                            const bool concurrent,
+                                            const Size &parentSize,
+                                            Measurer &measurer)
+{
+  const Float crossSize = line.crossSize;
+  applyIfNeeded(measurer, line.count(), concurrent, [&](size_t i) {
+    const size_t index = line.begin + i;
+    const auto &child = children[index];
+    const AlignItems alignItems = alignment(child.alignSelf, style.alignItems);
+    if (alignItems == AlignItems::Stretch) {
+      const Float cross = crossDimension(style.direction, storage.sizes[index]);
+      const Float stack = stackDimension(style.direction, storage.sizes[index]);
+      const Float violation = crossSize - cross;
+
+      // Only stretch if violation is positive. Compare against kViolationEpsilon here to avoid stretching against a tiny violation.
+      if (violation > kViolationEpsilon) {
+        storage.setMeasurement(index, crossChildMeasurement(measurer, index, child, style, stack, stack, crossSize, crossSize, parentSize));
+      }
+    }
+  });
+}
+
+/**
+ * Stretch lines and their items according to alignContent, alignItems and alignSelf.
+ * https://www.w3.org/TR/css-flexbox-1/#algo-line-stretch
+ * https://www.w3.org/TR/css-flexbox-1/#algo-stretch
+ */
+static void stretchLinesAlongCrossDimension(LayoutStorage &storage,
+                                            const std::vector<Child> &children,
+                                            const Style &style,
+                                            const bool concurrent,
+                                            const SizeRange &sizeRange,
+                                            const Size &parentSize,
+                                            Measurer &measurer)
+{
+  auto &lines = storage.lines;
+  assert(!lines.empty());
+  const std::size_t numOfLines = lines.size();
+  const Float violation = UnpositionedLayout::computeCrossViolation(computeLinesCrossDimensionSum(lines, style), style, sizeRange);
+  // Don't stretch if the stack is single line, because the line's cross size was clamped against the stack's constrained size.
+  const bool shouldStretchLines = (numOfLines > 1
+                                   && style.alignContent == AlignContent::Stretch
+                                   && violation > kViolationEpsilon);
+
+  Float extraCrossSizePerLine = violation / numOfLines;
+  for (auto &line : lines) {
+    if (shouldStretchLines) {
+      line.crossSize += extraCrossSizePerLine;
+    }
+
+    stretchItemsAlongCrossDimension(storage, line, children, style, concurrent, parentSize, measurer);
+  }
+}
+
+static bool itemIsBaselineAligned(const Style &style, const Child &child)
+{
+  AlignItems alignItems = alignment(child.alignSelf, style.alignItems);
+  return alignItems == AlignItems::BaselineFirst || alignItems == AlignItems::BaselineLast;
+}
+
+Float UnpositionedLayout::baselineForItem(const Style &style, const Child &child, const Measurement &measurement)
+{
+  switch (alignment(child.alignSelf, style.alignItems)) {
+    case AlignItems::BaselineFirst:
+      return measurement.ascender;
+    case AlignItems::BaselineLast:
+      return crossDimension(style.direction, measurement.size) + measurement.descender;
+    default:
+      return 0;
+  }
+}
+
+/**
+ * Computes cross size and baseline of each line.
+ * https://www.w3.org/TR/css-flexbox-1/#algo-cross-line
+ */
+static void computeLinesCrossSizeAndBaseline(LayoutStorage &storage,
+                                             const std::vector<Child> &children,
+                                             const Style &style,
+                                             const SizeRange &sizeRange)
+{
+  auto &lines = storage.lines;
+  assert(!lines.empty());
+  const bool isSingleLine = (lines.size() == 1);
+
+  const auto minCrossSize = crossDimension(style.direction, sizeRange.min);
+  const auto maxCrossSize = crossDimension(style.direction, sizeRange.max);
+  const bool definiteCrossSize = (minCrossSize == maxCrossSize);
+
+  // If the stack is single-line and has a definite cross size, the cross size of the line is the stack's definite cross size.
+  if (isSingleLine && definiteCrossSize) {
+    auto &line = lines[0];
+    line.crossSize = minCrossSize;
+
+    // We still need to determine the line's baseline
+    for (size_t index = line.begin; index < line.end; index++) {
+      const auto &child = children[index];
+      if (itemIsBaselineAligned(style, child)) {
+        Float baseline = UnpositionedLayout::baselineForItem(style, child, storage.measurement(index));
+        line.baseline = std::max(line.baseline, baseline);
+      }
+    }
+
+    return;
+  }
+
+  for (auto &line : lines) {
+    Float maxStartToBaselineDistance = 0;
+    Float maxBaselineToEndDistance = 0;
+    Float maxItemCrossSize = 0;
+
+    for (size_t index = line.begin; index < line.end; index++) {
+      const auto &child = children[index];
+      const Float itemCrossSize = crossDimension(style.direction, storage.sizes[index]);
+      if (itemIsBaselineAligned(style, child)) {
+        // Step 1. Collect all the items whose align-self is baseline. Find the largest of the distances
+        // between each item’s baseline and its hypothetical outer cross-start edge (aka. its baseline value),
+        // and the largest of the distances between each item’s baseline and its hypothetical outer cross-end edge,
+        // and sum these two values.
+        Float baseline = UnpositionedLayout::baselineForItem(style, child, storage.measurement(index));
+        maxStartToBaselineDistance = std::max(maxStartToBaselineDistance, baseline);
+        maxBaselineToEndDistance = std::max(maxBaselineToEndDistance, itemCrossSize - baseline);
+      } else {
+        // Step 2. Among all the items not collected by the previous step, find the largest outer hypothetical cross size.
+        maxItemCrossSize = std::max(maxItemCrossSize, itemCrossSize);
+      }
+    }
+
+    // Step 3. The used cross-size of the flex line is the largest of the numbers found in the previous two steps and zero.
+    line.crossSize = std::max(maxStartToBaselineDistance + maxBaselineToEndDistance, maxItemCrossSize);
+    if (isSingleLine) {
+      // If the stack is single-line, then clamp the line’s cross-size to be within the stack's min and max cross-size properties.
+      line.crossSize = std::min(std::max(minCrossSize, line.crossSize), maxCrossSize);
+    }
+
+    line.baseline = maxStartToBaselineDistance;
+  }
+}
+
+// Flex kernels
+//
+// Resolving the flexible lengths of a line picks one of the kernels below based on the sign of the line's violation.
+// Each kernel is a compile-time specialization that computes every item's adjustment in a single pass over the
+// line's slice of the LayoutStorage arrays.
+
+/** The flex-related values of one line's items, pointing into LayoutStorage. */
+struct FlexLineView {
+  size_t count;
+  /** Measured size of each item along the stack dimension. */
+  const Float *stackSizes;
+  const Float *flexGrow;
+  const Float *flexShrink;
+  /** Output of the adjustment pass: the amount each item grows (positive) or shrinks (negative) by. */
+  Float *adjustments;
+};
+
+template <Direction direction>
+static inline Float stackDimension(const Size &size)
+{
+  return (direction == Direction::Vertical) ? size.height : size.width;
+}
+
+static inline FlexLineView flexLineView(LayoutStorage &storage, const Line &line)
+{
+  return {
+    line.count(),
+    storage.stackSizes.data() + line.begin,
+    storage.flexGrow.data() + line.begin,
+    storage.flexShrink.data() + line.begin,
+    storage.adjustments.data() + line.begin,
+  };
+}
+
+/** Fills the flex inputs of every item; lines flex independently, so this is done once before flexing any line. */
+template <Direction direction>
+static void gatherFlexInputs(LayoutStorage &storage, const std::vector<Child> &children)
+{
+  for (size_t i = 0; i < children.size(); i++) {
+    storage.stackSizes[i] = stackDimension<direction>(storage.sizes[i]);
+    storage.flexGrow[i] = children[i].flexGrow;
+    storage.flexShrink[i] = children[i].flexShrink;
+  }
+}
+
+/** Used when the line is within its size range: nothing flexes. */
+struct NoFlexKernel {
+  static Float flexFactor(const FlexLineView &, const size_t)
+  {
+    return 0;
+  }
+
+  static void computeAdjustments(const FlexLineView &view, const Float, const Float)
+  {
+    std::fill(view.adjustments, view.adjustments + view.count, 0.0);
+  }
+};
+
+/** Distributes a positive violation proportionally to each item's flex grow factor. */
+struct FlexGrowKernel {
+  static Float flexFactor(const FlexLineView &view, const size_t i)
+  {
+    return view.flexGrow[i];
+  }
+
+  static void computeAdjustments(const FlexLineView &view, const Float violation, const Float flexFactorSum)
+  {
+    for (size_t i = 0; i < view.count; i++) {
+      view.adjustments[i] = std::floor(violation * (view.flexGrow[i] / flexFactorSum));
+    }
+  }
+};
+
+/**
+ Distributes a negative violation proportionally to each item's flex shrink factor scaled by its size. Unlike the flex
+ grow adjustment the flex shrink adjustment needs to take the size of each item into account.
+ */
+struct FlexShrinkKernel {
+  static Float flexFactor(const FlexLineView &view, const size_t i)
+  {
+    return view.flexShrink[i];
+  }
+
+  static void computeAdjustments(const FlexLineView &view, const Float violation, const Float flexFactorSum)
+  {
+    // Park each item's scaled flex shrink factor in its adjustment slot while summing them up.
+    Float scaledFlexShrinkFactorSum = 0;
+    for (size_t i = 0; i < view.count; i++) {
+      view.adjustments[i] = view.stackSizes[i] * (view.flexShrink[i] / flexFactorSum);
+      scaledFlexShrinkFactorSum += view.adjustments[i];
+    }
+    for (size_t i = 0; i < view.count; i++) {
+      if (scaledFlexShrinkFactorSum == 0.0) {
+        view.adjustments[i] = 0;
+      } else {
+        // The item should shrink proportionally to its share of the scaled flex shrink factor sum.
+        view.adjustments[i] = -std::fabs((view.adjustments[i] / scaledFlexShrinkFactorSum) * violation);
+      }
+    }
+  }
+};
+
+template <typename Kernel>
+static Float flexFactorSum(const FlexLineView &view)
+{
+  Float sum = 0;
+  for (size_t i = 0; i < view.count; i++) {
+    sum += Kernel::flexFactor(view, i);
+  }
+  return sum;
+}
+
+static inline bool isFlexibleInBothDirections(const Child &child)
+{
+  return child.flexGrow > 0 && child.flexShrink > 0;
+}
+
+/**
+ The flexible children may have been left not laid out in the initial layout pass, so we may have to go through and size
+ these children at zero size so that the children layouts are at least present.
+ */
+static void layoutFlexibleChildrenAtZeroSize(LayoutStorage &storage,
+                                             const Line &line,
+                                             const std::vector<Child> &children,
+                                             const Style &style,
+                                             const bool concurrent,
+                                             const SizeRange &sizeRange,
+                                             const Size &parentSize,
+                                             Measurer &measurer)
+{
+  applyIfNeeded(measurer, line.count(), concurrent, [&](size_t i) {
+    const size_t index = line.begin + i;
+    const auto &child = children[index];
+    if (isFlexibleInBothDirections(child)) {
+      storage.setMeasurement(index, crossChildMeasurement(measurer,
+                                                          index,
+                                                          child,
+                                                          style,
+                                                          0,
+                                                          0,
+                                                          crossDimension(style.direction, sizeRange.min),
+                                                          crossDimension(style.direction, sizeRange.max),
+                                                          parentSize));
+    }
+  });
+}
+
+/**
+ Computes the consumed stack dimension length for the given vector of items and stacking style.
+
+              stackDimensionSum
+          <----------------------->
+          +-----+  +-------+  +---+
+          |     |  |       |  |   |
+          |     |  |       |  |   |
+          +-----+  |       |  +---+
+                   +-------+
+
+ @param storage measurements of the items
+ @param begin index of the first item to sum
+ @param end index past the last item to sum
+ @param style the layout style of the overall stack layout
+ */
+static Float computeItemsStackDimensionSum(const LayoutStorage &storage,
+                                           const size_t begin,
+                                           const size_t end,
+                                           const std::vector<Child> &children,
+                                           const Style &style)
+{
+  // Sum up the children's spacing, starting from default spacing between each child.
+  Float childSpacingSum = (begin == end ? 0 : style.spacing * (end - begin - 1));
+  for (size_t i = begin; i < end; i++) {
+    childSpacingSum += children[i].spacingBefore + children[i].spacingAfter;
+  }
+
+  // Sum up the children's dimensions (including spacing) in the stack direction.
+  Float childStackDimensionSum = childSpacingSum;
+  for (size_t i = begin; i < end; i++) {
+    childStackDimensionSum += stackDimension(style.direction, storage.sizes[i]);
+  }
+  return childStackDimensionSum;
+}
+
+/**
+ Computes the violation by comparing a stack dimension sum with the overall allowable size range for the stack.
+
+ Violation is the distance you would have to add to the unbounded stack-direction length of the stack spec's
+ children in order to bring the stack within its allowed sizeRange.  The diagram below shows 3 horizontal stacks with
+ the different types of violation.
+
+                                          sizeRange
+                                       |------------|
+       +------+ +-------+ +-------+ +---------+
+       |      | |       | |       | |  |      |     |
+       |      | |       | |       | |         | (zero violation)
+       |      | |       | |       | |  |      |     |
+       +------+ +-------+ +-------+ +---------+
+                                       |            |
+       +------+ +-------+ +-------+
+       |      | |       | |       |    |            |
+       |      | |       | |       |<--> (positive violation)
+       |      | |       | |       |    |            |
+       +------+ +-------+ +-------+
+                                       |            |<------> (negative violation)
+       +------+ +-------+ +-------+ +---------+ +-----------+
+       |      | |       | |       | |  |      | |   |       |
+       |      | |       | |       | |         | |           |
+       |      | |       | |       | |  |      | |   |       |
+       +------+ +-------+ +-------+ +---------+ +-----------+
+
+ @param stackDimensionSum the consumed length of the children in the stack along the stack dimension
+ @param style layout style to be applied to all children
+ @param sizeRange the range of allowable sizes for the stack layout spec
+ */
+Float UnpositionedLayout::computeStackViolation(const Float stackDimensionSum,
+                                                const Style &style,
+                                                const SizeRange &sizeRange)
+{
+  const Float minStackDimension = stackDimension(style.direction, sizeRange.min);
+  const Float maxStackDimension = stackDimension(style.direction, sizeRange.max);
+  if (stackDimensionSum < minStackDimension) {
+    return minStackDimension - stackDimensionSum;
+  } else if (stackDimensionSum > maxStackDimension) {
+    return maxStackDimension - stackDimensionSum;
+  }
+  return 0;
+}
+
+/**
+ If we have a single flexible (both shrinkable and growable) child, and our allowed size range is set to a specific
+ number then we may avoid the first "intrinsic" size calculation.
+ */
+static inline bool useOptimizedFlexing(const std::vector<Child> &children,
+                                       const Style &style,
+                                       const SizeRange &sizeRange)
+{
+  const auto flexibleChildren = std::count_if(children.begin(), children.end(), isFlexibleInBothDirections);
+  return ((flexibleChildren == 1)
+          && (stackDimension(style.direction, sizeRange.min) ==
+              stackDimension(style.direction, sizeRange.max)));
+}
+
+/**
+ Flexes children in the stack axis to resolve a min or max stack size violation. First, determines which children are
+ flexible (see computeStackViolation and isFlexibleInViolationDirection). Then computes how much to flex each flexible child
+ and performs re-layout. Note that there may still be a non-zero violation even after flexing.
+
+ The actual CSS flexbox spec describes an iterative looping algorithm here, which may be adopted in t5837937:
+ http://www.w3.org/TR/css3-flexbox/#resolve-flexible-lengths
+
+ @param storage unpositioned lines and items from the original, unconstrained layout pass; modified in-place
+ @param style layout style to be applied to all children
+ @param sizeRange the range of allowable sizes for the stack layout component
+ @param parentSize Size of the stack layout component. May be undefined in either or both directions.
+ */
+template <typename Kernel>
+static void flexLineAlongStackDimension(LayoutStorage &storage,
+                                        const Line &line,
+                                        const FlexLineView &view,
+                                        const Float violation,
+                                        const std::vector<Child> &children,
+                                        const Style &style,
+                                        const bool concurrent,
+                                        const SizeRange &sizeRange,
+                                        const Size &parentSize,
+                                        const bool useOptimizedFlexing,
+                                        Measurer &measurer)
+{
+  // The flex factor sum is needed to determine if flexing is necessary.
+  // This value is also needed if the violation is positive and flexible items need to grow, so keep it around.
+  const Float factorSum = flexFactorSum<Kernel>(view);
+
+  // If no items are able to flex then there is nothing left to do with this line. Bail.
+  if (factorSum == 0) {
+    // If optimized flexing was used then we have to clean up the unsized items and lay them out at zero size.
+    if (useOptimizedFlexing) {
+      layoutFlexibleChildrenAtZeroSize(storage, line, children, style, concurrent, sizeRange, parentSize, measurer);
+    }
+    return;
+  }
+
+  Kernel::computeAdjustments(view, violation, factorSum);
+
+  // Compute any remaining violation to the first flexible item.
+  Float remainingViolation = violation;
+  size_t firstFlexItem = -1;
+  for (size_t i = 0; i < view.count; i++) {
+    remainingViolation -= view.adjustments[i];
+    // Items are consider inflexible if they do not need to make a flex adjustment.
+    if (firstFlexItem == (size_t)-1 && view.adjustments[i] != 0) {
+      firstFlexItem = i;
+    }
+  }
+  if (firstFlexItem == (size_t)-1) {
+    return;
+  }
+
+  applyIfNeeded(measurer, view.count, concurrent, [&](size_t i) {
+    const Float currentFlexAdjustment = view.adjustments[i];
+    // Items are consider inflexible if they do not need to make a flex adjustment.
+    if (currentFlexAdjustment != 0) {
+      const size_t index = line.begin + i;
+      const auto &child = children[index];
+      // Only apply the remaining violation for the first flexible item that has a flex grow factor.
+      const Float flexedStackSize = view.stackSizes[i] + currentFlexAdjustment + (i == firstFlexItem && child.flexGrow > 0 ? remainingViolation : 0);
+      storage.setMeasurement(index, crossChildMeasurement(measurer,
+                                                          index,
+                                                          child,
+                                                          style,
+                                                          std::max(flexedStackSize, (Float)0),
+                                                          std::max(flexedStackSize, (Float)0),
+                                                          crossDimension(style.direction, sizeRange.min),
+                                                          crossDimension(style.direction, sizeRange.max),
+                                                          parentSize));
+    }
+  });
+}
+
+static void flexLinesAlongStackDimension(LayoutStorage &storage,
+                                         const std::vector<Child> &children,
+                                         const Style &style,
+                                         const bool concurrent,
+                                         const SizeRange &sizeRange,
+                                         const Size &parentSize,
+                                         const bool useOptimizedFlexing,
+                                         Measurer &measurer)
+{
+  if (style.direction == Direction::Vertical) {
+    gatherFlexInputs<Direction::Vertical>(storage, children);
+  } else {
+    gatherFlexInputs<Direction::Horizontal>(storage, children);
+  }
+
+  for (const auto &line : storage.lines) {
+    const FlexLineView view = flexLineView(storage, line);
+    const Float violation = UnpositionedLayout::computeStackViolation(computeItemsStackDimensionSum(storage, line.begin, line.end, children, style), style, sizeRange);
+    if (std::fabs(violation) < kViolationEpsilon) {
+      flexLineAlongStackDimension<NoFlexKernel>(storage, line, view, violation, children, style, concurrent, sizeRange, parentSize, useOptimizedFlexing, measurer);
+    } else if (violation > 0) {
+      flexLineAlongStackDimension<FlexGrowKernel>(storage, line, view, violation, children, style, concurrent, sizeRange, parentSize, useOptimizedFlexing, measurer);
+    } else {
+      flexLineAlongStackDimension<FlexShrinkKernel>(storage, line, view, violation, children, style, concurrent, sizeRange, parentSize, useOptimizedFlexing, measurer);
+    }
+  }
+}
+
+/**
+ https://www.w3.org/TR/css-flexbox-1/#algo-line-break
+ */
+static void collectChildrenIntoLines(LayoutStorage &storage,
+                                     const std::vector<Child> &children,
+                                     const Style &style,
+                                     const SizeRange &sizeRange)
+{
+  auto &lines = storage.lines;
+  //TODO if infinite max stack size, fast path
+  if (style.flexWrap == FlexWrap::NoWrap) {
+    lines.push_back({0, children.size(), 0, 0, 0});
+    return;
+  }
+
+  size_t lineBegin = 0;
+  Float lineStackDimensionSum = 0;
+  Float interitemSpacing = 0;
+
+  for (size_t index = 0; index < children.size(); index++) {
+    const auto &child = children[index];
+    const Float itemStackDimension = stackDimension(style.direction, storage.sizes[index]);
+    const Float itemAndSpacingStackDimension = child.spacingBefore + itemStackDimension + child.spacingAfter;
+    const bool negativeViolationIfAddItem = (UnpositionedLayout::computeStackViolation(lineStackDimensionSum + interitemSpacing + itemAndSpacingStackDimension, style, sizeRange) < 0);
+    const bool breakCurrentLine = negativeViolationIfAddItem && index > lineBegin;
+
+    if (breakCurrentLine) {
+      lines.push_back({lineBegin, index, 0, 0, 0});
+      lineBegin = index;
+      lineStackDimensionSum = 0;
+      interitemSpacing = 0;
+    }
+
+    lineStackDimensionSum += interitemSpacing + itemAndSpacingStackDimension;
+    interitemSpacing = style.spacing;
+  }
+
+  // Handle last line
+  lines.push_back({lineBegin, children.size(), 0, 0, 0});
+}
+
+/**
+ Performs the first unconstrained layout of the children, generating the unpositioned items that are then flexed and
+ stretched.
+ */
+static void layoutItemsAlongUnconstrainedStackDimension(LayoutStorage &storage,
+                                                        const std::vector<Child> &children,
+                                                        const Style &style,
+                                                        const bool concurrent,
+                                                        const SizeRange &sizeRange,
+                                                        const Size &parentSize,
+                                                        const bool useOptimizedFlexing,
+                                                        Measurer &measurer)
+{
+  const Float minCrossDimension = crossDimension(style.direction, sizeRange.min);
+  const Float maxCrossDimension = crossDimension(style.direction, sizeRange.max);
+
+  applyIfNeeded(measurer, children.size(), concurrent, [&](size_t index) {
+    const auto &child = children[index];
+    if (useOptimizedFlexing && isFlexibleInBothDirections(child)) {
+      storage.setMeasurement(index, measurer.measureAtZeroSize(index));
+    } else {
+      storage.setMeasurement(index, crossChildMeasurement(measurer,
+                                                          index,
+                                                          child,
+                                                          style,
+                                                          child.flexBasis.resolve(stackDimension(style.direction, parentSize), 0),
+                                                          child.flexBasis.resolve(stackDimension(style.direction, parentSize), INFINITY),
+                                                          minCrossDimension,
+                                                          maxCrossDimension,
+                                                          parentSize));
+    }
+  });
+}
+
+UnpositionedLayout UnpositionedLayout::compute(const std::vector<Child> &children,
+                                               const Style &style,
+                                               const SizeRange &sizeRange,
+                                               const bool concurrent,
+                                               Measurer &measurer)
+{
+  LayoutArena::Lease storage = LayoutArena::acquire(children.size());
+  if (children.empty()) {
+    return {std::move(storage), 0, 0};
+  }
+
+  // If we have a fixed size in either dimension, pass it to children so they can resolve percentages against it.
+  // Otherwise, we pass kParentDimensionUndefined since it will depend on the content.
+  const Size parentSize = {
+    (sizeRange.min.width == sizeRange.max.width) ? sizeRange.min.width : kParentDimensionUndefined,
+    (sizeRange.min.height == sizeRange.max.height) ? sizeRange.min.height : kParentDimensionUndefined,
+  };
+
+  // We may be able to avoid some redundant layout passes
+  const bool optimizedFlexing = useOptimizedFlexing(children, style, sizeRange);
+
+  // We do a first pass of all the children, generating an unpositioned layout for each with an unbounded range along
+  // the stack dimension.  This allows us to compute the "intrinsic" size of each child and find the available violation
+  // which determines whether we must grow or shrink the flexible children.
+  layoutItemsAlongUnconstrainedStackDimension(*storage,
+                                              children,
+                                              style,
+                                              concurrent,
+                                              sizeRange,
+                                              parentSize,
+                                              optimizedFlexing,
+                                              measurer);
+
+  // Collect items into lines (https://www.w3.org/TR/css-flexbox-1/#algo-line-break)
+  collectChildrenIntoLines(*storage, children, style, sizeRange);
+
+  // Resolve the flexible lengths (https://www.w3.org/TR/css-flexbox-1/#resolve-flexible-lengths)
+  flexLinesAlongStackDimension(*storage, children, style, concurrent, sizeRange, parentSize, optimizedFlexing, measurer);
+
+  // Calculate the cross size of each flex line (https://www.w3.org/TR/css-flexbox-1/#algo-cross-line)
+  computeLinesCrossSizeAndBaseline(*storage, children, style, sizeRange);
+
+  // Handle 'align-content: stretch' (https://www.w3.org/TR/css-flexbox-1/#algo-line-stretch)
+  // Determine the used cross size of each item (https://www.w3.org/TR/css-flexbox-1/#algo-stretch)
+  stretchLinesAlongCrossDimension(*storage, children, style, concurrent, sizeRange, parentSize, measurer);
+
+  // Compute stack dimension sum of each line and the whole stack
+  Float layoutStackDimensionSum = 0;
+  for (auto &line : storage->lines) {
+    line.stackDimensionSum = computeItemsStackDimensionSum(*storage, line.begin, line.end, children, style);
+    // layoutStackDimensionSum is the max stackDimensionSum among all lines
+    layoutStackDimensionSum = std::max(line.stackDimensionSum, layoutStackDimensionSum);
+  }
+  // Compute cross dimension sum of the stack.
+  const Float layoutCrossDimensionSum = computeLinesCrossDimensionSum(storage->lines, style);
+
+  return {std::move(storage), layoutStackDimensionSum, layoutCrossDimensionSum};
+}
+
+// Positioning
+
+static Float crossOffsetForItem(const Measurement &measurement,
+                                const Child &child,
+                                const Style &style,
+                                const Float crossSize,
+                                const Float baseline,
+                                const Float screenScale)
+{
+  switch (alignment(child.alignSelf, style.alignItems)) {
+    case AlignItems::End:
+      return crossSize - crossDimension(style.direction, measurement.size);
+    case AlignItems::Center:
+      return floorPixelValue((crossSize - crossDimension(style.direction, measurement.size)) / 2, screenScale);
+    case AlignItems::BaselineFirst:
+    case AlignItems::BaselineLast:
+      return baseline - UnpositionedLayout::baselineForItem(style, child, measurement);
+    case AlignItems::Start:
+    case AlignItems::Stretch:
+    case AlignItems::NotSet:
+      return 0;
+  }
+  return 0;
+}
+
+static void crossOffsetAndSpacingForEachLine(const std::size_t numOfLines,
+                                             const Float crossViolation,
+                                             AlignContent alignContent,
+                                             Float &offset,
+                                             Float &spacing)
+{
+  assert(numOfLines > 0);
+
+  // Handle edge cases
+  if (alignContent == AlignContent::SpaceBetween && (crossViolation < kViolationEpsilon || numOfLines == 1)) {
+    alignContent = AlignContent::Start;
+  } else if (alignContent == AlignContent::SpaceAround && (crossViolation < kViolationEpsilon || numOfLines == 1)) {
+    alignContent = AlignContent::Center;
+  }
+
+  offset = 0;
+  spacing = 0;
+
+  switch (alignContent) {
+    case AlignContent::Center:
+      offset = crossViolation / 2;
+      break;
+    case AlignContent::End:
+      offset = crossViolation;
+      break;
+    case AlignContent::SpaceBetween:
+      // Spacing between the items, no spaces at the edges, evenly distributed
+      spacing = crossViolation / (numOfLines - 1);
+      break;
+    case AlignContent::SpaceAround: {
+      // Spacing between items are twice the spacing on the edges
+      Float spacingUnit = crossViolation / (numOfLines * 2);
+      offset = spacingUnit;
+      spacing = spacingUnit * 2;
+      break;
+    }
+    case AlignContent::Start:
+    case AlignContent::Stretch:
+      break;
+  }
+}
+
+static void stackOffsetAndSpacingForEachItem(const std::size_t numOfItems,
+                                             const Float stackViolation,
+                                             JustifyContent justifyContent,
+                                             Float &offset,
+                                             Float &spacing)
+{
+  assert(numOfItems > 0);
+
+  // Handle edge cases
+  if (justifyContent == JustifyContent::SpaceBetween && (stackViolation < kViolationEpsilon || numOfItems == 1)) {
+    justifyContent = JustifyContent::Start;
+  } else if (justifyContent == JustifyContent::SpaceAround && (stackViolation < kViolationEpsilon || numOfItems == 1)) {
+    justifyContent = JustifyContent::Center;
+  }
+
+  offset = 0;
+  spacing = 0;
+
+  switch (justifyContent) {
+    case JustifyContent::Center:
+      offset = stackViolation / 2;
+      break;
+    case JustifyContent::End:
+      offset = stackViolation;
+      break;
+    case JustifyContent::SpaceBetween:
+      // Spacing between the items, no spaces at the edges, evenly distributed
+      spacing = stackViolation / (numOfItems - 1);
+      break;
+    case JustifyContent::SpaceAround: {
+      // Spacing between items are twice the spacing on the edges
+      Float spacingUnit = stackViolation / (numOfItems * 2);
+      offset = spacingUnit;
+      spacing = spacingUnit * 2;
+      break;
+    }
+    case JustifyContent::Start:
+      break;
+  }
+}
+
+static inline Point operator+(const Point &p1, const Point &p2)
+{
+  return {p1.x + p2.x, p1.y + p2.y};
+}
+
+static inline void setStackValueToPoint(const Direction direction, const Float stack, Point &point)
+{
+  (direction == Direction::Vertical) ? (point.y = stack) : (point.x = stack);
+}
+
+static void positionItemsInLine(const LayoutStorage &storage,
+                                const Line &line,
+                                const std::vector<Child> &children,
+                                const Style &style,
+                                const Point &startingPoint,
+                                const Float stackSpacing,
+                                const Float screenScale,
+                                std::vector<Item> &positionedItems)
+{
+  Point p = startingPoint;
+  bool first = true;
+
+  for (size_t index = line.begin; index < line.end; index++) {
+    const auto &child = children[index];
+    p = p + directionPoint(style.direction, child.spacingBefore, 0);
+    if (!first) {
+      p = p + directionPoint(style.direction, style.spacing + stackSpacing, 0);
+    }
+    first = false;
+    const Measurement measurement = storage.measurement(index);
+    const Point position = p + directionPoint(style.direction, 0, crossOffsetForItem(measurement, child, style, line.crossSize, line.baseline, screenScale));
+    positionedItems.push_back({index, measurement, position});
+
+    p = p + directionPoint(style.direction, stackDimension(style.direction, measurement.size) + child.spacingAfter, 0);
+  }
+}
+
+PositionedLayout PositionedLayout::compute(const UnpositionedLayout &layout,
+                                           const std::vector<Child> &children,
+                                           const Style &style,
+                                           const SizeRange &sizeRange,
+                                           const Float screenScale)
+{
+  const auto &lines = layout.storage->lines;
+  if (lines.empty()) {
+    return {};
+  }
+
+  const auto numOfLines = lines.size();
+  const auto direction = style.direction;
+  const auto alignContent = style.alignContent;
+  const auto lineSpacing = style.lineSpacing;
+  const auto justifyContent = style.justifyContent;
+  const auto crossViolation = UnpositionedLayout::computeCrossViolation(layout.crossDimensionSum, style, sizeRange);
+  Float crossOffset;
+  Float crossSpacing;
+  crossOffsetAndSpacingForEachLine(numOfLines, crossViolation, alignContent, crossOffset, crossSpacing);
+
+  std::vector<Item> positionedItems;
+  positionedItems.reserve(children.size());
+  Point p = directionPoint(direction, 0, crossOffset);
+  bool first = true;
+  for (const auto &line : lines) {
+    if (!first) {
+      p = p + directionPoint(direction, 0, crossSpacing + lineSpacing);
+    }
+    first = false;
+
+    const auto stackViolation = UnpositionedLayout::computeStackViolation(line.stackDimensionSum, style, sizeRange);
+    Float stackOffset;
+    Float stackSpacing;
+    stackOffsetAndSpacingForEachItem(line.count(), stackViolation, justifyContent, stackOffset, stackSpacing);
+
+    setStackValueToPoint(direction, stackOffset, p);
+    positionItemsInLine(*layout.storage, line, children, style, p, stackSpacing, screenScale, positionedItems);
+
+    p = p + directionPoint(direction, -stackOffset, line.crossSize);
+  }
+
+  const Size finalSize = directionSize(direction, layout.stackDimensionSum, layout.crossDimensionSum);
+  return {std::move(positionedItems), clamp(sizeRange, finalSize)};
+}
+
+} // namespace StackLayout
+} // namespace AS
@@ -0,0 +1,302 @@
+//
+//  ASStackLayoutCore.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+// This file must stay free of Objective-C, UIKit and CoreGraphics so that the flex engine can be built, profiled and
+// fuzzed on any host with a C++11 compiler. See Benchmarks/StackLayoutCore.
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace AS {
+namespace StackLayout {
+
+typedef double Float;
+
+/** The threshold that determines if a violation has actually occurred. */
+extern const Float kViolationEpsilon;
+
+/** Mirrors ASLayoutElementParentDimensionUndefined. */
+extern const Float kParentDimensionUndefined;
+
+struct Size {
+  Float width;
+  Float height;
+};
+
+struct Point {
+  Float x;
+  Float y;
+};
+
+struct SizeRange {
+  Size min;
+  Size max;
+};
+
+// The enums below mirror their ASStackLayoutDefines.h counterparts value for value.
+
+enum class Direction : unsigned char { Vertical, Horizontal };
+
+enum class JustifyContent : unsigned char { Start, Center, End, SpaceBetween, SpaceAround };
+
+enum class AlignItems : unsigned char { Start, End, Center, Stretch, BaselineFirst, BaselineLast, NotSet };
+
+enum class AlignSelf : unsigned char { Auto, Start, End, Center, Stretch };
+
+enum class FlexWrap : unsigned char { NoWrap, Wrap };
+
+enum class AlignContent : unsigned char { Start, Center, End, SpaceBetween, SpaceAround, Stretch };
+
+/** Mirrors ASDimension. */
+struct Dimension {
+  enum class Unit : unsigned char { Auto, Points, Fraction };
+  Unit unit;
+  Float value;
+
+  Float resolve(const Float parentSize, const Float autoSize) const
+  {
+    switch (unit) {
+      case Unit::Auto:
+        return autoSize;
+      case Unit::Points:
+        return value;
+      case Unit::Fraction:
+        return value * parentSize;
+    }
+    return autoSize;
+  }
+};
+
+struct Style {
+  Direction direction;
+  Float spacing;
+  JustifyContent justifyContent;
+  AlignItems alignItems;
+  FlexWrap flexWrap;
+  AlignContent alignContent;
+  Float lineSpacing;
+};
+
+/** Plain copy of the style properties of a stack child that the flex algorithm reads. */
+struct Child {
+  Float spacingBefore;
+  Float spacingAfter;
+  Float flexGrow;
+  Float flexShrink;
+  Dimension flexBasis;
+  AlignSelf alignSelf;
+  /** The child's own size constraints resolved against an undefined parent, used when stretching. */
+  SizeRange resolvedSize;
+};
+
+/** The result of measuring a child. */
+struct Measurement {
+  Size size;
+  /** Baseline metrics of the child, read after it has been measured. */
+  Float ascender;
+  Float descender;
+};
+
+/**
+ * The host-side counterpart of the flex engine. Implementations produce the actual child layouts; the engine only ever
+ * sees their sizes.
+ */
+class Measurer {
+public:
+  virtual ~Measurer() {}
+
+  /**
+   * Measures the child at the given index within sizeRange. parentSize may contain kParentDimensionUndefined.
+   * Must be safe to call concurrently for different indexes if the engine is run with concurrent = true.
+   */
+  virtual Measurement measure(size_t index, const SizeRange &sizeRange, const Size &parentSize) = 0;
+
+  /** Produces a zero-sized layout for a flexible child that is skipped by the first layout pass. */
+  virtual Measurement measureAtZeroSize(size_t index) = 0;
+
+  /** Invokes work for each index in [0, count). The default implementation runs serially. */
+  virtual void apply(size_t count, const std::function<void(size_t)> &work)
+  {
+    for (size_t i = 0; i < count; i++) {
+      work(i);
+    }
+  }
+};
+
+struct Item {
+  /** Index of the child in the vector passed to UnpositionedLayout::compute. */
+  size_t index;
+  Measurement measurement;
+  /** Position relative to the stack, only valid after PositionedLayout::compute. */
+  Point position;
+};
+
+/**
+ * A line of items. Lines partition the children in order, so a line is simply the range [begin, end) of child indexes
+ * into the storage of its layout.
+ */
+struct Line {
+  size_t begin;
+  size_t end;
+  /** The total size of the children in the stack dimension, including all spacing. */
+  Float stackDimensionSum;
+  /** The size in the cross dimension */
+  Float crossSize;
+  /** The baseline of the stack which baseline aligned children should align to */
+  Float baseline;
+
+  size_t count() const { return end - begin; }
+};
+
+/**
+ * The per-item state of one layout pass, in structure-of-arrays form and indexed by child. Obtained from LayoutArena so
+ * that the capacity of every array is reused by later passes instead of being reallocated.
+ */
+struct LayoutStorage {
+  std::vector<Size> sizes;
+  std::vector<Float> ascenders;
+  std::vector<Float> descenders;
+  std::vector<Float> flexGrow;
+  std::vector<Float> flexShrink;
+  /** Flex scratch: measured size along the stack dimension, and the adjustment computed for it. */
+  std::vector<Float> stackSizes;
+  std::vector<Float> adjustments;
+  std::vector<Line> lines;
+
+  /** Sizes every per-item array for count items and removes all lines. */
+  void reset(size_t count);
+
+  Measurement measurement(const size_t index) const
+  {
+    return {sizes[index], ascenders[index], descenders[index]};
+  }
+
+  /** Safe to call concurrently for different indexes. */
+  void setMeasurement(const size_t index, const Measurement &measurement)
+  {
+    sizes[index] = measurement.size;
+    ascenders[index] = measurement.ascender;
+    descenders[index] = measurement.descender;
+  }
+};
+
+/**
+ * Recycles LayoutStorage through a small per-thread free list. Nested stacks acquire and release storage in LIFO order
+ * on the thread measuring them, so a handful of storages per thread serve any number of layout passes.
+ */
+class LayoutArena {
+public:
+  struct Recycler {
+    void operator()(LayoutStorage *storage) const;
+  };
+  typedef std::unique_ptr<LayoutStorage, Recycler> Lease;
+
+  /** Returns storage reset for count items. It goes back to the free list of the releasing thread when destroyed. */
+  static Lease acquire(size_t count);
+};
+
+/** Represents a set of stack layout children that have their final size computed, but are not yet positioned. */
+struct UnpositionedLayout {
+  /** Final measurements of the children and the set of proposed lines over them, not yet positioned. */
+  LayoutArena::Lease storage;
+  /**
+   * In a single line stack (e.g no wrap), this is the total size of the children in the stack dimension, including all spacing.
+   * In a multi-line stack, this is the largest stack dimension among lines.
+   */
+  Float stackDimensionSum;
+  Float crossDimensionSum;
+
+  /** Given a set of children, computes the unpositioned layouts for those children. */
+  static UnpositionedLayout compute(const std::vector<Child> &children,
+                                    const Style &style,
+                                    const SizeRange &sizeRange,
+                                    const bool concurrent,
+                                    Measurer &measurer);
+
+  static Float baselineForItem(const Style &style, const Child &child, const Measurement &measurement);
+
+  static Float computeStackViolation(const Float stackDimensionSum, const Style &style, const SizeRange &sizeRange);
+
+  static Float computeCrossViolation(const Float crossDimensionSum, const Style &style, const SizeRange &sizeRange);
+};
+
+/** Represents a set of laid out and positioned stack layout children. */
+struct PositionedLayout {
+  /** All items of all lines, in child order, with their positions set. */
+  std::vector<Item> items;
+  /** Final size of the stack */
+  Size size;
+
+  /**
+   * Given an unpositioned layout, computes the positions each child should be placed at.
+   * @param screenScale Used to floor centered offsets to whole pixels.
+   */
+  static PositionedLayout compute(const UnpositionedLayout &unpositionedLayout,
+                                  const std::vector<Child> &children,
+                                  const Style &style,
+                                  const SizeRange &sizeRange,
+                                  const Float screenScale);
+};
+
+// Geometry helpers
+
+inline Float stackDimension(const Direction direction, const Size &size)
+{
+  return (direction == Direction::Vertical) ? size.height : size.width;
+}
+
+inline Float crossDimension(const Direction direction, const Size &size)
+{
+  return (direction == Direction::Vertical) ? size.width : size.height;
+}
+
+inline Point directionPoint(const Direction direction, const Float stack, const Float cross)
+{
+  return (direction == Direction::Vertical) ? Point{cross, stack} : Point{stack, cross};
+}
+
+inline Size directionSize(const Direction direction, const Float stack, const Float cross)
+{
+  return (direction == Direction::Vertical) ? Size{cross, stack} : Size{stack, cross};
+}
+
+inline SizeRange directionSizeRange(const Direction direction,
+                                    const Float stackMin,
+                                    const Float stackMax,
+                                    const Float crossMin,
+                                    const Float crossMax)
+{
+  return {directionSize(direction, stackMin, crossMin), directionSize(direction, stackMax, crossMax)};
+}
+
+inline AlignItems alignment(const AlignSelf childAlignment, const AlignItems stackAlignment)
+{
+  switch (childAlignment) {
+    case AlignSelf::Center:
+      return AlignItems::Center;
+    case AlignSelf::End:
+      return AlignItems::End;
+    case AlignSelf::Start:
+      return AlignItems::Start;
+    case AlignSelf::Stretch:
+      return AlignItems::Stretch;
+    case AlignSelf::Auto:
+    default:
+      return stackAlignment;
+  }
+}
+
+/** Mirrors ASSizeRangeClamp. */
+Size clamp(const SizeRange &sizeRange, const Size &size);
+
+} // namespace StackLayout
+} // namespace AS
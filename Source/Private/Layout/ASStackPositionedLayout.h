@@ -13,10 +13,11 @@
 
 /** Represents a set of laid out and positioned stack layout children. */
 struct ASStackPositionedLayout {
-  const std::vector<ASStackLayoutSpecItem> items;
+  /** The positioned child layouts, in child order. */
+  const std::vector<ASLayout *> sublayouts;
   /** Final size of the stack */
   const CGSize size;
-  
+
   /** Given an unpositioned layout, computes the positions each child should be placed at. */
   static ASStackPositionedLayout compute(const ASStackUnpositionedLayout &unpositionedLayout,
                                          const ASStackLayoutSpecStyle &style,
@@ -10,12 +10,10 @@
 #import <vector>
 
 #import <AsyncDisplayKit/ASLayout.h>
+#import <AsyncDisplayKit/ASStackLayoutCore.h>
 #import <AsyncDisplayKit/ASStackLayoutSpecUtilities.h>
 #import <AsyncDisplayKit/ASStackLayoutSpec.h>
 
-/** The threshold that determines if a violation has actually occurred. */
-AS_EXTERN CGFloat const kViolationEpsilon;
-
 struct ASStackLayoutSpecChild {
   /** The original source child. */
   id<ASLayoutElement> element;
@@ -25,49 +23,58 @@ struct ASStackLayoutSpecChild {
   ASLayoutElementSize size;
 };
 
-struct ASStackLayoutSpecItem {
-  /** The original source child. */
-  ASStackLayoutSpecChild child;
-  /** The proposed layout or nil if no is calculated yet. */
-  ASLayout *layout;
-};
-
-struct ASStackUnpositionedLine {
-  /** The set of proposed children in this line, each contains child layout, not yet positioned. */
-  std::vector<ASStackLayoutSpecItem> items;
-  /** The total size of the children in the stack dimension, including all spacing. */
-  CGFloat stackDimensionSum;
-  /** The size in the cross dimension */
-  CGFloat crossSize;
-  /** The baseline of the stack which baseline aligned children should align to */
-  CGFloat baseline;
-};
-
-/** Represents a set of stack layout children that have their final layout computed, but are not yet positioned. */
+/**
+ * Represents a set of stack layout children that have their final layout computed, but are not yet positioned.
+ *
+ * The flex algorithm itself lives in ASStackLayoutCore and only deals with plain sizes. This struct bridges it to
+ * layout elements: it measures children via -layoutThatFits:parentSize: and keeps the resulting ASLayouts around.
+ */
 struct ASStackUnpositionedLayout {
-  /** The set of proposed lines, each contains child layouts, not yet positioned. */
-  const std::vector<ASStackUnpositionedLine> lines;
-  /** 
-   * In a single line stack (e.g no wrao), this is the total size of the children in the stack dimension, including all spacing.
-   * In a multi-line stack, this is the largest stack dimension among lines.
-   */
-  const CGFloat stackDimensionSum;
-  const CGFloat crossDimensionSum;
-  
+  /** Plain copies of the children's style properties, in the order they were passed to compute(). */
+  const std::vector<AS::StackLayout::Child> children;
+  /** Measurements and lines of the children, in storage recycled through AS::StackLayout::LayoutArena. */
+  AS::StackLayout::UnpositionedLayout layout;
+  /** The final layout of each child, indexed the same way as children. */
+  const std::vector<ASLayout *> sublayouts;
+
   /** Given a set of children, computes the unpositioned layouts for those children. */
   static ASStackUnpositionedLayout compute(const std::vector<ASStackLayoutSpecChild> &children,
                                            const ASStackLayoutSpecStyle &style,
                                            const ASSizeRange &sizeRange,
                                            const BOOL concurrent);
-  
-  static CGFloat baselineForItem(const ASStackLayoutSpecStyle &style,
-                                 const ASStackLayoutSpecItem &l);
-  
-  static CGFloat computeStackViolation(const CGFloat stackDimensionSum,
-                                       const ASStackLayoutSpecStyle &style,
-                                       const ASSizeRange &sizeRange);
-
-  static CGFloat computeCrossViolation(const CGFloat crossDimensionSum,
-                                       const ASStackLayoutSpecStyle &style,
-                                       const ASSizeRange &sizeRange);
 };
+
+#pragma mark - Conversions
+
+inline AS::StackLayout::Size ASStackLayoutCoreSize(const CGSize size)
+{
+  return {size.width, size.height};
+}
+
+inline CGSize ASStackLayoutCGSize(const AS::StackLayout::Size size)
+{
+  return CGSizeMake(size.width, size.height);
+}
+
+inline AS::StackLayout::SizeRange ASStackLayoutCoreSizeRange(const ASSizeRange &sizeRange)
+{
+  return {ASStackLayoutCoreSize(sizeRange.min), ASStackLayoutCoreSize(sizeRange.max)};
+}
+
+inline ASSizeRange ASStackLayoutSizeRange(const AS::StackLayout::SizeRange &sizeRange)
+{
+  return {ASStackLayoutCGSize(sizeRange.min), ASStackLayoutCGSize(sizeRange.max)};
+}
+
+inline AS::StackLayout::Style ASStackLayoutCoreStyle(const ASStackLayoutSpecStyle &style)
+{
+  return {
+    .direction = static_cast<AS::StackLayout::Direction>(style.direction),
+    .spacing = style.spacing,
+    .justifyContent = static_cast<AS::StackLayout::JustifyContent>(style.justifyContent),
+    .alignItems = static_cast<AS::StackLayout::AlignItems>(style.alignItems),
+    .flexWrap = static_cast<AS::StackLayout::FlexWrap>(style.flexWrap),
+    .alignContent = static_cast<AS::StackLayout::AlignContent>(style.alignContent),
+    .lineSpacing = style.lineSpacing,
+  };
+}
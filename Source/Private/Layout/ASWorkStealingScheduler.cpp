@@ -0,0 +1,280 @@
+//
+//  ASWorkStealingScheduler.cpp
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#include "ASWorkStealingScheduler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+#if __APPLE__
+#include <pthread/qos.h>
+#endif
+
+namespace AS {
+
+static thread_local WorkStealingScheduler *tCurrentScheduler = nullptr;
+static thread_local size_t tQueueIndex = 0;
+static thread_local unsigned tTaskDepth = 0;
+/** Numbers threads that are not workers in the order they first call parallelFor(), to spread them over queues. */
+static std::atomic<size_t> sCallerCount(0);
+static thread_local size_t tCallerNumber = SIZE_MAX;
+
+static unsigned currentQoSClass()
+{
+#if __APPLE__
+  return (unsigned)qos_class_self();
+#else
+  return 0;
+#endif
+}
+
+/** Moves a worker to the QoS class of the task it is about to run. */
+static void adoptQoSClass(unsigned qosClass)
+{
+#if __APPLE__
+  static thread_local unsigned tQoSClass = QOS_CLASS_UNSPECIFIED;
+  if (qosClass != tQoSClass && qosClass != QOS_CLASS_UNSPECIFIED) {
+    pthread_set_qos_class_self_np((qos_class_t)qosClass, 0);
+    tQoSClass = qosClass;
+  }
+#endif
+}
+
+WorkStealingScheduler &WorkStealingScheduler::shared()
+{
+  // Intentionally leaked so that workers never observe a destroyed scheduler during process teardown.
+  static WorkStealingScheduler *scheduler = new WorkStealingScheduler(std::max(1u, std::thread::hardware_concurrency()) - 1);
+  return *scheduler;
+}
+
+WorkStealingScheduler::WorkStealingScheduler(unsigned workerCount)
+: _callerQueueCount(workerCount + 1), _workerEpoch(0), _callerEpoch(0), _sleepingWorkers(0), _sleepingCallers(0),
+  _stopping(false), _steals(0)
+{
+  for (size_t i = 0; i < _callerQueueCount + workerCount; i++) {
+    _queues.emplace_back(new Queue());
+  }
+  for (unsigned i = 0; i < workerCount; i++) {
+    _workers.emplace_back(&WorkStealingScheduler::workerLoop, this, _callerQueueCount + i);
+  }
+}
+
+WorkStealingScheduler::~WorkStealingScheduler()
+{
+  {
+    std::lock_guard<std::mutex> l(_sleepMutex);
+    _stopping = true;
+  }
+  _workerCondition.notify_all();
+  for (auto &worker : _workers) {
+    worker.join();
+  }
+}
+
+bool WorkStealingScheduler::isExecutingTask()
+{
+  return tTaskDepth > 0;
+}
+
+size_t WorkStealingScheduler::queueIndexForCurrentThread()
+{
+  if (tCurrentScheduler == this) {
+    return tQueueIndex;
+  }
+  if (tCallerNumber == SIZE_MAX) {
+    tCallerNumber = sCallerCount.fetch_add(1, std::memory_order_relaxed);
+  }
+  return tCallerNumber % _callerQueueCount;
+}
+
+void WorkStealingScheduler::wakeCallers()
+{
+  _callerEpoch.fetch_add(1);
+  // Taking the lock orders this notification after a sleeper's predicate check.
+  std::lock_guard<std::mutex> l(_sleepMutex);
+  _callerCondition.notify_all();
+}
+
+void WorkStealingScheduler::push(size_t queueIndex, const Task &task)
+{
+  Queue &queue = *_queues[queueIndex];
+  {
+    std::lock_guard<std::mutex> l(queue.mutex);
+    queue.tasks.push_back(task);
+  }
+  _workerEpoch.fetch_add(1);
+  if (_sleepingWorkers.load() > 0) {
+    std::lock_guard<std::mutex> l(_sleepMutex);
+    _workerCondition.notify_one();
+  }
+  // The group cannot finish before this task has run, so it is still alive here.
+  if (task.group->callerSleeping.load()) {
+    wakeCallers();
+  }
+}
+
+bool WorkStealingScheduler::popLocal(size_t queueIndex, Task &task)
+{
+  // Newest first: the most recently split range is the smallest and the most likely to be warm in cache.
+  Queue &queue = *_queues[queueIndex];
+  std::lock_guard<std::mutex> l(queue.mutex);
+  if (queue.tasks.empty()) {
+    return false;
+  }
+  task = queue.tasks.back();
+  queue.tasks.pop_back();
+  return true;
+}
+
+bool WorkStealingScheduler::steal(size_t thiefIndex, Task &task)
+{
+  // Oldest first: the earliest pushed range of a victim is its largest, so one steal moves the most work.
+  const size_t queueCount = _queues.size();
+  for (size_t offset = 1; offset < queueCount; offset++) {
+    Queue &queue = *_queues[(thiefIndex + offset) % queueCount];
+    std::lock_guard<std::mutex> l(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = queue.tasks.front();
+      queue.tasks.pop_front();
+      _steals.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WorkStealingScheduler::findTask(size_t queueIndex, Task &task)
+{
+  return popLocal(queueIndex, task) || steal(queueIndex, task);
+}
+
+bool WorkStealingScheduler::findGroupTask(size_t queueIndex, const Group *group, Task &task)
+{
+  // Like findTask(), newest first from our own queue and oldest first from the others, but only the group's tasks.
+  const size_t queueCount = _queues.size();
+  for (size_t offset = 0; offset < queueCount; offset++) {
+    Queue &queue = *_queues[(queueIndex + offset) % queueCount];
+    std::lock_guard<std::mutex> l(queue.mutex);
+    if (offset == 0) {
+      for (auto it = queue.tasks.rbegin(); it != queue.tasks.rend(); ++it) {
+        if (it->group == group) {
+          task = *it;
+          queue.tasks.erase(std::next(it).base());
+          return true;
+        }
+      }
+    } else {
+      for (auto it = queue.tasks.begin(); it != queue.tasks.end(); ++it) {
+        if (it->group == group) {
+          task = *it;
+          queue.tasks.erase(it);
+          _steals.fetch_add(1, std::memory_order_relaxed);
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+void WorkStealingScheduler::execute(size_t queueIndex, Task task)
+{
+  // Split off the upper half until a single index is left, leaving the halves for ourselves or for thieves.
+  while (task.end - task.begin > 1) {
+    const size_t mid = task.begin + (task.end - task.begin) / 2;
+    push(queueIndex, {task.work, mid, task.end, task.group});
+    task.end = mid;
+  }
+
+  // Callers keep their own QoS class: lowering it would hold up whatever they are waiting for.
+  if (queueIndex >= _callerQueueCount) {
+    adoptQoSClass(task.group->qosClass);
+  }
+  tTaskDepth++;
+  (*task.work)(task.begin);
+  tTaskDepth--;
+
+  // The group may be gone as soon as pending reaches zero, so only the scheduler's own state is touched after that.
+  if (task.group->pending.fetch_sub(1) == 1 && _sleepingCallers.load() > 0) {
+    wakeCallers();
+  }
+}
+
+void WorkStealingScheduler::parallelFor(size_t count, const std::function<void(size_t)> &work)
+{
+  if (count == 0) {
+    return;
+  }
+
+  if (count == 1) {
+    tTaskDepth++;
+    work(0);
+    tTaskDepth--;
+    return;
+  }
+
+  Group group;
+  group.pending.store(count, std::memory_order_relaxed);
+  group.qosClass = currentQoSClass();
+  group.callerSleeping.store(false, std::memory_order_relaxed);
+  const size_t queueIndex = queueIndexForCurrentThread();
+  push(queueIndex, {&work, 0, count, &group});
+
+  // Help out with our own group instead of blocking, which is what keeps nested calls from deadlocking or
+  // oversubscribing. Any task of the group that is still queued can be taken here, so the group always finishes.
+  while (group.pending.load() != 0) {
+    Task task;
+    if (findGroupTask(queueIndex, &group, task)) {
+      execute(queueIndex, task);
+      continue;
+    }
+    // Every remaining index of our group is running on another thread; sleep until it finishes or one of them pushes
+    // another part of the group. Rechecking after announcing ourselves catches a push that raced with the search.
+    const size_t epoch = _callerEpoch.load();
+    _sleepingCallers.fetch_add(1);
+    group.callerSleeping.store(true);
+    if (findGroupTask(queueIndex, &group, task)) {
+      group.callerSleeping.store(false);
+      _sleepingCallers.fetch_sub(1);
+      execute(queueIndex, task);
+      continue;
+    }
+    {
+      std::unique_lock<std::mutex> l(_sleepMutex);
+      _callerCondition.wait(l, [&] { return _callerEpoch.load() != epoch || group.pending.load() == 0; });
+    }
+    group.callerSleeping.store(false);
+    _sleepingCallers.fetch_sub(1);
+  }
+}
+
+void WorkStealingScheduler::workerLoop(size_t queueIndex)
+{
+  tCurrentScheduler = this;
+  tQueueIndex = queueIndex;
+  while (true) {
+    const size_t epoch = _workerEpoch.load();
+    Task task;
+    if (findTask(queueIndex, task)) {
+      execute(queueIndex, task);
+      continue;
+    }
+    _sleepingWorkers.fetch_add(1);
+    std::unique_lock<std::mutex> l(_sleepMutex);
+    _workerCondition.wait(l, [&] { return _stopping || _workerEpoch.load() != epoch; });
+    const bool stopping = _stopping;
+    l.unlock();
+    _sleepingWorkers.fetch_sub(1);
+    if (stopping) {
+      return;
+    }
+  }
+}
+
+} // namespace AS
@@ -0,0 +1,123 @@
+//
+//  ASWorkStealingScheduler.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#pragma once
+
+// Plain C++11 so that it can be used by ASStackLayoutCore on any host.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace AS {
+
+/**
+ * A fork-join scheduler for recursive layout measurement.
+ *
+ * parallelFor() splits its range into tasks on the calling thread's deque. Idle workers steal the oldest (largest)
+ * ranges from other deques, and a thread that waits for its own range to finish keeps executing the pending tasks of
+ * that range instead of blocking. It never runs anybody else's tasks while it waits, so e.g. the main thread is not
+ * held up by background layout. A parallelFor() issued from inside a task therefore never spawns new threads: nested
+ * stacks spread over the same fixed set of workers, and total parallelism stays bounded by workerCount() + the number
+ * of callers.
+ *
+ * Under exp_work_stealing_layout, ASStackLayoutSpec measures on the shared scheduler only where measurement is already
+ * concurrent: stacks with @c concurrent set, and every stack measured from inside one of their tasks. Stacks outside
+ * such a subtree still measure serially, because measuring children off the calling thread must be opted into.
+ *
+ * On Apple platforms a worker runs each task at the QoS class of the thread that called parallelFor(), so that a
+ * main-thread layout waiting on a worker is not held up by a worker last used for background work.
+ */
+class WorkStealingScheduler {
+public:
+  /** Shared scheduler with one worker per active core, minus the core used by the calling thread. */
+  static WorkStealingScheduler &shared();
+
+  explicit WorkStealingScheduler(unsigned workerCount);
+  ~WorkStealingScheduler();
+
+  WorkStealingScheduler(const WorkStealingScheduler &) = delete;
+  WorkStealingScheduler &operator=(const WorkStealingScheduler &) = delete;
+
+  /**
+   * Invokes work for each index in [0, count) and returns once every invocation has finished. The calling thread
+   * participates. Safe to call from inside work.
+   */
+  void parallelFor(size_t count, const std::function<void(size_t)> &work);
+
+  /** Whether the calling thread is currently executing a task of any scheduler. */
+  static bool isExecutingTask();
+
+  unsigned workerCount() const { return (unsigned)_workers.size(); }
+
+  /** Number of tasks taken from another thread's deque since creation. */
+  size_t stealCount() const { return _steals.load(std::memory_order_relaxed); }
+
+private:
+  struct Group {
+    std::atomic<size_t> pending;
+    /** The caller's qos_class_t, which workers adopt while running the group's tasks. 0 where there is none. */
+    unsigned qosClass;
+    /** Whether the caller is asleep, and wants to be woken when another of the group's tasks is pushed. */
+    std::atomic<bool> callerSleeping;
+  };
+
+  struct Task {
+    const std::function<void(size_t)> *work;
+    size_t begin;
+    size_t end;
+    Group *group;
+  };
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void workerLoop(size_t queueIndex);
+  void push(size_t queueIndex, const Task &task);
+  bool popLocal(size_t queueIndex, Task &task);
+  bool steal(size_t thiefIndex, Task &task);
+  bool findTask(size_t queueIndex, Task &task);
+  bool findGroupTask(size_t queueIndex, const Group *group, Task &task);
+  void execute(size_t queueIndex, Task task);
+  size_t queueIndexForCurrentThread();
+  void wakeCallers();
+
+  /**
+   * The first _callerQueueCount queues are for threads that are not workers of this scheduler, each of which sticks to
+   * one of them. Callers may share a queue, which is fine since a caller only ever takes its own group's tasks.
+   * Worker i owns queue _callerQueueCount + i.
+   */
+  std::vector<std::unique_ptr<Queue>> _queues;
+  size_t _callerQueueCount;
+  std::vector<std::thread> _workers;
+
+  std::mutex _sleepMutex;
+  /** Idle workers, one of which is woken for every pushed task. */
+  std::condition_variable _workerCondition;
+  /** Threads waiting in parallelFor(), which are woken when a group finishes or gets a task while they sleep. */
+  std::condition_variable _callerCondition;
+  /** Bumped whenever a task is pushed, so idle workers can recheck without missing wakeups. */
+  std::atomic<size_t> _workerEpoch;
+  /** Bumped whenever sleeping callers are woken, likewise. */
+  std::atomic<size_t> _callerEpoch;
+  std::atomic<unsigned> _sleepingWorkers;
+  std::atomic<unsigned> _sleepingCallers;
+  bool _stopping;
+
+  std::atomic<size_t> _steals;
+};
+
+} // namespace AS
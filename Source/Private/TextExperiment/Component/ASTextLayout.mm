@@ -11,6 +11,7 @@
 
 #import <AsyncDisplayKit/ASAssert.h>
 #import <AsyncDisplayKit/ASConfigurationInternal.h>
+#import <AsyncDisplayKit/ASTextFramesetterPool.h>
 #import <AsyncDisplayKit/ASTextUtilities.h>
 #import <AsyncDisplayKit/ASTextAttribute.h>
 #import <AsyncDisplayKit/NSAttributedString+ASText.h>
@@ -509,69 +510,20 @@ dispatch_semaphore_signal(_lock);
     frameAttrs[(id)kCTFrameProgressionAttributeName] = @(kCTFrameProgressionRightToLeft);
   }
   
-  /*
-   * Framesetter cache.
-   * Framesetters can only be used by one thread at a time.
-   * Create a CFSet with no callbacks (raw pointers) to keep track of which
-   * framesetters are in use on other threads. If the one for our string is already in use,
-   * just create a new one. This should be pretty rare.
-   */
-  static pthread_mutex_t busyFramesettersLock = PTHREAD_MUTEX_INITIALIZER;
-  static NSCache<NSAttributedString *, id> *framesetterCache;
-  static CFMutableSetRef busyFramesetters;
-  static dispatch_once_t onceToken;
-  dispatch_once(&onceToken, ^{
-    if (ASActivateExperimentalFeature(ASExperimentalFramesetterCache)) {
-      framesetterCache = [[NSCache alloc] init];
-      framesetterCache.name = @"org.TextureGroup.Texture.framesetterCache";
-      busyFramesetters = CFSetCreateMutable(NULL, 0, NULL);
-    }
-  });
-
-  BOOL haveCached = NO, useCached = NO;
-  if (framesetterCache) {
-    // Check if there's one in the cache.
-    ctSetter = (__bridge_retained CTFramesetterRef)[framesetterCache objectForKey:text];
-
-    if (ctSetter) {
-      haveCached = YES;
-
-      // Check-and-set busy on the cached one.
-      pthread_mutex_lock(&busyFramesettersLock);
-      BOOL busy = CFSetContainsValue(busyFramesetters, ctSetter);
-      if (!busy) {
-        CFSetAddValue(busyFramesetters, ctSetter);
-        useCached = YES;
-      }
-      pthread_mutex_unlock(&busyFramesettersLock);
-
-      // Release if it was busy.
-      if (busy) {
-        CFRelease(ctSetter);
-        ctSetter = NULL;
-      }
-    }
-  }
-
-  // Create a framesetter if needed.
-  if (!ctSetter) {
+  // Framesetters can only be used by one thread at a time, so the pool lends one out until the frame is created.
+  const BOOL usePool = ASActivateExperimentalFeature(ASExperimentalFramesetterCache);
+  if (usePool) {
+    ctSetter = ASTextFramesetterPoolCheckOut(text);
+  } else {
     ctSetter = CTFramesetterCreateWithAttributedString((CFAttributedStringRef)text);
   }
 
   if (!ctSetter) FAIL_AND_RETURN
   ctFrame = CTFramesetterCreateFrame(ctSetter, ASTextCFRangeFromNSRange(range), cgPath, (CFDictionaryRef)frameAttrs);
 
-  // Return to cache.
-  if (framesetterCache) {
-    if (useCached) {
-      // If reused: mark available.
-      pthread_mutex_lock(&busyFramesettersLock);
-      CFSetRemoveValue(busyFramesetters, ctSetter);
-      pthread_mutex_unlock(&busyFramesettersLock);
-    } else if (!haveCached) {
-      // If first framesetter, add to cache.
-      [framesetterCache setObject:(__bridge id)ctSetter forKey:text];
-    }
+  if (usePool) {
+    ASTextFramesetterPoolCheckIn(text, ctSetter);
+    ctSetter = NULL;
   }
 
   if (!ctFrame) FAIL_AND_RETURN
@@ -1004,7 +956,7 @@ dispatch_semaphore_signal(_lock);
   layout.lineRowsEdge = lineRowsEdge;
   layout.lineRowsIndex = lineRowsIndex;
   CFRelease(cgPath);
-  CFRelease(ctSetter);
+  if (ctSetter) CFRelease(ctSetter);
   CFRelease(ctFrame);
   if (lineOrigins) free(lineOrigins);
   return layout;
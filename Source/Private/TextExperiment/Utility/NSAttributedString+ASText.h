@@ -666,6 +666,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BOOL)as_canDrawWithUIKit;
 
+/**
+ If YES, every paragraph is left aligned, or naturally aligned and left-to-right, so lines
+ start at the same offset no matter how wide the container is.
+ 
+ @discussion A layout of such a string in which no line had to wrap stays valid for any
+ container at least as wide as the text.
+ */
+- (BOOL)as_isLeftAligned;
+
 @end
 
 
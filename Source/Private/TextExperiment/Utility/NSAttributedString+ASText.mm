@@ -640,6 +640,54 @@ return style. _attr_;
 #undef Fail
 }
 
+- (BOOL)as_isLeftAligned {
+  __block BOOL result = YES;
+  __block BOOL natural = NO;
+  [self enumerateAttribute:NSParagraphStyleAttributeName inRange:self.as_rangeOfAll options:NSAttributedStringEnumerationLongestEffectiveRangeNotRequired usingBlock:^(NSParagraphStyle *style, NSRange range, BOOL *stop) {
+    if (!style) {
+      natural = YES;
+      return;
+    }
+    if (CFGetTypeID((__bridge CFTypeRef)(style)) == CTParagraphStyleGetTypeID() || style.tailIndent != 0) {
+      result = NO;
+      *stop = YES;
+      return;
+    }
+    switch (style.alignment) {
+      case NSTextAlignmentLeft:
+        break;
+      case NSTextAlignmentNatural:
+      case NSTextAlignmentJustified: // The last line of a paragraph is not justified.
+        if (style.baseWritingDirection == NSWritingDirectionRightToLeft) {
+          result = NO;
+          *stop = YES;
+        } else if (style.baseWritingDirection == NSWritingDirectionNatural) {
+          natural = YES;
+        }
+        break;
+      default:
+        result = NO;
+        *stop = YES;
+        break;
+    }
+  }];
+  if (result && natural) {
+    // The natural direction follows the first strong character; be conservative and reject any right-to-left script.
+    static NSCharacterSet *rightToLeftSet;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+      NSMutableCharacterSet *set = [NSMutableCharacterSet characterSetWithRange:NSMakeRange(0x0590, 0x0900 - 0x0590)];
+      [set addCharactersInRange:NSMakeRange(0xFB1D, 0xFE00 - 0xFB1D)];
+      [set addCharactersInRange:NSMakeRange(0xFE70, 0xFF00 - 0xFE70)];
+      [set addCharactersInRange:NSMakeRange(0x10800, 0x11000 - 0x10800)];
+      [set addCharactersInRange:NSMakeRange(0x1E800, 0x1F000 - 0x1E800)];
+      rightToLeftSet = [set copy];
+    });
+    result = [self.string rangeOfCharacterFromSet:rightToLeftSet].location == NSNotFound;
+  }
+  return result;
+}
+
 @end
 
 @implementation NSMutableAttributedString (ASText)
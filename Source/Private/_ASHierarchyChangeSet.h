@@ -113,6 +113,12 @@ NSString *NSStringFromASHierarchyChangeType(_ASHierarchyChangeType changeType);
 /// Indicates whether the change set is empty, that is it includes neither reload data nor per item or section changes.
 @property (nonatomic, readonly) BOOL isEmpty;
 
+/**
+ * Whether the data controller is committing only the leading items of this change set, and will insert the rest in a
+ * change set of their own. Views should not act on the content being complete, e.g. by checking for batch fetching.
+ */
+@property (nonatomic) BOOL hasPendingRemainder;
+
 /// The count of new ASCellNodes that can undergo async layout calculation. May be zero if all UIKit passthrough cells.
 @property (nonatomic, assign) NSUInteger countForAsyncLayout;
 
@@ -142,6 +148,11 @@ NSString *NSStringFromASHierarchyChangeType(_ASHierarchyChangeType changeType);
  */
 - (void)executeCompletionHandlerWithFinished:(BOOL)finished;
 
+/**
+ * Remove the combined completion handler and return it, so that it can run with another change set.
+ */
+- (nullable void(^)(BOOL finished))takeCompletionHandler AS_WARN_UNUSED_RESULT;
+
 /**
  * Get the section index after the update for the given section before the update.
  *
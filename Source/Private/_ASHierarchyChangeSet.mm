@@ -185,6 +185,13 @@ NSString *NSStringFromASHierarchyChangeType(_ASHierarchyChangeType changeType)
   }
 }
 
+- (void (^)(BOOL))takeCompletionHandler
+{
+  void (^completionHandler)(BOOL finished) = _completionHandler;
+  _completionHandler = nil;
+  return completionHandler;
+}
+
 - (void)markCompletedWithNewItemCounts:(std::vector<NSInteger>)newItemCounts
 {
   NSAssert(!_completed, @"Attempt to mark already-completed changeset as completed.");
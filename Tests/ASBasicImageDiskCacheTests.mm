@@ -0,0 +1,122 @@
+//
+//  ASBasicImageDiskCacheTests.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <XCTest/XCTest.h>
+
+#import <AsyncDisplayKit/ASBasicImageDiskCache.h>
+#import <AsyncDisplayKit/ASGraphicsContext.h>
+
+@interface ASBasicImageDiskCacheTests : XCTestCase
+@end
+
+@implementation ASBasicImageDiskCacheTests {
+  NSURL *_directoryURL;
+}
+
+- (void)setUp
+{
+  [super setUp];
+  _directoryURL = [[NSURL fileURLWithPath:NSTemporaryDirectory()] URLByAppendingPathComponent:[NSUUID UUID].UUIDString];
+}
+
+- (void)tearDown
+{
+  [[NSFileManager defaultManager] removeItemAtURL:_directoryURL error:NULL];
+  [super tearDown];
+}
+
+- (UIImage *)redImageWithSize:(CGSize)size
+{
+  return ASGraphicsCreateImage(ASPrimitiveTraitCollectionMakeDefault(), size, YES, 1, nil, nil, ^{
+    [[UIColor redColor] setFill];
+    UIRectFill((CGRect){ .size = size });
+  });
+}
+
+/** Waits for the cache's writes and trims. */
+- (void)waitForFilesOfCache:(ASBasicImageDiskCache *)cache
+{
+  dispatch_sync((dispatch_queue_t)[cache valueForKey:@"_ioQueue"], ^{});
+}
+
+- (UIImage *)cachedImageWithURL:(NSURL *)URL inCache:(ASBasicImageDiskCache *)cache
+{
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Cache lookup"];
+  __block UIImage *result;
+  [cache cachedImageWithURL:URL callbackQueue:dispatch_get_main_queue() completion:^(id<ASImageContainerProtocol> imageFromCache, ASImageCacheType cacheType) {
+    result = [imageFromCache asdk_image];
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+  return result;
+}
+
+- (void)testStoredImagesAreScaledDownAndSurviveTheCache
+{
+  NSURL *URL = [NSURL URLWithString:@"https://example.com/photo.jpg"];
+  ASBasicImageDiskCache *cache = [[ASBasicImageDiskCache alloc] initWithDirectoryURL:_directoryURL maximumPixelDimension:100];
+  UIImage *stored = [cache storeImage:[self redImageWithSize:CGSizeMake(400, 200)] forURL:URL];
+  XCTAssertEqual(CGImageGetWidth(stored.CGImage), 100);
+  XCTAssertEqual(CGImageGetHeight(stored.CGImage), 50);
+  [self waitForFilesOfCache:cache];
+
+  // A new cache, as after a relaunch, maps the same bitmap back.
+  ASBasicImageDiskCache *relaunchedCache = [[ASBasicImageDiskCache alloc] initWithDirectoryURL:_directoryURL maximumPixelDimension:100];
+  UIImage *cached = [self cachedImageWithURL:URL inCache:relaunchedCache];
+  XCTAssertEqual(CGImageGetWidth(cached.CGImage), 100);
+  XCTAssertEqual(CGImageGetHeight(cached.CGImage), 50);
+  XCTAssertEqualObjects(CFBridgingRelease(CGDataProviderCopyData(CGImageGetDataProvider(cached.CGImage))),
+                        CFBridgingRelease(CGDataProviderCopyData(CGImageGetDataProvider(stored.CGImage))));
+
+  // Other sizes and other URLs are cached separately.
+  ASBasicImageDiskCache *largerCache = [[ASBasicImageDiskCache alloc] initWithDirectoryURL:_directoryURL maximumPixelDimension:200];
+  XCTAssertNil([self cachedImageWithURL:URL inCache:largerCache]);
+  XCTAssertNil([self cachedImageWithURL:[NSURL URLWithString:@"https://example.com/other.jpg"] inCache:relaunchedCache]);
+
+  [relaunchedCache removeAllImages];
+  XCTAssertNil([self cachedImageWithURL:URL inCache:relaunchedCache]);
+}
+
+- (void)testStoredImagesKeepTheirOrientation
+{
+  NSURL *URL = [NSURL URLWithString:@"https://example.com/portrait.jpg"];
+  ASBasicImageDiskCache *cache = [[ASBasicImageDiskCache alloc] initWithDirectoryURL:_directoryURL maximumPixelDimension:100];
+  UIImage *source = [self redImageWithSize:CGSizeMake(400, 200)];
+  UIImage *rotated = [UIImage imageWithCGImage:source.CGImage scale:1 orientation:UIImageOrientationRight];
+  UIImage *stored = [cache storeImage:rotated forURL:URL];
+  XCTAssertEqual(stored.imageOrientation, UIImageOrientationRight);
+  XCTAssertTrue(CGSizeEqualToSize(stored.size, CGSizeMake(50, 100)));
+  [self waitForFilesOfCache:cache];
+
+  ASBasicImageDiskCache *relaunchedCache = [[ASBasicImageDiskCache alloc] initWithDirectoryURL:_directoryURL maximumPixelDimension:100];
+  UIImage *cached = [self cachedImageWithURL:URL inCache:relaunchedCache];
+  XCTAssertEqual(cached.imageOrientation, UIImageOrientationRight);
+  XCTAssertTrue(CGSizeEqualToSize(cached.size, CGSizeMake(50, 100)));
+}
+
+- (void)testByteLimitRemovesImages
+{
+  ASBasicImageDiskCache *cache = [[ASBasicImageDiskCache alloc] initWithDirectoryURL:_directoryURL maximumPixelDimension:100];
+  cache.byteLimit = 100 * 1024;
+  for (NSUInteger i = 0; i < 10; i++) {
+    NSURL *URL = [NSURL URLWithString:[NSString stringWithFormat:@"https://example.com/%lu.jpg", (unsigned long)i]];
+    [cache storeImage:[self redImageWithSize:CGSizeMake(100, 100)] forURL:URL];
+  }
+  [self waitForFilesOfCache:cache];
+
+  NSUInteger remaining = 0;
+  for (NSUInteger i = 0; i < 10; i++) {
+    NSURL *URL = [NSURL URLWithString:[NSString stringWithFormat:@"https://example.com/%lu.jpg", (unsigned long)i]];
+    remaining += ([self cachedImageWithURL:URL inCache:cache] != nil);
+  }
+  // Each image takes about 40 KB, and the cache trims to three quarters of its limit.
+  XCTAssertGreaterThan(remaining, 0);
+  XCTAssertLessThanOrEqual(remaining, 2);
+}
+
+@end
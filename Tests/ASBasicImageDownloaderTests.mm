@@ -7,9 +7,139 @@
 //  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
 //
 
+#import <ImageIO/ImageIO.h>
 #import <XCTest/XCTest.h>
 
 #import <AsyncDisplayKit/ASBasicImageDownloader.h>
+#import <AsyncDisplayKit/ASBasicImageDownloaderInternal.h>
+
+/**
+ * Stands in for an HTTP server: requests for as-test:// URLs are held until the test answers them with
+ * +respondToURL:, so tests can see which transfers the downloader has started. The body is logo-square.png unless
+ * +setBody:forURL: gave another.
+ */
+@interface ASTestHoldingURLProtocol : NSURLProtocol
++ (NSArray<NSURL *> *)startedURLs;
++ (void)setBody:(NSData *)body forURL:(NSURL *)URL;
+/** Sends the response and the first length bytes of the body, and keeps holding the rest. */
++ (void)respondToURL:(NSURL *)URL length:(NSUInteger)length;
+/** Sends whatever is left of the response and finishes it. */
++ (void)respondToURL:(NSURL *)URL;
+@end
+
+@implementation ASTestHoldingURLProtocol
+{
+  NSThread *_clientThread;
+  NSArray<NSString *> *_clientModes;
+  NSData *_body;
+  NSUInteger _sentLength;
+  BOOL _sentResponse;
+}
+
+static NSMutableArray<NSURL *> *startedURLs;
+static NSMutableDictionary<NSURL *, ASTestHoldingURLProtocol *> *heldProtocols;
+static NSMutableDictionary<NSURL *, NSData *> *bodies;
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request
+{
+  return [request.URL.scheme isEqualToString:@"as-test"];
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request
+{
+  return request;
+}
+
++ (NSArray<NSURL *> *)startedURLs
+{
+  @synchronized (self) {
+    return [startedURLs copy] ?: @[];
+  }
+}
+
++ (void)setBody:(NSData *)body forURL:(NSURL *)URL
+{
+  @synchronized (self) {
+    if (bodies == nil) {
+      bodies = [NSMutableDictionary dictionary];
+    }
+    bodies[URL] = body;
+  }
+}
+
++ (void)respondToURL:(NSURL *)URL length:(NSUInteger)length
+{
+  [self _respondToURL:URL length:length finish:NO];
+}
+
++ (void)respondToURL:(NSURL *)URL
+{
+  [self _respondToURL:URL length:NSUIntegerMax finish:YES];
+}
+
++ (void)_respondToURL:(NSURL *)URL length:(NSUInteger)length finish:(BOOL)finish
+{
+  ASTestHoldingURLProtocol *protocol;
+  @synchronized (self) {
+    protocol = heldProtocols[URL];
+    if (finish) {
+      [heldProtocols removeObjectForKey:URL];
+    }
+  }
+  if (protocol == nil) {
+    return;
+  }
+  // Client messages must arrive on the thread that started loading.
+  [protocol performSelector:@selector(_sendLength:) onThread:protocol->_clientThread withObject:@(length) waitUntilDone:NO modes:protocol->_clientModes];
+  if (finish) {
+    [protocol performSelector:@selector(_finish) onThread:protocol->_clientThread withObject:nil waitUntilDone:NO modes:protocol->_clientModes];
+  }
+}
+
+- (void)startLoading
+{
+  _clientThread = [NSThread currentThread];
+  _clientModes = @[ [NSRunLoop currentRunLoop].currentMode ?: NSDefaultRunLoopMode ];
+  @synchronized (self.class) {
+    if (startedURLs == nil) {
+      startedURLs = [NSMutableArray array];
+      heldProtocols = [NSMutableDictionary dictionary];
+    }
+    [startedURLs addObject:self.request.URL];
+    heldProtocols[self.request.URL] = self;
+    _body = bodies[self.request.URL];
+  }
+  if (_body == nil) {
+    NSURL *imageURL = [[NSBundle bundleForClass:self.class] URLForResource:@"logo-square" withExtension:@"png" subdirectory:@"TestResources"];
+    _body = [NSData dataWithContentsOfURL:imageURL];
+  }
+}
+
+- (void)stopLoading
+{
+}
+
+- (void)_sendLength:(NSNumber *)length
+{
+  if (!_sentResponse) {
+    NSDictionary *headers = @{ @"Content-Length" : [NSString stringWithFormat:@"%lu", (unsigned long)_body.length] };
+    NSURLResponse *response = [[NSHTTPURLResponse alloc] initWithURL:self.request.URL statusCode:200 HTTPVersion:@"HTTP/1.1" headerFields:headers];
+    [self.client URLProtocol:self didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+    _sentResponse = YES;
+  }
+  const NSUInteger end = MIN(_body.length, MAX(_sentLength, length.unsignedIntegerValue));
+  if (end > _sentLength) {
+    [self.client URLProtocol:self didLoadData:[_body subdataWithRange:NSMakeRange(_sentLength, end - _sentLength)]];
+    _sentLength = end;
+  }
+}
+
+- (void)_finish
+{
+  [self.client URLProtocolDidFinishLoading:self];
+}
+
+@end
 
 @interface ASBasicImageDownloaderTests : XCTestCase
 
@@ -44,4 +174,173 @@
   [self waitForExpectationsWithTimeout:30 handler:nil];
 }
 
+
+- (ASBasicImageDownloader *)holdingDownloader
+{
+  NSURLSessionConfiguration *configuration = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+  configuration.protocolClasses = @[ [ASTestHoldingURLProtocol class] ];
+  return [[ASBasicImageDownloader alloc] _initWithSessionConfiguration:configuration];
+}
+
+- (NSURL *)holdingURL
+{
+  return [NSURL URLWithString:[NSString stringWithFormat:@"as-test://%@/image.png", [NSUUID UUID].UUIDString]];
+}
+
+- (id)downloadURL:(NSURL *)URL withDownloader:(ASBasicImageDownloader *)downloader priority:(ASImageDownloaderPriority)priority expectation:(XCTestExpectation *)expectation
+{
+  return [downloader downloadImageWithURL:URL
+                                 priority:priority
+                            callbackQueue:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0)
+                         downloadProgress:nil
+                               completion:^(id<ASImageContainerProtocol>  _Nullable image, NSError * _Nullable error, id  _Nullable downloadIdentifier, id _Nullable userInfo) {
+                                 XCTAssertNotNil(image);
+                                 [expectation fulfill];
+                               }];
+}
+
+/** Waits until the stand-in has seen URLs start, in any order. */
+- (void)waitUntilStarted:(NSArray<NSURL *> *)URLs
+{
+  NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:10];
+  while (![[NSSet setWithArray:URLs] isSubsetOfSet:[NSSet setWithArray:[ASTestHoldingURLProtocol startedURLs]]] && [deadline timeIntervalSinceNow] > 0) {
+    [NSThread sleepForTimeInterval:0.01];
+  }
+  XCTAssert([[NSSet setWithArray:URLs] isSubsetOfSet:[NSSet setWithArray:[ASTestHoldingURLProtocol startedURLs]]]);
+}
+
+- (void)testConcurrentDownloadsAreLimited
+{
+  ASBasicImageDownloader *downloader = [self holdingDownloader];
+  downloader.maximumConcurrentDownloads = 2;
+  NSMutableArray<NSURL *> *URLs = [NSMutableArray array];
+  for (NSUInteger i = 0; i < 4; i++) {
+    NSURL *URL = [self holdingURL];
+    [URLs addObject:URL];
+    [self downloadURL:URL withDownloader:downloader priority:ASImageDownloaderPriorityVisible expectation:[self expectationWithDescription:URL.host]];
+  }
+
+  [self waitUntilStarted:[URLs subarrayWithRange:NSMakeRange(0, 2)]];
+  [NSThread sleepForTimeInterval:0.2];
+  XCTAssertFalse([[ASTestHoldingURLProtocol startedURLs] containsObject:URLs[2]]);
+  XCTAssertFalse([[ASTestHoldingURLProtocol startedURLs] containsObject:URLs[3]]);
+
+  // Each response frees a slot for the next waiting request.
+  [ASTestHoldingURLProtocol respondToURL:URLs[0]];
+  [self waitUntilStarted:@[ URLs[2] ]];
+  [ASTestHoldingURLProtocol respondToURL:URLs[1]];
+  [self waitUntilStarted:@[ URLs[3] ]];
+  [ASTestHoldingURLProtocol respondToURL:URLs[2]];
+  [ASTestHoldingURLProtocol respondToURL:URLs[3]];
+  [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+- (void)testWaitingDownloadsStartInPriorityOrderAndCancelledOnesNeverStart
+{
+  ASBasicImageDownloader *downloader = [self holdingDownloader];
+  downloader.maximumConcurrentDownloads = 1;
+  NSURL *blocking = [self holdingURL];
+  NSURL *preload = [self holdingURL];
+  NSURL *raised = [self holdingURL];
+  NSURL *visible = [self holdingURL];
+  NSURL *cancelled = [self holdingURL];
+  [self downloadURL:blocking withDownloader:downloader priority:ASImageDownloaderPriorityVisible expectation:[self expectationWithDescription:@"blocking"]];
+  [self waitUntilStarted:@[ blocking ]];
+
+  [self downloadURL:preload withDownloader:downloader priority:ASImageDownloaderPriorityPreload expectation:[self expectationWithDescription:@"preload"]];
+  id raisedIdentifier = [self downloadURL:raised withDownloader:downloader priority:ASImageDownloaderPriorityPreload expectation:[self expectationWithDescription:@"raised"]];
+  [self downloadURL:visible withDownloader:downloader priority:ASImageDownloaderPriorityVisible expectation:[self expectationWithDescription:@"visible"]];
+  id cancelledIdentifier = [self downloadURL:cancelled withDownloader:downloader priority:ASImageDownloaderPriorityVisible expectation:nil];
+  [downloader setPriority:ASImageDownloaderPriorityImminent withDownloadIdentifier:raisedIdentifier];
+  [downloader cancelImageDownloadForIdentifier:cancelledIdentifier];
+
+  NSArray<NSURL *> *expectedOrder = @[ blocking, visible, raised, preload ];
+  for (NSUInteger i = 0; i < expectedOrder.count; i++) {
+    [ASTestHoldingURLProtocol respondToURL:expectedOrder[i]];
+    if (i + 1 < expectedOrder.count) {
+      [self waitUntilStarted:@[ expectedOrder[i + 1] ]];
+    }
+  }
+  [self waitForExpectationsWithTimeout:10 handler:nil];
+
+  NSArray<NSURL *> *startedURLs = [ASTestHoldingURLProtocol startedURLs];
+  XCTAssertFalse([startedURLs containsObject:cancelled]);
+  NSMutableArray<NSURL *> *order = [NSMutableArray array];
+  for (NSURL *URL in startedURLs) {
+    if ([expectedOrder containsObject:URL]) {
+      [order addObject:URL];
+    }
+  }
+  XCTAssertEqualObjects(order, expectedOrder);
+}
+
+
+- (void)testPartialProgressiveJPEGIsRenderedAsItArrives
+{
+  // A photo-like gradient, large enough that the first half of the file holds a complete early scan.
+  const CGSize size = CGSizeMake(512, 512);
+  UIGraphicsBeginImageContextWithOptions(size, YES, 1);
+  for (NSUInteger row = 0; row < 64; row++) {
+    [[UIColor colorWithHue:row / 64.0 saturation:0.8 brightness:0.9 alpha:1] setFill];
+    UIRectFill(CGRectMake(0, row * 8, size.width, 8));
+  }
+  UIImage *source = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  NSMutableData *jpeg = [NSMutableData data];
+  CGImageDestinationRef destination = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)jpeg, CFSTR("public.jpeg"), 1, NULL);
+  CGImageDestinationAddImage(destination, source.CGImage, (__bridge CFDictionaryRef)@{
+    (__bridge NSString *)kCGImageDestinationLossyCompressionQuality : @0.9,
+    (__bridge NSString *)kCGImagePropertyJFIFDictionary : @{ (__bridge NSString *)kCGImagePropertyJFIFIsProgressive : @YES },
+  });
+  XCTAssertTrue(CGImageDestinationFinalize(destination));
+  CFRelease(destination);
+
+  // Hold the only slot, so that the progress image block is set before the transfer starts.
+  ASBasicImageDownloader *downloader = [self holdingDownloader];
+  downloader.maximumConcurrentDownloads = 1;
+  NSURL *blocking = [self holdingURL];
+  [self downloadURL:blocking withDownloader:downloader priority:ASImageDownloaderPriorityVisible expectation:[self expectationWithDescription:@"blocking"]];
+  [self waitUntilStarted:@[ blocking ]];
+
+  NSURL *URL = [self holdingURL];
+  [ASTestHoldingURLProtocol setBody:jpeg forURL:URL];
+  XCTestExpectation *completion = [self expectationWithDescription:@"completion"];
+  id identifier = [self downloadURL:URL withDownloader:downloader priority:ASImageDownloaderPriorityVisible expectation:completion];
+
+  XCTestExpectation *progressImage = [self expectationWithDescription:@"progress image"];
+  __block BOOL receivedProgressImage = NO;
+  [downloader setProgressImageBlock:^(UIImage *image, CGFloat progress, id downloadIdentifier) {
+    if (receivedProgressImage) {
+      return;
+    }
+    receivedProgressImage = YES;
+    XCTAssertEqual(downloadIdentifier, identifier);
+    XCTAssertGreaterThan(progress, 0);
+    XCTAssertLessThanOrEqual(progress, 0.5);
+    XCTAssertTrue(CGSizeEqualToSize(image.size, size));
+    [progressImage fulfill];
+  } callbackQueue:dispatch_get_main_queue() withDownloadIdentifier:identifier];
+
+  [ASTestHoldingURLProtocol respondToURL:blocking];
+  [self waitUntilStarted:@[ URL ]];
+  [ASTestHoldingURLProtocol respondToURL:URL length:jpeg.length / 2];
+  [self waitForExpectations:@[ progressImage ] timeout:10];
+
+  [ASTestHoldingURLProtocol respondToURL:URL];
+  [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+- (void)testDownloadsWithoutProgressImagesGoToAFile
+{
+  ASBasicImageDownloader *downloader = [self holdingDownloader];
+  NSURL *URL = [self holdingURL];
+  XCTestExpectation *completion = [self expectationWithDescription:@"completion"];
+  ASBasicImageDownloaderContext *context = [self downloadURL:URL withDownloader:downloader priority:ASImageDownloaderPriorityVisible expectation:completion];
+  [self waitUntilStarted:@[ URL ]];
+  XCTAssertTrue([context.sessionTask isKindOfClass:[NSURLSessionDownloadTask class]]);
+
+  [ASTestHoldingURLProtocol respondToURL:URL];
+  [self waitForExpectations:@[ completion ] timeout:10];
+}
+
 @end
@@ -42,6 +42,25 @@
 
 @end
 
+/** Runs willCalculateSize, which may block, whenever the node is measured. */
+@interface ASTestCallbackLayoutCellNode : ASCellNode
+
+@property (nonatomic) dispatch_block_t willCalculateSize;
+
+@end
+
+@implementation ASTestCallbackLayoutCellNode
+
+- (CGSize)calculateSizeThatFits:(CGSize)constrainedSize
+{
+  if (_willCalculateSize) {
+    _willCalculateSize();
+  }
+  return CGSizeMake(10, 10);
+}
+
+@end
+
 @interface ASTestSectionContext : NSObject <ASSectionContext>
 
 @property (nonatomic) NSInteger sectionIndex;
@@ -59,6 +78,8 @@
 
 @property (nonatomic) NSInteger sectionGeneration;
 @property (nonatomic) void(^willBeginBatchFetch)(ASBatchContext *);
+/// If set, called from the node blocks for items to create the node, on the thread that allocates it.
+@property (nonatomic) ASCellNode *(^nodeForItem)(NSIndexPath *);
 
 @end
 
@@ -87,7 +108,11 @@
 
 
 - (ASCellNodeBlock)collectionNode:(ASCollectionNode *)collectionNode nodeBlockForItemAtIndexPath:(NSIndexPath *)indexPath {
-  return ^{
+  ASCellNode *(^nodeForItem)(NSIndexPath *) = _nodeForItem;
+  return ^ASCellNode *{
+    if (nodeForItem) {
+      return nodeForItem(indexPath);
+    }
     ASTextCellNodeWithSetSelectedCounter *textCellNode = [ASTextCellNodeWithSetSelectedCounter new];
     textCellNode.text = indexPath.description;
     return textCellNode;
@@ -1141,6 +1166,61 @@
   }
 }
 
+- (void)testPipelinedUpdatesAllocateWhilePreviousUpdateLaysOut
+{
+  ASConfiguration *config = [ASConfiguration new];
+  config.experimentalFeatures = ASExperimentalOptimizeDataControllerPipeline | ASExperimentalPipelinedDataController;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+
+  UIWindow *window = [[UIWindow alloc] initWithFrame:[UIScreen mainScreen].bounds];
+  ASCollectionViewTestController *testController = [[ASCollectionViewTestController alloc] initWithNibName:nil bundle:nil];
+  ASCollectionNode *cn = testController.collectionNode;
+  cn.cellLayoutMode = ASCellLayoutModeAlwaysAsync;
+  window.rootViewController = testController;
+  [window makeKeyAndVisible];
+  [window layoutIfNeeded];
+  [cn waitUntilAllUpdatesAreProcessed];
+
+  // The first inserted node can't finish its layout until the second inserted node has been allocated, which can
+  // only happen if the second update is allocating while the first is laying out.
+  dispatch_semaphore_t secondNodeAllocated = dispatch_semaphore_create(0);
+  __block BOOL firstLayoutSawSecondAllocation = NO;
+  NSIndexPath *first = [NSIndexPath indexPathForItem:10 inSection:0];
+  NSIndexPath *second = [NSIndexPath indexPathForItem:11 inSection:0];
+  testController.asyncDelegate.nodeForItem = ^ASCellNode *(NSIndexPath *indexPath) {
+    ASTestCallbackLayoutCellNode *node = [[ASTestCallbackLayoutCellNode alloc] init];
+    if ([indexPath isEqual:first]) {
+      node.willCalculateSize = ^{
+        if (!firstLayoutSawSecondAllocation) {
+          firstLayoutSawSecondAllocation = (dispatch_semaphore_wait(secondNodeAllocated, dispatch_time(DISPATCH_TIME_NOW, 2 * NSEC_PER_SEC)) == 0);
+        }
+      };
+    } else if ([indexPath isEqual:second]) {
+      dispatch_semaphore_signal(secondNodeAllocated);
+    }
+    return node;
+  };
+
+  NSMutableArray<NSIndexPath *> *completions = [NSMutableArray array];
+  XCTestExpectation *updatesCompleted = [self expectationWithDescription:@"Both updates complete"];
+  updatesCompleted.expectedFulfillmentCount = 2;
+  for (NSIndexPath *indexPath in @[ first, second ]) {
+    testController.asyncDelegate->_itemCounts[0]++;
+    [cn performBatchUpdates:^{
+      [cn insertItemsAtIndexPaths:@[ indexPath ]];
+    } completion:^(BOOL finished) {
+      [completions addObject:indexPath];
+      [updatesCompleted fulfill];
+    }];
+  }
+
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+  XCTAssertTrue(firstLayoutSawSecondAllocation);
+  XCTAssertEqualObjects(completions, (@[ first, second ]), @"Expected updates to commit in order");
+  XCTAssertEqual([cn numberOfItemsInSection:0], 12);
+  XCTAssertNotNil([cn nodeForItemAtIndexPath:second].calculatedLayout);
+}
+
 - (void)testASPrimitiveTraitCollectionToUITraitCollection {
   ASPrimitiveTraitCollection collection = ASPrimitiveTraitCollectionMakeDefault();
   collection.displayGamut = UIDisplayGamutSRGB;
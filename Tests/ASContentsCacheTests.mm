@@ -0,0 +1,164 @@
+//
+//  ASContentsCacheTests.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <XCTest/XCTest.h>
+#import <AsyncDisplayKit/ASContentsCache.h>
+
+#import <atomic>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface ASContentsCacheTests : XCTestCase
+
+@end
+
+@implementation ASContentsCacheTests
+
+- (void)testValueIsReleasedWhenEntryIsReleased
+{
+  ASContentsCache<NSString *, NSObject *> *cache = [[ASContentsCache alloc] init];
+
+  __weak NSObject *weakValue;
+  @autoreleasepool {
+    ASWeakMapEntry *entry = [cache entryForKey:@"key" isCancelled:nil createValue:^NSObject *{
+      return [[NSObject alloc] init];
+    }];
+    weakValue = entry.value;
+    XCTAssertNotNil(weakValue);
+    XCTAssertEqual([cache entryForKey:[@"key" mutableCopy]], entry);
+  }
+  XCTAssertNil(weakValue);
+  XCTAssertNil([cache entryForKey:@"key"]);
+}
+
+- (void)testConcurrentRequestsCreateTheValueOnce
+{
+  ASContentsCache<NSNumber *, NSObject *> *cache = [[ASContentsCache alloc] initWithShardCount:2 costOfValue:nil];
+  const NSUInteger keyCount = 16;
+  std::atomic<NSUInteger> created(0);
+  std::atomic<NSUInteger> *createdPointer = &created;
+  NSMutableArray<ASWeakMapEntry *> *entries = [NSMutableArray array];
+  NSLock *entriesLock = [[NSLock alloc] init];
+
+  dispatch_apply(keyCount * 8, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+    ASWeakMapEntry *entry = [cache entryForKey:@(i % keyCount) isCancelled:nil createValue:^NSObject *{
+      (*createdPointer)++;
+      [NSThread sleepForTimeInterval:0.01];
+      return [[NSObject alloc] init];
+    }];
+    [entriesLock lock];
+    [entries addObject:entry];
+    [entriesLock unlock];
+  });
+
+  XCTAssertEqual(created.load(), keyCount);
+  XCTAssertEqual([NSSet setWithArray:[entries valueForKey:@"value"]].count, keyCount);
+}
+
+- (void)testWaiterCreatesTheValueIfItsCreatorGivesUp
+{
+  ASContentsCache<NSString *, NSObject *> *cache = [[ASContentsCache alloc] init];
+  dispatch_semaphore_t creating = dispatch_semaphore_create(0);
+  XCTestExpectation *gaveUp = [self expectationWithDescription:@"Creator gave up"];
+
+  dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+    ASWeakMapEntry *entry = [cache entryForKey:@"key" isCancelled:nil createValue:^NSObject *{
+      dispatch_semaphore_signal(creating);
+      [NSThread sleepForTimeInterval:0.05];
+      return nil;
+    }];
+    XCTAssertNil(entry);
+    [gaveUp fulfill];
+  });
+
+  dispatch_semaphore_wait(creating, DISPATCH_TIME_FOREVER);
+  __block BOOL created = NO;
+  ASWeakMapEntry *entry = [cache entryForKey:@"key" isCancelled:nil createValue:^NSObject *{
+    created = YES;
+    return [[NSObject alloc] init];
+  }];
+  XCTAssertTrue(created);
+  XCTAssertNotNil(entry.value);
+  [self waitForExpectationsWithTimeout:1 handler:nil];
+}
+
+- (void)testCancelledWaiterStopsWaiting
+{
+  ASContentsCache<NSString *, NSObject *> *cache = [[ASContentsCache alloc] init];
+  dispatch_semaphore_t creating = dispatch_semaphore_create(0);
+  dispatch_semaphore_t finish = dispatch_semaphore_create(0);
+  XCTestExpectation *created = [self expectationWithDescription:@"Creator finished"];
+
+  dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+    ASWeakMapEntry *entry = [cache entryForKey:@"key" isCancelled:nil createValue:^NSObject *{
+      dispatch_semaphore_signal(creating);
+      dispatch_semaphore_wait(finish, DISPATCH_TIME_FOREVER);
+      return [[NSObject alloc] init];
+    }];
+    XCTAssertNotNil(entry.value);
+    [created fulfill];
+  });
+
+  dispatch_semaphore_wait(creating, DISPATCH_TIME_FOREVER);
+  __block BOOL createdAgain = NO;
+  std::atomic<BOOL> cancelled(NO);
+  std::atomic<BOOL> *cancelledPointer = &cancelled;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, 20 * NSEC_PER_MSEC), dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+    cancelledPointer->store(YES);
+  });
+  ASWeakMapEntry *entry = [cache entryForKey:@"key" isCancelled:^BOOL{
+    return cancelledPointer->load();
+  } createValue:^NSObject *{
+    createdAgain = YES;
+    return [[NSObject alloc] init];
+  }];
+  XCTAssertNil(entry);
+  XCTAssertFalse(createdAgain);
+
+  dispatch_semaphore_signal(finish);
+  [self waitForExpectationsWithTimeout:1 handler:nil];
+}
+
+- (void)testRetainedEntriesOutliveTheirCallers
+{
+  ASContentsCache<NSString *, NSData *> *cache = [[ASContentsCache alloc] initWithShardCount:1 costOfValue:^NSUInteger(NSData *value) {
+    return value.length;
+  }];
+  cache.retainedCostLimit = 1000;
+
+  __weak NSData *weakFirst;
+  __weak NSData *weakSecond;
+  @autoreleasepool {
+    weakFirst = [cache entryForKey:@"first" isCancelled:nil createValue:^NSData *{
+      return [NSMutableData dataWithLength:600];
+    }].value;
+    weakSecond = [cache entryForKey:@"second" isCancelled:nil createValue:^NSData *{
+      return [NSMutableData dataWithLength:300];
+    }].value;
+  }
+  XCTAssertNotNil(weakFirst);
+  XCTAssertNotNil([cache entryForKey:@"second"]);
+
+  // Going over the limit releases the least recently used entry.
+  @autoreleasepool {
+    ASWeakMapEntry *third = [cache entryForKey:@"third" isCancelled:nil createValue:^NSData *{
+      return [NSMutableData dataWithLength:300];
+    }];
+    XCTAssertNotNil(third);
+  }
+  XCTAssertNil(weakFirst);
+  XCTAssertNotNil(weakSecond);
+
+  [cache removeAllRetainedEntries];
+  XCTAssertNil(weakSecond);
+  XCTAssertNil([cache entryForKey:@"third"]);
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
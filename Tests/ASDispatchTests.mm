@@ -61,4 +61,46 @@
   XCTAssertEqualObjects(indices, [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, iterations)]);
 }
 
+- (void)testDispatchApplyAdaptive
+{
+  dispatch_queue_t q = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+  NSInteger maxThreadCount = [NSProcessInfo processInfo].activeProcessorCount;
+  NSLock *lock = [NSLock new];
+  NSMutableSet *threads = [NSMutableSet set];
+  NSMutableIndexSet *indices = [NSMutableIndexSet indexSet];
+
+  size_t const iterations = 1E5;
+  ASDispatchApplyReport report;
+  ASDispatchApplyAdaptive(iterations, q, &report, ^(size_t i) {
+    [lock lock];
+    [threads addObject:[NSThread currentThread]];
+    XCTAssertFalse([indices containsIndex:i]);
+    [indices addIndex:i];
+    [lock unlock];
+  });
+  XCTAssertLessThanOrEqual(threads.count, maxThreadCount);
+  XCTAssertEqualObjects(indices, [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, iterations)]);
+  XCTAssertEqual(report.iterationCount, iterations);
+  XCTAssertEqual(report.threadCount, threads.count);
+  XCTAssertGreaterThanOrEqual(report.utilization, 0);
+  XCTAssertLessThanOrEqual(report.utilization, 1);
+}
+
+- (void)testDispatchApplyAdaptiveRunsSmallBatchesOnCallingThread
+{
+  dispatch_queue_t q = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+  NSThread *callingThread = [NSThread currentThread];
+  __block NSUInteger otherThreadCount = 0;
+
+  // The first batches teach the call site that its iterations are cheap.
+  for (NSInteger batch = 0; batch < 20; batch++) {
+    ASDispatchApplyAdaptive(8, q, NULL, ^(size_t i) {
+      if (batch == 19 && [NSThread currentThread] != callingThread) {
+        otherThreadCount++;
+      }
+    });
+  }
+  XCTAssertEqual(otherThreadCount, 0);
+}
+
 @end
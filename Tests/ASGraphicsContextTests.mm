@@ -93,4 +93,99 @@
   }
 }
 #endif
+
+/** The pixel at x, y from the top left, as 0xAARRGGBB. */
+static uint32_t ASGraphicsContextTestsPixel(UIImage *image, size_t x, size_t y)
+{
+  uint32_t pixel = 0;
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+  CGContextRef context = CGBitmapContextCreate(&pixel, 1, 1, 8, 4, colorSpace, kCGBitmapByteOrder32Host | kCGImageAlphaPremultipliedFirst);
+  CGContextDrawImage(context, CGRectMake(-(CGFloat)x, -(CGFloat)(CGImageGetHeight(image.CGImage) - 1 - y), CGImageGetWidth(image.CGImage), CGImageGetHeight(image.CGImage)), image.CGImage);
+  CGContextRelease(context);
+  CGColorSpaceRelease(colorSpace);
+  return pixel;
+}
+
+- (void)testTiledImageMatchesSinglePass
+{
+  const CGSize size = CGSizeMake(600, 2000);
+  void (^work)() = ^{
+    [[UIColor redColor] setFill];
+    UIRectFill(CGRectMake(0, 0, 600, 1000));
+    [[UIColor blueColor] setFill];
+    UIRectFill(CGRectMake(100, 1500, 200, 100));
+  };
+  ASPrimitiveTraitCollection traitCollection = ASPrimitiveTraitCollectionMakeDefault();
+  UIImage *tiled = ASGraphicsCreateTiledImage(traitCollection, size, YES, 1, nil, CGRectMake(0, 1500, 600, 500), YES, nil, work);
+  XCTAssertEqual(tiled.size.width, size.width);
+  XCTAssertEqual(tiled.size.height, size.height);
+
+  XCTAssertEqual(ASGraphicsContextTestsPixel(tiled, 10, 10), 0xFFFF0000);
+  XCTAssertEqual(ASGraphicsContextTestsPixel(tiled, 10, 999), 0xFFFF0000);
+  XCTAssertEqual(ASGraphicsContextTestsPixel(tiled, 10, 1000), 0xFF000000);
+  XCTAssertEqual(ASGraphicsContextTestsPixel(tiled, 150, 1550), 0xFF0000FF);
+  XCTAssertEqual(ASGraphicsContextTestsPixel(tiled, 350, 1550), 0xFF000000);
+}
+
+- (void)testTiledImageDrawsPriorityTileFirstAndStopsWhenCancelled
+{
+  __block NSUInteger tiles = 0;
+  __block CGRect firstClip = CGRectNull;
+  UIImage *image = ASGraphicsCreateTiledImage(ASPrimitiveTraitCollectionMakeDefault(), CGSizeMake(1000, 2000), NO, 1, nil, CGRectMake(0, 1900, 1000, 100), NO, ^BOOL{
+    return tiles >= 2;
+  }, ^{
+    if (tiles++ == 0) {
+      firstClip = CGContextGetClipBoundingBox(UIGraphicsGetCurrentContext());
+    }
+  });
+  XCTAssertNil(image);
+  XCTAssertEqual(tiles, 2);
+  XCTAssertTrue(CGRectContainsPoint(firstClip, CGPointMake(500, 1950)));
+}
+
+- (void)testTiledImageClipsWorkToEachTile
+{
+  __block CGFloat clippedHeight = 0;
+  __block BOOL clipsAreTiles = YES;
+  UIImage *image = ASGraphicsCreateTiledImage(ASPrimitiveTraitCollectionMakeDefault(), CGSizeMake(1000, 2000), NO, 2, nil, CGRectNull, NO, nil, ^{
+    CGRect clip = CGContextGetClipBoundingBox(UIGraphicsGetCurrentContext());
+    clipsAreTiles = clipsAreTiles && clip.size.width == 1000 && clip.size.height < 2000;
+    clippedHeight += clip.size.height;
+  });
+  XCTAssertNotNil(image);
+  XCTAssertTrue(clipsAreTiles);
+  XCTAssertEqual(clippedHeight, 2000);
+}
+
+#if AS_AT_LEAST_IOS13
+- (void)testTiledImageKeepsTheExtendedRangeOfItsSource
+{
+  if (AS_AVAILABLE_IOS_TVOS(12, 12)) {
+    UIGraphicsImageRendererFormat *format = [UIGraphicsImageRendererFormat preferredFormat];
+    format.preferredRange = UIGraphicsImageRendererFormatRangeExtended;
+    format.scale = 1;
+    UIImage *source = [[[UIGraphicsImageRenderer alloc] initWithSize:CGSizeMake(10, 10) format:format] imageWithActions:^(UIGraphicsImageRendererContext *context) {
+      [[UIColor colorWithDisplayP3Red:1 green:0 blue:0 alpha:1] setFill];
+      [context fillRect:CGRectMake(0, 0, 10, 10)];
+    }];
+    const CGSize size = CGSizeMake(1000, 2000);
+    void (^work)() = ^{
+      [source drawInRect:CGRectMake(0, 0, size.width, size.height)];
+    };
+    UIImage *single = ASGraphicsCreateImage(ASPrimitiveTraitCollectionMakeDefault(), size, YES, 1, source, nil, work);
+    UIImage *tiled = ASGraphicsCreateTiledImage(ASPrimitiveTraitCollectionMakeDefault(), size, YES, 1, source, CGRectNull, YES, nil, work);
+    XCTAssertEqual(CGImageGetBitsPerComponent(tiled.CGImage), CGImageGetBitsPerComponent(single.CGImage));
+  }
+}
+#endif
+
+- (void)testSmallTiledImageIsDrawnInOnePass
+{
+  __block NSUInteger passes = 0;
+  UIImage *image = ASGraphicsCreateTiledImage(ASPrimitiveTraitCollectionMakeDefault(), CGSizeMake(100, 100), NO, 1, nil, CGRectNull, YES, nil, ^{
+    passes++;
+  });
+  XCTAssertNotNil(image);
+  XCTAssertEqual(passes, 1);
+}
 @end
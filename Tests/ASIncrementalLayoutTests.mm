@@ -0,0 +1,166 @@
+//
+//  ASIncrementalLayoutTests.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <XCTest/XCTest.h>
+
+#import <AsyncDisplayKit/AsyncDisplayKit.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+
+@interface ASIncrementalLayoutTestNode : ASDisplayNode
+@property (nonatomic) CGFloat height;
+@property (nonatomic) NSUInteger calculationCount;
+@end
+
+@implementation ASIncrementalLayoutTestNode
+
+- (CGSize)calculateSizeThatFits:(CGSize)constrainedSize
+{
+  _calculationCount++;
+  return CGSizeMake(MIN(constrainedSize.width, 100), _height);
+}
+
+@end
+
+/** Counts the layouts it calculates for its own subtree. */
+@interface ASIncrementalLayoutCountingNode : ASDisplayNode
+@property (nonatomic) NSUInteger calculationCount;
+@end
+
+@implementation ASIncrementalLayoutCountingNode
+
+- (ASLayout *)calculateLayoutThatFits:(ASSizeRange)constrainedSize
+{
+  _calculationCount++;
+  return [super calculateLayoutThatFits:constrainedSize];
+}
+
+@end
+
+@interface ASIncrementalLayoutTests : XCTestCase
+@end
+
+@implementation ASIncrementalLayoutTests
+
+- (void)setUp
+{
+  [super setUp];
+  ASConfiguration *config = [ASConfiguration new];
+  config.experimentalFeatures = ASExperimentalIncrementalLayout;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+}
+
+- (void)testLayoutIsReusedForADifferentParentSize
+{
+  ASIncrementalLayoutTestNode *node = [ASIncrementalLayoutTestNode new];
+  node.height = 20;
+  const ASSizeRange sizeRange = ASSizeRangeMake(CGSizeZero, CGSizeMake(100, INFINITY));
+  const CGSize undefinedParentSize = CGSizeMake(ASLayoutElementParentDimensionUndefined, ASLayoutElementParentDimensionUndefined);
+
+  ASLayout *layout = [node layoutThatFits:sizeRange parentSize:CGSizeMake(100, 100)];
+  XCTAssertEqual([node layoutThatFits:sizeRange parentSize:undefinedParentSize], layout);
+  XCTAssertEqual([node layoutThatFits:sizeRange parentSize:undefinedParentSize], layout);
+  XCTAssertEqual(node.calculationCount, 1);
+}
+
+- (void)testFractionalSizeIsRecalculatedForADifferentParentSize
+{
+  ASIncrementalLayoutTestNode *node = [ASIncrementalLayoutTestNode new];
+  node.height = 20;
+  node.style.width = ASDimensionMakeWithFraction(0.5);
+  const ASSizeRange sizeRange = ASSizeRangeMake(CGSizeZero, CGSizeMake(100, INFINITY));
+
+  XCTAssertEqual([node layoutThatFits:sizeRange parentSize:CGSizeMake(100, 100)].size.width, 50);
+  XCTAssertEqual([node layoutThatFits:sizeRange parentSize:CGSizeMake(60, 100)].size.width, 30);
+  XCTAssertEqual(node.calculationCount, 2);
+}
+
+- (void)testResizingSubnodeOnlyRemeasuresItself
+{
+  ASIncrementalLayoutTestNode *resizingNode = [ASIncrementalLayoutTestNode new];
+  resizingNode.height = 20;
+  ASIncrementalLayoutTestNode *siblingNode = [ASIncrementalLayoutTestNode new];
+  siblingNode.height = 20;
+
+  ASDisplayNode *rootNode = [ASDisplayNode new];
+  rootNode.automaticallyManagesSubnodes = YES;
+  rootNode.layoutSpecBlock = ^ASLayoutSpec *(__kindof ASDisplayNode *node, ASSizeRange constrainedSize) {
+    return [ASStackLayoutSpec stackLayoutSpecWithDirection:ASStackLayoutDirectionVertical
+                                                   spacing:0
+                                            justifyContent:ASStackLayoutJustifyContentStart
+                                                alignItems:ASStackLayoutAlignItemsStart
+                                                  children:@[resizingNode, siblingNode]];
+  };
+
+  ASLayout *layout = [rootNode layoutThatFits:ASSizeRangeMake(CGSizeMake(100, 0), CGSizeMake(100, INFINITY))];
+  rootNode.frame = (CGRect){CGPointZero, layout.size};
+  [rootNode.view layoutIfNeeded];
+  XCTAssertEqual(rootNode.bounds.size.height, 40);
+  resizingNode.calculationCount = 0;
+  siblingNode.calculationCount = 0;
+
+  // The resizing node measures itself, asks its ancestors for layout and must then not be measured again by them.
+  resizingNode.height = 30;
+  [resizingNode setNeedsLayout];
+  [resizingNode.view layoutIfNeeded];
+  [rootNode.view layoutIfNeeded];
+
+  XCTAssertEqual(rootNode.bounds.size.height, 50);
+  XCTAssertEqual(resizingNode.frame.size.height, 30);
+  XCTAssertEqual(siblingNode.frame.origin.y, 30);
+  XCTAssertEqual(resizingNode.calculationCount, 1);
+  XCTAssertEqual(siblingNode.calculationCount, 0);
+}
+
+- (void)testTextChangeDoesNotRemeasureACleanSiblingSubtree
+{
+  ASTextNode *textNode = [ASTextNode new];
+  textNode.attributedText = [[NSAttributedString alloc] initWithString:@"Short"];
+
+  ASIncrementalLayoutTestNode *firstLeaf = [ASIncrementalLayoutTestNode new];
+  firstLeaf.height = 20;
+  ASIncrementalLayoutTestNode *secondLeaf = [ASIncrementalLayoutTestNode new];
+  secondLeaf.height = 20;
+  ASIncrementalLayoutCountingNode *siblingNode = [ASIncrementalLayoutCountingNode new];
+  siblingNode.automaticallyManagesSubnodes = YES;
+  siblingNode.layoutSpecBlock = ^ASLayoutSpec *(__kindof ASDisplayNode *node, ASSizeRange constrainedSize) {
+    ASStackLayoutSpec *stack = [ASStackLayoutSpec verticalStackLayoutSpec];
+    stack.children = @[firstLeaf, secondLeaf];
+    return stack;
+  };
+
+  ASDisplayNode *rootNode = [ASDisplayNode new];
+  rootNode.automaticallyManagesSubnodes = YES;
+  rootNode.layoutSpecBlock = ^ASLayoutSpec *(__kindof ASDisplayNode *node, ASSizeRange constrainedSize) {
+    return [ASStackLayoutSpec stackLayoutSpecWithDirection:ASStackLayoutDirectionVertical
+                                                   spacing:0
+                                            justifyContent:ASStackLayoutJustifyContentStart
+                                                alignItems:ASStackLayoutAlignItemsStart
+                                                  children:@[textNode, siblingNode]];
+  };
+
+  ASLayout *layout = [rootNode layoutThatFits:ASSizeRangeMake(CGSizeMake(100, 0), CGSizeMake(100, INFINITY))];
+  rootNode.frame = (CGRect){CGPointZero, layout.size};
+  [rootNode.view layoutIfNeeded];
+  const CGFloat textHeight = textNode.frame.size.height;
+  siblingNode.calculationCount = 0;
+  firstLeaf.calculationCount = 0;
+  secondLeaf.calculationCount = 0;
+
+  // The text wraps onto more lines, which resizes the root but leaves the sibling subtree clean.
+  textNode.attributedText = [[NSAttributedString alloc] initWithString:@"Long enough to wrap onto several lines of text"];
+  [textNode.view layoutIfNeeded];
+  [rootNode.view layoutIfNeeded];
+
+  XCTAssertGreaterThan(textNode.frame.size.height, textHeight);
+  XCTAssertEqual(siblingNode.frame.origin.y, textNode.frame.size.height);
+  XCTAssertEqual(siblingNode.calculationCount, 0);
+  XCTAssertEqual(firstLeaf.calculationCount, 0);
+  XCTAssertEqual(secondLeaf.calculationCount, 0);
+}
+
+@end
@@ -10,6 +10,7 @@
 #import <XCTest/XCTest.h>
 #import "ASXCTExtensions.h"
 #import <AsyncDisplayKit/ASLayoutElement.h>
+#import <AsyncDisplayKit/ASLayoutElementStylePrivate.h>
 
 #pragma mark - ASLayoutElementStyleTestsDelegate
 
@@ -124,4 +125,21 @@
   XCTAssertTrue([delegate.propertyNameChanged isEqualToString:ASLayoutElementStyleWidthProperty]);
 }
 
+- (void)testGenerationOnlyChangesWhenAPropertyChanges
+{
+  ASLayoutElementStyle *style = [ASLayoutElementStyle new];
+  NSUInteger generation = style.generation;
+
+  style.flexGrow = 1;
+  XCTAssertGreaterThan(style.generation, generation);
+  generation = style.generation;
+
+  style.flexGrow = 1;
+  style.width = ASDimensionAuto;
+  XCTAssertEqual(style.generation, generation);
+
+  style.preferredSize = CGSizeMake(10, 10);
+  XCTAssertGreaterThan(style.generation, generation);
+}
+
 @end
@@ -0,0 +1,101 @@
+//
+//  ASLayoutMemoTests.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <XCTest/XCTest.h>
+
+#import <AsyncDisplayKit/AsyncDisplayKit.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+#import <AsyncDisplayKit/ASLayoutMemo.h>
+
+@interface ASLayoutMemoTestNode : ASDisplayNode
+@property (nonatomic) NSUInteger calculationCount;
+@end
+
+@implementation ASLayoutMemoTestNode
+
+- (CGSize)calculateSizeThatFits:(CGSize)constrainedSize
+{
+  _calculationCount++;
+  return CGSizeMake(MIN(constrainedSize.width, 100), 20);
+}
+
+@end
+
+@interface ASLayoutMemoTests : XCTestCase
+@end
+
+@implementation ASLayoutMemoTests
+
+- (void)setUp
+{
+  [super setUp];
+  ASConfiguration *config = [ASConfiguration new];
+  config.experimentalFeatures = ASExperimentalLayoutMemo;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+  ASLayoutMemoResetStatistics();
+}
+
+- (void)testReturningToAnEarlierSizeRangeReusesTheLayout
+{
+  ASLayoutMemoTestNode *node = [ASLayoutMemoTestNode new];
+  const ASSizeRange portrait = ASSizeRangeMake(CGSizeZero, CGSizeMake(50, INFINITY));
+  const ASSizeRange landscape = ASSizeRangeMake(CGSizeZero, CGSizeMake(150, INFINITY));
+
+  ASLayout *portraitLayout = [node layoutThatFits:portrait];
+  [node layoutThatFits:landscape];
+  XCTAssertEqual(node.calculationCount, 2);
+
+  XCTAssertEqual([node layoutThatFits:portrait], portraitLayout);
+  XCTAssertEqual(node.calculationCount, 2);
+
+  const ASLayoutMemoStatistics statistics = ASLayoutMemoGetStatistics();
+  XCTAssertEqual(statistics.hits, 1);
+  XCTAssertEqual(statistics.misses, 2);
+}
+
+- (void)testUndefinedParentSizeHitsTheMemo
+{
+  // Stack layouts measure their children relative to an undefined parent size, whose dimensions are NaN.
+  ASLayoutMemoTestNode *node = [ASLayoutMemoTestNode new];
+  const ASSizeRange portrait = ASSizeRangeMake(CGSizeZero, CGSizeMake(50, INFINITY));
+  const ASSizeRange landscape = ASSizeRangeMake(CGSizeZero, CGSizeMake(150, INFINITY));
+
+  ASLayout *portraitLayout = [node layoutThatFits:portrait parentSize:ASLayoutElementParentSizeUndefined];
+  [node layoutThatFits:landscape parentSize:ASLayoutElementParentSizeUndefined];
+  XCTAssertEqual([node layoutThatFits:portrait parentSize:ASLayoutElementParentSizeUndefined], portraitLayout);
+  XCTAssertEqual(node.calculationCount, 2);
+  XCTAssertEqual(ASLayoutMemoGetStatistics().hits, 1);
+}
+
+- (void)testStyleChangeInvalidatesMemoizedLayouts
+{
+  ASLayoutMemoTestNode *node = [ASLayoutMemoTestNode new];
+  const ASSizeRange narrow = ASSizeRangeMake(CGSizeZero, CGSizeMake(50, INFINITY));
+  const ASSizeRange wide = ASSizeRangeMake(CGSizeZero, CGSizeMake(150, INFINITY));
+
+  [node layoutThatFits:narrow];
+  [node layoutThatFits:wide];
+  node.style.flexGrow = 1;
+  [node layoutThatFits:narrow];
+  XCTAssertEqual(node.calculationCount, 3);
+}
+
+- (void)testSetNeedsLayoutInvalidatesMemoizedLayouts
+{
+  ASLayoutMemoTestNode *node = [ASLayoutMemoTestNode new];
+  const ASSizeRange narrow = ASSizeRangeMake(CGSizeZero, CGSizeMake(50, INFINITY));
+  const ASSizeRange wide = ASSizeRangeMake(CGSizeZero, CGSizeMake(150, INFINITY));
+
+  [node layoutThatFits:narrow];
+  [node layoutThatFits:wide];
+  [node setNeedsLayout];
+  [node layoutThatFits:narrow];
+  XCTAssertEqual(node.calculationCount, 3);
+}
+
+@end
@@ -10,6 +10,8 @@
 
 #import <AsyncDisplayKit/ASRunLoopQueue.h>
 
+#import <atomic>
+
 #import "ASDisplayNodeTestsHelper.h"
 
 static NSTimeInterval const kRunLoopRunTime = 0.01; // Allow the RunLoop to run for 1/100 second each time.
@@ -25,6 +27,21 @@ static NSTimeInterval const kRunLoopRunTime = 0.01; // Allow the RunLoop to run
 }
 @end
 
+@interface DeallocRecorder : NSObject
+@property (nonatomic) void (^onDealloc)(void);
+@end
+
+@implementation DeallocRecorder
+- (void)dealloc
+{
+  _onDealloc();
+}
+@end
+
+@interface ASRunLoopQueue (Testing)
+- (void)processQueue;
+@end
+
 @interface ASRunLoopQueueTests : ASTestCase
 
 @end
@@ -198,4 +215,138 @@ static NSTimeInterval const kRunLoopRunTime = 0.01; // Allow the RunLoop to run
   XCTAssertTrue(queue.enabled);
 }
 
+
+- (void)testQueueProcessesObjectsInEnqueueOrderAndAcceptsThemAgainAfterward
+{
+  NSArray *objects = @[ [[NSObject alloc] init], [[NSObject alloc] init], [[NSObject alloc] init] ];
+  NSMutableArray *processed = [NSMutableArray array];
+  ASRunLoopQueue *queue = [[ASRunLoopQueue alloc] initWithRunLoop:CFRunLoopGetMain() retainObjects:NO handler:^(id  _Nonnull dequeuedItem, BOOL isQueueDrained) {
+    [processed addObject:dequeuedItem];
+  }];
+  queue.batchSize = 10;
+  for (id object in objects) {
+    [queue enqueue:object];
+  }
+  [queue enqueue:objects[0]];
+  [queue processQueue];
+  XCTAssertEqualObjects(processed, objects);
+
+  // Membership ends when an object is dequeued.
+  [queue enqueue:objects[0]];
+  [queue processQueue];
+  XCTAssertEqual(processed.count, 4);
+  XCTAssertEqual(processed.lastObject, objects[0]);
+}
+
+#pragma mark frame budget tests
+
+- (void)testFrameBudgetedQueueDrainsCheapItemsInOneTurn
+{
+  __block NSUInteger processedCount = 0;
+  ASRunLoopQueue *queue = [[ASRunLoopQueue alloc] initWithRunLoop:CFRunLoopGetMain() retainObjects:YES handler:^(id  _Nonnull dequeuedItem, BOOL isQueueDrained) {
+    processedCount++;
+  }];
+  queue.drainsWithinFrameBudget = YES;
+  for (NSUInteger i = 0; i < 500; i++) {
+    [queue enqueue:[[NSObject alloc] init]];
+  }
+  [queue processQueue];
+
+  XCTAssertEqual(processedCount, 500);
+  XCTAssertTrue(queue.isEmpty);
+  const ASRunLoopQueueStatistics statistics = queue.statistics;
+  XCTAssertEqual(statistics.processedItems, 500);
+  XCTAssertEqual(statistics.turns, 1);
+  XCTAssertEqual(statistics.exhaustedBudgets, 0);
+  XCTAssertGreaterThan(statistics.lastBatchSize, 1);
+  NSUInteger histogramCount = 0;
+  for (NSUInteger i = 0; i < ASRunLoopQueueItemCostHistogramBucketCount; i++) {
+    histogramCount += statistics.itemCostHistogram[i];
+  }
+  XCTAssertEqual(histogramCount, 500);
+}
+
+- (void)testFrameBudgetedQueueStopsWhenTheBudgetIsSpent
+{
+  ASRunLoopQueue *queue = [[ASRunLoopQueue alloc] initWithRunLoop:CFRunLoopGetMain() retainObjects:YES handler:^(id  _Nonnull dequeuedItem, BOOL isQueueDrained) {
+    [NSThread sleepForTimeInterval:kRunLoopRunTime]; // Longer than a quarter of a frame at any refresh rate.
+  }];
+  queue.drainsWithinFrameBudget = YES;
+  queue.batchSize = 1;
+  for (NSUInteger i = 0; i < 3; i++) {
+    [queue enqueue:[[NSObject alloc] init]];
+  }
+  [queue processQueue];
+
+  XCTAssertFalse(queue.isEmpty);
+  ASRunLoopQueueStatistics statistics = queue.statistics;
+  XCTAssertEqual(statistics.processedItems, 1);
+  XCTAssertEqual(statistics.exhaustedBudgets, 1);
+  XCTAssertEqual(statistics.itemCostHistogram[ASRunLoopQueueItemCostHistogramBucketCount - 1], 1);
+
+  // The queue signals its run loop source, so the remaining items drain over the next turns.
+  [queue resetStatistics];
+  [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:kRunLoopRunTime * 5]];
+  XCTAssertTrue(queue.isEmpty);
+  statistics = queue.statistics;
+  XCTAssertEqual(statistics.processedItems, 2);
+  XCTAssertEqual(statistics.lastBatchSize, 1);
+}
+
+- (void)testFrameBudgetedQueueWithoutHandlerReleasesItems
+{
+  ASRunLoopQueue *queue = [[ASRunLoopQueue alloc] initWithRunLoop:CFRunLoopGetMain() retainObjects:YES handler:nil];
+  queue.drainsWithinFrameBudget = YES;
+  __weak id weakObject;
+  @autoreleasepool {
+    id object = [[NSObject alloc] init];
+    weakObject = object;
+    [queue enqueue:object];
+    object = nil;
+    XCTAssertNotNil(weakObject);
+  }
+  [queue processQueue];
+  XCTAssertNil(weakObject);
+  XCTAssertEqual(queue.statistics.processedItems, 1);
+}
+
+
+#pragma mark dealloc queue tests
+
+- (void)testDeallocQueueReleasesInChunksAtUtilityQoS
+{
+  ASDeallocQueue *queue = [ASDeallocQueue sharedDeallocationQueue];
+  const NSTimeInterval coalescingInterval = queue.coalescingInterval;
+  const NSTimeInterval chunkTimeBudget = queue.chunkTimeBudget;
+  queue.coalescingInterval = 0;
+  // Every chunk stops after its first object.
+  queue.chunkTimeBudget = 0;
+
+  const NSUInteger objectCount = 20;
+  // Atomics cannot be copied into blocks, so the blocks capture pointers to them.
+  std::atomic<NSUInteger> deallocatedCount(0);
+  std::atomic<NSUInteger> utilityCount(0);
+  std::atomic<NSUInteger> *deallocatedCountPtr = &deallocatedCount;
+  std::atomic<NSUInteger> *utilityCountPtr = &utilityCount;
+  XCTestExpectation *expectation = [self expectationWithDescription:@"all released"];
+  for (NSUInteger i = 0; i < objectCount; i++) {
+    DeallocRecorder *object = [[DeallocRecorder alloc] init];
+    object.onDealloc = ^{
+      if (qos_class_self() == QOS_CLASS_UTILITY) {
+        (*utilityCountPtr)++;
+      }
+      if (++(*deallocatedCountPtr) == objectCount) {
+        [expectation fulfill];
+      }
+    };
+    [queue releaseObjectInBackground:&object];
+    XCTAssertNil(object);
+  }
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+  XCTAssertEqual(utilityCount.load(), objectCount);
+
+  queue.coalescingInterval = coalescingInterval;
+  queue.chunkTimeBudget = chunkTimeBudget;
+}
+
 @end
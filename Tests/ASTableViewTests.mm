@@ -17,6 +17,7 @@
 #import <AsyncDisplayKit/ASTableNode.h>
 #import <AsyncDisplayKit/ASTableView+Undeprecated.h>
 #import <AsyncDisplayKit/ASInternalHelpers.h>
+#import <AsyncDisplayKit/ASElementMap.h>
 
 #import "ASTestCase.h"
 #import "ASXCTExtensions.h"
@@ -24,12 +25,27 @@
 #define NumberOfSections 10
 #define NumberOfReloadIterations 50
 
+@interface ASDataController (Testing)
+- (void)setVisibleMap:(ASElementMap *)visibleMap;
+@end
+
 @interface ASTestDataController : ASDataController
 @property (nonatomic) int numberOfAllNodesRelayouts;
+/// The number of items in each map the data controller has made visible, in order.
+@property (nonatomic, readonly) NSMutableArray<NSNumber *> *visibleItemCounts;
 @end
 
 @implementation ASTestDataController
 
+- (void)setVisibleMap:(ASElementMap *)visibleMap
+{
+  [super setVisibleMap:visibleMap];
+  if (_visibleItemCounts == nil) {
+    _visibleItemCounts = [NSMutableArray array];
+  }
+  [_visibleItemCounts addObject:@(visibleMap.itemIndexPaths.count)];
+}
+
 - (void)relayoutAllNodesWithInvalidationBlock:(nullable void (^)())invalidationBlock
 {
   _numberOfAllNodesRelayouts++;
@@ -290,6 +306,47 @@
   }
 }
 
+- (void)testVisibleFirstAllocationCommitsDisplayRangeBeforeTheRest
+{
+  ASConfiguration *config = [ASConfiguration new];
+  config.experimentalFeatures = ASExperimentalOptimizeDataControllerPipeline | ASExperimentalVisibleFirstAllocation;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+
+  ASTestTableView *tableView = [[ASTestTableView alloc] __initWithFrame:CGRectMake(0, 0, 320, 480)
+                                                                  style:UITableViewStylePlain];
+  ASTableViewFilledDelegate *delegate = [ASTableViewFilledDelegate new];
+  ASTableViewFilledDataSource *dataSource = [ASTableViewFilledDataSource new];
+  dataSource.rowsPerSection = 100;
+  tableView.asyncDelegate = delegate;
+  tableView.asyncDataSource = dataSource;
+
+  // The reload's completion runs once every row is in, not when the leading rows are.
+  NSInteger totalRowCount = NumberOfSections * 100;
+  __block NSInteger rowCountInCompletion = 0;
+  XCTestExpectation *reloaded = [self expectationWithDescription:@"Reload completes"];
+  [tableView reloadDataWithCompletion:^{
+    rowCountInCompletion = [tableView numberOfRowsInSection:NumberOfSections - 1];
+    [reloaded fulfill];
+  }];
+  [tableView waitUntilAllUpdatesAreCommitted];
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+  XCTAssertEqual(rowCountInCompletion, 100);
+
+  // The rows that fill the display range are committed on their own, and the rest are inserted after them.
+  NSArray<NSNumber *> *visibleItemCounts = tableView.testDataController.visibleItemCounts;
+  NSUInteger firstLoadIndex = [visibleItemCounts indexOfObjectPassingTest:^BOOL(NSNumber *count, NSUInteger idx, BOOL *stop) {
+    return count.integerValue > 0;
+  }];
+  XCTAssertNotEqual(firstLoadIndex, NSNotFound);
+  XCTAssertGreaterThanOrEqual(visibleItemCounts[firstLoadIndex].integerValue * 42, 480);
+  XCTAssertLessThan(visibleItemCounts[firstLoadIndex].integerValue, totalRowCount);
+  XCTAssertEqual(visibleItemCounts.lastObject.integerValue, totalRowCount);
+
+  XCTAssertEqual([tableView numberOfRowsInSection:NumberOfSections - 1], 100);
+  NSIndexPath *lastIndexPath = [NSIndexPath indexPathForRow:99 inSection:NumberOfSections - 1];
+  XCTAssertNotNil([tableView nodeForRowAtIndexPath:lastIndexPath].calculatedLayout);
+}
+
 // TODO: Convert this to ARC.
 - (void)DISABLED_testTableViewDoesNotRetainItselfAndDelegate
 {
@@ -0,0 +1,32 @@
+//
+//  ASTextCacheTestCase.h
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import <XCTest/XCTest.h>
+
+#import <AsyncDisplayKit/ASExperimentalFeatures.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * The fixture of the tests of ASTextNode2's text caches. Each test runs with only the subclass's experiment on and
+ * starts from an empty cache with its default cost limit.
+ */
+@interface ASTextCacheTestCase : XCTestCase
+
+/** The experiment that turns the cache under test on. Subclasses must override. */
+@property (nonatomic, readonly) ASExperimentalFeatures experimentalFeatures;
+
+/** Empties the cache under test and restores its statistics and cost limit. Subclasses must override. */
+- (void)resetCache;
+
+/** A distinct string for each index, long enough to wrap at 100 points. */
+- (NSAttributedString *)textWithIndex:(NSUInteger)index;
+
+@end
+
+NS_ASSUME_NONNULL_END
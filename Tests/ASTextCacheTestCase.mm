@@ -0,0 +1,48 @@
+//
+//  ASTextCacheTestCase.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import "ASTextCacheTestCase.h"
+
+#import <UIKit/UIKit.h>
+
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+
+@implementation ASTextCacheTestCase
+
+- (void)setUp
+{
+  [super setUp];
+  ASConfiguration *config = [ASConfiguration new];
+  config.experimentalFeatures = self.experimentalFeatures;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+  [self resetCache];
+}
+
+- (void)tearDown
+{
+  [self resetCache];
+  [ASConfigurationManager test_resetWithConfiguration:nil];
+  [super tearDown];
+}
+
+- (ASExperimentalFeatures)experimentalFeatures
+{
+  return 0;
+}
+
+- (void)resetCache
+{
+}
+
+- (NSAttributedString *)textWithIndex:(NSUInteger)index
+{
+  NSString *string = [NSString stringWithFormat:@"%lu: Lorem ipsum dolor sit amet, consectetur adipisicing elit", (unsigned long)index];
+  return [[NSAttributedString alloc] initWithString:string attributes:@{ NSFontAttributeName : [UIFont systemFontOfSize:14] }];
+}
+
+@end
@@ -0,0 +1,75 @@
+//
+//  ASTextFramesetterPoolTests.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import "ASTextCacheTestCase.h"
+
+#import <AsyncDisplayKit/AsyncDisplayKit.h>
+#import <AsyncDisplayKit/ASTextFramesetterPool.h>
+#import <AsyncDisplayKit/ASTextLayout.h>
+
+@interface ASTextFramesetterPoolTests : ASTextCacheTestCase
+@end
+
+@implementation ASTextFramesetterPoolTests
+
+- (ASExperimentalFeatures)experimentalFeatures
+{
+  return ASExperimentalFramesetterCache;
+}
+
+- (void)resetCache
+{
+  ASTextFramesetterPoolSetCostLimit(4 * 1024 * 1024);
+  ASTextFramesetterPoolRemoveAllFramesetters();
+  ASTextFramesetterPoolResetStatistics();
+}
+
+- (void)testLayoutsOfDifferentSizesShareAFramesetter
+{
+  NSAttributedString *text = [self textWithIndex:0];
+  ASTextLayout *narrow = [ASTextLayout layoutWithContainerSize:CGSizeMake(100, CGFLOAT_MAX) text:text];
+  ASTextLayout *wide = [ASTextLayout layoutWithContainerSize:CGSizeMake(300, CGFLOAT_MAX) text:[text mutableCopy]];
+  XCTAssertGreaterThan(narrow.rowCount, wide.rowCount);
+
+  const ASTextFramesetterPoolStatistics statistics = ASTextFramesetterPoolGetStatistics();
+  XCTAssertEqual(statistics.misses, 1);
+  XCTAssertEqual(statistics.hits, 1);
+  XCTAssertEqual(statistics.count, 1);
+}
+
+- (void)testConcurrentCheckOutsGetTheirOwnFramesetters
+{
+  NSAttributedString *text = [self textWithIndex:0];
+  CTFramesetterRef first = ASTextFramesetterPoolCheckOut(text);
+  CTFramesetterRef second = ASTextFramesetterPoolCheckOut(text);
+  XCTAssertNotEqual(first, second);
+  ASTextFramesetterPoolCheckIn(text, first);
+  ASTextFramesetterPoolCheckIn(text, second);
+
+  CTFramesetterRef reused = ASTextFramesetterPoolCheckOut(text);
+  XCTAssertTrue(reused == first || reused == second);
+  ASTextFramesetterPoolCheckIn(text, reused);
+  XCTAssertEqual(ASTextFramesetterPoolGetStatistics().misses, 2);
+  XCTAssertEqual(ASTextFramesetterPoolGetStatistics().hits, 1);
+}
+
+- (void)testCostLimitEvictsStrings
+{
+  for (NSUInteger i = 0; i < 20; i++) {
+    NSAttributedString *text = [self textWithIndex:i];
+    ASTextFramesetterPoolCheckIn(text, ASTextFramesetterPoolCheckOut(text));
+  }
+  XCTAssertEqual(ASTextFramesetterPoolGetStatistics().count, 20);
+
+  ASTextFramesetterPoolSetCostLimit(16 * 1024);
+  const ASTextFramesetterPoolStatistics statistics = ASTextFramesetterPoolGetStatistics();
+  XCTAssertLessThan(statistics.count, 20);
+  XCTAssertEqual(statistics.evictions, 20 - statistics.count);
+}
+
+@end
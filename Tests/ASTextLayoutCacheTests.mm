@@ -0,0 +1,147 @@
+//
+//  ASTextLayoutCacheTests.mm
+//  Texture
+//
+//  Copyright (c) Pinterest, Inc.  All rights reserved.
+//  Licensed under Apache 2.0: http://www.apache.org/licenses/LICENSE-2.0
+//
+
+#import "ASTextCacheTestCase.h"
+
+#import <AsyncDisplayKit/AsyncDisplayKit.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
+#import <AsyncDisplayKit/ASTextLayout.h>
+#import <AsyncDisplayKit/ASTextLayoutCache.h>
+
+@interface ASTextLayoutCacheTests : ASTextCacheTestCase
+@end
+
+@implementation ASTextLayoutCacheTests
+
+- (ASExperimentalFeatures)experimentalFeatures
+{
+  return ASExperimentalTextLayoutCache;
+}
+
+- (void)resetCache
+{
+  ASTextLayoutCacheSetCostLimit(8 * 1024 * 1024);
+  ASTextLayoutCacheRemoveAllLayouts();
+  ASTextLayoutCacheResetStatistics();
+}
+
+- (void)testLayoutIsReusedForTheSameContainer
+{
+  NSAttributedString *text = [self textWithIndex:0];
+  ASTextLayout *layout = ASTextLayoutCacheGetLayout([ASTextContainer containerWithSize:CGSizeMake(100, CGFLOAT_MAX)], text);
+  ASTextLayout *wideLayout = ASTextLayoutCacheGetLayout([ASTextContainer containerWithSize:CGSizeMake(300, CGFLOAT_MAX)], text);
+  XCTAssertNotEqual(layout, wideLayout);
+
+  // An equal but distinct (and mutable) string finds the same layouts.
+  NSMutableAttributedString *equalText = [text mutableCopy];
+  XCTAssertEqual(ASTextLayoutCacheGetLayout([ASTextContainer containerWithSize:CGSizeMake(100, CGFLOAT_MAX)], equalText), layout);
+
+  const ASTextLayoutCacheStatistics statistics = ASTextLayoutCacheGetStatistics();
+  XCTAssertEqual(statistics.hits, 1);
+  XCTAssertEqual(statistics.misses, 2);
+  XCTAssertEqual(statistics.count, 1);
+  XCTAssertGreaterThan(statistics.cost, 0);
+}
+
+- (void)testCostLimitEvictsStrings
+{
+  for (NSUInteger i = 0; i < 50; i++) {
+    ASTextLayoutCacheGetLayout([ASTextContainer containerWithSize:CGSizeMake(100, CGFLOAT_MAX)], [self textWithIndex:i]);
+  }
+  XCTAssertEqual(ASTextLayoutCacheGetStatistics().count, 50);
+  XCTAssertEqual(ASTextLayoutCacheGetStatistics().evictions, 0);
+
+  ASTextLayoutCacheSetCostLimit(1024);
+  const ASTextLayoutCacheStatistics statistics = ASTextLayoutCacheGetStatistics();
+  XCTAssertLessThanOrEqual(statistics.cost, 1024);
+  XCTAssertLessThan(statistics.count, 50);
+  XCTAssertEqual(statistics.evictions, 50 - statistics.count);
+}
+
+- (void)testTextNodesShareLayoutsOfEqualStrings
+{
+  NSAttributedString *text = [self textWithIndex:0];
+  NSUInteger misses = 0;
+  for (NSUInteger i = 0; i < 3; i++) {
+    ASTextNode2 *node = [[ASTextNode2 alloc] init];
+    node.attributedText = text;
+    [node layoutThatFits:ASSizeRangeMake(CGSizeZero, CGSizeMake(120, INFINITY))];
+    if (i == 0) {
+      misses = ASTextLayoutCacheGetStatistics().misses;
+    }
+  }
+  const ASTextLayoutCacheStatistics statistics = ASTextLayoutCacheGetStatistics();
+  XCTAssertGreaterThan(misses, 0);
+  XCTAssertEqual(statistics.misses, misses);
+  XCTAssertGreaterThanOrEqual(statistics.hits, 2);
+}
+
+- (void)enableWidthRangeReuse
+{
+  ASConfiguration *config = [ASConfiguration new];
+  config.experimentalFeatures = ASExperimentalTextLayoutCache | ASExperimentalTextWidthRangeReuse;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+}
+
+- (void)testLayoutIsReusedForAnyWidthTheTextFits
+{
+  [self enableWidthRangeReuse];
+  NSAttributedString *text = [[NSAttributedString alloc] initWithString:@"Short\nlines" attributes:@{ NSFontAttributeName : [UIFont systemFontOfSize:14] }];
+  ASTextLayout *layout = ASTextLayoutCacheGetLayout([ASTextContainer containerWithSize:CGSizeMake(1000, CGFLOAT_MAX)], text);
+  const CGSize size = layout.textBoundingSize;
+  XCTAssertLessThan(size.width, 200);
+
+  XCTAssertEqual(ASTextLayoutCacheGetLayout([ASTextContainer containerWithSize:CGSizeMake(1200, CGFLOAT_MAX)], text), layout);
+  XCTAssertEqual(ASTextLayoutCacheGetLayout([ASTextContainer containerWithSize:CGSizeMake(320.5, CGFLOAT_MAX)], text), layout);
+  XCTAssertEqual(ASTextLayoutCacheGetLayout([ASTextContainer containerWithSize:size], text), layout);
+  XCTAssertEqual(ASTextLayoutCacheGetStatistics().hits, 3);
+
+  // Narrower or shorter than the text needs a layout of its own.
+  XCTAssertNotEqual(ASTextLayoutCacheGetLayout([ASTextContainer containerWithSize:CGSizeMake(size.width - 10, CGFLOAT_MAX)], text), layout);
+  XCTAssertNotEqual(ASTextLayoutCacheGetLayout([ASTextContainer containerWithSize:CGSizeMake(1000, size.height / 2)], text), layout);
+  // So do other container parameters.
+  ASTextContainer *inset = [ASTextContainer containerWithSize:CGSizeMake(1000, CGFLOAT_MAX) insets:UIEdgeInsetsMake(2, 2, 2, 2)];
+  XCTAssertNotEqual(ASTextLayoutCacheGetLayout(inset, text), layout);
+}
+
+- (void)testWrappedOrCenteredTextIsNotReusedAcrossWidths
+{
+  [self enableWidthRangeReuse];
+  NSAttributedString *wrapped = [self textWithIndex:0];
+  ASTextLayout *layout = ASTextLayoutCacheGetLayout([ASTextContainer containerWithSize:CGSizeMake(100, CGFLOAT_MAX)], wrapped);
+  XCTAssertGreaterThan(layout.rowCount, 1);
+  XCTAssertNotEqual(ASTextLayoutCacheGetLayout([ASTextContainer containerWithSize:CGSizeMake(101, CGFLOAT_MAX)], wrapped), layout);
+
+  NSMutableParagraphStyle *centered = [[NSMutableParagraphStyle alloc] init];
+  centered.alignment = NSTextAlignmentCenter;
+  NSAttributedString *text = [[NSAttributedString alloc] initWithString:@"Short" attributes:@{ NSFontAttributeName : [UIFont systemFontOfSize:14], NSParagraphStyleAttributeName : centered }];
+  layout = ASTextLayoutCacheGetLayout([ASTextContainer containerWithSize:CGSizeMake(1000, CGFLOAT_MAX)], text);
+  XCTAssertNotEqual(ASTextLayoutCacheGetLayout([ASTextContainer containerWithSize:CGSizeMake(1200, CGFLOAT_MAX)], text), layout);
+  XCTAssertEqual(ASTextLayoutCacheGetStatistics().hits, 0);
+}
+
+- (void)testPrefetchedLayoutIsFoundByMeasurement
+{
+  ASTextNode2 *node = [[ASTextNode2 alloc] init];
+  node.attributedText = [self textWithIndex:0];
+  const CGSize size = CGSizeMake(120, INFINITY);
+  [node prefetchLayoutForConstrainedSize:size];
+
+  NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:5];
+  while (ASTextLayoutCacheGetStatistics().prefetches == 0 && [deadline timeIntervalSinceNow] > 0) {
+    [NSThread sleepForTimeInterval:0.01];
+  }
+  XCTAssertEqual(ASTextLayoutCacheGetStatistics().prefetches, 1);
+
+  [node layoutThatFits:ASSizeRangeMake(CGSizeZero, size)];
+  const ASTextLayoutCacheStatistics statistics = ASTextLayoutCacheGetStatistics();
+  XCTAssertEqual(statistics.misses, 0);
+  XCTAssertGreaterThanOrEqual(statistics.hits, 1);
+}
+
+@end
@@ -8,6 +8,7 @@
 
 #import "ASTestCase.h"
 #import <AsyncDisplayKit/AsyncDisplayKit.h>
+#import <AsyncDisplayKit/ASConfigurationInternal.h>
 
 @interface ASTransactionTests : ASTestCase
 
@@ -81,4 +82,84 @@
   XCTAssertNil(weakTransaction);
 }
 
+- (void)testSchedulerRunsEveryOperationAndCompletes
+{
+  ASConfiguration *config = [ASConfiguration new];
+  config.experimentalFeatures = ASExperimentalTransactionScheduler;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+  ASAsyncTransactionSchedulerResetStatistics();
+
+  dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+  __block BOOL transactionCompleted = NO;
+  _ASAsyncTransaction *transaction = [[_ASAsyncTransaction alloc] initWithCompletionBlock:^(_ASAsyncTransaction *completedTransaction, BOOL canceled) {
+    XCTAssertFalse(canceled);
+    transactionCompleted = YES;
+  }];
+
+  const NSInteger operationCount = 100;
+  NSMutableArray<NSNumber *> *values = [NSMutableArray array];
+  for (NSInteger i = 0; i < operationCount; i++) {
+    [transaction addOperationWithBlock:^id<NSObject> _Nullable{
+      return @(i);
+    } priority:i % 4
+                                 queue:queue
+                            completion:^(id  _Nullable value, BOOL canceled) {
+                              [values addObject:value];
+                            }];
+  }
+  [transaction commit];
+  [transaction waitUntilComplete];
+
+  XCTAssertTrue(transactionCompleted);
+  // Completion blocks run in the order operations were added, whatever order the operations ran in.
+  XCTAssertEqual(values.count, operationCount);
+  for (NSInteger i = 0; i < values.count; i++) {
+    XCTAssertEqualObjects(values[i], @(i));
+  }
+
+  ASAsyncTransactionSchedulerStatistics statistics = ASAsyncTransactionSchedulerGetStatistics();
+  XCTAssertGreaterThanOrEqual(statistics.executedOperations, (NSUInteger)operationCount);
+  XCTAssertEqual(statistics.queueDepth, (NSUInteger)0);
+  XCTAssertGreaterThan(statistics.maxQueueDepth, (NSUInteger)0);
+}
+
+- (void)testSchedulerDropsStaleOperations
+{
+  ASConfiguration *config = [ASConfiguration new];
+  config.experimentalFeatures = ASExperimentalTransactionScheduler;
+  [ASConfigurationManager test_resetWithConfiguration:config];
+  ASAsyncTransactionSchedulerResetStatistics();
+
+  dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+  _ASAsyncTransaction *transaction = [[_ASAsyncTransaction alloc] initWithCompletionBlock:nil];
+
+  __block NSInteger executedCount = 0;
+  __block NSInteger completedCount = 0;
+  for (NSInteger i = 0; i < 10; i++) {
+    BOOL stale = (i % 2 == 0);
+    [transaction addOperationWithBlock:^id<NSObject> _Nullable{
+      @synchronized (self) {
+        executedCount++;
+      }
+      return @(i);
+    } priority:0
+                              deadline:CACurrentMediaTime() + 1.0 / 60.0
+                          isStaleBlock:^BOOL{
+                            return stale;
+                          }
+                                 queue:queue
+                            completion:^(id  _Nullable value, BOOL canceled) {
+                              XCTAssertEqualObjects(value, stale ? nil : @(i));
+                              completedCount++;
+                            }];
+  }
+  [transaction commit];
+  [transaction waitUntilComplete];
+
+  // Every completion block is still called, but stale operations never run.
+  XCTAssertEqual(completedCount, 10);
+  XCTAssertEqual(executedCount, 5);
+  XCTAssertEqual(ASAsyncTransactionSchedulerGetStatistics().droppedOperations, (NSUInteger)5);
+}
+
 @end
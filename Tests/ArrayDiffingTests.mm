@@ -243,6 +243,27 @@
   }
 }
 
+- (void)testDiffingLargeMostlySimilarArrays
+{
+  NSMutableArray<NSNumber *> *original = [NSMutableArray array];
+  for (NSInteger i = 0; i < 5000; i++) {
+    [original addObject:@(i)];
+  }
+  NSMutableArray<NSNumber *> *pending = [original mutableCopy];
+  [pending removeObjectAtIndex:4000];
+  [pending removeObjectAtIndex:10];
+  [pending insertObject:@(-1) atIndex:2500];
+
+  NSIndexSet *insertions, *deletions;
+  [original asdk_diffWithArray:pending insertions:&insertions deletions:&deletions compareBlock:^BOOL(id lhs, id rhs) {
+    return [lhs isEqual:rhs];
+  }];
+  XCTAssertEqualObjects(insertions, [NSIndexSet indexSetWithIndex:2500]);
+  NSMutableIndexSet *expectedDeletions = [NSMutableIndexSet indexSetWithIndex:10];
+  [expectedDeletions addIndex:4000];
+  XCTAssertEqualObjects(deletions, expectedDeletions);
+}
+
 - (void)testArrayDiffingRebuildingWithRandomElements
 {
   NSArray<NSNumber *> *original = @[];
@@ -251,6 +251,24 @@ carthage|all)
     success="1"
     ;;
 
+benchmarks)
+    # Support building, testing & benchmarking one host-side core: sh build.sh benchmarks StackLayoutCore
+    echo "Building, testing & benchmarking the host-side cores."
+
+    cmake -S Benchmarks -B build/Benchmarks -DCMAKE_BUILD_TYPE=Release
+    cmake --build build/Benchmarks
+    if [ -n "$2" ]; then
+        ctest --test-dir build/Benchmarks --output-on-failure -R "^${2}(Tests|BenchmarkSmoke)\$"
+        "build/Benchmarks/${2}Benchmark"
+    else
+        ctest --test-dir build/Benchmarks --output-on-failure
+        for benchmark in build/Benchmarks/*Benchmark; do
+            "$benchmark"
+        done
+    fi
+    success="1"
+    ;;
+
 *)
     echo "Unrecognized mode '$MODE'."
     ;;